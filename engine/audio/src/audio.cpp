@@ -55,6 +55,7 @@ Audio::Audio(Doc* doc)
   , m_doc(doc)
   , m_decoder(NULL)
   , m_audio_out(NULL)
+  , m_mixer(NULL)
   , m_audioDevice(QString())
   , m_sourceFileName("")
   , m_audioDuration(0)
@@ -69,6 +70,8 @@ Audio::Audio(Doc* doc)
 
 Audio::~Audio()
 {
+    if (m_mixer != NULL)
+        m_mixer->removeSource(m_decoder);
     if (m_audio_out != NULL)
     {
         m_audio_out->stop();
@@ -146,6 +149,11 @@ bool Audio::setSourceFileName(QString filename)
         // unload previous source
         if (m_decoder != NULL)
         {
+            if (m_mixer != NULL)
+            {
+                m_mixer->removeSource(m_decoder);
+                m_mixer = NULL;
+            }
             delete m_decoder;
             m_decoder = NULL;
         }
@@ -203,12 +211,22 @@ int Audio::adjustAttribute(qreal fraction, int attributeId)
 
     if (m_audio_out != NULL && attrIndex == Intensity)
         m_audio_out->adjustIntensity(getAttributeValue(Function::Intensity));
+    if (m_mixer != NULL && attrIndex == Intensity)
+        m_mixer->setSourceIntensity(m_decoder, getAttributeValue(Function::Intensity));
 
     return attrIndex;
 }
 
 void Audio::slotEndOfStream()
 {
+    if (m_mixer != NULL)
+    {
+        disconnect(m_mixer, SIGNAL(sourceFinished(AudioDecoder*)),
+                   this, SLOT(slotSourceFinished(AudioDecoder*)));
+        m_mixer->removeSource(m_decoder);
+        m_mixer = NULL;
+        m_decoder->seek(0);
+    }
     if (m_audio_out != NULL)
     {
         m_audio_out->stop();
@@ -220,6 +238,12 @@ void Audio::slotEndOfStream()
         stop(FunctionParent::master());
 }
 
+void Audio::slotSourceFinished(AudioDecoder *decoder)
+{
+    if (m_mixer != NULL && decoder == m_decoder)
+        slotEndOfStream();
+}
+
 void Audio::slotFunctionRemoved(quint32 fid)
 {
     Q_UNUSED(fid)
@@ -319,27 +343,42 @@ void Audio::preRun(MasterTimer* timer)
     {
         m_decoder->seek(elapsed());
         AudioParameters ap = m_decoder->audioParameters();
+
+        // Audio played on the global device is mixed with the other
+        // running Audio functions, unless its format can't be mixed
+        AudioMixer *mixer = m_doc->audioMixer();
+        if (m_audioDevice.isEmpty() &&
+            mixer->addSource(m_decoder, timer->elapsed(), getAttributeValue(Intensity),
+                             fadeInSpeed(), runOrder() == Audio::Loop))
+        {
+            m_mixer = mixer;
+            connect(m_mixer, SIGNAL(sourceFinished(AudioDecoder*)),
+                    this, SLOT(slotSourceFinished(AudioDecoder*)));
+        }
+        else
+        {
 #if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
  #if defined(__APPLE__) || defined(Q_OS_MAC)
-        //m_audio_out = new AudioRendererCoreAudio();
-        m_audio_out = new AudioRendererPortAudio(m_audioDevice);
+            //m_audio_out = new AudioRendererCoreAudio();
+            m_audio_out = new AudioRendererPortAudio(m_audioDevice);
  #elif defined(WIN32) || defined(Q_OS_WIN)
-        m_audio_out = new AudioRendererWaveOut(m_audioDevice);
+            m_audio_out = new AudioRendererWaveOut(m_audioDevice);
  #else
-        m_audio_out = new AudioRendererAlsa(m_audioDevice);
+            m_audio_out = new AudioRendererAlsa(m_audioDevice);
  #endif
-        m_audio_out->moveToThread(QCoreApplication::instance()->thread());
+            m_audio_out->moveToThread(QCoreApplication::instance()->thread());
 #else
-        m_audio_out = new AudioRendererQt(m_audioDevice);
+            m_audio_out = new AudioRendererQt(m_audioDevice);
 #endif
-        m_audio_out->setDecoder(m_decoder);
-        m_audio_out->initialize(ap.sampleRate(), ap.channels(), ap.format());
-        m_audio_out->adjustIntensity(getAttributeValue(Intensity));
-        m_audio_out->setFadeIn(fadeInSpeed());
-        m_audio_out->setLooped(runOrder() == Audio::Loop);
-        m_audio_out->start();
-        connect(m_audio_out, SIGNAL(endOfStreamReached()),
-                this, SLOT(slotEndOfStream()));
+            m_audio_out->setDecoder(m_decoder);
+            m_audio_out->initialize(ap.sampleRate(), ap.channels(), ap.format());
+            m_audio_out->adjustIntensity(getAttributeValue(Intensity));
+            m_audio_out->setFadeIn(fadeInSpeed());
+            m_audio_out->setLooped(runOrder() == Audio::Loop);
+            m_audio_out->start();
+            connect(m_audio_out, SIGNAL(endOfStreamReached()),
+                    this, SLOT(slotEndOfStream()));
+        }
     }
 
     Function::preRun(timer);
@@ -356,6 +395,8 @@ void Audio::setPause(bool enable)
             else
                 m_audio_out->resume();
         }
+        if (m_mixer != NULL)
+            m_mixer->setSourcePaused(m_decoder, enable);
 
         Function::setPause(enable);
     }
@@ -375,6 +416,8 @@ void Audio::write(MasterTimer* timer, QList<Universe *> universes)
     {
         if (m_audio_out != NULL && totalDuration() - elapsed() <= fadeOutSpeed())
             m_audio_out->setFadeOut(fadeOutSpeed());
+        if (m_mixer != NULL && totalDuration() - elapsed() <= fadeOutSpeed())
+            m_mixer->setSourceFadeOut(m_decoder, fadeOutSpeed());
     }
 }
 
@@ -24,6 +24,7 @@
 
 #include "audiorenderer.h"
 #include "audiodecoder.h"
+#include "audiomixer.h"
 #include "function.h"
 
 class QXmlStreamReader;
@@ -122,11 +123,17 @@ signals:
 protected slots:
     void slotEndOfStream();
 
+    /** Catches AudioMixer::sourceFinished() to stop when the source of
+        this function ends */
+    void slotSourceFinished(AudioDecoder *decoder);
+
 private:
     /** Instance of an AudioDecoder to perform actual audio decoding */
     AudioDecoder *m_decoder;
     /** output interface to render audio data got from m_decoder */
     AudioRenderer *m_audio_out;
+    /** The mixer playing m_decoder on the global audio device, instead of m_audio_out */
+    AudioMixer *m_mixer;
     /** Audio device to use for rendering */
     QString m_audioDevice;
     /** Absolute start time of Audio over a timeline (in milliseconds) */
@@ -33,16 +33,23 @@
 
 #define M_2PI       6.28318530718           /* 2*pi */
 
+/** Number of spectrum bins cleared as noise */
+#define FFT_NOISE_BINS  5
+
 AudioCapture::AudioCapture (QObject* parent)
     : QThread (parent)
     , m_userStop(true)
     , m_pause(false)
+    , m_logarithmicBands(false)
     , m_captureSize(0)
     , m_sampleRate(0)
     , m_channels(0)
     , m_audioBuffer(NULL)
     , m_fftInputBuffer(NULL)
     , m_fftOutputBuffer(NULL)
+    , m_fftPlan(NULL)
+    , m_spectrumSize(0)
+    , m_spectrumRate(0)
 {
     int bufferSize = AUDIO_DEFAULT_BUFFER_SIZE;
     m_sampleRate = AUDIO_DEFAULT_SAMPLE_RATE;
@@ -59,6 +66,11 @@ AudioCapture::AudioCapture (QObject* parent)
     if (var.isValid() == true)
         m_channels = var.toInt();
 
+    var = settings.value(SETTINGS_AUDIO_INPUT_LOGBANDS);
+
+    if (var.isValid() == true)
+        m_logarithmicBands = var.toBool();
+
     qDebug() << "[AudioCapture] initialize" << m_sampleRate << m_channels;
 
     m_captureSize = bufferSize * m_channels;
@@ -78,6 +90,8 @@ AudioCapture::~AudioCapture()
     delete[] m_audioBuffer;
     delete[] m_fftInputBuffer;
 #ifdef HAS_FFTW3
+    if (m_fftPlan)
+        fftw_destroy_plan((fftw_plan)m_fftPlan);
     if (m_fftOutputBuffer)
         fftw_free(m_fftOutputBuffer);
 #endif
@@ -135,6 +149,23 @@ void AudioCapture::unregisterBandsNumber(int number)
     }
 }
 
+void AudioCapture::setLogarithmicBands(bool enable)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_logarithmicBands = enable;
+
+    // bands edges are computed again at the next processData
+    QMutableMapIterator <int, BandsData> it(m_fftMagnitudeMap);
+    while (it.hasNext())
+        it.next().value().m_bandsEdges.clear();
+}
+
+bool AudioCapture::logarithmicBands() const
+{
+    return m_logarithmicBands;
+}
+
 void AudioCapture::stop()
 {
     qDebug() << "[AudioCapture] stop capture";
@@ -145,35 +176,109 @@ void AudioCapture::stop()
     }
 }
 
-double AudioCapture::fillBandsData(int number)
+void AudioCapture::setupSpectrum()
 {
-    // m_fftOutputBuffer contains the real and imaginary data of a spectrum
-    // representing all the frequencies from 0 to m_sampleRate Hz.
-    // I will just consider 0 to 5000Hz and will calculate average magnitude
-    // for the number of desired bands.
-    double maxMagnitude = 0;
+    if (m_spectrumSize != m_captureSize)
+    {
 #ifdef HAS_FFTW3
-    unsigned int i = 0;
-    int subBandWidth = ((m_captureSize * SPECTRUM_MAX_FREQUENCY) / m_sampleRate) / number;
+        if (m_fftPlan)
+            fftw_destroy_plan((fftw_plan)m_fftPlan);
+        // Planning overwrites the buffers, which are filled right after
+        m_fftPlan = fftw_plan_dft_r2c_1d(m_captureSize, m_fftInputBuffer,
+                                         (fftw_complex*)m_fftOutputBuffer, FFTW_MEASURE);
+#endif
+        m_windowTable.resize(m_captureSize);
+        for (unsigned int i = 0; i < m_captureSize; i++)
+        {
+#ifdef USE_BLACKMAN
+            double a0 = (1-0.16)/2;
+            double a1 = 0.5;
+            double a2 = 0.16/2;
+            m_windowTable[i] = a0 - a1 * qCos((M_2PI * i) / (m_captureSize - 1)) +
+                               a2 * qCos((2 * M_2PI * i) / (m_captureSize - 1));
+#endif
+#ifdef USE_HANNING
+            m_windowTable[i] = 0.5 * (1.00 - qCos((M_2PI * i) / (m_captureSize - 1)));
+#endif
+#ifdef USE_NO_WINDOW
+            m_windowTable[i] = 1.0;
+#endif
+        }
+        m_spectrumSize = m_captureSize;
+    }
+
+    // I will just consider 0 to 5000Hz of the spectrum, which holds the
+    // frequencies from 0 to m_sampleRate Hz, of which the first half is usable
+    unsigned int bins = (m_captureSize * SPECTRUM_MAX_FREQUENCY) / m_sampleRate;
+    m_fftMagnitude.resize(qMin(bins, m_captureSize / 2 + 1));
+    m_spectrumRate = m_sampleRate;
+
+    // the bands edges depend on the spectrum size
+    QMutableMapIterator <int, BandsData> it(m_fftMagnitudeMap);
+    while (it.hasNext())
+        it.next().value().m_bandsEdges.clear();
+}
+
+QVector<int> AudioCapture::bandsEdges(int number) const
+{
+    QVector<int> edges(number + 1);
+    int bins = m_fftMagnitude.size();
+#ifdef CLEAR_FFT_NOISE
+    int first = FFT_NOISE_BINS;
+#else
+    int first = 1;
+#endif
+
+    if (m_logarithmicBands == false || first >= bins)
+    {
+        // bands of the same width. The bins left over are not considered
+        int subBandWidth = bins / number;
+        for (int b = 0; b <= number; b++)
+            edges[b] = b * subBandWidth;
+        return edges;
+    }
+
+    // each band is wider than the previous one by the same ratio, and
+    // spans at least one bin while there are any left
+    double ratio = qPow(double(bins) / first, 1.0 / number);
+    edges[0] = first;
+    for (int b = 1; b < number; b++)
+    {
+        int edge = qMax(qRound(first * qPow(ratio, b)), edges[b - 1] + 1);
+        edges[b] = qMin(edge, bins);
+    }
+    edges[number] = bins;
+
+    return edges;
+}
+
+double AudioCapture::fillBandsData(BandsData& data)
+{
+    // Calculate the average magnitude of the bins of each band
+    double maxMagnitude = 0;
+    int number = data.m_fftMagnitudeBuffer.size();
+
+    if (data.m_bandsEdges.isEmpty())
+        data.m_bandsEdges = bandsEdges(number);
+
+    const int *edges = data.m_bandsEdges.constData();
+    const double *magnitude = m_fftMagnitude.constData();
+    double *bands = data.m_fftMagnitudeBuffer.data();
 
     for (int b = 0; b < number; b++)
     {
-        quint64 magnitudeSum = 0;
-        for (int s = 0; s < subBandWidth; s++, i++)
-        {
-            if (i == m_captureSize)
-                break;
-            magnitudeSum += qSqrt((((fftw_complex*)m_fftOutputBuffer)[i][0] * ((fftw_complex*)m_fftOutputBuffer)[i][0]) +
-                                  (((fftw_complex*)m_fftOutputBuffer)[i][1] * ((fftw_complex*)m_fftOutputBuffer)[i][1]));
-        }
-        double bandMagnitude = (magnitudeSum / subBandWidth);
-        m_fftMagnitudeMap[number].m_fftMagnitudeBuffer[b] = bandMagnitude;
+        double magnitudeSum = 0;
+        for (int i = edges[b]; i < edges[b + 1]; i++)
+            magnitudeSum += magnitude[i];
+
+        double bandMagnitude = 0;
+        if (edges[b + 1] > edges[b])
+            bandMagnitude = magnitudeSum / (edges[b + 1] - edges[b]);
+        bands[b] = bandMagnitude;
         if (maxMagnitude < bandMagnitude)
             maxMagnitude = bandMagnitude;
     }
-#else
-    Q_UNUSED(number)
-#endif
+
     return maxMagnitude;
 }
 
@@ -183,12 +288,14 @@ void AudioCapture::processData()
     unsigned int i;
     quint64 pwrSum = 0;
 
-    // 1 ********* Initialize FFTW
-    fftw_plan plan_forward;
-    plan_forward = fftw_plan_dft_r2c_1d(m_captureSize, m_fftInputBuffer, (fftw_complex*)m_fftOutputBuffer , 0);
+    // 1 ********* Create the FFT plan and the window table
+    // *********** the first time or when the capture changed
+    if (m_spectrumSize != m_captureSize || m_spectrumRate != m_sampleRate)
+        setupSpectrum();
 
     // 2 ********* Apply a window to audio data
     // *********** and convert it to doubles
+    const double *window = m_windowTable.constData();
 
     for (i = 0; i < m_captureSize; i++)
     {
@@ -197,44 +304,39 @@ void AudioCapture::processData()
         else
             pwrSum += m_audioBuffer[i];
 
-#ifdef USE_BLACKMAN
-        double a0 = (1-0.16)/2;
-        double a1 = 0.5;
-        double a2 = 0.16/2;
-        m_fftInputBuffer[i] = m_audioBuffer[i]  * (a0 - a1 * qCos((M_2PI * i) / (m_captureSize - 1)) +
-                              a2 * qCos((2 * M_2PI * i) / (m_captureSize - 1)));
-#endif
-#ifdef USE_HANNING
-        m_fftInputBuffer[i] = m_audioBuffer[i] * (0.5 * (1.00 - qCos((M_2PI * i) / (m_captureSize - 1))));
-#endif
-#ifdef USE_NO_WINDOW
-        m_fftInputBuffer[i] = (double)m_audioBuffer[i];
-#endif
+        m_fftInputBuffer[i] = m_audioBuffer[i] * window[i];
     }
 
     // 3 ********* Perform FFT
-    fftw_execute(plan_forward);
-    fftw_destroy_plan(plan_forward);
+    fftw_execute((fftw_plan)m_fftPlan);
 
     // 4 ********* Clear FFT noise
+    fftw_complex *output = (fftw_complex*)m_fftOutputBuffer;
 #ifdef CLEAR_FFT_NOISE
     //We delete some values since these will ruin our output
-    for (int n = 0; n < 5; n++)
+    for (int n = 0; n < FFT_NOISE_BINS; n++)
     {
-        ((fftw_complex*)m_fftOutputBuffer)[n][0] = 0;
-        ((fftw_complex*)m_fftOutputBuffer)[n][1] = 0;
+        output[n][0] = 0;
+        output[n][1] = 0;
     }
 #endif
 
     // 5 ********* Calculate the average signal power
     m_signalPower = pwrSum / m_captureSize;
 
-    // 6 ********* Calculate vector magnitude
-    foreach(int barsNumber, m_fftMagnitudeMap.keys())
+    // 6 ********* Calculate vector magnitude, once for all the bands
+    double *magnitude = m_fftMagnitude.data();
+    for (i = 0; i < (unsigned int)m_fftMagnitude.size(); i++)
+        magnitude[i] = qSqrt((output[i][0] * output[i][0]) + (output[i][1] * output[i][1]));
+
+    // 7 ********* Calculate the bands magnitude
+    QMutableMapIterator <int, BandsData> it(m_fftMagnitudeMap);
+    while (it.hasNext())
     {
-        double maxMagnitude = fillBandsData(barsNumber);
-        emit dataProcessed(m_fftMagnitudeMap[barsNumber].m_fftMagnitudeBuffer.data(),
-                           m_fftMagnitudeMap[barsNumber].m_fftMagnitudeBuffer.size(),
+        BandsData &data = it.next().value();
+        double maxMagnitude = fillBandsData(data);
+        emit dataProcessed(data.m_fftMagnitudeBuffer.data(),
+                           data.m_fftMagnitudeBuffer.size(),
                            maxMagnitude, m_signalPower);
     }
 #endif
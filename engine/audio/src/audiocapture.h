@@ -30,6 +30,7 @@
 #define SETTINGS_AUDIO_INPUT_DEVICE   "audio/input"
 #define SETTINGS_AUDIO_INPUT_SRATE    "audio/samplerate"
 #define SETTINGS_AUDIO_INPUT_CHANNELS "audio/channels"
+#define SETTINGS_AUDIO_INPUT_LOGBANDS "audio/logbands"
 
 #define AUDIO_DEFAULT_SAMPLE_RATE     44100
 #define AUDIO_DEFAULT_CHANNELS        1
@@ -47,6 +48,9 @@ struct BandsData
 {
     int m_registerCounter;
     QVector<double> m_fftMagnitudeBuffer;
+    /** The spectrum bins where each band starts, followed by the end of
+     *  the last band. Empty when they have to be computed again */
+    QVector<int> m_bandsEdges;
 };
 
 class AudioCapture : public QThread
@@ -77,6 +81,13 @@ public:
 
     static int maxFrequency() { return SPECTRUM_MAX_FREQUENCY; }
 
+    /**
+     * Enable or disable log-spaced frequency bands. When disabled,
+     * the spectrum is split in bands of the same width
+     */
+    void setLogarithmicBands(bool enable);
+    bool logarithmicBands() const;
+
     protected:
     /*!
      * Prepares object for usage and setups required audio parameters.
@@ -120,17 +131,26 @@ protected:
     void stop();
 
 private:
+    /** Create the FFT plan and the window table for the current capture size,
+     *  and size the spectrum for the current sample rate */
+    void setupSpectrum();
+
+    /** Compute the spectrum bins edges of $number bands */
+    QVector<int> bandsEdges(int number) const;
+
     /** This is called at every processData to fill a single BandsData structure */
-    double fillBandsData(int number);
+    double fillBandsData(BandsData& data);
 
     /** This is the method where captured audio data is processed in this order
      *  1) calculates the signal power, which will be the volume bar
      *  2) perform the FFT
-     *  3) retrieve the signal magnitude for each registered number of bands
+     *  3) calculate the magnitude of each spectrum bin
+     *  4) retrieve the signal magnitude for each registered number of bands
      */
     void processData();
 
     bool m_userStop, m_pause;
+    bool m_logarithmicBands;
 
 signals:
     void dataProcessed(double *spectrumBands, int size, double maxMagnitude, quint32 power);
@@ -156,6 +176,16 @@ protected:
     double *m_fftInputBuffer;
     void *m_fftOutputBuffer;
 
+    /** The FFT plan and the window table, made for m_spectrumSize samples */
+    void *m_fftPlan;
+    unsigned int m_spectrumSize;
+    QVector<double> m_windowTable;
+
+    /** The magnitude of each spectrum bin up to SPECTRUM_MAX_FREQUENCY,
+     *  at m_spectrumRate */
+    unsigned int m_spectrumRate;
+    QVector<double> m_fftMagnitude;
+
     /** Map of the registered clients (key is the number of bands) */
     QMap <int, BandsData> m_fftMagnitudeMap;
 };
@@ -0,0 +1,464 @@
+/*
+  Q Light Controller Plus
+  audiomixer.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QDebug>
+#include <string.h>
+
+#include "audiomixer.h"
+#include "audiorenderer.h"
+#include "qlcmacros.h"
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+ #if defined(__APPLE__) || defined(Q_OS_MAC)
+   #include "audiorenderer_portaudio.h"
+ #elif defined(WIN32) || defined(Q_OS_WIN)
+   #include "audiorenderer_waveout.h"
+ #else
+   #include "audiorenderer_alsa.h"
+ #endif
+#else
+ #include "audiorenderer_qt.h"
+#endif
+
+/** The mix is always stereo */
+#define MIXER_CHANNELS      2
+
+/** Duration of the ramp applied on intensity changes, to avoid clicks */
+#define INTENSITY_RAMP_MS   20
+
+AudioMixer::AudioMixer(QObject *parent)
+    : AudioDecoder()
+    , m_renderer(NULL)
+    , m_running(false)
+    , m_position(0)
+    , m_lastStartTime(0)
+    , m_lastStartFrame(0)
+{
+    setParent(parent);
+    configure(44100, MIXER_CHANNELS, PCM_S16LE);
+
+    // sourceFinished is emitted by the renderer thread
+    qRegisterMetaType<AudioDecoder*>("AudioDecoder*");
+}
+
+AudioMixer::~AudioMixer()
+{
+    if (m_renderer != NULL)
+    {
+        m_renderer->stop();
+        delete m_renderer;
+    }
+}
+
+/*********************************************************************
+ * Mixing
+ *********************************************************************/
+
+/** Add $count samples of $samples to $mix, scaled by $gain */
+static void mixGain(float *mix, const float *samples, int count, float gain)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    const __m128 gainVec = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 value = _mm_mul_ps(_mm_loadu_ps(samples + i), gainVec);
+        _mm_storeu_ps(mix + i, _mm_add_ps(_mm_loadu_ps(mix + i), value));
+    }
+#endif
+    for (; i < count; i++)
+        mix[i] += samples[i] * gain;
+}
+
+/** Add $frames stereo frames of $samples to $mix, scaled by a gain
+ *  starting at $gain and moving by $step at each frame */
+static void mixRamp(float *mix, const float *samples, int frames, float gain, float step)
+{
+    int count = frames * MIXER_CHANNELS;
+    int i = 0;
+#if defined(__SSE2__)
+    // 4 samples are 2 stereo frames
+    __m128 gainVec = _mm_set_ps(gain + step, gain + step, gain, gain);
+    const __m128 stepVec = _mm_set1_ps(2 * step);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 value = _mm_mul_ps(_mm_loadu_ps(samples + i), gainVec);
+        _mm_storeu_ps(mix + i, _mm_add_ps(_mm_loadu_ps(mix + i), value));
+        gainVec = _mm_add_ps(gainVec, stepVec);
+    }
+#endif
+    for (; i < count; i++)
+        mix[i] += samples[i] * (gain + step * (i / MIXER_CHANNELS));
+}
+
+/** Convert $count samples of $mix to 16 bit, clipping them */
+static void mixToS16(const float *mix, qint16 *out, int count)
+{
+    int i = 0;
+#if defined(__SSE2__)
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i low = _mm_cvtps_epi32(_mm_loadu_ps(mix + i));
+        __m128i high = _mm_cvtps_epi32(_mm_loadu_ps(mix + i + 4));
+        // packing saturates to the 16 bit range
+        _mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(low, high));
+    }
+#endif
+    for (; i < count; i++)
+        out[i] = qint16(qRound(qBound(-32768.0f, mix[i], 32767.0f)));
+}
+
+qint64 AudioMixer::read(char *data, qint64 maxSize)
+{
+    QList <AudioDecoder *> finished;
+    int frames = int(maxSize / (MIXER_CHANNELS * sizeof(qint16)));
+
+    QMutexLocker locker(&m_mutex);
+
+    if (m_sources.isEmpty())
+    {
+        m_running = false;
+        return 0;
+    }
+
+    int count = frames * MIXER_CHANNELS;
+    if (m_mixBuffer.size() < count)
+    {
+        m_readBuffer.resize(count);
+        m_sourceBuffer.resize(count);
+        m_mixBuffer.resize(count);
+    }
+
+    float *mix = m_mixBuffer.data();
+    memset(mix, 0, count * sizeof(float));
+
+    for (int s = 0; s < m_sources.count(); s++)
+    {
+        Source &source = m_sources[s];
+        if (source.m_paused)
+            continue;
+
+        // the source starts in a later block
+        qint64 offset = source.m_startFrame - m_position;
+        if (offset >= frames)
+            continue;
+
+        bool ended = false;
+
+        // the source was started in a tick whose first frame is already
+        // mixed: drop the frames it missed, to stay aligned with the
+        // other sources started in that tick
+        while (offset < 0 && ended == false)
+        {
+            int missed = int(qMin(-offset, qint64(frames)));
+            if (readSource(source, missed) < missed)
+                ended = true;
+            offset += missed;
+        }
+        source.m_startFrame = qMax(source.m_startFrame, m_position);
+
+        int wanted = frames - int(qMax(offset, qint64(0)));
+        int read = ended ? 0 : readSource(source, wanted);
+        float *dest = mix + (frames - wanted) * MIXER_CHANNELS;
+        const float *samples = m_sourceBuffer.constData();
+        int done = 0;
+
+        if (source.m_rampFrames > 0)
+        {
+            done = int(qMin(qint64(read), source.m_rampFrames));
+            mixRamp(dest, samples, done, source.m_gain, source.m_gainStep);
+            source.m_rampFrames -= done;
+            if (source.m_rampFrames == 0)
+                source.m_gain = source.m_gainTarget;
+            else
+                source.m_gain += source.m_gainStep * done;
+        }
+
+        // a faded out source plays silently until its end
+        if (done < read && source.m_gain != 0)
+            mixGain(dest + done * MIXER_CHANNELS, samples + done * MIXER_CHANNELS,
+                    (read - done) * MIXER_CHANNELS, source.m_gain);
+
+        if (ended || read < wanted)
+        {
+            finished.append(source.m_decoder);
+            m_sources.remove(s);
+            s--;
+        }
+    }
+
+    mixToS16(mix, (qint16 *)data, count);
+    m_position += frames;
+
+    locker.unlock();
+
+    foreach (AudioDecoder *decoder, finished)
+        emit sourceFinished(decoder);
+
+    return qint64(count) * sizeof(qint16);
+}
+
+int AudioMixer::readSource(Source &source, int frames)
+{
+    char *buffer = (char *)m_readBuffer.data();
+    qint64 frameSize = source.m_channels * sizeof(qint16);
+    qint64 wanted = frames * frameSize;
+    qint64 got = 0;
+    bool rewound = false;
+
+    while (got < wanted)
+    {
+        qint64 read = source.m_decoder->read(buffer + got, wanted - got);
+        if (read <= 0)
+        {
+            // a looped source starts over, unless it is empty
+            if (source.m_looped && rewound == false)
+            {
+                source.m_decoder->seek(0);
+                rewound = true;
+                continue;
+            }
+            break;
+        }
+        got += read;
+        rewound = false;
+    }
+
+    int framesRead = int(got / frameSize);
+    const qint16 *in = m_readBuffer.constData();
+    float *out = m_sourceBuffer.data();
+
+    if (source.m_channels == 1)
+    {
+        for (int f = 0; f < framesRead; f++)
+            out[f * 2] = out[f * 2 + 1] = in[f];
+    }
+    else
+    {
+        for (int i = 0; i < framesRead * MIXER_CHANNELS; i++)
+            out[i] = in[i];
+    }
+
+    return framesRead;
+}
+
+/*********************************************************************
+ * Sources
+ *********************************************************************/
+
+bool AudioMixer::isMixable(const AudioParameters &ap) const
+{
+    if (ap.format() != PCM_S16LE || ap.channels() < 1 || ap.channels() > MIXER_CHANNELS)
+        return false;
+
+    // the output rate is set by the first source
+    return m_running == false || ap.sampleRate() == audioParameters().sampleRate();
+}
+
+bool AudioMixer::canMix(const AudioParameters &ap)
+{
+    QMutexLocker locker(&m_mutex);
+    return isMixable(ap);
+}
+
+int AudioMixer::sourceIndex(AudioDecoder *decoder) const
+{
+    for (int i = 0; i < m_sources.count(); i++)
+    {
+        if (m_sources.at(i).m_decoder == decoder)
+            return i;
+    }
+    return -1;
+}
+
+void AudioMixer::setRamp(Source &source, float target, qint64 frames)
+{
+    source.m_gainTarget = target;
+
+    if (frames <= 0)
+    {
+        source.m_gain = target;
+        source.m_gainStep = 0;
+        source.m_rampFrames = 0;
+    }
+    else
+    {
+        source.m_gainStep = (target - source.m_gain) / frames;
+        source.m_rampFrames = frames;
+    }
+}
+
+qint64 AudioMixer::msToFrames(quint64 ms) const
+{
+    return qint64(ms * audioParameters().sampleRate() / 1000);
+}
+
+bool AudioMixer::addSource(AudioDecoder *decoder, quint64 startTime, qreal intensity,
+                           uint fadeIn, bool looped)
+{
+    if (decoder == NULL)
+        return false;
+
+    AudioParameters ap = decoder->audioParameters();
+
+    QMutexLocker locker(&m_mutex);
+
+    if (isMixable(ap) == false)
+        return false;
+
+    int index = sourceIndex(decoder);
+    if (index != -1)
+        m_sources.remove(index);
+
+    bool restart = (m_running == false);
+    if (restart)
+    {
+        // the mix starts over, at the rate of this source
+        configure(ap.sampleRate(), MIXER_CHANNELS, PCM_S16LE);
+        m_position = 0;
+        m_lastStartTime = startTime;
+        m_lastStartFrame = 0;
+        m_running = true;
+    }
+    else if (startTime != m_lastStartTime)
+    {
+        m_lastStartTime = startTime;
+        m_lastStartFrame = m_position;
+    }
+
+    Source source;
+    source.m_decoder = decoder;
+    source.m_channels = ap.channels();
+    source.m_startFrame = m_lastStartFrame;
+    source.m_intensity = CLAMP(intensity, 0.0, 1.0);
+    source.m_gain = fadeIn == 0 ? source.m_intensity : 0;
+    setRamp(source, source.m_intensity, msToFrames(fadeIn));
+    source.m_fadingOut = false;
+    source.m_looped = looped;
+    source.m_paused = false;
+    m_sources.append(source);
+
+    locker.unlock();
+
+    if (restart)
+        restartRenderer();
+
+    return true;
+}
+
+void AudioMixer::removeSource(AudioDecoder *decoder)
+{
+    QMutexLocker locker(&m_mutex);
+
+    int index = sourceIndex(decoder);
+    if (index != -1)
+        m_sources.remove(index);
+}
+
+int AudioMixer::sourcesCount()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_sources.count();
+}
+
+void AudioMixer::setSourceIntensity(AudioDecoder *decoder, qreal intensity)
+{
+    QMutexLocker locker(&m_mutex);
+
+    int index = sourceIndex(decoder);
+    if (index == -1)
+        return;
+
+    Source &source = m_sources[index];
+    source.m_intensity = CLAMP(intensity, 0.0, 1.0);
+    if (source.m_fadingOut)
+        return;
+
+    // a fade in goes on towards the new intensity
+    if (source.m_rampFrames > 0)
+        setRamp(source, source.m_intensity, source.m_rampFrames);
+    else
+        setRamp(source, source.m_intensity, msToFrames(INTENSITY_RAMP_MS));
+}
+
+void AudioMixer::setSourceFadeOut(AudioDecoder *decoder, uint fadeTime)
+{
+    QMutexLocker locker(&m_mutex);
+
+    int index = sourceIndex(decoder);
+    if (index == -1 || m_sources.at(index).m_fadingOut)
+        return;
+
+    m_sources[index].m_fadingOut = true;
+    setRamp(m_sources[index], 0, msToFrames(fadeTime));
+}
+
+void AudioMixer::setSourcePaused(AudioDecoder *decoder, bool paused)
+{
+    QMutexLocker locker(&m_mutex);
+
+    int index = sourceIndex(decoder);
+    if (index != -1)
+        m_sources[index].m_paused = paused;
+}
+
+/*********************************************************************
+ * Renderer
+ *********************************************************************/
+
+AudioRenderer *AudioMixer::createRenderer()
+{
+    AudioRenderer *renderer;
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+ #if defined(__APPLE__) || defined(Q_OS_MAC)
+    renderer = new AudioRendererPortAudio(QString());
+ #elif defined(WIN32) || defined(Q_OS_WIN)
+    renderer = new AudioRendererWaveOut(QString());
+ #else
+    renderer = new AudioRendererAlsa(QString());
+ #endif
+    renderer->moveToThread(QCoreApplication::instance()->thread());
+#else
+    renderer = new AudioRendererQt(QString());
+#endif
+    return renderer;
+}
+
+void AudioMixer::restartRenderer()
+{
+    // the previous renderer reached the end of the mix, or is about to
+    if (m_renderer != NULL)
+    {
+        m_renderer->stop();
+        delete m_renderer;
+    }
+
+    AudioParameters ap = audioParameters();
+    qDebug() << "[AudioMixer] start rendering at" << ap.sampleRate() << "Hz";
+
+    m_renderer = createRenderer();
+    m_renderer->setDecoder(this);
+    m_renderer->initialize(ap.sampleRate(), ap.channels(), ap.format());
+    m_renderer->start();
+}
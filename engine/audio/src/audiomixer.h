@@ -0,0 +1,199 @@
+/*
+  Q Light Controller Plus
+  audiomixer.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <QVector>
+#include <QMutex>
+
+#include "audiodecoder.h"
+
+class AudioRenderer;
+
+/** @addtogroup engine_audio Audio
+ * @{
+ */
+
+/**
+ * AudioMixer sums the audio of all the running Audio functions into
+ * a single stream, played by one AudioRenderer on the global audio
+ * output device.
+ *
+ * The mixer is the decoder of its renderer: the renderer thread reads
+ * the mix from read(), which pulls a block of samples from each source
+ * decoder, applies its gain and fade ramps and adds it to the mix. The
+ * output is always 16 bit stereo, at the sample rate of the first source
+ * started while the mixer was idle. Sources with another sample rate or
+ * format can't be mixed, and play on a renderer of their own.
+ *
+ * Start times are MasterTimer times: the sources started in the same
+ * timer tick start on the same output frame, even if the renderer mixed
+ * a block in between.
+ */
+class AudioMixer : public AudioDecoder
+{
+    Q_OBJECT
+
+public:
+    AudioMixer(QObject* parent = 0);
+    ~AudioMixer();
+
+    /*********************************************************************
+     * AudioDecoder
+     *********************************************************************/
+public:
+    /** @reimpl. The mixer can't be copied */
+    AudioDecoder *createCopy() { return NULL; }
+
+    /** @reimpl */
+    int priority() const { return 0; }
+
+    /** @reimpl. The mixer doesn't decode files */
+    QStringList supportedFormats() { return QStringList(); }
+
+    /** @reimpl */
+    bool initialize(const QString &path) { Q_UNUSED(path) return false; }
+
+    /** @reimpl */
+    qint64 totalTime() { return 0; }
+
+    /** @reimpl. The mix can't be seeked */
+    void seek(qint64 time) { Q_UNUSED(time) }
+
+    /**
+     * Mix up to $maxSize bytes of the running sources to $data.
+     * Returns 0 when there are no sources left, which ends the
+     * renderer thread until a new source is added.
+     */
+    qint64 read(char *data, qint64 maxSize);
+
+    /** @reimpl */
+    int bitrate() { return 0; }
+
+    /*********************************************************************
+     * Sources
+     *********************************************************************/
+public:
+    /** Check if audio with the parameters $ap can be mixed with the running sources */
+    bool canMix(const AudioParameters &ap);
+
+    /**
+     * Start mixing the audio of $decoder from its current position.
+     *
+     * @param decoder The decoder providing the audio data
+     * @param startTime The MasterTimer time of the start, in milliseconds
+     * @param intensity The source gain (0.0 - 1.0)
+     * @param fadeIn Duration of the fade in, in milliseconds
+     * @param looped If true, the decoder restarts from the beginning at its end
+     * @return false if the audio can't be mixed
+     */
+    bool addSource(AudioDecoder *decoder, quint64 startTime, qreal intensity,
+                   uint fadeIn, bool looped);
+
+    /** Stop mixing the audio of $decoder */
+    void removeSource(AudioDecoder *decoder);
+
+    /** Get the number of sources being mixed */
+    int sourcesCount();
+
+    /** Set the gain of the source of $decoder, with a short ramp */
+    void setSourceIntensity(AudioDecoder *decoder, qreal intensity);
+
+    /** Fade out the source of $decoder in $fadeTime milliseconds. A fade out
+     *  is done once, further requests for the same source are ignored */
+    void setSourceFadeOut(AudioDecoder *decoder, uint fadeTime);
+
+    /** Pause or resume the source of $decoder. A paused source is silent
+     *  and keeps its position */
+    void setSourcePaused(AudioDecoder *decoder, bool paused);
+
+signals:
+    /** Emitted by the renderer thread when the source of $decoder reached its end */
+    void sourceFinished(AudioDecoder *decoder);
+
+protected:
+    /** Create the renderer that plays the mix on the output device */
+    virtual AudioRenderer *createRenderer();
+
+private:
+    struct Source
+    {
+        AudioDecoder *m_decoder;
+        int m_channels;
+
+        /** The output frame where the source starts */
+        qint64 m_startFrame;
+
+        /** Gain of the source. A ramp moves it by m_gainStep at
+         *  each frame for m_rampFrames frames, up to m_gainTarget */
+        float m_gain;
+        float m_gainStep;
+        float m_gainTarget;
+        qint64 m_rampFrames;
+
+        float m_intensity;
+        bool m_fadingOut;
+        bool m_looped;
+        bool m_paused;
+    };
+
+    /** Check if audio with the parameters $ap can be mixed, with m_mutex locked */
+    bool isMixable(const AudioParameters &ap) const;
+
+    /** Get the index of the source of $decoder, or -1 if not found */
+    int sourceIndex(AudioDecoder *decoder) const;
+
+    /** Start a ramp of the gain of $source to $target, lasting $frames frames */
+    static void setRamp(Source &source, float target, qint64 frames);
+
+    /** Read up to $frames frames of $source as stereo floats in m_sourceBuffer.
+     *  Returns the number of frames read, less than $frames at the end of the source */
+    int readSource(Source &source, int frames);
+
+    /** Stop the current renderer, if any, and start a new one */
+    void restartRenderer();
+
+    /** Convert $ms milliseconds into output frames */
+    qint64 msToFrames(quint64 ms) const;
+
+private:
+    QMutex m_mutex;
+    QVector<Source> m_sources;
+    AudioRenderer *m_renderer;
+
+    /** True while the renderer reads the mix */
+    bool m_running;
+
+    /** Output frames mixed since the renderer started */
+    qint64 m_position;
+
+    /** MasterTimer time and output frame of the latest start */
+    quint64 m_lastStartTime;
+    qint64 m_lastStartFrame;
+
+    /** Scratch buffers, all of interleaved stereo samples */
+    QVector<qint16> m_readBuffer;
+    QVector<float> m_sourceBuffer;
+    QVector<float> m_mixBuffer;
+};
+
+/** @} */
+
+#endif
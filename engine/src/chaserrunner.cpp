@@ -45,10 +45,14 @@ ChaserRunner::ChaserRunner(const Doc* doc, const Chaser* chaser, quint32 startTi
     , m_lastRunStepIdx(-1)
     , m_roundTime(new QElapsedTimer())
     , m_order()
+    , m_randomState((quint32(qrand()) << 1) | 1)
     , m_intensity(1.0)
 {
     Q_ASSERT(chaser != NULL);
 
+    m_stagedStep.m_index = -1;
+    m_stagedStep.m_function = NULL;
+
     if (m_chaser->type() == Function::SequenceType)
     {
         qDebug() << "[ChaserRunner] startTime:" << startTime;
@@ -91,6 +95,8 @@ void ChaserRunner::slotChaserChanged()
 {
     // Handle (possible) speed change on the next write() pass
     m_updateOverrideSpeeds = true;
+    // The staged step might not be the next one anymore
+    m_stagedStep.m_index = -1;
     QList<ChaserRunnerStep*> delList;
     foreach(ChaserRunnerStep *step, m_runnerSteps)
     {
@@ -385,10 +391,20 @@ void ChaserRunner::shuffle(QVector<int> & data)
    int n = data.size();
    for (int i = n - 1; i > 0; --i)
    {
-       qSwap(data[i], data[qrand() % (i + 1)]);
+       qSwap(data[i], data[nextRandom() % (i + 1)]);
    }
 }
 
+quint32 ChaserRunner::nextRandom()
+{
+    quint32 x = m_randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    m_randomState = x;
+    return x;
+}
+
 int ChaserRunner::randomStepIndex(int step) const
 {
    if (m_chaser->runOrder() == Function::Random && step >= 0 && step < m_order.size())
@@ -485,8 +501,13 @@ void ChaserRunner::startNewStep(int index, MasterTimer* timer, qreal intensity,
     if (index < 0 || index >= m_chaser->steps().count())
         index = 0; // fallback to the first step
 
-    ChaserStep step(m_chaser->steps().at(index));
-    Function *func = m_doc->function(step.fid);
+    // Use the step resolved ahead of time if it is this one,
+    // otherwise resolve it now
+    if (m_stagedStep.m_index != index)
+        stageStep(index);
+    m_stagedStep.m_index = -1;
+
+    Function *func = m_stagedStep.m_function;
     if (func == NULL)
         return;
 
@@ -521,10 +542,10 @@ void ChaserRunner::startNewStep(int index, MasterTimer* timer, qreal intensity,
     if (m_chaser->type() == Function::SequenceType)
     {
         Scene *s = qobject_cast<Scene*>(func);
-        // blind == true is a workaround to reuse the same scene
-        // without messing up the previous values
-        for (int i = 0; i < step.values.count(); i++)
-            s->setValue(step.values.at(i), true);
+        // the values are set blind, as a workaround to reuse
+        // the same scene without messing up the previous values
+        s->setStagedValues(m_stagedStep.m_values);
+        m_stagedStep.m_values = Scene::StagedValues();
     }
 
     // Set intensity before starting the function. Otherwise the intensity
@@ -666,6 +687,74 @@ FunctionParent ChaserRunner::functionParent() const
     return FunctionParent(FunctionParent::Function, m_chaser->id());
 }
 
+/****************************************************************************
+ * Lookahead
+ ****************************************************************************/
+
+void ChaserRunner::prepareNextStep()
+{
+    // Nothing is running yet, or a new start step is about to be set
+    if (m_runnerSteps.isEmpty() || m_newStartStepIdx != -1)
+        return;
+
+    if (m_stagedStep.m_index != -1)
+        return;
+
+    int index = predictNextStepIndex();
+    if (index != -1)
+        stageStep(index);
+}
+
+void ChaserRunner::stageStep(int index)
+{
+    m_stagedStep.m_index = index;
+    m_stagedStep.m_function = NULL;
+    m_stagedStep.m_values = Scene::StagedValues();
+
+    if (index < 0 || index >= m_chaser->steps().count())
+        return;
+
+    ChaserStep step(m_chaser->steps().at(index));
+    Function *func = m_doc->function(step.fid);
+    if (func == NULL)
+        return;
+
+    m_stagedStep.m_function = func;
+
+    Scene *scene = qobject_cast<Scene*>(func);
+    if (scene == NULL)
+        return;
+
+    if (m_chaser->type() == Function::SequenceType)
+        m_stagedStep.m_values = scene->stageValues(step.values);
+    else
+        scene->prepareValues();
+}
+
+int ChaserRunner::predictNextStepIndex()
+{
+    // getNextStepIndex() consumes the next/previous requests, reverses
+    // ping pong chasers and reshuffles random ones. Keep the state as it is:
+    // if things go differently, the step is resolved when it starts.
+    // The random state is restored too, so that the shuffle done when the
+    // step starts is the same as the predicted one
+    Function::Direction direction = m_direction;
+    QVector<int> order = m_order;
+    quint32 randomState = m_randomState;
+    bool next = m_next;
+    bool previous = m_previous;
+
+    int index = getNextStepIndex();
+
+    m_direction = direction;
+    m_order = order;
+    m_randomState = randomState;
+    m_next = next;
+    m_previous = previous;
+
+    return index;
+}
+
 bool ChaserRunner::write(MasterTimer* timer, QList<Universe *> universes)
 {
     Q_UNUSED(universes);
@@ -679,6 +768,8 @@ bool ChaserRunner::write(MasterTimer* timer, QList<Universe *> universes)
         clearRunningList();
     }
 
+    bool stepStarted = false;
+
     if (m_newStartStepIdx != -1)
     {
         m_lastRunStepIdx = m_newStartStepIdx;
@@ -686,6 +777,7 @@ bool ChaserRunner::write(MasterTimer* timer, QList<Universe *> universes)
         qDebug() << "Starting from step" << m_lastRunStepIdx << "@ offset" << m_startOffset;
         startNewStep(m_lastRunStepIdx, timer, m_intensity, false);
         emit currentStepChanged(m_lastRunStepIdx);
+        stepStarted = true;
     }
 
     quint32 prevStepRoundElapsed = 0;
@@ -738,6 +830,7 @@ bool ChaserRunner::write(MasterTimer* timer, QList<Universe *> universes)
         {
             startNewStep(m_lastRunStepIdx, timer, m_intensity, false, prevStepRoundElapsed);
             emit currentStepChanged(m_lastRunStepIdx);
+            stepStarted = true;
         }
         else
         {
@@ -745,6 +838,11 @@ bool ChaserRunner::write(MasterTimer* timer, QList<Universe *> universes)
         }
     }
 
+    // Resolve the next step now, but not on
+    // the tick that already had to start a step
+    if (stepStarted == false)
+        prepareNextStep();
+
     return true;
 }
 
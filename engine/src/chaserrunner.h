@@ -26,6 +26,7 @@
 #include <QMap>
 
 #include "function.h"
+#include "scene.h"
 
 class QElapsedTimer;
 class FadeChannel;
@@ -146,7 +147,13 @@ private:
     /**
      * Shuffle the current steps order
      */
-    static void shuffle(QVector<int> & data);
+    void shuffle(QVector<int> & data);
+
+    /**
+     * Get the next number of the runner's own random sequence.
+     * Unlike qrand(), its state can be saved and restored
+     */
+    quint32 nextRandom();
 
     /**
      * Retrieve the randomized index of a
@@ -180,6 +187,7 @@ private:
     int m_lastRunStepIdx;                   //! Index of the last step ran
     QElapsedTimer* m_roundTime;             //! Counts the time between steps
     QVector<int> m_order;                   //! Array of step indices in a randomized order
+    quint32 m_randomState;                  //! State of the random sequence used to shuffle m_order
 
     /************************************************************************
      * Intensity
@@ -224,6 +232,38 @@ private:
 private:
     FunctionParent functionParent() const;
 
+    /************************************************************************
+     * Lookahead
+     ************************************************************************/
+private:
+    /**
+     * Resolve the step that follows the running one before it starts:
+     * its Function and, for sequences, the values to set into the bound
+     * Scene. write() calls this on the tick that follows the start of a
+     * step, so that no step change has to resolve the step it starts.
+     */
+    void prepareNextStep();
+
+    /** Resolve the step at $index into m_stagedStep */
+    void stageStep(int index);
+
+    /**
+     * Get the index of the step that getNextStepIndex() will return
+     * if nothing changes meanwhile, leaving the runner state untouched
+     */
+    int predictNextStepIndex();
+
+private:
+    /** A step resolved ahead of its start */
+    struct StagedStep
+    {
+        int m_index;                        //! Index of the staged step, -1 if none
+        Function* m_function;               //! The step Function
+        Scene::StagedValues m_values;       //! The step values of a sequence
+    };
+
+    StagedStep m_stagedStep;
+
 public:
     /**
      * Call this from the parent function's write() method to run the steps.
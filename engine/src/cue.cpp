@@ -22,10 +22,12 @@
 #include <QXmlStreamWriter>
 #include <QDebug>
 
+#include "fixture.h"
 #include "cue.h"
 
 Cue::Cue(const QString& name)
     : m_name(name)
+    , m_resolved(false)
     , m_fadeInSpeed(0)
     , m_fadeOutSpeed(0)
     , m_duration(0)
@@ -35,6 +37,7 @@ Cue::Cue(const QString& name)
 Cue::Cue(const QHash <uint,uchar> values)
     : m_name(QString())
     , m_values(values)
+    , m_resolved(false)
     , m_fadeInSpeed(0)
     , m_fadeOutSpeed(0)
     , m_duration(0)
@@ -44,6 +47,8 @@ Cue::Cue(const QHash <uint,uchar> values)
 Cue::Cue(const Cue& cue)
     : m_name(cue.name())
     , m_values(cue.values())
+    , m_resolvedValues(cue.m_resolvedValues)
+    , m_resolved(cue.m_resolved)
     , m_fadeInSpeed(cue.fadeInSpeed())
     , m_fadeOutSpeed(cue.fadeOutSpeed())
     , m_duration(cue.duration())
@@ -75,12 +80,16 @@ QString Cue::name() const
 void Cue::setValue(uint channel, uchar value)
 {
     m_values[channel] = value;
+    m_resolved = false;
 }
 
 void Cue::unsetValue(uint channel)
 {
     if (m_values.contains(channel) == true)
+    {
         m_values.remove(channel);
+        m_resolved = false;
+    }
 }
 
 uchar Cue::value(uint channel) const
@@ -96,6 +105,43 @@ QHash <uint,uchar> Cue::values() const
     return m_values;
 }
 
+void Cue::resolveValues(const Doc* doc)
+{
+    m_resolvedValues.clear();
+    m_resolvedValues.reserve(m_values.size());
+
+    QHashIterator <uint,uchar> it(m_values);
+    while (it.hasNext() == true)
+    {
+        it.next();
+
+        // Cue channels are absolute DMX addresses: the FadeChannel
+        // constructor finds the fixture they belong to and caches the group.
+        // Addresses with no fixture cache the Intensity fallback, so that
+        // switching cues does no fixture lookup at all
+        FadeChannel fc(doc, Fixture::invalidId(), it.key());
+        fc.setTarget(it.value());
+        m_resolvedValues.append(fc);
+    }
+
+    m_resolved = true;
+}
+
+bool Cue::isResolved() const
+{
+    return m_resolved;
+}
+
+void Cue::invalidateValues()
+{
+    m_resolved = false;
+}
+
+QVector <FadeChannel> Cue::resolvedValues() const
+{
+    return m_resolvedValues;
+}
+
 /****************************************************************************
  * Speed
  ****************************************************************************/
@@ -21,13 +21,16 @@
 #ifndef CUE_H
 #define CUE_H
 
+#include <QVector>
 #include <QString>
 #include <QHash>
 
+#include "fadechannel.h"
 #include "scenevalue.h"
 
 class QXmlStreamReader;
 class QXmlStreamWriter;
+class Doc;
 
 /** @addtogroup engine Engine
  * @{
@@ -71,8 +74,28 @@ public:
 
     QHash <uint,uchar> values() const;
 
+    /**
+     * Resolve the cue values against the fixtures of $doc: each value
+     * becomes a FadeChannel with its universe, address and channel group
+     * looked up once, so that the cue can be faded with no further
+     * lookups. Setting or unsetting a value afterwards discards them.
+     */
+    void resolveValues(const Doc* doc);
+
+    /** Check if the resolved values are up to date with the cue values */
+    bool isResolved() const;
+
+    /** Mark the resolved values as outdated, e.g. when fixtures change,
+     *  so that they are resolved again when the cue is next used */
+    void invalidateValues();
+
+    /** Get the values resolved by resolveValues(), with their target set */
+    QVector <FadeChannel> resolvedValues() const;
+
 private:
     QHash <uint,uchar> m_values;
+    QVector <FadeChannel> m_resolvedValues;
+    bool m_resolved;
 
     /************************************************************************
      * Speed
@@ -53,6 +53,16 @@ CueStack::CueStack(Doc* doc)
 {
     //qDebug() << Q_FUNC_INFO << (void*) this;
     Q_ASSERT(doc != NULL);
+
+    // Cue values are resolved against the fixtures, so any change in
+    // the fixtures setup requires to resolve them again. That happens
+    // when a cue is next used, since a project load changes every fixture
+    connect(doc, SIGNAL(fixtureAdded(quint32)),
+            this, SLOT(slotFixturesChanged()));
+    connect(doc, SIGNAL(fixtureRemoved(quint32)),
+            this, SLOT(slotFixturesChanged()));
+    connect(doc, SIGNAL(fixtureChanged(quint32)),
+            this, SLOT(slotFixturesChanged()));
 }
 
 CueStack::~CueStack()
@@ -157,6 +167,7 @@ void CueStack::appendCue(const Cue& cue)
         QMutexLocker locker(&m_mutex);
         m_cues.append(cue);
         index = m_cues.size() - 1;
+        m_cues[index].resolveValues(doc());
     }
 
     emit added(index);
@@ -174,6 +185,7 @@ void CueStack::insertCue(int index, const Cue& cue)
         if (index >= 0 && index < m_cues.size())
         {
             m_cues.insert(index, cue);
+            m_cues[index].resolveValues(doc());
             cueAdded = true;
             emit added(index);
 
@@ -200,6 +212,7 @@ void CueStack::replaceCue(int index, const Cue& cue)
         if (index >= 0 && index < m_cues.size())
         {
            m_cues[index] = cue;
+           m_cues[index].resolveValues(doc());
            cueChanged = true;
         }
     }
@@ -268,6 +281,13 @@ QList <Cue> CueStack::cues() const
     return m_cues;
 }
 
+void CueStack::slotFixturesChanged()
+{
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < m_cues.size(); i++)
+        m_cues[i].invalidateValues();
+}
+
 void CueStack::setCurrentIndex(int index)
 {
     qDebug() << Q_FUNC_INFO;
@@ -439,16 +459,13 @@ void CueStack::writeDMX(MasterTimer* timer, QList<Universe*> ua)
     Q_UNUSED(timer);
     if (isFlashing() == true && m_cues.size() > 0)
     {
-        QHashIterator <uint,uchar> it(m_cues.first().values());
-        while (it.hasNext() == true)
+        QVector <FadeChannel> values(resolvedCue(0).resolvedValues());
+        for (int i = 0; i < values.size(); i++)
         {
-            it.next();
-            FadeChannel fc;
-            fc.setChannel(doc(), it.key());
-            fc.setTarget(it.value());
-            int uni = qFloor(fc.channel() / 512);
-            if (uni < ua.size())
-                ua[uni]->write(fc.channel() - (uni * 512), fc.target());
+            const FadeChannel& fc(values.at(i));
+            quint32 uni = fc.universe();
+            if (uni < quint32(ua.size()))
+                ua[uni]->write(fc.addressInUniverse(), fc.target());
         }
     }
 }
@@ -525,11 +542,10 @@ void CueStack::postRun(MasterTimer* timer)
     Q_ASSERT(m_fader != NULL);
 
     // Bounce all intensity channels to MasterTimer's fader for zeroing
-    QHashIterator <FadeChannel,FadeChannel> it(m_fader->channels());
-    while (it.hasNext() == true)
+    const FadeChannelTable& channels(m_fader->channels());
+    for (int i = 0; i < channels.count(); i++)
     {
-        it.next();
-        FadeChannel fc = it.value();
+        FadeChannel fc = channels.at(i);
 
         if (fc.group(doc()) == QLCChannel::Intensity)
         {
@@ -586,25 +602,15 @@ void CueStack::switchCue(int from, int to, const QList<Universe *> ua)
 {
     qDebug() << Q_FUNC_INFO;
 
-    Cue newCue;
-    Cue oldCue;
-
-    {
-        QMutexLocker locker(&m_mutex);
-
-        if (to >= 0 && to < m_cues.size())
-            newCue = m_cues[to];
-        if (from >= 0 && from < m_cues.size())
-            oldCue = m_cues[from];
-    }
+    Cue newCue(resolvedCue(to));
+    Cue oldCue(resolvedCue(from));
+    QVector <FadeChannel> newValues(newCue.resolvedValues());
+    QVector <FadeChannel> oldValues(oldCue.resolvedValues());
 
     // Fade out the HTP channels of the previous cue
-    QHashIterator <uint,uchar> oldit(oldCue.values());
-    while (oldit.hasNext() == true)
+    for (int i = 0; i < oldValues.size(); i++)
     {
-        oldit.next();
-
-        FadeChannel fc(doc(), Fixture::invalidId(), oldit.key());
+        FadeChannel fc(oldValues.at(i));
 
         if (fc.group(doc()) == QLCChannel::Intensity)
         {
@@ -618,12 +624,9 @@ void CueStack::switchCue(int from, int to, const QList<Universe *> ua)
     }
 
     // Fade in all channels of the new cue
-    QHashIterator <uint,uchar> newit(newCue.values());
-    while (newit.hasNext() == true)
+    for (int i = 0; i < newValues.size(); i++)
     {
-        newit.next();
-        FadeChannel fc(doc(), Fixture::invalidId(), newit.key());
-        fc.setTarget(newit.value());
+        FadeChannel fc(newValues.at(i));
         fc.setElapsed(0);
         fc.setReady(false);
         fc.setFadeTime(newCue.fadeInSpeed());
@@ -632,16 +635,30 @@ void CueStack::switchCue(int from, int to, const QList<Universe *> ua)
     }
 }
 
+Cue CueStack::resolvedCue(int index)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (index < 0 || index >= m_cues.size())
+        return Cue();
+
+    // Cues are resolved when they are stored. They are resolved here
+    // after a fixtures change or when their values changed in place
+    if (m_cues[index].isResolved() == false)
+        m_cues[index].resolveValues(doc());
+
+    return m_cues[index];
+}
+
 void CueStack::insertStartValue(FadeChannel& fc, const QList<Universe *> ua)
 {
-    qDebug() << Q_FUNC_INFO;
-    const QHash <FadeChannel,FadeChannel>& channels(m_fader->channels());
-    if (channels.contains(fc) == true)
+    const FadeChannelTable& channels(m_fader->channels());
+    int existing = channels.indexOf(fc);
+    if (existing != -1)
     {
         // GenericFader contains the channel so grab its current
         // value as the new starting value to get a smoother fade
-        FadeChannel existing = channels[fc];
-        fc.setStart(existing.current());
+        fc.setStart(channels.current(existing));
         fc.setCurrent(fc.start());
     }
     else
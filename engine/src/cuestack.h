@@ -180,6 +180,14 @@ public:
     /** Get a list of all cues */
     QList <Cue> cues() const;
 
+private:
+    /** Get a copy of the cue at $index, with its values resolved */
+    Cue resolvedCue(int index);
+
+private slots:
+    /** Resolve the values of all cues again after a fixture change */
+    void slotFixturesChanged();
+
 signals:
     void added(int index);
     void removed(int index);
@@ -33,6 +33,7 @@
 
 #include "monitorproperties.h"
 #include "audioplugincache.h"
+#include "audiomixer.h"
 #include "rgbscriptscache.h"
 #include "channelsgroup.h"
 #include "collection.h"
@@ -70,6 +71,7 @@ Doc::Doc(QObject* parent, int universes)
     , m_audioPluginCache(new AudioPluginCache(this))
     , m_masterTimer(new MasterTimer(this))
     , m_ioMap(new InputOutputMap(this, universes))
+    , m_audioMixer(NULL)
     , m_monitorProps(NULL)
     , m_mode(Design)
     , m_kiosk(false)
@@ -94,6 +96,10 @@ Doc::~Doc()
 
     clearContents();
 
+    // after the functions, which might still be mixed
+    delete m_audioMixer;
+    m_audioMixer = NULL;
+
     if (isKiosk() == false)
     {
         // TODO: is this still needed ??
@@ -272,6 +278,14 @@ QSharedPointer<AudioCapture> Doc::audioInputCapture()
     return m_inputCapture;
 }
 
+AudioMixer *Doc::audioMixer()
+{
+    if (m_audioMixer == NULL)
+        m_audioMixer = new AudioMixer();
+
+    return m_audioMixer;
+}
+
 void Doc::destroyAudioCapture()
 {
     if (m_inputCapture.isNull() == false)
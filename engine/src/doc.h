@@ -38,6 +38,7 @@
 #include "fixture.h"
 
 class AudioCapture;
+class AudioMixer;
 class RGBScriptsCache;
 class AudioPluginCache;
 class MonitorProperties;
@@ -145,6 +146,9 @@ public:
     /** Destroy a previously created audio capture instance */
     void destroyAudioCapture();
 
+    /** Get the mixer that plays the Audio functions on the global audio device */
+    AudioMixer* audioMixer();
+
 private:
     QLCFixtureDefCache *m_fixtureDefCache;
     QLCModifiersCache *m_modifiersCache;
@@ -154,6 +158,7 @@ private:
     MasterTimer *m_masterTimer;
     InputOutputMap *m_ioMap;
     QSharedPointer<AudioCapture> m_inputCapture;
+    AudioMixer *m_audioMixer;
     MonitorProperties *m_monitorProps;
 
     /*********************************************************************
@@ -59,6 +59,8 @@ EFX::EFX(Doc* doc) : Function(doc, Function::EFXType)
 
     m_algorithm = EFX::Circle;
 
+    m_pathDirty.storeRelease(1);
+
     setName(tr("New EFX"));
 
     m_fader = NULL;
@@ -143,6 +145,8 @@ bool EFX::copyFrom(const Function* function)
 
     m_algorithm = efx->m_algorithm;
 
+    m_pathDirty.storeRelease(1);
+
     return Function::copyFrom(function);
 }
 
@@ -172,6 +176,8 @@ void EFX::setAlgorithm(EFX::Algorithm algo)
     else
         m_algorithm = EFX::Circle;
 
+    m_pathDirty.storeRelease(1);
+
     emit changed(this->id());
 }
 
@@ -273,6 +279,11 @@ void EFX::preview(QPolygonF &polygon, Function::Direction direction, int startOf
 }
 
 void EFX::calculatePoint(Function::Direction direction, int startOffset, float iterator, float* x, float* y) const
+{
+    calculatePoint(calculateIterator(direction, startOffset, iterator), x, y);
+}
+
+float EFX::calculateIterator(Function::Direction direction, int startOffset, float iterator) const
 {
     iterator = calculateDirection(direction, iterator);
     iterator += convertOffset(startOffset + getAttributeValue(StartOffset));
@@ -280,7 +291,7 @@ void EFX::calculatePoint(Function::Direction direction, int startOffset, float i
     if (iterator >= M_PI * 2.0)
         iterator -= M_PI * 2.0;
 
-    calculatePoint(iterator, x, y);
+    return iterator;
 }
 
 void EFX::rotateAndScale(float* x, float* y) const
@@ -316,8 +327,14 @@ float EFX::calculateDirection(Function::Direction direction, float iterator) con
     }
 }
 
-// this function should map from 0..M_PI * 2 -> -1..1
 void EFX::calculatePoint(float iterator, float* x, float* y) const
+{
+    calculateShape(iterator, x, y);
+    rotateAndScale(x, y);
+}
+
+// this function should map from 0..M_PI * 2 -> -1..1
+void EFX::calculateShape(float iterator, float* x, float* y) const
 {
     switch (algorithm())
     {
@@ -409,8 +426,67 @@ void EFX::calculatePoint(float iterator, float* x, float* y) const
         }
         break;
     }
+}
 
-    rotateAndScale(x, y);
+/*****************************************************************************
+ * Path table
+ *****************************************************************************/
+
+void EFX::updatePathTable()
+{
+    // Clear the flag first: a change made while sampling flags it again
+    m_pathDirty.storeRelease(0);
+
+    m_pathX.resize(EFX_PATH_RESOLUTION + 1);
+    m_pathY.resize(EFX_PATH_RESOLUTION + 1);
+
+    float *pathX = m_pathX.data();
+    float *pathY = m_pathY.data();
+    for (int i = 0; i <= EFX_PATH_RESOLUTION; i++)
+        calculateShape(float((M_PI * 2.0 * i) / EFX_PATH_RESOLUTION), &pathX[i], &pathY[i]);
+}
+
+void EFX::calculatePathPoints(int count, const float* iterators, float* x, float* y) const
+{
+    // No table yet, or a stale one: compute the points the slow way
+    if (m_pathDirty.loadAcquire() == 1 || m_pathX.isEmpty())
+    {
+        for (int i = 0; i < count; i++)
+            calculatePoint(iterators[i], &x[i], &y[i]);
+        return;
+    }
+
+    const float *pathX = m_pathX.constData();
+    const float *pathY = m_pathY.constData();
+    const float scale = float(EFX_PATH_RESOLUTION / (M_PI * 2.0));
+    const bool choppy = (algorithm() == SquareChoppy);
+
+    float w = getAttributeValue(Width);
+    float h = getAttributeValue(Height);
+    float xOff = getAttributeValue(XOffset);
+    float yOff = getAttributeValue(YOffset);
+    float cosR = m_cosR;
+    float sinR = m_sinR;
+
+    for (int i = 0; i < count; i++)
+    {
+        float pos = iterators[i] * scale;
+        int index = qBound(0, int(pos), EFX_PATH_RESOLUTION - 1);
+        float frac = pos - index;
+
+        float xx = pathX[index] + (pathX[index + 1] - pathX[index]) * frac;
+        float yy = pathY[index] + (pathY[index + 1] - pathY[index]) * frac;
+
+        // keep the jumps of the choppy square sharp
+        if (choppy)
+        {
+            xx = round(xx);
+            yy = round(yy);
+        }
+
+        x[i] = xOff + xx * cosR * w + yy * sinR * h;
+        y[i] = yOff - xx * sinR * w + yy * cosR * h;
+    }
 }
 
 /*****************************************************************************
@@ -534,6 +610,7 @@ int EFX::yOffset() const
 void EFX::setXFrequency(int freq)
 {
     m_xFrequency = static_cast<float> (CLAMP(freq, 0, 32));
+    m_pathDirty.storeRelease(1);
     emit changed(this->id());
 }
 
@@ -545,6 +622,7 @@ int EFX::xFrequency() const
 void EFX::setYFrequency(int freq)
 {
     m_yFrequency = static_cast<float> (CLAMP(freq, 0, 32));
+    m_pathDirty.storeRelease(1);
     emit changed(this->id());
 }
 
@@ -568,6 +646,7 @@ bool EFX::isFrequencyEnabled()
 void EFX::setXPhase(int phase)
 {
     m_xPhase = static_cast<float> (CLAMP(phase, 0, 359)) * M_PI / 180.0;
+    m_pathDirty.storeRelease(1);
     emit changed(this->id());
 }
 
@@ -579,6 +658,7 @@ int EFX::xPhase() const
 void EFX::setYPhase(int phase)
 {
     m_yPhase = static_cast<float> (CLAMP(phase, 0, 359)) * M_PI / 180.0;
+    m_pathDirty.storeRelease(1);
     emit changed(this->id());
 }
 
@@ -1015,6 +1095,8 @@ void EFX::preRun(MasterTimer* timer)
     m_fader->adjustIntensity(getAttributeValue(Intensity));
     m_fader->setBlendMode(blendMode());
 
+    updatePathTable();
+
     Function::preRun(timer);
 }
 
@@ -1027,16 +1109,35 @@ void EFX::write(MasterTimer* timer, QList<Universe*> universes)
     if (isPaused())
         return;
 
+    if (m_pathDirty.loadAcquire() == 1)
+        updatePathTable();
+
+    int count = 0;
+    m_stepFixtures.resize(m_fixtures.count());
+    m_stepIterators.resize(m_fixtures.count());
+    m_stepX.resize(m_fixtures.count());
+    m_stepY.resize(m_fixtures.count());
+
+    // First advance all the fixtures, collecting the path position
+    // of the ones that need a new point
     QListIterator <EFXFixture*> it(m_fixtures);
     while (it.hasNext() == true)
     {
         EFXFixture* ef = it.next();
         if (ef->isReady() == false)
-            ef->nextStep(timer, universes);
+        {
+            if (ef->prepareStep(timer, universes, &m_stepIterators[count]) == true)
+                m_stepFixtures[count++] = ef;
+        }
         else
             ready++;
     }
 
+    // then compute all the points in one pass and write them
+    calculatePathPoints(count, m_stepIterators.constData(), m_stepX.data(), m_stepY.data());
+    for (int i = 0; i < count; i++)
+        m_stepFixtures[i]->setPoint(universes, m_stepX[i], m_stepY[i]);
+
     incrementElapsed();
 
     /* Check for stop condition */
@@ -21,6 +21,7 @@
 #ifndef EFX_H
 #define EFX_H
 
+#include <QAtomicInt>
 #include <QVector>
 #include <QPoint>
 #include <QList>
@@ -67,6 +68,9 @@ class Fixture;
 #define KXMLQLCEFXLeafAlgorithmName "Leaf"
 #define KXMLQLCEFXLissajousAlgorithmName "Lissajous"
 
+/** Number of samples of the EFX path table over a whole cycle */
+#define EFX_PATH_RESOLUTION 4096
+
 /**
  * An EFX (effects) function that is used to create
  * more complex automation especially for moving lights
@@ -181,6 +185,17 @@ public:
      */
     void calculatePoint(Function::Direction direction, int startOffset, float iterator, float* x, float* y) const;
 
+    /**
+     * Fold the direction and start offset of a fixture into its
+     * position on the path.
+     *
+     * @param direction Forward or Backward
+     * @param startOffset The fixture start offset, in degrees
+     * @param iterator Step number (0..M_PI*2)
+     * @return The position on the path (0..M_PI*2)
+     */
+    float calculateIterator(Function::Direction direction, int startOffset, float iterator) const;
+
 private:
 
     void preview(QPolygonF &polygon, Function::Direction direction, int startOffset) const;
@@ -209,6 +224,16 @@ private:
      */
     void calculatePoint(float iterator, float* x, float* y) const;
 
+    /**
+     * Calculate a single point of the current algorithm path, before
+     * it gets rotated and scaled (-1..1 on both axes).
+     *
+     * @param iterator Step number (input)
+     * @param x Used to store the calculated X coordinate (output)
+     * @param y Used to store the calculated Y coordinate (output)
+     */
+    void calculateShape(float iterator, float* x, float* y) const;
+
     /**
      * Recalculate iterator depending on direction
      *
@@ -221,6 +246,39 @@ private:
     /** Current algorithm used by the EFX */
     Algorithm m_algorithm;
 
+    /*********************************************************************
+     * Path table
+     *********************************************************************/
+public:
+    /**
+     * Calculate the points of $count fixtures in one pass, sampling the
+     * path table with linear interpolation and applying the current
+     * rotation, size and offset. Before the table is built, points are
+     * calculated with calculatePoint().
+     *
+     * @param count The number of points to calculate
+     * @param iterators The positions on the path, as returned by calculateIterator()
+     * @param x Used to store the calculated X coordinates (output)
+     * @param y Used to store the calculated Y coordinates (output)
+     */
+    void calculatePathPoints(int count, const float* iterators, float* x, float* y) const;
+
+private:
+    /** Sample the shape of the current algorithm into m_pathX and m_pathY */
+    void updatePathTable();
+
+private:
+    /** The shape of the path at EFX_PATH_RESOLUTION + 1 points over 0..M_PI*2.
+     *  It depends on algorithm, frequency and phase only, so that width,
+     *  height, rotation and offsets can change without rebuilding it */
+    QVector<float> m_pathX;
+    QVector<float> m_pathY;
+
+    /** Set to 1 when algorithm, frequency or phase change. The table is
+     *  rebuilt by the running EFX at the next write(). The setters run on
+     *  the UI thread and write() on the MasterTimer thread */
+    QAtomicInt m_pathDirty;
+
     /*********************************************************************
      * Width
      *********************************************************************/
@@ -562,6 +620,14 @@ public:
     /** @reimp */
     void postRun(MasterTimer* timer, QList<Universe*> universes);
 
+private:
+    /** Fixtures that need a new point at the current tick, with their
+     *  path positions and the calculated points */
+    QVector<EFXFixture*> m_stepFixtures;
+    QVector<float> m_stepIterators;
+    QVector<float> m_stepX;
+    QVector<float> m_stepY;
+
     /*********************************************************************
      * Intensity
      *********************************************************************/
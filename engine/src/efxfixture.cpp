@@ -374,17 +374,31 @@ uint EFXFixture::timeOffset() const
  * Running
  *****************************************************************************/
 void EFXFixture::nextStep(MasterTimer* timer, QList<Universe *> universes)
+{
+    float iterator = 0;
+
+    if (prepareStep(timer, universes, &iterator) == true)
+    {
+        float valX = 0;
+        float valY = 0;
+
+        m_parent->calculatePathPoints(1, &iterator, &valX, &valY);
+        setPoint(universes, valX, valY);
+    }
+}
+
+bool EFXFixture::prepareStep(MasterTimer* timer, QList<Universe *> universes, float* iterator)
 {
     m_elapsed += MasterTimer::tick();
 
     // Bail out without doing anything if this fixture is ready (after single-shot)
     // or it has no pan&tilt channels (not valid).
     if (m_ready == true || isValid() == false)
-        return;
+        return false;
 
     // Bail out without doing anything if this fixture is waiting for its turn.
     if (m_parent->propagationMode() == EFX::Serial && m_elapsed < timeOffset() && !m_started)
-        return;
+        return false;
 
     // Fade in
     if (m_started == false)
@@ -392,7 +406,7 @@ void EFXFixture::nextStep(MasterTimer* timer, QList<Universe *> universes)
 
     // Nothing to do
     if (m_parent->duration() == 0)
-        return;
+        return false;
 
     // Scale from elapsed time in relation to overall duration to a point in a circle
     uint pos = (m_elapsed + timeOffset()) % m_parent->duration();
@@ -400,31 +414,12 @@ void EFXFixture::nextStep(MasterTimer* timer, QList<Universe *> universes)
                            float(0), float(m_parent->duration()),
                            float(0), float(M_PI * 2));
 
-    float valX = 0;
-    float valY = 0;
-
     if ((m_parent->propagationMode() == EFX::Serial &&
         m_elapsed < (m_parent->duration() + timeOffset()))
         || m_elapsed < m_parent->duration())
     {
-        m_parent->calculatePoint(m_runTimeDirection, m_startOffset, m_currentAngle, &valX, &valY);
-
-        /* Write this fixture's data to universes. */
-        switch(m_mode)
-        {
-        case PanTilt:
-            setPointPanTilt(universes, valX, valY);
-            break;
-
-        case RGB:
-            setPointRGB(universes, valX, valY);
-            break;
-
-        case Dimmer:
-            //Use Y for coherence with RGB gradient.
-            setPointDimmer(universes, valY);
-            break;
-        }
+        *iterator = m_parent->calculateIterator(m_runTimeDirection, m_startOffset, m_currentAngle);
+        return true;
     }
     else
     {
@@ -445,6 +440,28 @@ void EFXFixture::nextStep(MasterTimer* timer, QList<Universe *> universes)
 
         m_elapsed %= m_parent->duration();
     }
+
+    return false;
+}
+
+void EFXFixture::setPoint(QList<Universe *> universes, float x, float y)
+{
+    /* Write this fixture's data to universes. */
+    switch(m_mode)
+    {
+    case PanTilt:
+        setPointPanTilt(universes, x, y);
+        break;
+
+    case RGB:
+        setPointRGB(universes, x, y);
+        break;
+
+    case Dimmer:
+        //Use Y for coherence with RGB gradient.
+        setPointDimmer(universes, y);
+        break;
+    }
 }
 
 void EFXFixture::setPointPanTilt(QList<Universe *> universes, float pan, float tilt)
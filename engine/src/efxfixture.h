@@ -187,6 +187,16 @@ private:
     /** Calculate the next step data for this fixture */
     void nextStep(MasterTimer* timer, QList<Universe *> universes);
 
+    /**
+     * Move this fixture one tick forward. When a new point must be
+     * written, return true and store in $iterator the fixture position
+     * on the EFX path, to be calculated by EFX::calculatePathPoints().
+     */
+    bool prepareStep(MasterTimer* timer, QList<Universe *> universes, float* iterator);
+
+    /** Write the point $x, $y of the EFX path according to this fixture's mode */
+    void setPoint(QList<Universe *> universes, float x, float y);
+
     /** Write this EFXFixture's channel data to universes */
     void setPointPanTilt(QList<Universe *> universes, float pan, float tilt);
     void setPointDimmer(QList<Universe *> universes, float dimmer);
@@ -0,0 +1,307 @@
+/*
+  Q Light Controller Plus
+  engineprofiler.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtAlgorithms>
+#include <algorithm>
+#include <QMutexLocker>
+#include <QDebug>
+#include <QFile>
+
+#include "engineprofiler.h"
+#include "function.h"
+#include "doc.h"
+
+EngineProfiler::EngineProfiler(Doc *doc)
+    : m_doc(doc)
+    , m_enabled(0)
+{
+    reset();
+}
+
+EngineProfiler::~EngineProfiler()
+{
+}
+
+QString EngineProfiler::stageToString(EngineProfiler::Stage stage)
+{
+    switch (stage)
+    {
+        case TickStage: return "Tick";
+        case PrepareStage: return "Prepare";
+        case FunctionsStage: return "Functions";
+        case DMXSourcesStage: return "DMXSources";
+        case FaderStage: return "Fader";
+        case DumpStage: return "Dump";
+        default: return "Unknown";
+    }
+}
+
+void EngineProfiler::setEnabled(bool enable)
+{
+    m_enabled.storeRelease(enable ? 1 : 0);
+}
+
+bool EngineProfiler::isEnabled() const
+{
+    return m_enabled.loadAcquire() == 1;
+}
+
+void EngineProfiler::reset()
+{
+    for (int s = 0; s < StageCount; s++)
+    {
+        StageData &data = m_stages[s];
+        data.m_count.storeRelease(0);
+        data.m_total.storeRelease(0);
+        data.m_max.storeRelease(0);
+        for (int i = 0; i < s_bucketsCount; i++)
+            data.m_buckets[i].storeRelease(0);
+    }
+
+    QMutexLocker locker(&m_functionsMutex);
+    m_functionCosts.clear();
+}
+
+/****************************************************************************
+ * Recording
+ ****************************************************************************/
+
+void EngineProfiler::addStageSample(EngineProfiler::Stage stage, quint64 ns)
+{
+    StageData &data = m_stages[stage];
+
+    data.m_buckets[bucketIndex(ns)].fetchAndAddRelaxed(1);
+    data.m_total.fetchAndAddRelaxed(ns);
+    if (ns > data.m_max.loadAcquire())
+        data.m_max.storeRelease(ns);
+    data.m_count.fetchAndAddRelease(1);
+}
+
+void EngineProfiler::addFunctionSample(quint32 id, quint64 ns)
+{
+    FunctionCost sample;
+    sample.m_id = id;
+    sample.m_calls = 1;
+    sample.m_totalNs = ns;
+    sample.m_maxNs = ns;
+    m_pendingSamples.append(sample);
+}
+
+void EngineProfiler::commitTick()
+{
+    if (m_pendingSamples.isEmpty())
+        return;
+
+    {
+        QMutexLocker locker(&m_functionsMutex);
+        foreach (const FunctionCost &sample, m_pendingSamples)
+        {
+            QHash<quint32, FunctionCost>::iterator it = m_functionCosts.find(sample.m_id);
+            if (it == m_functionCosts.end())
+            {
+                m_functionCosts.insert(sample.m_id, sample);
+                continue;
+            }
+
+            it->m_calls++;
+            it->m_totalNs += sample.m_totalNs;
+            if (sample.m_maxNs > it->m_maxNs)
+                it->m_maxNs = sample.m_maxNs;
+        }
+    }
+
+    // keep the allocated memory for the next tick
+    m_pendingSamples.resize(0);
+}
+
+/****************************************************************************
+ * Stage statistics
+ ****************************************************************************/
+
+quint64 EngineProfiler::count(EngineProfiler::Stage stage) const
+{
+    return m_stages[stage].m_count.loadAcquire();
+}
+
+quint64 EngineProfiler::totalNs(EngineProfiler::Stage stage) const
+{
+    return m_stages[stage].m_total.loadAcquire();
+}
+
+quint64 EngineProfiler::maxNs(EngineProfiler::Stage stage) const
+{
+    return m_stages[stage].m_max.loadAcquire();
+}
+
+quint64 EngineProfiler::meanNs(EngineProfiler::Stage stage) const
+{
+    quint64 samples = count(stage);
+    if (samples == 0)
+        return 0;
+
+    return totalNs(stage) / samples;
+}
+
+quint64 EngineProfiler::percentileNs(EngineProfiler::Stage stage, qreal percentile) const
+{
+    const StageData &data = m_stages[stage];
+    quint64 total = 0;
+    quint64 counts[s_bucketsCount];
+
+    for (int i = 0; i < s_bucketsCount; i++)
+    {
+        counts[i] = data.m_buckets[i].loadAcquire();
+        total += counts[i];
+    }
+
+    if (total == 0)
+        return 0;
+
+    quint64 rank = quint64(qBound(0.0, percentile, 100.0) * qreal(total) / 100.0 + 0.5);
+    if (rank == 0)
+        rank = 1;
+
+    quint64 seen = 0;
+    for (int i = 0; i < s_bucketsCount; i++)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+            return qMin(bucketUpperBound(i), maxNs(stage));
+    }
+
+    return maxNs(stage);
+}
+
+int EngineProfiler::bucketIndex(quint64 ns)
+{
+    if (ns < 4)
+        return int(ns);
+
+    int exponent = 63 - qCountLeadingZeroBits(ns);
+    int sub = int(ns >> (exponent - 2)) & 3;
+
+    return exponent * 4 + sub;
+}
+
+quint64 EngineProfiler::bucketUpperBound(int index)
+{
+    if (index < 4)
+        return quint64(index);
+
+    // buckets 4 to 7 are never used
+    if (index < 8)
+        return 3;
+
+    int exponent = index / 4;
+    quint64 sub = quint64(index % 4);
+
+    if (exponent == 63 && sub == 3)
+        return Q_UINT64_C(0xFFFFFFFFFFFFFFFF);
+
+    return ((5 + sub) << (exponent - 2)) - 1;
+}
+
+/****************************************************************************
+ * Function statistics
+ ****************************************************************************/
+
+static bool costGreaterThan(const EngineProfiler::FunctionCost &a,
+                            const EngineProfiler::FunctionCost &b)
+{
+    return a.m_totalNs > b.m_totalNs;
+}
+
+QList<EngineProfiler::FunctionCost> EngineProfiler::functionCosts() const
+{
+    QList<FunctionCost> costs;
+    {
+        QMutexLocker locker(&m_functionsMutex);
+        costs = m_functionCosts.values();
+    }
+
+    std::sort(costs.begin(), costs.end(), costGreaterThan);
+
+    return costs;
+}
+
+/****************************************************************************
+ * Export
+ ****************************************************************************/
+
+QByteArray EngineProfiler::toJson() const
+{
+    QJsonObject root;
+    root.insert("enabled", isEnabled());
+
+    QJsonArray stages;
+    for (int s = 0; s < StageCount; s++)
+    {
+        Stage stage = Stage(s);
+        QJsonObject obj;
+        obj.insert("name", stageToString(stage));
+        obj.insert("count", double(count(stage)));
+        obj.insert("totalNs", double(totalNs(stage)));
+        obj.insert("meanNs", double(meanNs(stage)));
+        obj.insert("maxNs", double(maxNs(stage)));
+        obj.insert("p50Ns", double(percentileNs(stage, 50)));
+        obj.insert("p90Ns", double(percentileNs(stage, 90)));
+        obj.insert("p99Ns", double(percentileNs(stage, 99)));
+        stages.append(obj);
+    }
+    root.insert("stages", stages);
+
+    QJsonArray functions;
+    foreach (const FunctionCost &cost, functionCosts())
+    {
+        QJsonObject obj;
+        obj.insert("id", double(cost.m_id));
+        if (m_doc != NULL)
+        {
+            Function *function = m_doc->function(cost.m_id);
+            if (function != NULL)
+                obj.insert("name", function->name());
+        }
+        obj.insert("calls", double(cost.m_calls));
+        obj.insert("totalNs", double(cost.m_totalNs));
+        obj.insert("meanNs", double(cost.m_calls ? cost.m_totalNs / cost.m_calls : 0));
+        obj.insert("maxNs", double(cost.m_maxNs));
+        functions.append(obj);
+    }
+    root.insert("functions", functions);
+
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool EngineProfiler::saveToFile(const QString &path) const
+{
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate) == false)
+    {
+        qWarning() << Q_FUNC_INFO << "Unable to write profile to" << path;
+        return false;
+    }
+
+    file.write(toJson());
+    file.close();
+
+    return true;
+}
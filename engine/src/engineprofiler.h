@@ -0,0 +1,169 @@
+/*
+  Q Light Controller Plus
+  engineprofiler.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef ENGINEPROFILER_H
+#define ENGINEPROFILER_H
+
+#include <QAtomicInteger>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QVector>
+#include <QMutex>
+#include <QHash>
+#include <QList>
+
+class Doc;
+
+/** @addtogroup engine Engine
+ * @{
+ */
+
+/**
+ * EngineProfiler measures where the time of each MasterTimer tick goes.
+ *
+ * The duration of each tick stage is recorded in a log-linear histogram
+ * (4 sub-buckets per power of two, in nanoseconds), so percentiles can be
+ * estimated with a 25% precision at most. Stage histograms are written by the
+ * timer thread and read by any thread without locking.
+ *
+ * The cost of each Function::write() call is collected during the tick
+ * and published once per tick, in commitTick().
+ */
+class EngineProfiler
+{
+public:
+    EngineProfiler(Doc* doc);
+    ~EngineProfiler();
+
+    enum Stage
+    {
+        TickStage = 0,
+        PrepareStage,
+        FunctionsStage,
+        DMXSourcesStage,
+        FaderStage,
+        DumpStage,
+        StageCount
+    };
+
+    static QString stageToString(Stage stage);
+
+    /** Enable or disable profiling. When disabled, nothing is recorded */
+    void setEnabled(bool enable);
+    bool isEnabled() const;
+
+    /** Clear all the collected data */
+    void reset();
+
+private:
+    Doc* m_doc;
+
+    /** Set by any thread, read by the timer thread at every tick */
+    QAtomicInt m_enabled;
+
+    /*********************************************************************
+     * Recording (timer thread only)
+     *********************************************************************/
+public:
+    /** Record $ns nanoseconds spent in $stage */
+    void addStageSample(Stage stage, quint64 ns);
+
+    /** Record $ns nanoseconds spent in the write() call of function $id */
+    void addFunctionSample(quint32 id, quint64 ns);
+
+    /** Publish the function samples collected during the current tick */
+    void commitTick();
+
+    /*********************************************************************
+     * Stage statistics
+     *********************************************************************/
+public:
+    /** Number of samples recorded for $stage */
+    quint64 count(Stage stage) const;
+
+    /** Total time spent in $stage, in nanoseconds */
+    quint64 totalNs(Stage stage) const;
+
+    /** Longest sample recorded for $stage, in nanoseconds */
+    quint64 maxNs(Stage stage) const;
+
+    /** Mean duration of $stage, in nanoseconds */
+    quint64 meanNs(Stage stage) const;
+
+    /** Upper bound of the histogram bucket holding the $percentile
+     *  (0.0 - 100.0) sample of $stage, in nanoseconds */
+    quint64 percentileNs(Stage stage, qreal percentile) const;
+
+    /** Index of the histogram bucket holding $ns */
+    static int bucketIndex(quint64 ns);
+
+    /** Upper bound, in nanoseconds, of the bucket at $index */
+    static quint64 bucketUpperBound(int index);
+
+private:
+    /** 4 sub-buckets for each of the 64 powers of two */
+    static const int s_bucketsCount = 64 * 4;
+
+    struct StageData
+    {
+        QAtomicInteger<quint64> m_count;
+        QAtomicInteger<quint64> m_total;
+        QAtomicInteger<quint64> m_max;
+        QAtomicInteger<quint64> m_buckets[s_bucketsCount];
+    };
+
+    StageData m_stages[StageCount];
+
+    /*********************************************************************
+     * Function statistics
+     *********************************************************************/
+public:
+    struct FunctionCost
+    {
+        quint32 m_id;
+        quint64 m_calls;
+        quint64 m_totalNs;
+        quint64 m_maxNs;
+    };
+
+    /** Get the cost of each profiled Function, most expensive first */
+    QList<FunctionCost> functionCosts() const;
+
+private:
+    /** Samples collected during the current tick */
+    QVector<FunctionCost> m_pendingSamples;
+
+    /** Mutex that guards access to m_functionCosts */
+    mutable QMutex m_functionsMutex;
+    QHash<quint32, FunctionCost> m_functionCosts;
+
+    /*********************************************************************
+     * Export
+     *********************************************************************/
+public:
+    /** Get all the collected data as a JSON document */
+    QByteArray toJson() const;
+
+    /** Write the JSON document to the file at $path */
+    bool saveToFile(const QString& path) const;
+};
+
+/** @} */
+
+#endif
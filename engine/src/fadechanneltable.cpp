@@ -0,0 +1,296 @@
+/*
+  Q Light Controller Plus
+  fadechanneltable.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <cmath>
+
+#include "fadechanneltable.h"
+#include "fadechannel.h"
+#include "universe.h"
+
+#define SLOTS_GROW_STEP 64
+
+FadeChannelTable::FadeChannelTable()
+    : m_count(0)
+{
+}
+
+FadeChannelTable::~FadeChannelTable()
+{
+}
+
+int FadeChannelTable::count() const
+{
+    return m_count;
+}
+
+int FadeChannelTable::size() const
+{
+    return m_count;
+}
+
+bool FadeChannelTable::isEmpty() const
+{
+    return m_count == 0;
+}
+
+void FadeChannelTable::clear()
+{
+    for (int i = 0; i < m_count; i++)
+        m_index[m_universe[i]][m_addressInUniverse[i]] = -1;
+
+    m_count = 0;
+}
+
+quint32 FadeChannelTable::keyOf(const FadeChannel& fc)
+{
+    if (fc.channel() == QLCChannel::invalid())
+        return UINT_MAX;
+
+    quint32 universe = fc.universe();
+    if (universe == Universe::invalid() || universe >= (UINT_MAX / UNIVERSE_SIZE))
+        return UINT_MAX;
+
+    return universe * UNIVERSE_SIZE + fc.addressInUniverse();
+}
+
+int FadeChannelTable::indexOf(const FadeChannel& fc) const
+{
+    return indexOf(keyOf(fc));
+}
+
+int FadeChannelTable::indexOf(quint32 address) const
+{
+    quint32 universe = address / UNIVERSE_SIZE;
+    if (universe >= quint32(m_index.size()))
+        return -1;
+
+    const QVector<int> &block = m_index.at(universe);
+    if (block.isEmpty())
+        return -1;
+
+    return block.at(address % UNIVERSE_SIZE);
+}
+
+bool FadeChannelTable::contains(const FadeChannel& fc) const
+{
+    return indexOf(fc) != -1;
+}
+
+FadeChannel FadeChannelTable::at(int index) const
+{
+    Q_ASSERT(index >= 0 && index < m_count);
+
+    FadeChannel fc;
+    fc.m_fixture = m_fixture.at(index);
+    fc.m_universe = m_fixtureUniverse.at(index);
+    fc.m_channel = m_channel.at(index);
+    fc.m_address = m_fixtureAddress.at(index);
+    fc.m_group = QLCChannel::Group(m_group.at(index));
+    fc.m_start = m_start.at(index);
+    fc.m_target = m_target.at(index);
+    fc.m_current = m_current.at(index);
+    fc.m_ready = m_flags.at(index) & Ready;
+    fc.m_flashing = m_flags.at(index) & Flashing;
+    fc.m_fadeTime = m_fadeTime.at(index);
+    fc.m_elapsed = m_elapsed.at(index);
+
+    return fc;
+}
+
+FadeChannel FadeChannelTable::value(const FadeChannel& fc) const
+{
+    int index = indexOf(fc);
+    if (index == -1)
+        return FadeChannel();
+
+    return at(index);
+}
+
+FadeChannel FadeChannelTable::operator[](const FadeChannel& fc) const
+{
+    return value(fc);
+}
+
+void FadeChannelTable::setSlot(int index, const FadeChannel& fc,
+                               QLCChannel::Group group, bool canFade)
+{
+    m_fixture[index] = fc.m_fixture;
+    m_fixtureUniverse[index] = fc.m_universe;
+    m_channel[index] = fc.m_channel;
+    m_fixtureAddress[index] = fc.m_address;
+    m_group[index] = group;
+
+    uchar flags = 0;
+    if (fc.m_ready)
+        flags |= Ready;
+    if (fc.m_flashing)
+        flags |= Flashing;
+    if (canFade)
+        flags |= CanFade;
+    m_flags[index] = flags;
+
+    m_start[index] = uchar(fc.m_start);
+    m_target[index] = uchar(fc.m_target);
+    m_current[index] = uchar(fc.m_current);
+    m_fadeTime[index] = fc.m_fadeTime;
+    m_elapsed[index] = fc.m_elapsed;
+}
+
+int FadeChannelTable::insert(const FadeChannel& fc, QLCChannel::Group group, bool canFade)
+{
+    quint32 key = keyOf(fc);
+    if (key == UINT_MAX)
+        return -1;
+
+    quint32 universe = key / UNIVERSE_SIZE;
+    quint32 address = key % UNIVERSE_SIZE;
+
+    if (universe >= quint32(m_index.size()))
+        m_index.resize(universe + 1);
+
+    // the block of a universe is allocated with its first channel
+    QVector<int> &block = m_index[universe];
+    if (block.isEmpty())
+        block.fill(-1, UNIVERSE_SIZE);
+
+    int index = block.at(address);
+    if (index == -1)
+    {
+        if (m_count == m_fixture.size())
+        {
+            int capacity = m_count + SLOTS_GROW_STEP;
+            m_fixture.resize(capacity);
+            m_fixtureUniverse.resize(capacity);
+            m_channel.resize(capacity);
+            m_fixtureAddress.resize(capacity);
+            m_universe.resize(capacity);
+            m_addressInUniverse.resize(capacity);
+            m_group.resize(capacity);
+            m_flags.resize(capacity);
+            m_start.resize(capacity);
+            m_target.resize(capacity);
+            m_current.resize(capacity);
+            m_fadeTime.resize(capacity);
+            m_elapsed.resize(capacity);
+        }
+
+        index = m_count++;
+        block[address] = index;
+        m_universe[index] = universe;
+        m_addressInUniverse[index] = address;
+    }
+
+    setSlot(index, fc, group, canFade);
+
+    return index;
+}
+
+bool FadeChannelTable::remove(const FadeChannel& fc)
+{
+    int index = indexOf(fc);
+    if (index == -1)
+        return false;
+
+    removeAt(index);
+    return true;
+}
+
+void FadeChannelTable::removeAt(int index)
+{
+    Q_ASSERT(index >= 0 && index < m_count);
+
+    m_index[m_universe.at(index)][m_addressInUniverse.at(index)] = -1;
+
+    int last = m_count - 1;
+    if (index != last)
+    {
+        // move the last slot in place of the removed one
+        m_fixture[index] = m_fixture.at(last);
+        m_fixtureUniverse[index] = m_fixtureUniverse.at(last);
+        m_channel[index] = m_channel.at(last);
+        m_fixtureAddress[index] = m_fixtureAddress.at(last);
+        m_universe[index] = m_universe.at(last);
+        m_addressInUniverse[index] = m_addressInUniverse.at(last);
+        m_group[index] = m_group.at(last);
+        m_flags[index] = m_flags.at(last);
+        m_start[index] = m_start.at(last);
+        m_target[index] = m_target.at(last);
+        m_current[index] = m_current.at(last);
+        m_fadeTime[index] = m_fadeTime.at(last);
+        m_elapsed[index] = m_elapsed.at(last);
+
+        m_index[m_universe.at(index)][m_addressInUniverse.at(index)] = index;
+    }
+
+    m_count--;
+}
+
+uchar FadeChannelTable::current(int index, qreal intensity) const
+{
+    return uchar(floor((qreal(m_current.at(index)) * intensity) + 0.5));
+}
+
+uchar FadeChannelTable::nextStep(int index, uint ms)
+{
+    uint elapsed = m_elapsed.at(index);
+    if (elapsed < UINT_MAX)
+    {
+        elapsed += ms;
+        m_elapsed[index] = elapsed;
+    }
+
+    uint fadeTime = m_fadeTime.at(index);
+    int start = m_start.at(index);
+    int target = m_target.at(index);
+    int current;
+
+    if (elapsed >= fadeTime || (m_flags.at(index) & Ready))
+    {
+        // Return the target value if all time has been consumed
+        // or if the channel has been marked ready.
+        current = target;
+    }
+    else if (elapsed == 0)
+    {
+        current = start;
+    }
+    else
+    {
+        current = target - start;
+        current = current * (qreal(elapsed) / qreal(fadeTime));
+        current += start;
+    }
+
+    m_current[index] = uchar(current);
+
+    return uchar(current);
+}
+
+void FadeChannelTable::setTarget(int index, uchar target, uint fadeTime)
+{
+    if (m_target.at(index) != target)
+    {
+        m_start[index] = m_current.at(index);
+        m_target[index] = target;
+        m_elapsed[index] = 0;
+    }
+
+    m_flags[index] &= ~(Ready | Flashing);
+    m_fadeTime[index] = fadeTime;
+}
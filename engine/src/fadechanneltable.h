@@ -0,0 +1,174 @@
+/*
+  Q Light Controller Plus
+  fadechanneltable.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef FADECHANNELTABLE_H
+#define FADECHANNELTABLE_H
+
+#include <QVector>
+
+#include "qlcchannel.h"
+
+class FadeChannel;
+
+/** @addtogroup engine Engine
+ * @{
+ */
+
+/**
+ * FadeChannelTable is the storage used by GenericFader to hold the channels
+ * being faded. Channels are kept in a dense list of slots, stored as a
+ * structure of arrays, so that a fader tick is a linear walk over the active
+ * channels only. A sparse index, addressed by absolute DMX address
+ * (universe * UNIVERSE_SIZE + address), maps a channel to its slot in O(1).
+ * The index holds a block of addresses only for the universes the table
+ * has been used with, so a fader on a single universe stays small.
+ *
+ * Since the table is indexed by DMX address, two FadeChannels pointing to
+ * the same universe address are considered the same channel.
+ */
+class FadeChannelTable
+{
+public:
+    FadeChannelTable();
+    ~FadeChannelTable();
+
+    /** Return the number of channels in the table */
+    int count() const;
+
+    /** Same as count(). Provided for QHash-like usage */
+    int size() const;
+
+    /** Return true if the table holds no channels */
+    bool isEmpty() const;
+
+    /** Remove all the channels. Allocated memory is retained for reuse */
+    void clear();
+
+    /** Return the slot index of the channel matching $fc's address, or -1 */
+    int indexOf(const FadeChannel& fc) const;
+
+    /** Return the slot index of the channel at the absolute DMX $address, or -1 */
+    int indexOf(quint32 address) const;
+
+    /** Return the absolute DMX address used as key for $fc, or UINT_MAX */
+    static quint32 keyOf(const FadeChannel& fc);
+
+    /** Return true if the table holds a channel at $fc's address */
+    bool contains(const FadeChannel& fc) const;
+
+    /** Build a FadeChannel out of the slot at $index */
+    FadeChannel at(int index) const;
+
+    /** Return a copy of the channel matching $fc's address, or an empty FadeChannel */
+    FadeChannel value(const FadeChannel& fc) const;
+    FadeChannel operator[](const FadeChannel& fc) const;
+
+    /**
+     * Insert $fc in the table, or replace the channel at the same address.
+     *
+     * @param fc The channel to store
+     * @param group The channel group, resolved by the caller
+     * @param canFade Whether the channel can be faded, resolved by the caller
+     * @return The slot index of the channel, or -1 if $fc has no valid address
+     */
+    int insert(const FadeChannel& fc, QLCChannel::Group group, bool canFade);
+
+    /** Remove the channel matching $fc's address. Return true on success */
+    bool remove(const FadeChannel& fc);
+
+    /**
+     * Remove the channel at $index. The last slot is moved in its place,
+     * so when iterating, $index must be visited again.
+     */
+    void removeAt(int index);
+
+    /************************************************************************
+     * Slot access
+     ************************************************************************/
+public:
+    quint32 universe(int index) const { return m_universe[index]; }
+    quint32 addressInUniverse(int index) const { return m_addressInUniverse[index]; }
+    QLCChannel::Group group(int index) const { return QLCChannel::Group(m_group[index]); }
+    bool canFade(int index) const { return m_flags[index] & CanFade; }
+    bool isFlashing(int index) const { return m_flags[index] & Flashing; }
+
+    uchar start(int index) const { return m_start[index]; }
+    uchar target(int index) const { return m_target[index]; }
+    uchar current(int index) const { return m_current[index]; }
+    void setCurrent(int index, uchar value) { m_current[index] = value; }
+
+    /** Get the current value at $index, modified by $intensity */
+    uchar current(int index, qreal intensity) const;
+
+    /**
+     * Increment the elapsed time of the slot at $index by $ms milliseconds
+     * and return its new current value. Same as FadeChannel::nextStep()
+     */
+    uchar nextStep(int index, uint ms);
+
+    /**
+     * Start a fade of the slot at $index towards $target, lasting $fadeTime
+     * milliseconds. If $target is the one already set, the running fade
+     * goes on untouched, otherwise it restarts from the current value.
+     */
+    void setTarget(int index, uchar target, uint fadeTime);
+
+private:
+    /** Store $fc values in the existing slot at $index */
+    void setSlot(int index, const FadeChannel& fc, QLCChannel::Group group, bool canFade);
+
+private:
+    enum SlotFlags
+    {
+        Ready    = 1 << 0,
+        Flashing = 1 << 1,
+        CanFade  = 1 << 2
+    };
+
+    /** Slot index of each address, one block of UNIVERSE_SIZE entries per
+     *  universe, indexed by universe. Universes that never held a channel
+     *  have an empty block. -1 when not present */
+    QVector< QVector<int> > m_index;
+
+    /** Number of slots in use. Vectors may be bigger to avoid reallocations */
+    int m_count;
+
+    /* FadeChannel identity, used to rebuild FadeChannels in at() */
+    QVector<quint32> m_fixture;
+    QVector<quint32> m_channel;
+    QVector<quint32> m_fixtureUniverse;
+    QVector<quint32> m_fixtureAddress;
+
+    /* Resolved output location */
+    QVector<quint32> m_universe;
+    QVector<quint16> m_addressInUniverse;
+    QVector<int> m_group;
+    QVector<uchar> m_flags;
+
+    /* Fade state */
+    QVector<uchar> m_start;
+    QVector<uchar> m_target;
+    QVector<uchar> m_current;
+    QVector<uint> m_fadeTime;
+    QVector<uint> m_elapsed;
+};
+
+/** @} */
+
+#endif
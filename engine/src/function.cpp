@@ -1002,6 +1002,16 @@ void Function::write(MasterTimer *timer, QList<Universe *> universes)
     Q_UNUSED(universes);
 }
 
+bool Function::supportsPrepareWrite() const
+{
+    return false;
+}
+
+void Function::prepareWrite(MasterTimer *timer)
+{
+    Q_UNUSED(timer);
+}
+
 void Function::postRun(MasterTimer* timer, QList<Universe *> universes)
 {
     Q_UNUSED(timer);
@@ -672,6 +672,24 @@ public:
      */
     virtual void write(MasterTimer* timer, QList<Universe*> universes);
 
+    /**
+     * Return true if the function implements prepareWrite(), so that
+     * MasterTimer can run it before the write() call of each tick.
+     */
+    virtual bool supportsPrepareWrite() const;
+
+    /**
+     * Compute the values that the next write() call will output.
+     * When enabled, MasterTimer calls this method at the beginning of a tick,
+     * on worker threads and concurrently with other functions.
+     * Implementations must therefore touch only their own state: no access to
+     * universes, to MasterTimer's fader or to other functions is allowed.
+     * write() must still work if prepareWrite() has not been called.
+     *
+     * @param timer The MasterTimer that is running the function
+     */
+    virtual void prepareWrite(MasterTimer* timer);
+
     /**
      * Called by MasterTimer when the function is stopped. No more write()
      * calls will arrive to the function after this call. The function may
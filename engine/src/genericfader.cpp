@@ -38,22 +38,22 @@ GenericFader::~GenericFader()
 
 void GenericFader::add(const FadeChannel& ch)
 {
-    QHash<FadeChannel,FadeChannel>::iterator channelIterator = m_channels.find(ch);
-    if (channelIterator != m_channels.end())
+    int index = m_channels.indexOf(ch);
+    if (index != -1)
     {
         // perform a HTP check
-        if (channelIterator.value().current() <= ch.current())
-            channelIterator.value() = ch;
+        if (m_channels.current(index) <= ch.current())
+            m_channels.insert(ch, ch.group(m_doc), ch.canFade(m_doc));
     }
     else
     {
-        m_channels.insert(ch, ch);
+        m_channels.insert(ch, ch.group(m_doc), ch.canFade(m_doc));
     }
 }
 
 void GenericFader::forceAdd(const FadeChannel &ch)
 {
-    m_channels.insert(ch, ch);
+    m_channels.insert(ch, ch.group(m_doc), ch.canFade(m_doc));
 }
 
 void GenericFader::remove(const FadeChannel& ch)
@@ -66,32 +66,37 @@ void GenericFader::removeAll()
     m_channels.clear();
 }
 
-const QHash <FadeChannel,FadeChannel>& GenericFader::channels() const
+const FadeChannelTable& GenericFader::channels() const
+{
+    return m_channels;
+}
+
+FadeChannelTable& GenericFader::channels()
 {
     return m_channels;
 }
 
 void GenericFader::write(QList<Universe*> ua, bool paused)
 {
-    QMutableHashIterator <FadeChannel,FadeChannel> it(m_channels);
-    while (it.hasNext() == true)
+    uint tick = MasterTimer::tick();
+    int i = 0;
+
+    while (i < m_channels.count())
     {
-        FadeChannel& fc(it.next().value());
-        QLCChannel::Group grp = fc.group(m_doc);
-        quint32 addr = fc.addressInUniverse();
-        quint32 universe = fc.universe();
-        bool canFade = fc.canFade(m_doc);
+        QLCChannel::Group grp = m_channels.group(i);
+        quint32 addr = m_channels.addressInUniverse(i);
+        quint32 universe = m_channels.universe(i);
         uchar value;
 
         // Calculate the next step
         if (paused)
-            value = fc.current();
+            value = m_channels.current(i);
         else
-            value = fc.nextStep(MasterTimer::tick());
+            value = m_channels.nextStep(i, tick);
 
         // Apply intensity to HTP channels
-        if (grp == QLCChannel::Intensity && canFade == true)
-            value = fc.current(intensity());
+        if (grp == QLCChannel::Intensity && m_channels.canFade(i) == true)
+            value = m_channels.current(i, intensity());
 
         if (universe != Universe::invalid())
         {
@@ -103,22 +108,22 @@ void GenericFader::write(QList<Universe*> ua, bool paused)
         {
             // Remove all HTP channels that reach their target _zero_ value.
             // They have no effect either way so removing them saves CPU a bit.
-            if (fc.current() == 0 && fc.target() == 0)
+            // The last slot is moved in place of the removed one, so don't
+            // advance the index.
+            if (m_channels.current(i) == 0 && m_channels.target(i) == 0)
             {
-                it.remove();
+                m_channels.removeAt(i);
                 continue;
             }
         }
-/*
-        else
+
+        if (m_channels.isFlashing(i))
         {
-            // Remove all LTP channels after their time is up
-            if (fc.elapsed() >= fc.fadeTime())
-                it.remove();
+            m_channels.removeAt(i);
+            continue;
         }
-*/
-        if (fc.isFlashing())
-            it.remove();
+
+        i++;
     }
 }
 
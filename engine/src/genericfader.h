@@ -21,8 +21,8 @@
 #define GENERICFADER
 
 #include <QList>
-#include <QHash>
 
+#include "fadechanneltable.h"
 #include "universe.h"
 
 class FadeChannel;
@@ -63,8 +63,12 @@ public:
      */
     void removeAll();
 
-    /** Get all channels in a non-modifiable hashmap */
-    const QHash <FadeChannel,FadeChannel>& channels() const;
+    /** Get all channels in a non-modifiable table */
+    const FadeChannelTable& channels() const;
+
+    /** Get all channels in a modifiable table, for callers updating
+     *  many channels at once. No HTP check is performed */
+    FadeChannelTable& channels();
 
     /**
      * Run the channels forward by one step and write their current values to
@@ -97,7 +101,7 @@ public:
     void setBlendMode(Universe::BlendMode mode);
 
 private:
-    QHash <FadeChannel,FadeChannel> m_channels;
+    FadeChannelTable m_channels;
     qreal m_intensity;
     Universe::BlendMode m_blendMode;
     Doc* m_doc;
@@ -117,6 +117,9 @@ bool InputOutputMap::setBlackout(bool blackout)
         locker.relock();
     }
 
+    if (blackout == true)
+        endFrame();
+
     emit blackoutChanged(m_blackout);
 
     return true;
@@ -300,25 +303,60 @@ void InputOutputMap::dumpUniverses()
     QMutexLocker locker(&m_universeMutex);
     if (m_blackout == false)
     {
-        for (int i = 0; i < m_universeArray.count(); i++)
+        int count = m_universeArray.count();
+        if (m_dumpChanged.size() != count)
+            m_dumpChanged.resize(count);
+
+        // send all the universes of this frame back to back,
+        // to minimize the skew between them on the outputs
+        for (int i = 0; i < count; i++)
         {
             Universe *universe = m_universeArray.at(i);
-            const QByteArray postGM = universe->postGMValues()->mid(0, universe->usedChannels());
-
-            // notify the universe listeners that some channels have changed
-            if (universe->hasChanged())
-            {
-                locker.unlock();
-                emit universesWritten(i, postGM);
-                locker.relock();
-            }
+            bool changed = universe->hasChanged();
+            m_dumpChanged[i] = changed;
 
             // this is where QLC+ sends data to the output plugins
-            universe->dumpOutput(postGM);
+            universe->dumpOutput(universe->postGMSnapshot(), changed);
+        }
+
+        endFrame();
+
+        // notify the universe listeners that some channels have changed
+        for (int i = 0; i < count && i < m_universeArray.count(); i++)
+        {
+            if (m_dumpChanged.at(i) == false)
+                continue;
+
+            // shallow copy of the snapshot taken by hasChanged()
+            const QByteArray postGM = m_universeArray.at(i)->postGMSnapshot();
+
+            locker.unlock();
+            emit universesWritten(i, postGM);
+            locker.relock();
         }
     }
 }
 
+void InputOutputMap::endFrame()
+{
+    // keep the allocated memory for the next tick
+    m_dumpPlugins.resize(0);
+
+    for (int i = 0; i < m_universeArray.count(); i++)
+    {
+        Universe *universe = m_universeArray.at(i);
+        for (int p = 0; p < universe->outputPatchesCount(); p++)
+        {
+            QLCIOPlugin *plugin = universe->outputPatch(p)->plugin();
+            if (plugin != NULL && m_dumpPlugins.contains(plugin) == false)
+                m_dumpPlugins.append(plugin);
+        }
+    }
+
+    foreach (QLCIOPlugin *plugin, m_dumpPlugins)
+        plugin->endFrame();
+}
+
 void InputOutputMap::resetUniverses()
 {
     {
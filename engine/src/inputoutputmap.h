@@ -21,6 +21,7 @@
 #define INPUTOUTPUTMAP_H
 
 #include <QSharedPointer>
+#include <QVector>
 #include <QObject>
 #include <QMutex>
 #include <QDir>
@@ -256,7 +257,10 @@ public:
 
     /**
      * Write current universe array data to plugins, each universe within
-     * the array to its assigned plugin.
+     * the array to its assigned plugin. When all the universes have been
+     * written, QLCIOPlugin::endFrame() is called once on each plugin
+     * involved, and only then universesWritten() is emitted for
+     * the universes that changed.
      */
     void dumpUniverses();
 
@@ -280,6 +284,16 @@ private:
     /** Mutex guarding m_universeArray */
     QMutex m_universeMutex;
 
+    /** Per universe changed flags of the frame being dumped */
+    QVector<bool> m_dumpChanged;
+
+    /** Output plugins involved in the frame being dumped */
+    QVector<QLCIOPlugin *> m_dumpPlugins;
+
+    /** Call QLCIOPlugin::endFrame() once on each patched output plugin.
+     *  m_universeMutex must be locked by the caller */
+    void endFrame();
+
     /*********************************************************************
      * Grand Master
      *********************************************************************/
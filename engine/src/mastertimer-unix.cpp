@@ -21,10 +21,15 @@
 
 #include <sys/time.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <fcntl.h>
 #include <errno.h>
+#if defined(Q_OS_LINUX)
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 #include <QDebug>
 
@@ -63,17 +68,11 @@ int MasterTimerPrivate::compareTime(struct timespec *time1, struct timespec *tim
 #endif
 {
     if (time1->tv_sec < time2->tv_sec)
-    {
-        qDebug() << "Time is late by" << (time2->tv_sec - time1->tv_sec) << "seconds";
         return -1;
-    }
     else if (time1->tv_sec > time2->tv_sec)
         return 1;
     else if (time1->tv_nsec < time2->tv_nsec)
-    {
-        qDebug() << "Time is late by" << (time2->tv_nsec - time1->tv_nsec) << "nanoseconds";
         return -1;
-    }
     else if (time1->tv_nsec > time2->tv_nsec)
         return 1;
     else
@@ -90,7 +89,20 @@ void MasterTimerPrivate::run()
     Q_ASSERT(mt != NULL);
 
     /* How long to wait each loop, in nanoseconds */
-    int nsTickTime = 1000000000L / mt->frequency();
+    long nsTickTime = long(mt->tickNs());
+
+#if defined(Q_OS_LINUX)
+    if (mt->m_realtimeScheduling)
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = sched_get_priority_max(SCHED_FIFO) / 2;
+
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0)
+            qWarning() << Q_FUNC_INFO << "Unable to set realtime scheduling:" << strerror(err);
+    }
+#endif
 
     /* Allocate this from stack here so that GCC doesn't have
        to do it everytime implicitly when gettimeofday() is called */
@@ -149,8 +161,8 @@ void MasterTimerPrivate::run()
          * to process all the running Functions :'( */
         if (compareTime(finish, current) <= 0)
         {
-            qDebug() << Q_FUNC_INFO << "MasterTimer is running late !";
-            /* No need to sleep. Immediately process the next tick */
+            /* No need to sleep. Immediately process the next tick.
+               Late ticks are accounted by MasterTimer::timingStats() */
             mt->timerTick();
             /* Now the finish time needs to be recalibrated */
 #if defined(Q_OS_OSX) || defined(Q_OS_IOS)
@@ -161,6 +173,14 @@ void MasterTimerPrivate::run()
             continue;
         }
 
+#if defined(Q_OS_LINUX)
+        /* Sleep until the absolute finish time, so that interruptions
+           and the time spent here don't add up to the tick length */
+        do
+        {
+            ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, finish, NULL);
+        } while (ret == EINTR);
+#else
         /* Do a rough sleep using the kernel to return control.
            We know that this will never be seconds as we are dealing
            with jumps of under a second every time. */
@@ -181,6 +201,7 @@ void MasterTimerPrivate::run()
             sleepTime->tv_nsec = remainingTime->tv_nsec;
             ret = nanosleep(sleepTime, remainingTime);
         }
+#endif
 
 #if 0
         /* Now take full CPU for precision (only a few nanoseconds,
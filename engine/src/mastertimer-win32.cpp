@@ -76,8 +76,12 @@ void MasterTimerPrivate::start()
         return;
     }
 
+    /* The timer period must be a whole number of milliseconds. Use the
+       nominal tick rounded down, which MasterTimer::advanceTick() accounts */
+    UINT period = UINT(MasterTimer::tickNs() / 1000000);
+
     /* Adjust system timer to operate on its minimum tick period */
-    m_systemTimerResolution = MIN(MAX(ptc.wPeriodMin, m_masterTimer->tick()), ptc.wPeriodMax);
+    m_systemTimerResolution = MIN(MAX(ptc.wPeriodMin, period), ptc.wPeriodMax);
     result = timeBeginPeriod(m_systemTimerResolution);
     if (result != TIMERR_NOERROR)
     {
@@ -90,7 +94,7 @@ void MasterTimerPrivate::start()
                                     (WAITORTIMERCALLBACK) masterTimerWin32Callback,
                                     this,
                                     0,
-                                    m_masterTimer->tick(),
+                                    period,
                                     WT_EXECUTELONGFUNCTION);
     if (!ok)
     {
@@ -19,18 +19,20 @@
 */
 
 #include <QDebug>
+#include <QRunnable>
 #include <QSettings>
+#include <QThreadPool>
 #include <QElapsedTimer>
 #include <QMutexLocker>
 
 #if defined(WIN32) || defined(Q_OS_WIN)
 #   include "mastertimer-win32.h"
 #else
-#   include <unistd.h>
 #   include "mastertimer-unix.h"
 #endif
 
 #include "inputoutputmap.h"
+#include "engineprofiler.h"
 #include "genericfader.h"
 #include "fadechannel.h"
 #include "mastertimer.h"
@@ -41,11 +43,16 @@
 #include "doc.h"
 
 #define MASTERTIMER_FREQUENCY "mastertimer/frequency"
+#define MASTERTIMER_REALTIME "mastertimer/realtime"
+#define MASTERTIMER_PROFILER "mastertimer/profiler"
+#define MASTERTIMER_PROFILER_FILE "mastertimer/profilerfile"
+#define MASTERTIMER_WORKERS "mastertimer/workers"
 #define LATE_TO_BEAT_THRESHOLD 25
 
 /** The timer tick frequency in Hertz */
 uint MasterTimer::s_frequency = 50;
-uint MasterTimer::s_tick = 20;
+QAtomicInt MasterTimer::s_tick(20);
+quint64 MasterTimer::s_tickNs = 20000000;
 
 //#define DEBUG_MASTERTIMER
 
@@ -53,14 +60,57 @@ uint MasterTimer::s_tick = 20;
 quint64 ticksCount = 0;
 #endif
 
+/**
+ * A task run by the MasterTimer worker threads. Tasks pick the functions
+ * to prepare one at a time from a shared index, so that a worker ending
+ * early takes over the remaining functions.
+ */
+class MasterTimerPrepareTask : public QRunnable
+{
+public:
+    MasterTimerPrepareTask(MasterTimer *timer)
+        : m_timer(timer)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        m_timer->runPrepareTasks();
+        m_timer->m_prepareDone.release();
+    }
+
+private:
+    MasterTimer *m_timer;
+};
+
+/** Record the time elapsed since $lap in $stage, and start a new lap */
+static inline void profileLap(EngineProfiler *profiler, EngineProfiler::Stage stage,
+                              const QElapsedTimer &timer, qint64 &lap)
+{
+    qint64 now = timer.nsecsElapsed();
+    profiler->addStageSample(stage, quint64(now - lap));
+    lap = now;
+}
+
 /*****************************************************************************
  * Initialization
  *****************************************************************************/
 
 MasterTimer::MasterTimer(Doc* doc)
     : QObject(doc)
+    , m_tickRemainderNs(0)
+    , m_elapsed(0)
+    , m_realtimeScheduling(false)
     , d_ptr(new MasterTimerPrivate(this))
+    , m_profiler(new EngineProfiler(doc))
+    , m_statsTicks(0)
+    , m_statsLateTicks(0)
+    , m_statsJitterSumNs(0)
+    , m_statsMaxJitterNs(0)
+    , m_startQueue(NULL)
     , m_stopAllFunctions(false)
+    , m_workerPool(NULL)
     , m_dmxSourceListMutex(QMutex::Recursive)
     , m_fader(new GenericFader(doc))
     , m_beatSourceType(None)
@@ -78,7 +128,23 @@ MasterTimer::MasterTimer(Doc* doc)
     if (var.isValid() == true)
         s_frequency = var.toUInt();
 
-    s_tick = uint(double(1000) / double(s_frequency));
+    if (s_frequency == 0)
+        s_frequency = 50;
+
+    s_tickNs = Q_UINT64_C(1000000000) / s_frequency;
+    s_tick.storeRelease(int(s_tickNs / 1000000));
+
+    var = settings.value(MASTERTIMER_REALTIME);
+    if (var.isValid() == true)
+        m_realtimeScheduling = var.toBool();
+
+    var = settings.value(MASTERTIMER_PROFILER);
+    if (var.isValid() == true)
+        m_profiler->setEnabled(var.toBool());
+
+    var = settings.value(MASTERTIMER_WORKERS);
+    if (var.isValid() == true)
+        setWorkerThreads(var.toInt());
 }
 
 MasterTimer::~MasterTimer()
@@ -89,12 +155,20 @@ MasterTimer::~MasterTimer()
     delete d_ptr;
     d_ptr = NULL;
 
+    setWorkerThreads(0);
+
+    // discard pending start requests
+    takeStartQueue();
+
+    delete m_profiler;
+
     delete m_beatTimer;
 }
 
 void MasterTimer::start()
 {
     Q_ASSERT(d_ptr != NULL);
+    m_tickTimer.invalidate();
     d_ptr->start();
 }
 
@@ -103,6 +177,14 @@ void MasterTimer::stop()
     Q_ASSERT(d_ptr != NULL);
     stopAllFunctions();
     d_ptr->stop();
+
+    if (m_profiler->isEnabled())
+    {
+        QSettings settings;
+        QVariant var = settings.value(MASTERTIMER_PROFILER_FILE);
+        if (var.isValid() == true && var.toString().isEmpty() == false)
+            m_profiler->saveToFile(var.toString());
+    }
 }
 
 void MasterTimer::timerTick()
@@ -114,6 +196,9 @@ void MasterTimer::timerTick()
     qDebug() << "[MasterTimer] *********** tick:" << ticksCount++ << "**********";
 #endif
 
+    updateTimingStats();
+    advanceTick();
+
     switch (m_beatSourceType)
     {
         case Internal:
@@ -145,21 +230,59 @@ void MasterTimer::timerTick()
         break;
     }
 
+    bool profiling = m_profiler->isEnabled();
+    QElapsedTimer profileTimer;
+    qint64 lap = 0;
+    if (profiling)
+        profileTimer.start();
+
+    // prepare functions before locking the universes
+    timerPrepareFunctions();
+    if (profiling)
+        profileLap(m_profiler, EngineProfiler::PrepareStage, profileTimer, lap);
+
     QList<Universe *> universes = doc->inputOutputMap()->claimUniverses();
     for (int i = 0 ; i < universes.count(); i++)
     {
         universes[i]->flushInput();
+        universes[i]->startBatch();
         universes[i]->zeroIntensityChannels();
         universes[i]->zeroRelativeValues();
     }
 
+    if (profiling)
+        lap = profileTimer.nsecsElapsed();
+
     timerTickFunctions(universes);
+    if (profiling)
+        profileLap(m_profiler, EngineProfiler::FunctionsStage, profileTimer, lap);
+
     timerTickDMXSources(universes);
+    if (profiling)
+        profileLap(m_profiler, EngineProfiler::DMXSourcesStage, profileTimer, lap);
+
     timerTickFader(universes);
+    if (profiling)
+        profileLap(m_profiler, EngineProfiler::FaderStage, profileTimer, lap);
+
+    // compute the post Grand Master values of each universe in one pass
+    for (int i = 0 ; i < universes.count(); i++)
+        universes[i]->commitBatch();
 
     doc->inputOutputMap()->releaseUniverses();
+
+    if (profiling)
+        lap = profileTimer.nsecsElapsed();
+
     doc->inputOutputMap()->dumpUniverses();
 
+    if (profiling)
+    {
+        profileLap(m_profiler, EngineProfiler::DumpStage, profileTimer, lap);
+        m_profiler->addStageSample(EngineProfiler::TickStage, quint64(profileTimer.nsecsElapsed()));
+        m_profiler->commitTick();
+    }
+
     m_beatRequested = false;
 }
 
@@ -170,7 +293,97 @@ uint MasterTimer::frequency()
 
 uint MasterTimer::tick()
 {
-    return s_tick;
+    return uint(s_tick.loadAcquire());
+}
+
+quint64 MasterTimer::tickNs()
+{
+    return s_tickNs;
+}
+
+quint64 MasterTimer::elapsed() const
+{
+    return m_elapsed;
+}
+
+void MasterTimer::advanceTick()
+{
+#if defined(WIN32) || defined(Q_OS_WIN)
+    // The system timer fires at the rounded down period,
+    // so every tick lasts the same whole number of milliseconds
+    uint tick = uint(s_tickNs / 1000000);
+#else
+    m_tickRemainderNs += s_tickNs;
+    uint tick = uint(m_tickRemainderNs / 1000000);
+    m_tickRemainderNs -= quint64(tick) * 1000000;
+#endif
+    s_tick.storeRelease(int(tick));
+    m_elapsed += tick;
+}
+
+/*****************************************************************************
+ * Profiling
+ *****************************************************************************/
+
+EngineProfiler *MasterTimer::profiler() const
+{
+    return m_profiler;
+}
+
+/*****************************************************************************
+ * Timing statistics
+ *****************************************************************************/
+
+MasterTimer::TimingStats MasterTimer::timingStats() const
+{
+    QMutexLocker locker(&m_statsMutex);
+
+    TimingStats stats;
+    stats.ticks = m_statsTicks;
+    stats.lateTicks = m_statsLateTicks;
+    stats.meanJitterNs = m_statsTicks ? m_statsJitterSumNs / m_statsTicks : 0;
+    stats.maxJitterNs = m_statsMaxJitterNs;
+
+    return stats;
+}
+
+void MasterTimer::resetTimingStats()
+{
+    QMutexLocker locker(&m_statsMutex);
+
+    m_statsTicks = 0;
+    m_statsLateTicks = 0;
+    m_statsJitterSumNs = 0;
+    m_statsMaxJitterNs = 0;
+}
+
+void MasterTimer::updateTimingStats()
+{
+    if (m_tickTimer.isValid() == false)
+    {
+        // first tick since start(). Nothing to measure
+        m_tickTimer.start();
+        return;
+    }
+
+    quint64 elapsed = quint64(m_tickTimer.nsecsElapsed());
+    m_tickTimer.restart();
+
+#if defined(WIN32) || defined(Q_OS_WIN)
+    // the system timer runs at the rounded down period
+    quint64 period = quint64(tick()) * 1000000;
+#else
+    quint64 period = s_tickNs;
+#endif
+    quint64 jitter = elapsed > period ? elapsed - period : period - elapsed;
+
+    QMutexLocker locker(&m_statsMutex);
+    m_statsTicks++;
+    m_statsJitterSumNs += jitter;
+    if (jitter > m_statsMaxJitterNs)
+        m_statsMaxJitterNs = jitter;
+    if (elapsed > period + period / 2)
+        m_statsLateTicks++;
 }
 
 /*****************************************************************************
@@ -182,23 +395,49 @@ void MasterTimer::startFunction(Function* function)
     if (function == NULL)
         return;
 
-    QMutexLocker locker(&m_functionListMutex);
-    if (m_startQueue.contains(function) == false)
-        m_startQueue.append(function);
+    StartRequest* request = new StartRequest;
+    request->m_function = function;
+
+    /* Push the request on top of the queue. Duplicates are
+     * discarded by the timer thread when taking the queue */
+    StartRequest* head;
+    do
+    {
+        head = m_startQueue.loadAcquire();
+        request->m_next = head;
+    } while (m_startQueue.testAndSetRelease(head, request) == false);
 }
 
-void MasterTimer::stopAllFunctions()
+QList<Function *> MasterTimer::takeStartQueue()
 {
-    m_stopAllFunctions = true;
+    QList<Function*> queue;
 
-    /* Wait until all functions have been stopped */
-    while (runningFunctions() > 0)
+    StartRequest* request = m_startQueue.fetchAndStoreAcquire(NULL);
+    while (request != NULL)
     {
-#if defined(WIN32) || defined(Q_OS_WIN)
-        Sleep(10);
-#else
-        usleep(10000);
-#endif
+        // requests are linked from the newest to the oldest
+        if (queue.contains(request->m_function) == false)
+            queue.prepend(request->m_function);
+        else
+            queue.move(queue.indexOf(request->m_function), 0);
+
+        StartRequest* next = request->m_next;
+        delete request;
+        request = next;
+    }
+
+    return queue;
+}
+
+void MasterTimer::stopAllFunctions()
+{
+    {
+        QMutexLocker locker(&m_stopAllMutex);
+        m_stopAllFunctions = true;
+
+        /* Wait until all functions have been stopped by the timer thread */
+        while (runningFunctions() > 0)
+            m_functionsStopped.wait(&m_stopAllMutex);
     }
 
     // WARNING: the following brackets are fundamental for
@@ -287,7 +526,7 @@ void MasterTimer::timerTickFunctions(QList<Universe *> universes)
                 if (function->stopped() == false && m_stopAllFunctions == false)
                 {
                     if (firstIteration)
-                        function->write(this, universes);
+                        timerWriteFunction(function, universes);
                 }
                 else
                 {
@@ -319,38 +558,121 @@ void MasterTimer::timerTickFunctions(QList<Universe *> universes)
         firstIteration = false;
     }
 
+    /* Start the queued functions. Their first write may queue other ones */
+    QList<Function*> startQueue = takeStartQueue();
+    while (startQueue.isEmpty() == false)
     {
-        QMutexLocker locker(&m_functionListMutex);
-        while (m_startQueue.size() > 0)
+        foreach (Function* f, startQueue)
         {
-            QList<Function*> startQueue(m_startQueue);
-            m_startQueue.clear();
-            locker.unlock();
-
-            foreach (Function* f, startQueue)
+            if (m_functionList.contains(f))
             {
-                if (m_functionList.contains(f))
-                {
-                    f->postRun(this, universes);
-                }
-                else
-                {
-                    m_functionList.append(f);
-                    functionListHasChanged = true;
-                }
-                f->preRun(this);
-                f->write(this, universes);
-                emit functionStarted(f->id());
+                f->postRun(this, universes);
             }
-
-            locker.relock();
+            else
+            {
+                m_functionList.append(f);
+                functionListHasChanged = true;
+            }
+            f->preRun(this);
+            timerWriteFunction(f, universes);
+            emit functionStarted(f->id());
         }
+
+        startQueue = takeStartQueue();
+    }
+
+    if (m_stopAllFunctions && m_functionList.isEmpty())
+    {
+        QMutexLocker locker(&m_stopAllMutex);
+        m_functionsStopped.wakeAll();
     }
 
     if (functionListHasChanged)
         emit functionListChanged();
 }
 
+void MasterTimer::timerWriteFunction(Function *function, QList<Universe *> universes)
+{
+    if (m_profiler->isEnabled() == false)
+    {
+        function->write(this, universes);
+        return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    function->write(this, universes);
+    m_profiler->addFunctionSample(function->id(), quint64(timer.nsecsElapsed()));
+}
+
+/****************************************************************************
+ * Parallel function preparation
+ ****************************************************************************/
+
+void MasterTimer::setWorkerThreads(int count)
+{
+    count = qMax(0, count);
+    if (count == workerThreads())
+        return;
+
+    delete m_workerPool;
+    m_workerPool = NULL;
+    qDeleteAll(m_prepareTasks);
+    m_prepareTasks.clear();
+
+    if (count == 0)
+        return;
+
+    m_workerPool = new QThreadPool();
+    m_workerPool->setMaxThreadCount(count);
+    // keep the threads alive between ticks
+    m_workerPool->setExpiryTimeout(-1);
+
+    for (int i = 0; i < count; i++)
+        m_prepareTasks.append(new MasterTimerPrepareTask(this));
+}
+
+int MasterTimer::workerThreads() const
+{
+    return m_prepareTasks.count();
+}
+
+void MasterTimer::timerPrepareFunctions()
+{
+    if (m_workerPool == NULL || m_stopAllFunctions == true)
+        return;
+
+    m_prepareList.clear();
+    foreach (Function *function, m_functionList)
+    {
+        if (function != NULL && function->stopped() == false &&
+            function->supportsPrepareWrite())
+            m_prepareList.append(function);
+    }
+
+    // nothing to share. Functions will render in write()
+    if (m_prepareList.count() < 2)
+        return;
+
+    // the timer thread takes part in the job too
+    int tasks = qMin(m_prepareTasks.count(), m_prepareList.count() - 1);
+
+    m_prepareIndex.store(0);
+    for (int i = 0; i < tasks; i++)
+        m_workerPool->start(m_prepareTasks.at(i));
+
+    runPrepareTasks();
+
+    m_prepareDone.acquire(tasks);
+}
+
+void MasterTimer::runPrepareTasks()
+{
+    int index;
+    while ((index = m_prepareIndex.fetchAndAddOrdered(1)) < m_prepareList.count())
+        m_prepareList.at(index)->prepareWrite(this);
+}
+
 /****************************************************************************
  * DMX Sources
  ****************************************************************************/
@@ -453,14 +775,14 @@ void MasterTimer::faderForceAdd(const FadeChannel& ch)
     fader()->forceAdd(ch);
 }
 
-QHash<FadeChannel,FadeChannel> MasterTimer::faderChannels() const
+FadeChannelTable MasterTimer::faderChannels() const
 {
     QMutexLocker faderLocker(const_cast<QMutex*>(&m_faderMutex));
 
     return fader()->channels();
 }
 
-QHash<FadeChannel,FadeChannel> const& MasterTimer::faderChannelsRef() const
+FadeChannelTable const& MasterTimer::faderChannelsRef() const
 {
     return fader()->channels();
 }
@@ -21,13 +21,21 @@
 #ifndef MASTERTIMER_H
 #define MASTERTIMER_H
 
+#include <QElapsedTimer>
+#include <QWaitCondition>
+#include <QAtomicPointer>
+#include <QSemaphore>
+#include <QAtomicInt>
 #include <QHash>
 #include <QObject>
 #include <QMutex>
 #include <QList>
 
+class MasterTimerPrepareTask;
+class FadeChannelTable;
+class EngineProfiler;
 class MasterTimerPrivate;
-class QElapsedTimer;
+class QThreadPool;
 class GenericFader;
 class FadeChannel;
 class DMXSource;
@@ -45,6 +53,7 @@ class MasterTimer : public QObject
     Q_DISABLE_COPY(MasterTimer)
 
     friend class MasterTimerPrivate;
+    friend class MasterTimerPrepareTask;
 
     /*************************************************************************
      * Initialization
@@ -70,32 +79,111 @@ public:
     /** Get the timer tick frequency in Hertz */
     static uint frequency();
 
-    /** Get the length of one timer tick in milliseconds */
+    /**
+     * Get the length of the current timer tick in milliseconds.
+     * When the tick period is not a whole number of milliseconds (i.e. 44Hz
+     * or 120Hz), ticks alternate between the two nearest lengths, so that
+     * the time accounted by functions doesn't drift from the real time.
+     * On Windows the system timer can only fire every whole millisecond:
+     * there the tick is constant and the period is rounded down.
+     */
     static uint tick();
 
+    /** Get the nominal length of one timer tick in nanoseconds */
+    static quint64 tickNs();
+
+    /** Get the time run by the timer, as the sum of its ticks, in milliseconds */
+    quint64 elapsed() const;
+
 private:
     /** Execute one timer tick (called by MasterTimerPrivate) */
     void timerTick();
 
+    /** Compute the length in milliseconds of the tick about to run */
+    void advanceTick();
+
 private:
     /** The timer tick frequency in Hertz */
     static uint s_frequency;
 
-    /** Duration in milliseconds of a single tick */
-    static uint s_tick;
+    /** Duration in milliseconds of the current tick. Changed by the timer
+     *  thread at each tick and read by any thread */
+    static QAtomicInt s_tick;
+
+    /** Nominal duration in nanoseconds of a single tick */
+    static quint64 s_tickNs;
+
+    /** Nanoseconds not yet accounted in s_tick */
+    quint64 m_tickRemainderNs;
+
+    /** Sum of the ticks run so far, in milliseconds */
+    quint64 m_elapsed;
+
+    /** Use realtime (SCHED_FIFO) scheduling for the timer thread, if supported */
+    bool m_realtimeScheduling;
 
     /** The private reference to a MasterTimer platform dependent implementation */
     MasterTimerPrivate* d_ptr;
 
+    /*************************************************************************
+     * Profiling
+     *************************************************************************/
+public:
+    /** Get the profiler measuring the time spent in each tick stage
+     *  and by each running function. Disabled by default */
+    EngineProfiler* profiler() const;
+
+private:
+    EngineProfiler* m_profiler;
+
+    /*************************************************************************
+     * Timing statistics
+     *************************************************************************/
+public:
+    /** Statistics of the real time elapsed between ticks */
+    struct TimingStats
+    {
+        /** Number of measured ticks */
+        quint64 ticks;
+        /** Number of ticks started more than half a tick late */
+        quint64 lateTicks;
+        /** Mean deviation from the nominal tick length, in nanoseconds */
+        quint64 meanJitterNs;
+        /** Largest deviation from the nominal tick length, in nanoseconds */
+        quint64 maxJitterNs;
+    };
+
+    /** Get the timing statistics collected since the last reset */
+    TimingStats timingStats() const;
+
+    /** Reset the timing statistics */
+    void resetTimingStats();
+
+private:
+    /** Measure the time elapsed since the previous tick */
+    void updateTimingStats();
+
+private:
+    /** Time elapsed since the previous tick */
+    QElapsedTimer m_tickTimer;
+    /** Mutex that guards access to the statistics below */
+    mutable QMutex m_statsMutex;
+    quint64 m_statsTicks;
+    quint64 m_statsLateTicks;
+    quint64 m_statsJitterSumNs;
+    quint64 m_statsMaxJitterNs;
+
     /*********************************************************************
      * Functions
      *********************************************************************/
 public:
     /** Start the given function */
-    /** This should be called by the function itself */
+    /** This should be called by the function itself. The request is queued
+     *  without locking and processed at the next timer tick */
     virtual void startFunction(Function* function);
 
-    /** Stop all functions. Doesn't affect registered DMX sources. */
+    /** Stop all functions and wait until the timer thread has stopped them.
+     *  Doesn't affect registered DMX sources. */
     void stopAllFunctions();
 
     /** Fade all functions for a given time and then stop them all */
@@ -115,17 +203,73 @@ private:
     /** Execute one timer tick for each registered Function */
     void timerTickFunctions(QList<Universe *> universes);
 
+    /** Write the next values of $function, measuring it when profiling */
+    void timerWriteFunction(Function* function, QList<Universe *> universes);
+
+    /** Take all the pending start requests, in the order they were made */
+    QList <Function*> takeStartQueue();
+
 private:
     /** List of currently running functions */
     QList <Function*> m_functionList;
-    QList <Function*> m_startQueue;
 
-    /** Mutex that guards access to m_startQueue */
-    QMutex m_functionListMutex;
+    /** A start request, linked to the one made before it */
+    struct StartRequest
+    {
+        Function* m_function;
+        StartRequest* m_next;
+    };
+
+    /** The most recent start request. Requests are pushed by any thread
+     *  and taken all at once by the timer thread, so no lock is needed */
+    QAtomicPointer<StartRequest> m_startQueue;
 
     /** Flag for stopping all functions */
     bool m_stopAllFunctions;
 
+    /** Mutex and condition used to wait for all functions to stop */
+    QMutex m_stopAllMutex;
+    QWaitCondition m_functionsStopped;
+
+    /*********************************************************************
+     * Parallel function preparation
+     *********************************************************************/
+public:
+    /**
+     * Set the number of worker threads used to run Function::prepareWrite()
+     * of the running functions in parallel, at the beginning of each tick.
+     * Functions still write to universes serially, in their running order.
+     * Zero (the default) disables parallel preparation.
+     * This should be called while the timer is not running.
+     */
+    void setWorkerThreads(int count);
+
+    /** Get the number of worker threads used to prepare functions */
+    int workerThreads() const;
+
+private:
+    /** Run prepareWrite() of the running functions on the worker threads */
+    void timerPrepareFunctions();
+
+    /** Prepare functions from m_prepareList until none is left */
+    void runPrepareTasks();
+
+private:
+    /** The pool of worker threads. NULL when parallel preparation is disabled */
+    QThreadPool* m_workerPool;
+
+    /** Reusable tasks started on m_workerPool at each tick */
+    QList <MasterTimerPrepareTask*> m_prepareTasks;
+
+    /** Functions to prepare in the current tick */
+    QList <Function*> m_prepareList;
+
+    /** Index of the next function of m_prepareList to be prepared */
+    QAtomicInt m_prepareIndex;
+
+    /** Released by each task when m_prepareList has been consumed */
+    QSemaphore m_prepareDone;
+
     /*************************************************************************
      * DMX Sources
      *************************************************************************/
@@ -162,11 +306,7 @@ private:
     /** List of currently registered DMX sources */
     QList <DMXSource*> m_dmxSourceList;
 
-    /** Mutex that guards access to m_dmxSourceList 
-     *
-     * In case both m_functionListMutex and m_dmxSourceListMutex are needed,
-     * always lock m_functionListMutex first!
-     */
+    /** Mutex that guards access to m_dmxSourceList */
     QMutex m_dmxSourceListMutex;
 
     /*************************************************************************
@@ -182,8 +322,8 @@ private:
 public:
     void faderAdd(const FadeChannel& ch);
     void faderForceAdd(const FadeChannel& ch);
-    QHash<FadeChannel,FadeChannel> faderChannels() const;
-    QHash<FadeChannel,FadeChannel> const& faderChannelsRef() const;
+    FadeChannelTable faderChannels() const;
+    FadeChannelTable const& faderChannelsRef() const;
     QMutex* faderMutex() const;
 
 private:
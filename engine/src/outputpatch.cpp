@@ -24,6 +24,8 @@
 #   include <unistd.h>
 #endif
 
+#include <QSettings>
+
 #include "qlcioplugin.h"
 #include "outputpatch.h"
 
@@ -40,7 +42,13 @@ OutputPatch::OutputPatch(QObject* parent)
     , m_universe(UINT_MAX)
     , m_paused(false)
     , m_blackout(false)
+    , m_refreshInterval(0)
+    , m_forceWrite(true)
 {
+    QSettings settings;
+    QVariant var = settings.value(SETTINGS_OUTPUT_REFRESH);
+    if (var.isValid() == true)
+        m_refreshInterval = var.toInt();
 }
 
 OutputPatch::OutputPatch(quint32 universe, QObject* parent)
@@ -50,7 +58,13 @@ OutputPatch::OutputPatch(quint32 universe, QObject* parent)
     , m_universe(universe)
     , m_paused(false)
     , m_blackout(false)
+    , m_refreshInterval(0)
+    , m_forceWrite(true)
 {
+    QSettings settings;
+    QVariant var = settings.value(SETTINGS_OUTPUT_REFRESH);
+    if (var.isValid() == true)
+        m_refreshInterval = var.toInt();
 }
 
 OutputPatch::~OutputPatch()
@@ -70,6 +84,7 @@ bool OutputPatch::set(QLCIOPlugin* plugin, quint32 output)
 
     m_plugin = plugin;
     m_pluginLine = output;
+    m_forceWrite = true;
 
     if (m_plugin != NULL)
     {
@@ -95,6 +110,7 @@ bool OutputPatch::reconnect()
         usleep(GRACE_MS * 1000);
 #endif
         bool ret = m_plugin->openOutput(m_pluginLine, m_universe);
+        m_forceWrite = true;
         if (ret == true)
         {
             foreach(QString par, m_parametersCache.keys())
@@ -144,6 +160,7 @@ bool OutputPatch::isPatched() const
 void OutputPatch::setPluginParameter(QString prop, QVariant value)
 {
     m_parametersCache[prop] = value;
+    m_forceWrite = true;
     if (m_plugin != NULL)
         m_plugin->setParameter(m_universe, m_pluginLine, QLCIOPlugin::Output, prop, value);
 }
@@ -174,6 +191,8 @@ void OutputPatch::setPaused(bool paused)
     if (m_pauseBuffer.length())
         m_pauseBuffer.clear();
 
+    m_forceWrite = true;
+
     emit pausedChanged(m_paused);
 }
 
@@ -188,14 +207,33 @@ void OutputPatch::setBlackout(bool blackout)
         return;
 
     m_blackout = blackout;
+    m_forceWrite = true;
     emit blackoutChanged(m_blackout);
 }
 
-void OutputPatch::dump(quint32 universe, const QByteArray& data)
+int OutputPatch::refreshInterval() const
+{
+    return m_refreshInterval;
+}
+
+void OutputPatch::setRefreshInterval(int ms)
+{
+    m_refreshInterval = qMax(0, ms);
+}
+
+void OutputPatch::dump(quint32 universe, const QByteArray& data, bool dataChanged)
 {
     /* Don't do anything if there is no plugin and/or output line. */
     if (m_plugin != NULL && m_pluginLine != QLCIOPlugin::invalidLine())
     {
+        /* Skip unchanged data, unless the refresh interval has expired */
+        if (m_refreshInterval > 0 && dataChanged == false && m_forceWrite == false &&
+            m_lastWrite.isValid() && m_lastWrite.elapsed() < m_refreshInterval)
+            return;
+
+        m_forceWrite = false;
+        m_lastWrite.restart();
+
         if (m_paused)
         {
             if (m_pauseBuffer.isNull())
@@ -20,6 +20,7 @@
 #ifndef OUTPUTPATCH_H
 #define OUTPUTPATCH_H
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QMap>
 
@@ -36,6 +37,8 @@ class QLCIOPlugin;
 #define KXMLQLCOutputPatchPlugin "Plugin"
 #define KXMLQLCOutputPatchOutput "Output"
 
+#define SETTINGS_OUTPUT_REFRESH "outputpatch/refreshinterval"
+
 class OutputPatch : public QObject
 {
     Q_OBJECT
@@ -116,9 +119,19 @@ public:
     bool blackout() const;
     void setBlackout(bool blackout);
 
+    /**
+     * Get/Set the refresh interval in milliseconds. When greater than zero,
+     * unchanged data is not written to the plugin more often than this,
+     * so protocols needing a periodic resend are still kept alive.
+     * When zero (the default), data is written on every dump.
+     */
+    int refreshInterval() const;
+    void setRefreshInterval(int ms);
+
     /** Write the contents of a 512 channel value buffer to the plugin.
-      * Called periodically by OutputMap. No need to call manually. */
-    void dump(quint32 universe, const QByteArray &data);
+      * Called periodically by OutputMap. No need to call manually.
+      * $dataChanged tells if $data differs from the previous dump */
+    void dump(quint32 universe, const QByteArray &data, bool dataChanged = true);
 
 signals:
     void pausedChanged(bool paused);
@@ -129,6 +142,13 @@ private:
     QByteArray m_pauseBuffer;
     bool m_paused;
     bool m_blackout;
+
+    /** Refresh interval of unchanged data, in milliseconds */
+    int m_refreshInterval;
+    /** Time elapsed since the last write to the plugin */
+    QElapsedTimer m_lastWrite;
+    /** Flag set to write the next dump regardless of data changes */
+    bool m_forceWrite;
 };
 
 /** @} */
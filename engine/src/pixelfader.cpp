@@ -0,0 +1,239 @@
+/*
+  Q Light Controller Plus
+  pixelfader.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include <string.h>
+#include <cmath>
+
+#include "pixelfader.h"
+#include "mastertimer.h"
+
+PixelFader::PixelFader()
+    : m_count(0)
+    , m_intensity(1)
+    , m_blendMode(Universe::NormalBlend)
+{
+}
+
+PixelFader::~PixelFader()
+{
+}
+
+void PixelFader::clear()
+{
+    m_count = 0;
+    m_remapped.clear();
+}
+
+void PixelFader::remap()
+{
+    m_remapped.clear();
+    m_remapped.reserve(m_count);
+
+    for (int i = 0; i < m_count; i++)
+    {
+        SlotState state;
+        state.m_start = m_start.at(i);
+        state.m_delta = m_delta.at(i);
+        state.m_fadeTime = m_fadeTime.at(i);
+        state.m_elapsed = m_elapsed.at(i);
+        state.m_target = m_target.at(i);
+        state.m_current = m_current.at(i);
+        m_remapped.insert(m_universe.at(i) * UNIVERSE_SIZE + m_addressInUniverse.at(i), state);
+    }
+
+    m_count = 0;
+}
+
+int PixelFader::count() const
+{
+    return m_count;
+}
+
+int PixelFader::add(quint32 address, bool intensity, bool canFade)
+{
+    int index = m_count++;
+
+    if (m_count > m_universe.size())
+    {
+        // grow by 4 slots, so that advance() runs on whole vectors
+        int padded = (m_count + 3) & ~3;
+        m_universe.resize(padded);
+        m_addressInUniverse.resize(padded);
+        m_flags.resize(padded);
+        m_start.resize(padded);
+        m_delta.resize(padded);
+        m_fadeTime.resize(padded);
+        m_elapsed.resize(padded);
+        m_target.resize(padded);
+        m_current.resize(padded);
+    }
+
+    // padding slots are left as 0 -> 0 fades
+    for (int i = index; i < m_universe.size(); i++)
+    {
+        m_start[i] = 0;
+        m_delta[i] = 0;
+        m_fadeTime[i] = 1;
+        m_elapsed[i] = 0;
+        m_target[i] = 0;
+        m_current[i] = 0;
+    }
+
+    m_universe[index] = address / UNIVERSE_SIZE;
+    m_addressInUniverse[index] = address % UNIVERSE_SIZE;
+
+    uchar flags = 0;
+    if (intensity)
+        flags |= Intensity;
+    if (canFade)
+        flags |= CanFade;
+    m_flags[index] = flags;
+
+    QHash<quint32, SlotState>::const_iterator it = m_remapped.constFind(address);
+    if (it != m_remapped.constEnd())
+    {
+        const SlotState &state = it.value();
+        m_start[index] = state.m_start;
+        m_delta[index] = state.m_delta;
+        m_fadeTime[index] = state.m_fadeTime;
+        m_elapsed[index] = state.m_elapsed;
+        m_target[index] = state.m_target;
+        m_current[index] = state.m_current;
+    }
+
+    return index;
+}
+
+void PixelFader::setTarget(int index, uchar target, uint fadeTime)
+{
+    if (m_target.at(index) != target)
+    {
+        m_start[index] = m_current.at(index);
+        m_delta[index] = float(int(target) - int(m_current.at(index)));
+        m_target[index] = target;
+        m_elapsed[index] = 0;
+    }
+
+    // a 0ms fade reaches the target at the next tick, like a 1ms one
+    m_fadeTime[index] = float(qMax(fadeTime, uint(1)));
+}
+
+uchar PixelFader::current(int index, qreal intensity) const
+{
+    return uchar(floor((qreal(m_current.at(index)) * intensity) + 0.5));
+}
+
+void PixelFader::advance(uint ms)
+{
+    const qint32 *start = m_start.constData();
+    const float *delta = m_delta.constData();
+    const float *fadeTime = m_fadeTime.constData();
+    float *elapsed = m_elapsed.data();
+    uchar *current = m_current.data();
+    float step = float(ms);
+    int i = 0;
+
+    // current = start + int((target - start) * (elapsed / fadeTime)),
+    // computed in double like FadeChannel::calculateCurrent() does, so
+    // that pixels fade through the very same values as the channels.
+    // Elapsed times stop at the fade time, so the last step lands right
+    // on the target
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 msVec = _mm_set1_ps(step);
+    int padded = (m_count + 3) & ~3;
+    for (; i < padded; i += 4)
+    {
+        __m128 fade = _mm_loadu_ps(fadeTime + i);
+        __m128 el = _mm_min_ps(_mm_add_ps(_mm_loadu_ps(elapsed + i), msVec), fade);
+        _mm_storeu_ps(elapsed + i, el);
+
+        // float holds the integer times and deltas exactly, the
+        // products are done on two pairs of doubles
+        __m128 d = _mm_loadu_ps(delta + i);
+        __m128d offsetLo = _mm_mul_pd(_mm_cvtps_pd(d),
+                                      _mm_div_pd(_mm_cvtps_pd(el), _mm_cvtps_pd(fade)));
+        __m128d offsetHi = _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(d, d)),
+                                      _mm_div_pd(_mm_cvtps_pd(_mm_movehl_ps(el, el)),
+                                                 _mm_cvtps_pd(_mm_movehl_ps(fade, fade))));
+        __m128i offset = _mm_unpacklo_epi64(_mm_cvttpd_epi32(offsetLo),
+                                            _mm_cvttpd_epi32(offsetHi));
+        __m128i value = _mm_add_epi32(_mm_loadu_si128((const __m128i *)(start + i)), offset);
+
+        value = _mm_packs_epi32(value, zero);
+        value = _mm_packus_epi16(value, zero);
+        int packed = _mm_cvtsi128_si32(value);
+        memcpy(current + i, &packed, 4);
+    }
+#endif
+
+    for (; i < m_count; i++)
+    {
+        float el = qMin(elapsed[i] + step, fadeTime[i]);
+        elapsed[i] = el;
+        current[i] = uchar(start[i] + int(qreal(delta[i]) * (qreal(el) / qreal(fadeTime[i]))));
+    }
+}
+
+void PixelFader::write(QList<Universe *> universes, bool paused)
+{
+    if (paused == false)
+        advance(MasterTimer::tick());
+
+    quint32 universesCount = quint32(universes.count());
+
+    for (int i = 0; i < m_count; i++)
+    {
+        if (m_universe.at(i) >= universesCount)
+            continue;
+
+        uchar value = m_current.at(i);
+        uchar flags = m_flags.at(i);
+
+        if (flags & Intensity)
+        {
+            // Intensity channels that faded out have no effect either way
+            if (m_blendMode == Universe::NormalBlend && value == 0 && m_target.at(i) == 0)
+                continue;
+
+            if (flags & CanFade)
+                value = current(i, m_intensity);
+        }
+
+        universes[m_universe.at(i)]->writeBlended(m_addressInUniverse.at(i), value, m_blendMode);
+    }
+}
+
+void PixelFader::adjustIntensity(qreal fraction)
+{
+    m_intensity = fraction;
+}
+
+qreal PixelFader::intensity() const
+{
+    return m_intensity;
+}
+
+void PixelFader::setBlendMode(Universe::BlendMode mode)
+{
+    m_blendMode = mode;
+}
@@ -0,0 +1,162 @@
+/*
+  Q Light Controller Plus
+  pixelfader.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef PIXELFADER_H
+#define PIXELFADER_H
+
+#include <QVector>
+#include <QHash>
+#include <QList>
+
+#include "universe.h"
+
+/** @addtogroup engine Engine
+ * @{
+ */
+
+/**
+ * PixelFader fades the channels of an RGB Matrix between two frames.
+ *
+ * Unlike GenericFader, the channels are set once when the matrix pixel
+ * map is compiled and then addressed by slot index, so a new step is
+ * a plain walk over the map with no lookup. Each slot holds the value
+ * the channel fades from (the previous frame) and the one it fades to
+ * (the next frame), and a tick interpolates all the slots at once, with
+ * SSE2 when available, before writing them to the universes.
+ *
+ * Values are computed with the same formula as FadeChannel, so a matrix
+ * fades as it did with GenericFader.
+ */
+class PixelFader
+{
+public:
+    PixelFader();
+    ~PixelFader();
+
+    /** Remove all the slots. Allocated memory is retained for reuse */
+    void clear();
+
+    /**
+     * Remove all the slots like clear(), but remember their fade state.
+     * The slots added next for one of the same addresses resume their
+     * fade where it was, so a map compiled again doesn't black out the
+     * pixels that are still there.
+     */
+    void remap();
+
+    /** Get the number of slots */
+    int count() const;
+
+    /**
+     * Add a slot for the channel at the absolute DMX $address
+     * (universe * UNIVERSE_SIZE + address).
+     *
+     * @param address The absolute DMX address of the channel
+     * @param intensity true if the channel belongs to the Intensity group
+     * @param canFade Whether the channel intensity can be adjusted
+     * @return The index of the new slot
+     */
+    int add(quint32 address, bool intensity, bool canFade);
+
+    /**
+     * Start a fade of the slot at $index towards $target, lasting $fadeTime
+     * milliseconds. If $target is the one already set, the running fade
+     * goes on untouched, otherwise it restarts from the current value.
+     */
+    void setTarget(int index, uchar target, uint fadeTime);
+
+    quint32 universe(int index) const { return m_universe[index]; }
+    quint32 addressInUniverse(int index) const { return m_addressInUniverse[index]; }
+
+    uchar start(int index) const { return uchar(m_start[index]); }
+    uchar target(int index) const { return m_target[index]; }
+    uchar current(int index) const { return m_current[index]; }
+
+    /** Get the current value at $index, modified by $intensity */
+    uchar current(int index, qreal intensity) const;
+
+    /** Get the fade time of the slot at $index. A 0ms fade is reported as 1ms */
+    uint fadeTime(int index) const { return uint(m_fadeTime[index]); }
+
+    /** Get the elapsed time of the slot at $index. It stops at the fade time */
+    uint elapsed(int index) const { return uint(m_elapsed[index]); }
+
+    /** Move all the fades forward by $ms milliseconds */
+    void advance(uint ms);
+
+    /**
+     * Run the fades forward by one tick and write the current values
+     * to $universes. Slots of universes not in the list are skipped.
+     *
+     * @param universes The universes that receive channel data
+     * @param paused When true, the current values are written as they are
+     */
+    void write(QList<Universe *> universes, bool paused = false);
+
+    /** Adjust the intensity of the Intensity channels by $fraction (0.0 - 1.0) */
+    void adjustIntensity(qreal fraction);
+    qreal intensity() const;
+
+    /** Set the blend mode used to write to the universes */
+    void setBlendMode(Universe::BlendMode mode);
+
+private:
+    enum SlotFlags
+    {
+        Intensity = 1 << 0,
+        CanFade   = 1 << 1
+    };
+
+    /** Fade state of a slot removed by remap() */
+    struct SlotState
+    {
+        qint32 m_start;
+        float m_delta;
+        float m_fadeTime;
+        float m_elapsed;
+        uchar m_target;
+        uchar m_current;
+    };
+
+    /** Number of slots in use. Vectors are padded to a multiple of 4 slots */
+    int m_count;
+
+    /* Output location */
+    QVector<quint32> m_universe;
+    QVector<quint16> m_addressInUniverse;
+    QVector<uchar> m_flags;
+
+    /* Fade state. Times are floats, so that 4 slots are computed at once */
+    QVector<qint32> m_start;
+    QVector<float> m_delta;
+    QVector<float> m_fadeTime;
+    QVector<float> m_elapsed;
+    QVector<uchar> m_target;
+    QVector<uchar> m_current;
+
+    /** Fade state of the slots removed by the latest remap(), by address */
+    QHash<quint32, SlotState> m_remapped;
+
+    qreal m_intensity;
+    Universe::BlendMode m_blendMode;
+};
+
+/** @} */
+
+#endif
@@ -28,6 +28,7 @@
 #include "rgbaudio.h"
 #include "rgbimage.h"
 #include "rgbplain.h"
+#include "rgbstream.h"
 #include "rgbtext.h"
 #include "doc.h"
 
@@ -39,15 +40,29 @@
 
 RGBAlgorithm::RGBAlgorithm(Doc * doc)
     : m_doc(doc)
+    , m_revision(0)
     , m_startColor(QColor())
     , m_endColor(QColor())
 {
 }
 
+void RGBAlgorithm::renderPreview(const QSize& size, uint rgb, int step, RGBFrame& frame)
+{
+    renderMap(size, rgb, step, frame);
+}
+
+RGBMap RGBAlgorithm::rgbMap(const QSize& size, uint rgb, int step)
+{
+    RGBFrame frame;
+    renderPreview(size, rgb, step, frame);
+    return frame.toMap();
+}
+
 void RGBAlgorithm::setColors(QColor start, QColor end)
 {
     m_startColor = start;
     m_endColor = end;
+    bumpRevision();
 }
 
 /****************************************************************************
@@ -61,10 +76,12 @@ QStringList RGBAlgorithm::algorithms(Doc * doc)
     RGBText text(doc);
     RGBImage image(doc);
     RGBAudio audio(doc);
+    RGBStream stream(doc);
     list << plain.name();
     list << text.name();
     list << image.name();
     list << audio.name();
+    list << stream.name();
     list << doc->rgbScriptsCache()->names();
     return list;
 }
@@ -75,6 +92,7 @@ RGBAlgorithm* RGBAlgorithm::algorithm(Doc * doc, const QString& name)
     RGBImage image(doc);
     RGBAudio audio(doc);
     RGBPlain plain(doc);
+    RGBStream stream(doc);
     if (name == text.name())
         return text.clone();
     else if (name == image.name())
@@ -83,6 +101,8 @@ RGBAlgorithm* RGBAlgorithm::algorithm(Doc * doc, const QString& name)
         return audio.clone();
     else if (name == plain.name())
         return plain.clone();
+    else if (name == stream.name())
+        return stream.clone();
     else
         return doc->rgbScriptsCache()->script(name).clone();
 }
@@ -132,6 +152,12 @@ RGBAlgorithm* RGBAlgorithm::loader(Doc * doc, QXmlStreamReader &root)
         if (plain.loadXML(root) == true)
             algo = plain.clone();
     }
+    else if (type == KXMLQLCRGBStream)
+    {
+        RGBStream stream(doc);
+        if (stream.loadXML(root) == true)
+            algo = stream.clone();
+    }
     else
     {
         qWarning() << "Unrecognized RGB algorithm type:" << type;
@@ -26,6 +26,8 @@
 #include <QColor>
 #include <QSize>
 
+#include "rgbframe.h"
+
 class QXmlStreamReader;
 class QXmlStreamWriter;
 
@@ -35,8 +37,6 @@ class Doc;
  * @{
  */
 
-typedef QVector<QVector<uint> > RGBMap;
-
 #define KXMLQLCRGBAlgorithm "Algorithm"
 #define KXMLQLCRGBAlgorithmType "Type"
 
@@ -52,7 +52,8 @@ public:
         Script,
         Image,
         Audio,
-        Plain
+        Plain,
+        Stream
     };
 
     /** Create a clone of the algorithm. Caller takes ownership of the pointer. */
@@ -65,6 +66,26 @@ private:
 
     Doc * m_doc;
 
+    /************************************************************************
+     * Frame caching
+     ************************************************************************/
+public:
+    /** Return true if the algorithm always renders the same frame for the
+     *  same size, color, step and settings. Frames of a deterministic
+     *  algorithm can be cached and reused by RGBMatrix */
+    virtual bool isDeterministic() const { return false; }
+
+    /** Get a number that changes every time the algorithm settings change.
+     *  Frames cached at a different revision are stale */
+    uint revision() const { return m_revision; }
+
+protected:
+    /** Mark the algorithm settings as changed */
+    void bumpRevision() { m_revision++; }
+
+private:
+    uint m_revision;
+
     /************************************************************************
      * RGB API
      ************************************************************************/
@@ -72,8 +93,22 @@ public:
     /** Maximum step count for rgbMap() function. */
     virtual int rgbMapStepCount(const QSize& size) = 0;
 
-    /** Get the RGBMap for the given step. */
-    virtual RGBMap rgbMap(const QSize& size, uint rgb, int step) = 0;
+    /** Render the given step into $frame, resizing it to $size. The caller
+     *  reuses $frame across steps, so rendering doesn't allocate memory */
+    virtual void renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame) = 0;
+
+    /** Render the given step into $frame for a preview. Unlike renderMap(),
+     *  this must not change the playback state of a running algorithm.
+     *  By default it is the same as renderMap() */
+    virtual void renderPreview(const QSize& size, uint rgb, int step, RGBFrame& frame);
+
+    /** Get the RGBMap for the given step. This is a copy of a frame
+     *  rendered with renderPreview(), for callers that don't run the
+     *  algorithm at every step, like the editor previews */
+    RGBMap rgbMap(const QSize& size, uint rgb, int step);
+
+    /** Acquire the resources needed to render the steps of a running matrix */
+    virtual void preRun() {}
 
     /** Release resources that may have been acquired in rgbMap() */
     virtual void postRun() {}
@@ -119,7 +119,7 @@ int RGBAudio::rgbMapStepCount(const QSize& size)
     return 1;
 }
 
-RGBMap RGBAudio::rgbMap(const QSize& size, uint rgb, int step)
+void RGBAudio::renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame)
 {
     Q_UNUSED(step);
 
@@ -129,12 +129,8 @@ RGBMap RGBAudio::rgbMap(const QSize& size, uint rgb, int step)
     if (capture.data() != m_audioInput)
         setAudioCapture(capture.data());
 
-    RGBMap map(size.height());
-    for (int y = 0; y < size.height(); y++)
-    {
-        map[y].resize(size.width());
-        map[y].fill(0);
-    }
+    frame.resize(size);
+    frame.fill(0);
 
     // on the first round, just set the proper number of
     // spectrum bands to receive
@@ -143,13 +139,13 @@ RGBMap RGBAudio::rgbMap(const QSize& size, uint rgb, int step)
         m_bandsNumber = size.width();
         qDebug() << "[RGBAudio] set" << m_bandsNumber << "bars";
         m_audioInput->registerBandsNumber(m_bandsNumber);
-        return map;
+        return;
     }
     if (m_barColors.count() == 0)
         calculateColors(size.height());
 
     double volHeight = (m_volumePower * size.height()) / 0x7FFF;
-    for (int x = 0; x < m_spectrumValues.count(); x++)
+    for (int x = 0; x < m_spectrumValues.count() && x < size.width(); x++)
     {
         int barHeight;
         if (m_maxMagnitude == 0)
@@ -163,13 +159,11 @@ RGBMap RGBAudio::rgbMap(const QSize& size, uint rgb, int step)
         for (int y = size.height() - barHeight; y < size.height(); y++)
         {
             if (m_barColors.count() == 0)
-                map[y][x] = rgb;
+                frame.setPixel(x, y, rgb);
             else
-                map[y][x] = m_barColors.at(y);
+                frame.setPixel(x, y, m_barColors.at(y));
         }
     }
-
-    return map;
 }
 
 void RGBAudio::postRun()
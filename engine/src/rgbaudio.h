@@ -71,7 +71,7 @@ public:
     int rgbMapStepCount(const QSize& size);
 
     /** @reimp */
-    RGBMap rgbMap(const QSize& size, uint rgb, int step);
+    void renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame);
 
     /** @reimp */
     virtual void postRun();
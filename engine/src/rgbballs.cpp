@@ -0,0 +1,195 @@
+/*
+  Q Light Controller Plus
+  rgbballs.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <math.h>
+
+#include "rgbballs.h"
+
+RGBBalls::RGBBalls(Doc * doc)
+    : RGBNativeScript(doc, "Balls", QStringList() << "presetSize" << "presetNumber"
+                                                  << "presetRandom" << "presetCollision")
+    , m_ballSize(1)
+    , m_ballsCount(5)
+    , m_randomColors(false)
+    , m_collision(false)
+    , m_initialized(false)
+{
+}
+
+/* Like RGBScript, a copy starts from the script defaults */
+RGBBalls::RGBBalls(const RGBBalls& s)
+    : RGBNativeScript(s)
+    , m_ballSize(1)
+    , m_ballsCount(5)
+    , m_randomColors(false)
+    , m_collision(false)
+    , m_initialized(false)
+{
+}
+
+RGBBalls::~RGBBalls()
+{
+}
+
+RGBAlgorithm* RGBBalls::clone() const
+{
+    RGBBalls* balls = new RGBBalls(*this);
+    return static_cast<RGBAlgorithm*> (balls);
+}
+
+int RGBBalls::rgbMapStepCount(const QSize& size)
+{
+    return size.width() * size.height();
+}
+
+void RGBBalls::initialize(const QSize& size)
+{
+    m_balls.resize(qMax(0, m_ballsCount));
+
+    for (int i = 0; i < m_balls.size(); i++)
+    {
+        Ball &ball = m_balls[i];
+        ball.m_x = randomValue() * (size.width() - 1);
+        ball.m_y = randomValue() * (size.height() - 1);
+        ball.m_stepY = randomValue() * 2 - 1;
+        ball.m_stepX = randomValue() * 2 - 1;
+
+        // pick colors that are not too dim
+        uint r, g, b;
+        do
+        {
+            r = uint(jsRound(randomValue() * 255));
+            g = uint(jsRound(randomValue() * 255));
+            b = uint(jsRound(randomValue() * 255));
+        } while (r + g + b < 356);
+        ball.m_color = (r << 16) + (g << 8) + b;
+    }
+
+    m_initialized = true;
+}
+
+void RGBBalls::renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame)
+{
+    Q_UNUSED(step)
+
+    if (m_initialized == false)
+        initialize(size);
+
+    frame.resize(size);
+    frame.fill(0);
+
+    int width = size.width();
+    int height = size.height();
+    double radius = m_ballSize / 2;
+    int boxSize = int(jsRound(radius));
+
+    for (int i = 0; i < m_balls.size(); i++)
+    {
+        Ball &ball = m_balls[i];
+        if (m_randomColors)
+            rgb = ball.m_color;
+
+        int r = (rgb >> 16) & 0x00FF;
+        int g = (rgb >> 8) & 0x00FF;
+        int b = rgb & 0x00FF;
+        int my = int(floor(ball.m_y));
+        int mx = int(floor(ball.m_x));
+
+        // draw the ball with faded edges, adding up to the other balls
+        for (int ry = qMax(0, my - boxSize); ry < my + boxSize + 2 && ry < height; ry++)
+        {
+            uint *line = frame.scanLine(ry);
+            for (int rx = qMax(0, mx - boxSize); rx < mx + boxSize + 2 && rx < width; rx++)
+            {
+                double offx = rx - ball.m_x;
+                double offy = ry - ball.m_y;
+                double hyp = 1 - (sqrt((offx * offx) + (offy * offy)) / (radius + 1));
+                if (hyp < 0)
+                    hyp = 0;
+
+                uint point = line[rx];
+                int pr = ((point >> 16) & 0x00FF) + int(jsRound(r * hyp));
+                int pg = ((point >> 8) & 0x00FF) + int(jsRound(g * hyp));
+                int pb = (point & 0x00FF) + int(jsRound(b * hyp));
+
+                line[rx] = (uint(qMin(pr, 255)) << 16) + (uint(qMin(pg, 255)) << 8) + uint(qMin(pb, 255));
+            }
+        }
+
+        if (m_collision)
+        {
+            // swap directions with the balls that are too close
+            for (int ti = 0; ti < m_balls.size(); ti++)
+            {
+                if (ti == i)
+                    continue;
+
+                Ball &other = m_balls[ti];
+                double disy = (ball.m_y + ball.m_stepY) - other.m_y;
+                double disx = (ball.m_x + ball.m_stepX) - other.m_x;
+                if (sqrt((disx * disx) + (disy * disy)) < 1.414 * radius)
+                {
+                    qSwap(ball.m_stepY, other.m_stepY);
+                    qSwap(ball.m_stepX, other.m_stepX);
+                }
+            }
+        }
+
+        // bounce on the edges
+        if (ball.m_y <= 0 && ball.m_stepY < 0)
+            ball.m_stepY *= -1;
+        else if (ball.m_y >= height - 1 && ball.m_stepY > 0)
+            ball.m_stepY *= -1;
+
+        if (ball.m_x <= 0 && ball.m_stepX < 0)
+            ball.m_stepX *= -1;
+        else if (ball.m_x >= width - 1 && ball.m_stepX > 0)
+            ball.m_stepX *= -1;
+
+        ball.m_y += ball.m_stepY;
+        ball.m_x += ball.m_stepX;
+    }
+}
+
+void RGBBalls::applyProperty(const QString& propertyName, const QString& value)
+{
+    if (propertyName == "presetSize")
+    {
+        m_ballSize = value.toDouble();
+    }
+    else if (propertyName == "presetNumber")
+    {
+        m_ballsCount = value.toInt();
+        m_initialized = false;
+    }
+    else if (propertyName == "presetRandom")
+    {
+        if (value == "Yes")
+            m_randomColors = true;
+        else if (value == "No")
+            m_randomColors = false;
+    }
+    else if (propertyName == "presetCollision")
+    {
+        if (value == "Yes")
+            m_collision = true;
+        else if (value == "No")
+            m_collision = false;
+    }
+}
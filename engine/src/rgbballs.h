@@ -0,0 +1,83 @@
+/*
+  Q Light Controller Plus
+  rgbballs.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef RGBBALLS_H
+#define RGBBALLS_H
+
+#include <QVector>
+
+#include "rgbnativescript.h"
+
+/** @addtogroup engine_functions Functions
+ * @{
+ */
+
+/**
+ * Native implementation of balls.js: balls bouncing on the edges of
+ * the matrix, and optionally on each other.
+ */
+class RGBBalls : public RGBNativeScript
+{
+public:
+    RGBBalls(Doc * doc);
+    RGBBalls(const RGBBalls& s);
+    ~RGBBalls();
+
+    /** @reimp */
+    RGBAlgorithm* clone() const;
+
+    /************************************************************************
+     * RGBAlgorithm API
+     ************************************************************************/
+public:
+    /** @reimp */
+    int rgbMapStepCount(const QSize& size);
+
+    /** @reimp */
+    void renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame);
+
+protected:
+    /** @reimp */
+    void applyProperty(const QString& propertyName, const QString& value);
+
+private:
+    /** Throw the balls at random positions and directions */
+    void initialize(const QSize& size);
+
+private:
+    double m_ballSize;
+    int m_ballsCount;
+    bool m_randomColors;
+    bool m_collision;
+    bool m_initialized;
+
+    struct Ball
+    {
+        double m_y;
+        double m_x;
+        double m_stepY;
+        double m_stepX;
+        uint m_color;
+    };
+    QVector<Ball> m_balls;
+};
+
+/** @} */
+
+#endif
@@ -0,0 +1,94 @@
+/*
+  Q Light Controller Plus
+  rgbframe.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <string.h>
+
+#include "rgbframe.h"
+
+RGBFrame::RGBFrame()
+    : m_width(0)
+    , m_height(0)
+    , m_stride(0)
+{
+}
+
+RGBFrame::RGBFrame(const QSize& size)
+    : m_width(0)
+    , m_height(0)
+    , m_stride(0)
+{
+    resize(size);
+}
+
+RGBFrame::~RGBFrame()
+{
+}
+
+void RGBFrame::resize(const QSize& size)
+{
+    m_width = qMax(0, size.width());
+    m_height = qMax(0, size.height());
+    m_stride = (m_width + 3) & ~3;
+
+    int pixels = m_stride * m_height;
+    // QVector keeps its capacity when shrinking
+    if (pixels != m_data.size())
+        m_data.resize(pixels);
+}
+
+void RGBFrame::fill(uint rgb)
+{
+    m_data.fill(rgb);
+}
+
+/****************************************************************************
+ * RGBMap compatibility
+ ****************************************************************************/
+
+RGBMap RGBFrame::toMap() const
+{
+    RGBMap map(m_height);
+    for (int y = 0; y < m_height; y++)
+    {
+        map[y].resize(m_width);
+        if (m_width > 0)
+            memcpy(map[y].data(), constScanLine(y), m_width * sizeof(uint));
+    }
+
+    return map;
+}
+
+void RGBFrame::fromMap(const RGBMap& map)
+{
+    int width = 0;
+    for (int y = 0; y < map.size(); y++)
+        width = qMax(width, map[y].size());
+
+    resize(QSize(width, map.size()));
+
+    for (int y = 0; y < m_height; y++)
+    {
+        uint *line = scanLine(y);
+        const QVector<uint>& row(map[y]);
+        if (row.size() > 0)
+            memcpy(line, row.constData(), row.size() * sizeof(uint));
+        for (int x = row.size(); x < m_width; x++)
+            line[x] = 0;
+    }
+}
@@ -0,0 +1,92 @@
+/*
+  Q Light Controller Plus
+  rgbframe.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef RGBFRAME_H
+#define RGBFRAME_H
+
+#include <QVector>
+#include <QSize>
+
+/** @addtogroup engine_functions Functions
+ * @{
+ */
+
+typedef QVector<QVector<uint> > RGBMap;
+
+/**
+ * RGBFrame is a contiguous buffer of RGB pixels, rendered by an RGBAlgorithm
+ * for a single step. Pixels are stored row by row and each row starts
+ * $stride pixels after the previous one. The stride is a multiple of 4
+ * pixels, so that rows are 16 bytes aligned with respect to the buffer
+ * start and whole rows can be processed with vector instructions.
+ *
+ * The allocated memory is kept when a frame is resized to the same or a
+ * smaller size, so a frame reused across steps doesn't allocate.
+ */
+class RGBFrame
+{
+public:
+    RGBFrame();
+    RGBFrame(const QSize& size);
+    ~RGBFrame();
+
+    /** Resize the frame to $size. Pixel values are undefined afterwards */
+    void resize(const QSize& size);
+
+    QSize size() const { return QSize(m_width, m_height); }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+
+    /** Distance in pixels between the start of two consecutive rows */
+    int stride() const { return m_stride; }
+
+    /** Return true if the frame holds no pixels */
+    bool isEmpty() const { return m_width == 0 || m_height == 0; }
+
+    /** Set all the pixels to $rgb */
+    void fill(uint rgb);
+
+    /** Get the pixels of row $y */
+    uint *scanLine(int y) { return m_data.data() + y * m_stride; }
+    const uint *constScanLine(int y) const { return m_data.constData() + y * m_stride; }
+
+    uint pixel(int x, int y) const { return m_data.at(y * m_stride + x); }
+    void setPixel(int x, int y, uint rgb) { m_data[y * m_stride + x] = rgb; }
+
+    /************************************************************************
+     * RGBMap compatibility
+     ************************************************************************/
+public:
+    /** Copy the frame into a new RGBMap */
+    RGBMap toMap() const;
+
+    /** Copy $map into the frame. The frame is as high as $map and as wide
+     *  as its longest row. Missing pixels of shorter rows are set to 0 */
+    void fromMap(const RGBMap& map);
+
+private:
+    int m_width;
+    int m_height;
+    int m_stride;
+    QVector<uint> m_data;
+};
+
+/** @} */
+
+#endif
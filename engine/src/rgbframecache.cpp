@@ -0,0 +1,85 @@
+/*
+  Q Light Controller Plus
+  rgbframecache.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include "rgbframecache.h"
+
+RGBFrameCache::RGBFrameCache(int budget)
+    : m_frames(qMax(0, budget))
+    , m_revision(0)
+{
+}
+
+RGBFrameCache::~RGBFrameCache()
+{
+}
+
+void RGBFrameCache::setBudget(int bytes)
+{
+    // frames are evicted if they don't fit anymore
+    m_frames.setMaxCost(qMax(0, bytes));
+}
+
+int RGBFrameCache::budget() const
+{
+    return m_frames.maxCost();
+}
+
+const RGBFrame *RGBFrameCache::frame(const QSize& size, uint rgb, int step, uint revision)
+{
+    checkRevision(revision);
+
+    RGBFrameKey key = { size.width(), size.height(), rgb, step };
+    return m_frames.object(key);
+}
+
+void RGBFrameCache::insert(const QSize& size, uint rgb, int step, uint revision, const RGBFrame& frame)
+{
+    checkRevision(revision);
+
+    int cost = frame.stride() * frame.height() * int(sizeof(uint));
+    if (cost > m_frames.maxCost())
+        return;
+
+    RGBFrameKey key = { size.width(), size.height(), rgb, step };
+    m_frames.insert(key, new RGBFrame(frame), cost);
+}
+
+void RGBFrameCache::clear()
+{
+    m_frames.clear();
+}
+
+int RGBFrameCache::count() const
+{
+    return m_frames.count();
+}
+
+int RGBFrameCache::memoryUsage() const
+{
+    return m_frames.totalCost();
+}
+
+void RGBFrameCache::checkRevision(uint revision)
+{
+    if (revision == m_revision)
+        return;
+
+    m_frames.clear();
+    m_revision = revision;
+}
@@ -0,0 +1,101 @@
+/*
+  Q Light Controller Plus
+  rgbframecache.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef RGBFRAMECACHE_H
+#define RGBFRAMECACHE_H
+
+#include <QCache>
+#include <QHash>
+
+#include "rgbframe.h"
+
+/** @addtogroup engine_functions Functions
+ * @{
+ */
+
+/** Inputs an algorithm renders a frame from */
+struct RGBFrameKey
+{
+    int m_width;
+    int m_height;
+    uint m_rgb;
+    int m_step;
+
+    bool operator==(const RGBFrameKey& other) const
+    {
+        return m_width == other.m_width && m_height == other.m_height &&
+               m_rgb == other.m_rgb && m_step == other.m_step;
+    }
+};
+
+inline uint qHash(const RGBFrameKey& key, uint seed = 0)
+{
+    return qHash(key.m_step, seed) ^ qHash(key.m_rgb, seed) ^
+           qHash((key.m_width << 16) | key.m_height, seed);
+}
+
+/**
+ * RGBFrameCache holds the frames rendered by a deterministic RGBAlgorithm,
+ * so that a matrix running in loop renders each step only once.
+ *
+ * Frames are kept within a memory budget, and the least recently used
+ * ones are evicted first. All the frames are dropped when the algorithm
+ * revision changes, since they no longer match the algorithm settings.
+ */
+class RGBFrameCache
+{
+public:
+    RGBFrameCache(int budget = 0);
+    ~RGBFrameCache();
+
+    /** Set the maximum memory, in bytes, taken by the cached frames.
+     *  A budget of 0 disables the cache */
+    void setBudget(int bytes);
+    int budget() const;
+
+    /** Get the frame rendered for $size, $rgb and $step by an algorithm
+     *  at $revision, or NULL if not cached. The frame is valid until the
+     *  next insert() */
+    const RGBFrame *frame(const QSize& size, uint rgb, int step, uint revision);
+
+    /** Cache a copy of $frame, rendered for $size, $rgb and $step by an
+     *  algorithm at $revision */
+    void insert(const QSize& size, uint rgb, int step, uint revision, const RGBFrame& frame);
+
+    /** Drop all the cached frames */
+    void clear();
+
+    /** Number of cached frames */
+    int count() const;
+
+    /** Memory, in bytes, taken by the cached frames */
+    int memoryUsage() const;
+
+private:
+    /** Drop the frames if they don't belong to $revision */
+    void checkRevision(uint revision);
+
+private:
+    QCache<RGBFrameKey, RGBFrame> m_frames;
+    uint m_revision;
+};
+
+/** @} */
+
+#endif
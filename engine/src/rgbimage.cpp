@@ -99,6 +99,7 @@ void RGBImage::setImageData(int width, int height, const QByteArray &pixelData)
         }
     }
     m_image = newImg;
+    bumpRevision();
 }
 
 void RGBImage::reloadImage()
@@ -111,6 +112,7 @@ void RGBImage::reloadImage()
 
     QMutexLocker locker(&m_mutex);
 
+    bumpRevision();
     if (!m_image.load(m_filename))
     {
         qDebug() << "[RGBImage] Failed to load" << m_filename;
@@ -128,6 +130,7 @@ void RGBImage::setAnimationStyle(RGBImage::AnimationStyle ani)
         m_animationStyle = ani;
     else
         m_animationStyle = Static;
+    bumpRevision();
 }
 
 RGBImage::AnimationStyle RGBImage::animationStyle() const
@@ -176,6 +179,7 @@ QStringList RGBImage::animationStyles()
 void RGBImage::setXOffset(int offset)
 {
     m_xOffset = offset;
+    bumpRevision();
 }
 
 int RGBImage::xOffset() const
@@ -186,6 +190,7 @@ int RGBImage::xOffset() const
 void RGBImage::setYOffset(int offset)
 {
     m_yOffset = offset;
+    bumpRevision();
 }
 
 int RGBImage::yOffset() const
@@ -216,14 +221,22 @@ int RGBImage::rgbMapStepCount(const QSize& size)
     }
 }
 
-RGBMap RGBImage::rgbMap(const QSize& size, uint rgb, int step)
+bool RGBImage::isDeterministic() const
+{
+    return true;
+}
+
+void RGBImage::renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame)
 {
     Q_UNUSED(rgb);
 
     QMutexLocker locker(&m_mutex);
 
     if (m_image.width() == 0 || m_image.height() == 0)
-        return RGBMap();
+    {
+        frame.resize(QSize());
+        return;
+    }
 
     int xOffs = xOffset();
     int yOffs = yOffset();
@@ -244,22 +257,20 @@ RGBMap RGBImage::rgbMap(const QSize& size, uint rgb, int step)
         break;
     }
 
-    RGBMap map(size.height());
+    frame.resize(size);
     for (int y = 0; y < size.height(); y++)
     {
-        map[y].resize(size.width());
+        uint *line = frame.scanLine(y);
+        int y1 = (y + yOffs) % m_image.height();
+
         for (int x = 0; x < size.width(); x++)
         {
             int x1 = (x + xOffs) % m_image.width();
-            int y1 = (y + yOffs) % m_image.height();
 
-            map[y][x] = m_image.pixel(x1,y1);
-            if (qAlpha(map[y][x]) == 0)
-                map[y][x] = 0;
+            QRgb pixel = m_image.pixel(x1, y1);
+            line[x] = qAlpha(pixel) == 0 ? 0 : pixel;
         }
     }
-
-    return map;
 }
 
 QString RGBImage::name() const
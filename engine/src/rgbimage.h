@@ -98,7 +98,10 @@ public:
     int rgbMapStepCount(const QSize& size);
 
     /** @reimp */
-    RGBMap rgbMap(const QSize& size, uint rgb, int step);
+    bool isDeterministic() const;
+
+    /** @reimp */
+    void renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame);
 
     /** @reimp */
     QString name() const;
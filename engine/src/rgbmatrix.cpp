@@ -22,14 +22,16 @@
 #include <QXmlStreamWriter>
 #include <QCoreApplication>
 #include <QElapsedTimer>
+#include <QSettings>
 #include <QDebug>
 #include <cmath>
 #include <QDir>
 
 #include "qlcfixturehead.h"
 #include "fixturegroup.h"
-#include "genericfader.h"
+#include "fadechanneltable.h"
 #include "fadechannel.h"
+#include "pixelfader.h"
 #include "rgbmatrix.h"
 #include "qlcmacros.h"
 #include "rgbaudio.h"
@@ -41,6 +43,11 @@
 #define KXMLQLCRGBMatrixFixtureGroup "FixtureGroup"
 #define KXMLQLCRGBMatrixDimmerControl "DimmerControl"
 
+#define RGBMATRIX_FRAMECACHE "rgbmatrix/framecache"
+
+/** Default memory budget, in kB, of the frame cache of each matrix */
+#define RGBMATRIX_FRAMECACHE_DEFAULT 4096
+
 #define KXMLQLCRGBMatrixProperty "Property"
 #define KXMLQLCRGBMatrixPropertyName "Name"
 #define KXMLQLCRGBMatrixPropertyValue "Value"
@@ -63,10 +70,30 @@ RGBMatrix::RGBMatrix(Doc* doc)
     , m_roundTime(new QElapsedTimer())
     , m_stepsCount(0)
     , m_stepBeatDuration(0)
+    , m_stepPrepared(false)
+    , m_stepChanged(false)
+    , m_mapDirty(true)
+    , m_mapSlots(0)
 {
     setName(tr("New RGB Matrix"));
     setDuration(500);
 
+    static int frameCacheBudget = -1;
+    if (frameCacheBudget == -1)
+    {
+        frameCacheBudget = RGBMATRIX_FRAMECACHE_DEFAULT;
+        QSettings settings;
+        QVariant var = settings.value(RGBMATRIX_FRAMECACHE);
+        if (var.isValid() == true)
+            frameCacheBudget = var.toInt();
+    }
+    setFrameCacheBudget(frameCacheBudget * 1024);
+
+    connect(doc, SIGNAL(fixtureChanged(quint32)),
+            this, SLOT(slotFixtureChanged(quint32)));
+    connect(doc, SIGNAL(fixtureGroupChanged(quint32)),
+            this, SLOT(slotFixtureGroupChanged(quint32)));
+
     RGBScript scr = doc->rgbScriptsCache()->script("Stripes");
     setAlgorithm(scr.clone());
 }
@@ -116,6 +143,7 @@ quint32 RGBMatrix::totalDuration()
 void RGBMatrix::setDimmerControl(bool dimmerControl)
 {
     m_dimmerControl = dimmerControl;
+    invalidateMap();
 }
 
 bool RGBMatrix::dimmerControl() const
@@ -174,6 +202,7 @@ void RGBMatrix::setFixtureGroup(quint32 id)
     {
         QMutexLocker algoLocker(&m_algorithmMutex);
         m_group = doc()->fixtureGroup(m_fixtureGroupID);
+        m_mapDirty = true;
     }
     m_stepsCount = stepsCount();
 }
@@ -193,6 +222,10 @@ void RGBMatrix::setAlgorithm(RGBAlgorithm* algo)
         QMutexLocker algorithmLocker(&m_algorithmMutex);
         delete m_algorithm;
         m_algorithm = algo;
+        m_frameCache.clear();
+
+        if (m_algorithm != NULL && isRunning())
+            m_algorithm->preRun();
 
         /** If there's been a change of Script algorithm "on the fly",
          *  then re-apply the properties currently set in this RGBMatrix */
@@ -498,13 +531,15 @@ void RGBMatrix::preRun(MasterTimer* timer)
         if (m_algorithm != NULL)
         {
             Q_ASSERT(m_fader == NULL);
-            m_fader = new GenericFader(doc());
+            m_fader = new PixelFader();
             m_fader->adjustIntensity(getAttributeValue(Intensity));
             m_fader->setBlendMode(blendMode());
 
             // Copy direction from parent class direction
             m_stepHandler->initializeDirection(direction(), m_startColor, m_endColor, m_stepsCount);
 
+            m_algorithm->preRun();
+
             if (m_algorithm->type() == RGBAlgorithm::Script)
             {
                 RGBScript *script = static_cast<RGBScript*> (m_algorithm);
@@ -516,17 +551,20 @@ void RGBMatrix::preRun(MasterTimer* timer)
                 }
             }
         }
+
+        // also sets up the slots of m_fader
+        compileMap();
+        m_stepChanged = true;
     }
 
     m_roundTime->restart();
+    m_stepPrepared = false;
 
     Function::preRun(timer);
 }
 
 void RGBMatrix::write(MasterTimer* timer, QList<Universe *> universes)
 {
-    Q_UNUSED(timer);
-
     {
         QMutexLocker algorithmLocker(&m_algorithmMutex);
         if (m_group == NULL)
@@ -544,19 +582,9 @@ void RGBMatrix::write(MasterTimer* timer, QList<Universe *> universes)
         if (m_algorithm == NULL || m_algorithm->apiVersion() == 0)
             return;
 
-        if (isPaused() == false)
-        {
-            // Get a new map every time elapsed is reset to zero
-            if (elapsed() < MasterTimer::tick())
-            {
-                if (tempoType() == Beats)
-                    m_stepBeatDuration = beatsToTime(duration(), timer->beatTimeDuration());
-
-                //qDebug() << "RGBMatrix step" << m_stepHandler->currentStepIndex() << ", color:" << QString::number(m_stepHandler->stepColor().rgb(), 16);
-                RGBMap map = m_algorithm->rgbMap(m_group->size(), m_stepHandler->stepColor().rgb(), m_stepHandler->currentStepIndex());
-                updateMapChannels(map, m_group);
-            }
-        }
+        if (m_stepPrepared == false)
+            renderStep(timer);
+        m_stepPrepared = false;
     }
 
     // Run the generic fader that takes care of fading in/out individual channels
@@ -603,32 +631,73 @@ void RGBMatrix::write(MasterTimer* timer, QList<Universe *> universes)
     }
 }
 
+bool RGBMatrix::supportsPrepareWrite() const
+{
+    return true;
+}
+
+void RGBMatrix::prepareWrite(MasterTimer *timer)
+{
+    QMutexLocker algorithmLocker(&m_algorithmMutex);
+
+    renderStep(timer);
+    m_stepPrepared = true;
+}
+
+void RGBMatrix::renderStep(MasterTimer *timer)
+{
+    if (m_group == NULL || m_fader == NULL || duration() == 0)
+        return;
+
+    if (m_algorithm == NULL || m_algorithm->apiVersion() == 0)
+        return;
+
+    if (isPaused() == false)
+    {
+        // Get a new map every time a new step begins
+        if (m_stepChanged)
+        {
+            m_stepChanged = false;
+
+            if (tempoType() == Beats)
+                m_stepBeatDuration = beatsToTime(duration(), timer->beatTimeDuration());
+
+            //qDebug() << "RGBMatrix step" << m_stepHandler->currentStepIndex() << ", color:" << QString::number(m_stepHandler->stepColor().rgb(), 16);
+            const RGBFrame& frame = renderFrame(m_group->size(), m_stepHandler->stepColor().rgb(),
+                                                m_stepHandler->currentStepIndex());
+            updateMapChannels(frame, m_group);
+        }
+    }
+}
+
 void RGBMatrix::postRun(MasterTimer* timer, QList<Universe *> universes)
 {
     if (m_fader != NULL)
     {
-        QHashIterator <FadeChannel,FadeChannel> it(m_fader->channels());
-        while (it.hasNext() == true)
+        QVector<bool> done(m_fader->count(), false);
+
+        for (int i = 0; i < m_mapChannels.count(); i++)
         {
-            it.next();
-            FadeChannel fc = it.value();
-            // fade out only intensity channels
-            if (fc.group(doc()) != QLCChannel::Intensity)
+            const MapChannel& mc(m_mapChannels.at(i));
+            // fade out only intensity channels, once per slot
+            if (mc.m_group != QLCChannel::Intensity || done.at(mc.m_slot))
                 continue;
+            done[mc.m_slot] = true;
 
-            bool canFade = true;
-            Fixture *fixture = doc()->fixture(fc.fixture());
-            if (fixture != NULL)
-                canFade = fixture->channelCanFade(fc.channel());
-            fc.setStart(fc.current(getAttributeValue(Intensity)));
-            fc.setCurrent(fc.current(getAttributeValue(Intensity)));
+            uchar value = m_fader->current(mc.m_slot, getAttributeValue(Intensity));
+            if (value == 0)
+                continue;
+
+            FadeChannel fc(mc.m_fadeChannel);
+            fc.setStart(value);
+            fc.setCurrent(value);
 
             fc.setElapsed(0);
             fc.setReady(false);
-            if (canFade == false)
+            if (mc.m_canFade == false)
             {
                 fc.setFadeTime(0);
-                fc.setTarget(fc.current(getAttributeValue(Intensity)));
+                fc.setTarget(value);
             }
             else
             {
@@ -664,6 +733,7 @@ void RGBMatrix::roundCheck()
         stop(FunctionParent::master());
 
     m_roundTime->restart();
+    m_stepChanged = true;
 
     if (tempoType() == Beats)
         roundElapsed(m_stepBeatDuration);
@@ -671,17 +741,145 @@ void RGBMatrix::roundCheck()
         roundElapsed(duration());
 }
 
-void RGBMatrix::updateMapChannels(const RGBMap& map, const FixtureGroup* grp)
+const RGBFrame& RGBMatrix::renderFrame(const QSize& size, uint rgb, int step)
 {
+    if (m_frameCache.budget() == 0 || m_algorithm->isDeterministic() == false)
+    {
+        m_algorithm->renderMap(size, rgb, step, m_frame);
+        return m_frame;
+    }
+
+    const RGBFrame *cached = m_frameCache.frame(size, rgb, step, m_algorithm->revision());
+    if (cached != NULL)
+        return *cached;
+
+    m_algorithm->renderMap(size, rgb, step, m_frame);
+    m_frameCache.insert(size, rgb, step, m_algorithm->revision(), m_frame);
+
+    return m_frame;
+}
+
+void RGBMatrix::updateMapChannels(const RGBFrame& frame, const FixtureGroup* grp)
+{
+    if (m_mapDirty == true || m_mapSize != grp->size())
+        compileMap();
+
     uint fadeTime = (overrideFadeInSpeed() == defaultSpeed()) ? fadeInSpeed() : overrideFadeInSpeed();
+    uint fadeOutTime = fadeOutSpeed();
+    const MapChannel* mapChannels = m_mapChannels.constData();
+    const int* pixels = m_mapPixels.constData();
+    int width = qMin(frame.width(), m_mapSize.width());
+    int height = qMin(frame.height(), m_mapSize.height());
+
+    // Set the fader slots of ALL pixels in the color map.
+    // Slots already fading to the same target keep fading.
+    for (int y = 0; y < height; y++)
+    {
+        const uint *row = frame.constScanLine(y);
+
+        for (int x = 0; x < width; x++)
+        {
+            int pixel = y * m_mapSize.width() + x;
+            uint col = row[x];
+
+            for (int i = pixels[pixel]; i < pixels[pixel + 1]; i++)
+            {
+                const MapChannel& mc(mapChannels[i]);
+                uchar target;
+
+                switch (mc.m_component)
+                {
+                    case MapRed: target = qRed(col); break;
+                    case MapGreen: target = qGreen(col); break;
+                    case MapBlue: target = qBlue(col); break;
+                    case MapCyan: target = QColor(col).cyan(); break;
+                    case MapMagenta: target = QColor(col).magenta(); break;
+                    case MapYellow: target = QColor(col).yellow(); break;
+                    // the weights are taken from
+                    // https://en.wikipedia.org/wiki/YUV#SDTV_with_BT.601
+                    case MapGray: target = 0.299 * qRed(col) + 0.587 * qGreen(col) + 0.114 * qBlue(col); break;
+                    default: target = col == 0 ? 0 : 255; break;
+                }
+
+                // Fade in speed is used for all non-zero targets
+                m_fader->setTarget(mc.m_slot, target, target == 0 ? fadeOutTime : fadeTime);
+            }
+        }
+    }
+}
+
+/****************************************************************************
+ * Frame cache
+ ****************************************************************************/
+
+void RGBMatrix::setFrameCacheBudget(int bytes)
+{
+    QMutexLocker algorithmLocker(&m_algorithmMutex);
+    m_frameCache.setBudget(bytes);
+}
+
+int RGBMatrix::frameCacheBudget()
+{
+    QMutexLocker algorithmLocker(&m_algorithmMutex);
+    return m_frameCache.budget();
+}
+
+/****************************************************************************
+ * Pixel map
+ ****************************************************************************/
+
+void RGBMatrix::slotFixtureRemoved(quint32 fxi_id)
+{
+    Q_UNUSED(fxi_id);
+    invalidateMap();
+}
+
+void RGBMatrix::slotFixtureChanged(quint32 fxi_id)
+{
+    Q_UNUSED(fxi_id);
+    invalidateMap();
+}
 
-    // Create/modify fade channels for ALL pixels in the color map.
-    for (int y = 0; y < map.size(); y++)
+void RGBMatrix::slotFixtureGroupChanged(quint32 id)
+{
+    if (id == m_fixtureGroupID)
+        invalidateMap();
+}
+
+void RGBMatrix::invalidateMap()
+{
+    QMutexLocker algorithmLocker(&m_algorithmMutex);
+    m_mapDirty = true;
+}
+
+void RGBMatrix::compileMap()
+{
+    m_mapChannels.clear();
+    m_mapPixels.clear();
+    m_mapSize = QSize();
+    m_mapDirty = false;
+    m_mapSlots = 0;
+
+    // slots on the same addresses keep fading from their current values
+    if (m_fader != NULL)
+        m_fader->remap();
+
+    if (m_group == NULL)
+        return;
+
+    QHash<quint32, int> addressSlots;
+
+    m_mapSize = m_group->size();
+    m_mapPixels.reserve(m_mapSize.width() * m_mapSize.height() + 1);
+
+    for (int y = 0; y < m_mapSize.height(); y++)
     {
-        for (int x = 0; x < map[y].size(); x++)
+        for (int x = 0; x < m_mapSize.width(); x++)
         {
+            m_mapPixels.append(m_mapChannels.size());
+
             QLCPoint pt(x, y);
-            GroupHead grpHead(grp->head(pt));
+            GroupHead grpHead(m_group->head(pt));
             Fixture* fxi = doc()->fixture(grpHead.fxi);
             if (fxi == NULL)
                 continue;
@@ -698,7 +896,7 @@ void RGBMatrix::updateMapChannels(const RGBMap& map, const FixtureGroup* grp)
             // They are the master dimmer (affects whole fixture)
             // and per-head dimmer.
             //
-            // If there are no RGB or CMY channels, the least important* dimmer channel 
+            // If there are no RGB or CMY channels, the least important* dimmer channel
             // is used to create grayscale image.
             //
             // The rest of the dimmer channels are set to full if dimmer control is
@@ -708,7 +906,7 @@ void RGBMatrix::updateMapChannels(const RGBMap& map, const FixtureGroup* grp)
             // Note: If there is only one head, and only one dimmer channel,
             // make it a master dimmer in fixture definition.
             //
-            // *least important - per head dimmer if present, 
+            // *least important - per head dimmer if present,
             // otherwise per fixture dimmer if present
             QVector <quint32> dim;
             if (masterDim != QLCChannel::invalid())
@@ -717,67 +915,26 @@ void RGBMatrix::updateMapChannels(const RGBMap& map, const FixtureGroup* grp)
             if (headDim != QLCChannel::invalid())
                 dim << headDim;
 
-            uint col = map[y][x];
+            QList <QPair<quint32, MapComponent> > channels;
 
             if (rgb.size() == 3)
             {
                 // RGB color mixing
-                {
-                    FadeChannel fc(doc(), grpHead.fxi, rgb.at(0));
-                    fc.setTarget(qRed(col));
-                    insertStartValues(fc, fadeTime);
-                    m_fader->add(fc);
-                }
-
-                {
-                    FadeChannel fc(doc(), grpHead.fxi, rgb.at(1));
-                    fc.setTarget(qGreen(col));
-                    insertStartValues(fc, fadeTime);
-                    m_fader->add(fc);
-                }
-
-                {
-                    FadeChannel fc(doc(), grpHead.fxi, rgb.at(2));
-                    fc.setTarget(qBlue(col));
-                    insertStartValues(fc, fadeTime);
-                    m_fader->add(fc);
-                }
+                channels << qMakePair(rgb.at(0), MapRed);
+                channels << qMakePair(rgb.at(1), MapGreen);
+                channels << qMakePair(rgb.at(2), MapBlue);
             }
             else if (cmy.size() == 3)
             {
                 // CMY color mixing
-                QColor cmyCol(col);
-
-                {
-                    FadeChannel fc(doc(), grpHead.fxi, cmy.at(0));
-                    fc.setTarget(cmyCol.cyan());
-                    insertStartValues(fc, fadeTime);
-                    m_fader->add(fc);
-                }
-
-                {
-                    FadeChannel fc(doc(), grpHead.fxi, cmy.at(1));
-                    fc.setTarget(cmyCol.magenta());
-                    insertStartValues(fc, fadeTime);
-                    m_fader->add(fc);
-                }
-
-                {
-                    FadeChannel fc(doc(), grpHead.fxi, cmy.at(2));
-                    fc.setTarget(cmyCol.yellow());
-                    insertStartValues(fc, fadeTime);
-                    m_fader->add(fc);
-                }
+                channels << qMakePair(cmy.at(0), MapCyan);
+                channels << qMakePair(cmy.at(1), MapMagenta);
+                channels << qMakePair(cmy.at(2), MapYellow);
             }
             else if (!dim.empty())
             {
                 // Set dimmer to value of the color (e.g. for PARs)
-                FadeChannel fc(doc(), grpHead.fxi, dim.last());
-                // the weights are taken from
-                // https://en.wikipedia.org/wiki/YUV#SDTV_with_BT.601
-                fc.setTarget(0.299 * qRed(col) + 0.587 * qGreen(col) + 0.114 * qBlue(col));
-                insertStartValues(fc, fadeTime);
-                m_fader->add(fc);
+                channels << qMakePair(dim.last(), MapGray);
                 dim.pop_back();
             }
 
@@ -785,51 +942,40 @@ void RGBMatrix::updateMapChannels(const RGBMap& map, const FixtureGroup* grp)
             {
                 // Set the rest of the dimmer channels to full on
                 foreach(quint32 ch, dim)
-                {
-                    FadeChannel fc(doc(), grpHead.fxi, ch);
-                    fc.setTarget(col == 0 ? 0 : 255);
-                    insertStartValues(fc, fadeTime);
-                    m_fader->add(fc);
-                }
+                    channels << qMakePair(ch, MapDimmerOn);
             }
-        }
-    }
-}
 
-void RGBMatrix::insertStartValues(FadeChannel& fc, uint fadeTime) const
-{
-    Q_ASSERT(m_fader != NULL);
+            for (int i = 0; i < channels.size(); i++)
+            {
+                MapChannel mc;
+                mc.m_fadeChannel = FadeChannel(doc(), grpHead.fxi, channels.at(i).first);
+                mc.m_address = FadeChannelTable::keyOf(mc.m_fadeChannel);
+                if (mc.m_address == UINT_MAX)
+                    continue;
+
+                mc.m_group = mc.m_fadeChannel.group(doc());
+                mc.m_canFade = mc.m_fadeChannel.canFade(doc());
+                mc.m_component = channels.at(i).second;
+
+                QHash<quint32, int>::const_iterator it = addressSlots.constFind(mc.m_address);
+                if (it != addressSlots.constEnd())
+                {
+                    mc.m_slot = it.value();
+                }
+                else
+                {
+                    mc.m_slot = m_mapSlots++;
+                    addressSlots.insert(mc.m_address, mc.m_slot);
+                    if (m_fader != NULL)
+                        m_fader->add(mc.m_address, mc.m_group == QLCChannel::Intensity, mc.m_canFade);
+                }
 
-    // To create a nice and smooth fade, get the starting value from
-    // m_fader's existing FadeChannel (if any). Otherwise just assume
-    // we're starting from zero.
-    QHash <FadeChannel,FadeChannel>::const_iterator oldChannelIterator = m_fader->channels().find(fc);
-    if (oldChannelIterator != m_fader->channels().end())
-    {
-        FadeChannel old = oldChannelIterator.value();
-        fc.setCurrent(old.current());
-        if (fc.target() == old.target())
-        {
-            fc.setStart(old.start());
-            fc.setElapsed(old.elapsed());
+                m_mapChannels.append(mc);
+            }
         }
-        else
-            fc.setStart(old.current());
-    }
-    else
-    {
-        fc.setCurrent(0);
-        fc.setStart(0);
     }
 
-    // The channel is not ready yet
-    fc.setReady(false);
-
-    // Fade in speed is used for all non-zero targets
-    if (fc.target() == 0)
-        fc.setFadeTime(fadeOutSpeed());
-    else
-        fc.setFadeTime(fadeTime);
+    m_mapPixels.append(m_mapChannels.size());
 }
 
 /*********************************************************************
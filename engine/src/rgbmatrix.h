@@ -35,12 +35,13 @@
 #else
   #include "rgbscript.h"
 #endif
+#include "rgbframecache.h"
+#include "fadechannel.h"
 #include "function.h"
 
 class QElapsedTimer;
 class FixtureGroup;
-class GenericFader;
-class FadeChannel;
+class PixelFader;
 class QDir;
 
 /** @addtogroup engine_functions Functions
@@ -221,6 +222,12 @@ public:
     /** @reimp */
     void write(MasterTimer* timer, QList<Universe*> universes);
 
+    /** @reimp */
+    bool supportsPrepareWrite() const;
+
+    /** @reimp */
+    void prepareWrite(MasterTimer* timer);
+
     /** @reimp */
     void postRun(MasterTimer* timer, QList<Universe*> universes);
 
@@ -228,16 +235,21 @@ private:
     /** Check what should be done when elapsed() >= duration() */
     void roundCheck();
 
-    /** Update new FadeChannels to m_fader when $map has changed since last time */
-    void updateMapChannels(const RGBMap& map, const FixtureGroup* grp);
+    /** Render the current step into m_fader, if a new step has begun.
+     *  m_algorithmMutex must be locked by the caller */
+    void renderStep(MasterTimer* timer);
 
-    /** Grab starting values for a fade channel from $fader if available */
-    void insertStartValues(FadeChannel& fc, uint fadeTime) const;
+    /** Render the frame of $step, or get it from m_frameCache when the
+     *  algorithm is deterministic */
+    const RGBFrame& renderFrame(const QSize& size, uint rgb, int step);
+
+    /** Set the targets of the m_fader slots to the colors of $frame */
+    void updateMapChannels(const RGBFrame& frame, const FixtureGroup* grp);
 
 private:
-    /** Reference of a GenericFader in charge of actually sending DMX data
+    /** Reference of a PixelFader in charge of actually sending DMX data
      *  of the current RGB Matrix step, including fade transitions */
-    GenericFader* m_fader;
+    PixelFader* m_fader;
 
     /** Reference to a timer counting the time in ms between steps */
     QElapsedTimer* m_roundTime;
@@ -248,6 +260,96 @@ private:
     /** The duration of a step based on the current BPM (Beats tempo only) */
     uint m_stepBeatDuration;
 
+    /** Flag set when the current tick's step has been rendered by prepareWrite() */
+    bool m_stepPrepared;
+
+    /** Flag set when a new step begins, cleared when its frame is rendered.
+     *  Guarded by m_algorithmMutex */
+    bool m_stepChanged;
+
+    /** The frame rendered by the algorithm, reused at every step */
+    RGBFrame m_frame;
+
+    /************************************************************************
+     * Frame cache
+     ************************************************************************/
+public:
+    /** Set the memory, in bytes, used to cache the frames rendered by
+     *  deterministic algorithms. A budget of 0 disables the cache */
+    void setFrameCacheBudget(int bytes);
+    int frameCacheBudget();
+
+private:
+    /** The frames already rendered by a deterministic algorithm */
+    RGBFrameCache m_frameCache;
+
+    /************************************************************************
+     * Pixel map
+     ************************************************************************/
+protected slots:
+    /** @reimp */
+    void slotFixtureRemoved(quint32 fxi_id);
+
+    /** Invalidate the pixel map when a fixture of the group changes */
+    void slotFixtureChanged(quint32 fxi_id);
+
+    /** Invalidate the pixel map when the matrix fixture group changes */
+    void slotFixtureGroupChanged(quint32 id);
+
+private:
+    /** Resolve once the channels controlled by each pixel of m_group, so that
+     *  rendering a step doesn't have to look up fixtures and heads.
+     *  The slots of m_fader, if any, are set up again.
+     *  m_algorithmMutex must be locked by the caller */
+    void compileMap();
+
+    /** Mark the pixel map to be compiled again before the next step */
+    void invalidateMap();
+
+private:
+    /** The color component a map channel is set to */
+    enum MapComponent
+    {
+        MapRed,
+        MapGreen,
+        MapBlue,
+        MapCyan,
+        MapMagenta,
+        MapYellow,
+        MapGray,
+        MapDimmerOn
+    };
+
+    struct MapChannel
+    {
+        /** Absolute DMX address of the channel */
+        quint32 m_address;
+        /** Template used to fade out the channel when the matrix stops */
+        FadeChannel m_fadeChannel;
+        /** Slot of the channel in m_fader. Pixels sharing a channel,
+         *  like a fixture master dimmer, share the slot too */
+        int m_slot;
+        QLCChannel::Group m_group;
+        bool m_canFade;
+        MapComponent m_component;
+    };
+
+    /** The channels of all the pixels, row by row */
+    QVector<MapChannel> m_mapChannels;
+
+    /** Index of the first channel of each pixel in m_mapChannels.
+     *  The last item is the total number of channels */
+    QVector<int> m_mapPixels;
+
+    /** The group size m_mapChannels has been compiled for */
+    QSize m_mapSize;
+
+    /** Flag set when m_mapChannels must be compiled again */
+    bool m_mapDirty;
+
+    /** Number of distinct channels in m_mapChannels */
+    int m_mapSlots;
+
     /*********************************************************************
      * Attributes
      *********************************************************************/
@@ -0,0 +1,113 @@
+/*
+  Q Light Controller Plus
+  rgbnativescript.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QDebug>
+#include <math.h>
+
+#include "rgbnativescript.h"
+#include "rgbstarfield.h"
+#include "rgbplasma.h"
+#include "rgbballs.h"
+#include "rgbnoise.h"
+#include "rgbwaves.h"
+
+RGBNativeScript::RGBNativeScript(Doc * doc, const QString& scriptName,
+                                 const QStringList& propertyNames)
+    : RGBScript(doc)
+    , m_scriptName(scriptName)
+    , m_propertyNames(propertyNames)
+{
+}
+
+RGBNativeScript::RGBNativeScript(const RGBNativeScript& s)
+    : RGBScript(s)
+    , m_scriptName(s.m_scriptName)
+    , m_propertyNames(s.m_propertyNames)
+{
+}
+
+RGBNativeScript::~RGBNativeScript()
+{
+}
+
+RGBNativeScript* RGBNativeScript::create(Doc * doc, const QString& fileName)
+{
+    if (fileName == "plasma.js")
+        return new RGBPlasma(doc);
+    else if (fileName == "plasmacolors.js")
+        return new RGBPlasmaColors(doc);
+    else if (fileName == "waves.js")
+        return new RGBWaves(doc);
+    else if (fileName == "starfield.js")
+        return new RGBStarfield(doc);
+    else if (fileName == "balls.js")
+        return new RGBBalls(doc);
+    else if (fileName == "noise.js")
+        return new RGBNoise(doc);
+
+    return NULL;
+}
+
+bool RGBNativeScript::isValid()
+{
+    if (apiVersion() == 0 || name() != m_scriptName)
+        return false;
+
+    // a modified script may not render what the native code does
+    QStringList names;
+    foreach (RGBScriptProperty prop, properties())
+        names << prop.m_name;
+
+    if (names != m_propertyNames)
+    {
+        qWarning() << fileName() << "properties don't match the native" << m_scriptName;
+        return false;
+    }
+
+    return true;
+}
+
+/****************************************************************************
+ * RGBAlgorithm API
+ ****************************************************************************/
+
+void RGBNativeScript::preRun()
+{
+    // steps are not rendered by the script engine, so there is no need
+    // for an engine of its own
+}
+
+bool RGBNativeScript::setProperty(QString propertyName, QString value)
+{
+    if (RGBScript::setProperty(propertyName, value) == false)
+        return false;
+
+    applyProperty(propertyName, value);
+    return true;
+}
+
+double RGBNativeScript::randomValue()
+{
+    return double(qrand()) / (double(RAND_MAX) + 1.0);
+}
+
+double RGBNativeScript::jsRound(double value)
+{
+    return floor(value + 0.5);
+}
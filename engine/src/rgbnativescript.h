@@ -0,0 +1,90 @@
+/*
+  Q Light Controller Plus
+  rgbnativescript.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef RGBNATIVESCRIPT_H
+#define RGBNATIVESCRIPT_H
+
+#include <QStringList>
+
+#ifdef QT_QML_LIB
+  #include "rgbscriptv4.h"
+#else
+  #include "rgbscript.h"
+#endif
+
+/** @addtogroup engine_functions Functions
+ * @{
+ */
+
+/**
+ * RGBNativeScript is a compiled implementation of one of the bundled
+ * RGB scripts.
+ *
+ * The .js file is still loaded and evaluated, so the name, author,
+ * colors and properties of the algorithm are the ones of the script, and
+ * a project referencing the script finds it under the same name. Property
+ * values are written to the script first, and then applied to the native
+ * state, so reading them back returns exactly what the script returns.
+ * Only the rendering of the steps bypasses the script engine.
+ */
+class RGBNativeScript : public RGBScript
+{
+public:
+    RGBNativeScript(Doc * doc, const QString& scriptName, const QStringList& propertyNames);
+    RGBNativeScript(const RGBNativeScript& s);
+    ~RGBNativeScript();
+
+    /** Create the native implementation of the bundled script stored
+     *  in $fileName. Returns NULL if there is none */
+    static RGBNativeScript* create(Doc * doc, const QString& fileName);
+
+    /** Return true if the loaded script is the one implemented by this
+     *  class, with the same properties */
+    bool isValid();
+
+    /************************************************************************
+     * RGBAlgorithm API
+     ************************************************************************/
+public:
+    /** @reimp */
+    void preRun();
+
+    /** @reimp */
+    bool setProperty(QString propertyName, QString value);
+
+protected:
+    /** Apply $value to the native state of $propertyName. Called once the
+     *  script has accepted the value */
+    virtual void applyProperty(const QString& propertyName, const QString& value) = 0;
+
+public:
+    /** Get a random number in the [0, 1) range, like Math.random() */
+    static double randomValue();
+
+    /** Emulate Javascript's Math.round() */
+    static double jsRound(double value);
+
+private:
+    QString m_scriptName;
+    QStringList m_propertyNames;
+};
+
+/** @} */
+
+#endif
@@ -0,0 +1,164 @@
+/*
+  Q Light Controller Plus
+  rgbnoise.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "rgbnoise.h"
+
+RGBNoise::RGBNoise(Doc * doc)
+    : RGBNativeScript(doc, "Noise", QStringList() << "noisePercentage")
+    , m_coverage(High)
+    , m_counter(0)
+{
+    for (int i = 0; i < 4; i++)
+        m_seeds[i] = (quint32(qrand()) << 1) | 1;
+}
+
+/* Like RGBScript, a copy starts from the script defaults */
+RGBNoise::RGBNoise(const RGBNoise& s)
+    : RGBNativeScript(s)
+    , m_coverage(High)
+    , m_counter(0)
+{
+    for (int i = 0; i < 4; i++)
+        m_seeds[i] = (quint32(qrand()) << 1) | 1;
+}
+
+RGBNoise::~RGBNoise()
+{
+}
+
+RGBAlgorithm* RGBNoise::clone() const
+{
+    RGBNoise* noise = new RGBNoise(*this);
+    return static_cast<RGBAlgorithm*> (noise);
+}
+
+int RGBNoise::rgbMapStepCount(const QSize& size)
+{
+    return size.width() * size.height();
+}
+
+quint32 RGBNoise::nextRandom(int lane)
+{
+    quint32 x = m_seeds[lane];
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    m_seeds[lane] = x;
+    return x;
+}
+
+/** Get a 0 - 254 level out of a random number, like floor(random() * 255) */
+static inline uint randomLevel(quint32 random)
+{
+    return ((random >> 16) * 255) >> 16;
+}
+
+/** Limit each component of $rgb to $level */
+static inline uint limitColor(uint rgb, uint level)
+{
+    return qMin((rgb >> 16) & 0x00FF, level) << 16 |
+           qMin((rgb >> 8) & 0x00FF, level) << 8 |
+           qMin(rgb & 0x00FF, level);
+}
+
+void RGBNoise::fillNoise(uint *line, int count, uint rgb)
+{
+    int i = 0;
+
+#if defined(__SSE2__)
+    // run the 4 generators side by side, one for each pixel
+    __m128i seeds = _mm_loadu_si128((const __m128i *)m_seeds);
+    const __m128i color = _mm_set1_epi32(int(rgb & 0x00FFFFFF));
+    const __m128i scale = _mm_set1_epi16(255);
+    for (; i + 4 <= count; i += 4)
+    {
+        seeds = _mm_xor_si128(seeds, _mm_slli_epi32(seeds, 13));
+        seeds = _mm_xor_si128(seeds, _mm_srli_epi32(seeds, 17));
+        seeds = _mm_xor_si128(seeds, _mm_slli_epi32(seeds, 5));
+
+        // the level in the low byte, copied to the red, green and blue bytes
+        __m128i level = _mm_mulhi_epu16(_mm_srli_epi32(seeds, 16), scale);
+        level = _mm_or_si128(level, _mm_slli_epi32(level, 8));
+        level = _mm_or_si128(level, _mm_slli_epi32(level, 8));
+
+        _mm_storeu_si128((__m128i *)(line + i), _mm_min_epu8(level, color));
+    }
+    _mm_storeu_si128((__m128i *)m_seeds, seeds);
+#endif
+
+    for (; i < count; i++)
+        line[i] = limitColor(rgb, randomLevel(nextRandom(i & 3)));
+}
+
+void RGBNoise::renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame)
+{
+    Q_UNUSED(step)
+
+    frame.resize(size);
+
+    for (int y = 0; y < size.height(); y++)
+    {
+        uint *line = frame.scanLine(y);
+
+        // with a high coverage every pixel is lit
+        if (m_coverage == High)
+        {
+            m_counter = 0;
+            fillNoise(line, size.width(), rgb);
+            continue;
+        }
+
+        for (int x = 0; x < size.width(); x++)
+        {
+            uint level = randomLevel(nextRandom(0));
+            double random = double(nextRandom(1)) / 4294967296.0;
+            double threshold = (m_coverage == Low) ? random * 4 + 7 : random * 5;
+
+            // light a pixel every few pixels
+            m_counter++;
+            if (m_counter >= threshold)
+            {
+                m_counter = 0;
+                line[x] = limitColor(rgb, level);
+            }
+            else
+            {
+                line[x] = 0;
+            }
+        }
+    }
+}
+
+void RGBNoise::applyProperty(const QString& propertyName, const QString& value)
+{
+    if (propertyName != "noisePercentage")
+        return;
+
+    // the script lights every pixel with an unknown coverage
+    if (value == "Low")
+        m_coverage = Low;
+    else if (value == "Medium")
+        m_coverage = Medium;
+    else
+        m_coverage = High;
+}
@@ -0,0 +1,80 @@
+/*
+  Q Light Controller Plus
+  rgbnoise.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef RGBNOISE_H
+#define RGBNOISE_H
+
+#include "rgbnativescript.h"
+
+/** @addtogroup engine_functions Functions
+ * @{
+ */
+
+/**
+ * Native implementation of noise.js: pixels of random brightness,
+ * up to the step color.
+ *
+ * Random levels come from 4 xorshift generators, so that 4 pixels
+ * are computed at once with SSE2.
+ */
+class RGBNoise : public RGBNativeScript
+{
+public:
+    RGBNoise(Doc * doc);
+    RGBNoise(const RGBNoise& s);
+    ~RGBNoise();
+
+    /** @reimp */
+    RGBAlgorithm* clone() const;
+
+    /************************************************************************
+     * RGBAlgorithm API
+     ************************************************************************/
+public:
+    /** @reimp */
+    int rgbMapStepCount(const QSize& size);
+
+    /** @reimp */
+    void renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame);
+
+protected:
+    /** @reimp */
+    void applyProperty(const QString& propertyName, const QString& value);
+
+private:
+    /** Fill $count pixels of $line with random levels of $rgb */
+    void fillNoise(uint *line, int count, uint rgb);
+
+    /** Get the next random number of the generator $lane */
+    quint32 nextRandom(int lane);
+
+private:
+    enum Coverage { Low, Medium, High };
+    Coverage m_coverage;
+
+    /** Pixels since the last one that was lit */
+    int m_counter;
+
+    /** State of the random generators */
+    quint32 m_seeds[4];
+};
+
+/** @} */
+
+#endif
@@ -56,17 +56,11 @@ int RGBPlain::rgbMapStepCount(const QSize& size)
     return 1;
 }
 
-RGBMap RGBPlain::rgbMap(const QSize& size, uint rgb, int step)
+void RGBPlain::renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame)
 {
     Q_UNUSED(step)
-    RGBMap map(size.height());
-    for (int y = 0; y < size.height(); y++)
-    {
-        map[y].resize(size.width());
-        map[y].fill(rgb);
-    }
-
-    return map;
+    frame.resize(size);
+    frame.fill(rgb);
 }
 
 QString RGBPlain::name() const
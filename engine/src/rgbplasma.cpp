@@ -0,0 +1,369 @@
+/*
+  Q Light Controller Plus
+  rgbplasma.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <math.h>
+
+#include "rgbplasma.h"
+
+/** Number of colors interpolated between two gradient colors */
+#define GRADIENT_STEPS 300
+
+/****************************************************************************
+ * Perlin noise
+ ****************************************************************************/
+
+/* This is a port of Ken Perlin's Java code, as found in plasma.js.
+   The original Java code is at http://cs.nyu.edu/%7Eperlin/noise/.
+   The permutation table is repeated, so it's indexed with & 255 */
+static const uchar permutation[256] = {
+    151,160,137,91,90,15,131,13,201,95,96,53,194,233,7,225,140,36,103,30,69,142,
+    8,99,37,240,21,10,23,190,6,148,247,120,234,75,0,26,197,62,94,252,219,203,117,
+    35,11,32,57,177,33,88,237,149,56,87,174,20,125,136,171,168,68,175,74,165,71,
+    134,139,48,27,166,77,146,158,231,83,111,229,122,60,211,133,230,220,105,92,41,
+    55,46,245,40,244,102,143,54,65,25,63,161,1,216,80,73,209,76,132,187,208,89,
+    18,169,200,196,135,130,116,188,159,86,164,100,109,198,173,186,3,64,52,217,226,
+    250,124,123,5,202,38,147,118,126,255,82,85,212,207,206,59,227,47,16,58,17,182,
+    189,28,42,223,183,170,213,119,248,152,2,44,154,163,70,221,153,101,155,167,43,
+    172,9,129,22,39,253,19,98,108,110,79,113,224,232,178,185,112,104,218,246,97,
+    228,251,34,242,193,238,210,144,12,191,179,162,241,81,51,145,235,249,14,239,
+    107,49,192,214,31,181,199,106,157,184,84,204,176,115,121,50,45,127,4,150,254,
+    138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180
+};
+
+static inline int perm(int i)
+{
+    return permutation[i & 255];
+}
+
+static inline double fade(double t)
+{
+    return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+static inline double lerp(double t, double a, double b)
+{
+    return a + t * (b - a);
+}
+
+static inline double grad(int hash, double x, double y, double z)
+{
+    int h = hash & 15;
+    double u = h < 8 ? x : y;
+    double v = h < 4 ? y : (h == 12 || h == 14) ? x : z;
+    return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
+}
+
+/****************************************************************************
+ * RGBPlasma
+ ****************************************************************************/
+
+RGBPlasma::RGBPlasma(Doc * doc)
+    : RGBNativeScript(doc, "Plasma", QStringList() << "presetIndex" << "presetSize"
+                                                   << "ramp" << "stepsize")
+    , m_presetIndex(0)
+    , m_presetSize(5)
+    , m_ramp(20)
+    , m_speed(25)
+    , m_noiseStep(100)
+{
+}
+
+RGBPlasma::RGBPlasma(Doc * doc, const QString& scriptName, const QStringList& propertyNames)
+    : RGBNativeScript(doc, scriptName, propertyNames)
+    , m_presetIndex(0)
+    , m_presetSize(5)
+    , m_ramp(20)
+    , m_speed(25)
+    , m_noiseStep(100)
+{
+}
+
+/* Like RGBScript, a copy starts from the script defaults */
+RGBPlasma::RGBPlasma(const RGBPlasma& s)
+    : RGBNativeScript(s)
+    , m_presetIndex(0)
+    , m_presetSize(5)
+    , m_ramp(20)
+    , m_speed(25)
+    , m_noiseStep(100)
+{
+}
+
+RGBPlasma::~RGBPlasma()
+{
+}
+
+RGBAlgorithm* RGBPlasma::clone() const
+{
+    RGBPlasma* plasma = new RGBPlasma(*this);
+    return static_cast<RGBAlgorithm*> (plasma);
+}
+
+int RGBPlasma::rgbMapStepCount(const QSize& size)
+{
+    return size.width() * size.height();
+}
+
+void RGBPlasma::renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame)
+{
+    Q_UNUSED(rgb)
+    Q_UNUSED(step)
+
+    if (m_gradient.isEmpty())
+        updateGradient();
+
+    int width = size.width();
+    int height = size.height();
+    frame.resize(size);
+
+    double scale = m_presetSize / 2;
+    m_noiseStep += pow(100, m_speed / 50) / 500;
+    m_noiseStep = fmod(m_noiseStep, 256);
+
+    // the noise coordinates of a pixel are separable, so the cube and the
+    // fade curve of each column and row are computed once per frame
+    int square = qMax(width, height);
+    m_columns.resize(width);
+    m_rows.resize(height);
+    for (int i = 0; i < square; i++)
+    {
+        double pos = scale * (double(i) / square);
+        double cube = floor(pos);
+        Axis axis = { int(cube) & 255, pos - cube, fade(pos - cube) };
+        if (i < width)
+            m_columns[i] = axis;
+        if (i < height)
+            m_rows[i] = axis;
+    }
+
+    double zCube = floor(m_noiseStep);
+    int Z = int(zCube) & 255;
+    double z = m_noiseStep - zCube;
+    double w = fade(z);
+
+    double exponent = m_ramp / 10;
+    int gradientSize = m_gradient.size();
+    const uint *gradient = m_gradient.constData();
+    const Axis *columns = m_columns.constData();
+
+    for (int row = 0; row < height; row++)
+    {
+        const Axis &ay = m_rows.at(row);
+        int Y = ay.m_cube;
+        double y = ay.m_pos;
+        double v = ay.m_fade;
+        uint *line = frame.scanLine(row);
+
+        for (int col = 0; col < width; col++)
+        {
+            int X = columns[col].m_cube;
+            double x = columns[col].m_pos;
+            double u = columns[col].m_fade;
+
+            int A = perm(X) + Y, AA = perm(A) + Z, AB = perm(A + 1) + Z;
+            int B = perm(X + 1) + Y, BA = perm(B) + Z, BB = perm(B + 1) + Z;
+
+            double n = lerp(w, lerp(v, lerp(u, grad(perm(AA), x, y, z),
+                                               grad(perm(BA), x - 1, y, z)),
+                                       lerp(u, grad(perm(AB), x, y - 1, z),
+                                               grad(perm(BB), x - 1, y - 1, z))),
+                               lerp(v, lerp(u, grad(perm(AA + 1), x, y, z - 1),
+                                               grad(perm(BA + 1), x - 1, y, z - 1)),
+                                       lerp(u, grad(perm(AB + 1), x, y - 1, z - 1),
+                                               grad(perm(BB + 1), x - 1, y - 1, z - 1))));
+            n = (1 + n) / 2;
+
+            // an index past the gradient is black, as in the script
+            double index = jsRound(pow(n, exponent) * gradientSize);
+            line[col] = (index >= 0 && index < gradientSize) ? gradient[int(index)] : 0;
+        }
+    }
+}
+
+void RGBPlasma::applyProperty(const QString& propertyName, const QString& value)
+{
+    if (propertyName == "presetIndex")
+    {
+        if (value == "Fire")
+            m_presetIndex = 1;
+        else if (value == "Abstract")
+            m_presetIndex = 2;
+        else if (value == "Ocean")
+            m_presetIndex = 3;
+        else
+            m_presetIndex = 0;
+    }
+    else if (propertyName == "presetSize")
+    {
+        m_presetSize = value.toDouble();
+    }
+    else if (propertyName == "ramp")
+    {
+        m_ramp = value.toDouble();
+    }
+    else if (propertyName == "stepsize")
+    {
+        m_speed = value.toDouble();
+    }
+
+    invalidateGradient();
+}
+
+QVector<uint> RGBPlasma::gradientColors() const
+{
+    QVector<uint> colors;
+
+    switch (m_presetIndex)
+    {
+        default:
+        case 0: colors << 0xFF0000 << 0x00FF00 << 0x0000FF; break;
+        case 1: colors << 0xFFFF00 << 0xFF0000 << 0x000040 << 0xFF0000; break;
+        case 2: colors << 0x5571FF << 0x00FFFF << 0xFF00FF << 0xFFFF00; break;
+        case 3: colors << 0x003AB9 << 0x02EAFF; break;
+    }
+
+    return colors;
+}
+
+void RGBPlasma::invalidateGradient()
+{
+    m_gradient.clear();
+}
+
+void RGBPlasma::updateGradient()
+{
+    QVector<uint> colors = gradientColors();
+
+    m_gradient.resize(colors.size() * GRADIENT_STEPS);
+    uint *gradient = m_gradient.data();
+
+    for (int i = 0; i < colors.size(); i++)
+    {
+        uint sColor = colors.at(i);
+        uint eColor = colors.at((i + 1) % colors.size());
+        *gradient++ = sColor;
+
+        int sr = (sColor >> 16) & 0x00FF;
+        int sg = (sColor >> 8) & 0x00FF;
+        int sb = sColor & 0x00FF;
+        double stepR = double(int((eColor >> 16) & 0x00FF) - sr) / GRADIENT_STEPS;
+        double stepG = double(int((eColor >> 8) & 0x00FF) - sg) / GRADIENT_STEPS;
+        double stepB = double(int(eColor & 0x00FF) - sb) / GRADIENT_STEPS;
+
+        for (int s = 1; s < GRADIENT_STEPS; s++)
+        {
+            uint r = uint(floor(sr + (stepR * s))) & 0x00FF;
+            uint g = uint(floor(sg + (stepG * s))) & 0x00FF;
+            uint b = uint(floor(sb + (stepB * s))) & 0x00FF;
+            *gradient++ = (r << 16) + (g << 8) + b;
+        }
+    }
+}
+
+/****************************************************************************
+ * RGBPlasmaColors
+ ****************************************************************************/
+
+static const struct
+{
+    const char *m_name;
+    uint m_rgb;
+} plasmaPalette[] = {
+    { "White", 0xFFFFFF }, { "Cream", 0xFFFF7F }, { "Pink", 0xFF7F7F },
+    { "Rose", 0x7F3F3F }, { "Coral", 0x7F3F1F }, { "Dim Red", 0x7F0000 },
+    { "Red", 0xFF0000 }, { "Orange", 0xFF3F00 }, { "Dim Orange", 0x7F1F00 },
+    { "Goldenrod", 0x7F3F00 }, { "Gold", 0xFF7F00 }, { "Yellow", 0xFFFF00 },
+    { "Dim Yellow", 0x7F7F00 }, { "Lime", 0x7FFF00 }, { "Pale Green", 0x3F7F00 },
+    { "Dim Green", 0x007F00 }, { "Green", 0x00FF00 }, { "Seafoam", 0x00FF3F },
+    { "Turquoise", 0x007F3F }, { "Teal", 0x007F7F }, { "Cyan", 0x00FFFF },
+    { "Electric Blue", 0x007FFF }, { "Blue", 0x0000FF }, { "Dim Blue", 0x00007F },
+    { "Pale Blue", 0x1F1F7F }, { "Indigo", 0x1F00BF }, { "Purple", 0x3F00BF },
+    { "Violet", 0x7F007F }, { "Magenta", 0xFF00FF }, { "Hot Pink", 0xFF003F },
+    { "Deep Pink", 0x7F001F }, { "OFF", 0x000000 }
+};
+
+static const int plasmaPaletteSize = int(sizeof(plasmaPalette) / sizeof(plasmaPalette[0]));
+
+RGBPlasmaColors::RGBPlasmaColors(Doc * doc)
+    : RGBPlasma(doc, "Plasma (Colors)", QStringList() << "color1Index" << "color2Index"
+                                        << "color3Index" << "color4Index" << "color5Index"
+                                        << "presetSize" << "ramp" << "stepsize")
+{
+    m_ramp = 15;
+    m_colorIndex[0] = 0;
+    m_colorIndex[1] = 6;
+    m_colorIndex[2] = 16;
+    m_colorIndex[3] = 22;
+    m_colorIndex[4] = 31;
+}
+
+RGBPlasmaColors::RGBPlasmaColors(const RGBPlasmaColors& s)
+    : RGBPlasma(s)
+{
+    m_ramp = 15;
+    m_colorIndex[0] = 0;
+    m_colorIndex[1] = 6;
+    m_colorIndex[2] = 16;
+    m_colorIndex[3] = 22;
+    m_colorIndex[4] = 31;
+}
+
+RGBPlasmaColors::~RGBPlasmaColors()
+{
+}
+
+RGBAlgorithm* RGBPlasmaColors::clone() const
+{
+    RGBPlasmaColors* plasma = new RGBPlasmaColors(*this);
+    return static_cast<RGBAlgorithm*> (plasma);
+}
+
+void RGBPlasmaColors::applyProperty(const QString& propertyName, const QString& value)
+{
+    for (int i = 0; i < s_colorsCount; i++)
+    {
+        if (propertyName != QString("color%1Index").arg(i + 1))
+            continue;
+
+        // unknown colors are turned off
+        m_colorIndex[i] = plasmaPaletteSize - 1;
+        for (int c = 0; c < plasmaPaletteSize; c++)
+        {
+            if (value == plasmaPalette[c].m_name)
+            {
+                m_colorIndex[i] = c;
+                break;
+            }
+        }
+
+        invalidateGradient();
+        return;
+    }
+
+    RGBPlasma::applyProperty(propertyName, value);
+}
+
+QVector<uint> RGBPlasmaColors::gradientColors() const
+{
+    QVector<uint> colors;
+    for (int i = 0; i < s_colorsCount; i++)
+        colors << plasmaPalette[m_colorIndex[i]].m_rgb;
+
+    return colors;
+}
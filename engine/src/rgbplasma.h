@@ -0,0 +1,123 @@
+/*
+  Q Light Controller Plus
+  rgbplasma.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef RGBPLASMA_H
+#define RGBPLASMA_H
+
+#include <QVector>
+
+#include "rgbnativescript.h"
+
+/** @addtogroup engine_functions Functions
+ * @{
+ */
+
+/**
+ * Native implementation of plasma.js: a gradient mapped on Perlin noise
+ * that scrolls along its Z axis at every step.
+ */
+class RGBPlasma : public RGBNativeScript
+{
+public:
+    RGBPlasma(Doc * doc);
+    RGBPlasma(const RGBPlasma& s);
+    ~RGBPlasma();
+
+    /** @reimp */
+    RGBAlgorithm* clone() const;
+
+protected:
+    RGBPlasma(Doc * doc, const QString& scriptName, const QStringList& propertyNames);
+
+    /************************************************************************
+     * RGBAlgorithm API
+     ************************************************************************/
+public:
+    /** @reimp */
+    int rgbMapStepCount(const QSize& size);
+
+    /** @reimp */
+    void renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame);
+
+protected:
+    /** @reimp */
+    void applyProperty(const QString& propertyName, const QString& value);
+
+    /** Get the colors the gradient goes through */
+    virtual QVector<uint> gradientColors() const;
+
+    /** Rebuild the gradient at the next rendered step */
+    void invalidateGradient();
+
+private:
+    /** Interpolate 300 colors between each couple of gradientColors() */
+    void updateGradient();
+
+protected:
+    int m_presetIndex;
+    double m_presetSize;
+    double m_ramp;
+    double m_speed;
+
+private:
+    /** Position of the noise along its Z axis */
+    double m_noiseStep;
+
+    QVector<uint> m_gradient;
+
+    /** Noise cube coordinates of each column and row of the frame */
+    struct Axis
+    {
+        int m_cube;
+        double m_pos;
+        double m_fade;
+    };
+    QVector<Axis> m_columns;
+    QVector<Axis> m_rows;
+};
+
+/**
+ * Native implementation of plasmacolors.js: the plasma effect with
+ * a gradient between 5 colors picked from a palette.
+ */
+class RGBPlasmaColors : public RGBPlasma
+{
+public:
+    RGBPlasmaColors(Doc * doc);
+    RGBPlasmaColors(const RGBPlasmaColors& s);
+    ~RGBPlasmaColors();
+
+    /** @reimp */
+    RGBAlgorithm* clone() const;
+
+protected:
+    /** @reimp */
+    void applyProperty(const QString& propertyName, const QString& value);
+
+    /** @reimp */
+    QVector<uint> gradientColors() const;
+
+private:
+    static const int s_colorsCount = 5;
+    int m_colorIndex[s_colorsCount];
+};
+
+/** @} */
+
+#endif
@@ -22,6 +22,9 @@
 #include <QCoreApplication>
 #include <QScriptEngine>
 #include <QScriptValue>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QRunnable>
 #include <QStringList>
 #include <QMutex>
 #include <QDebug>
@@ -43,27 +46,81 @@
 QScriptEngine* RGBScript::s_engine = NULL;
 QMutex* RGBScript::s_engineMutex = NULL;
 
+/**
+ * Creates the engine of a running script and evaluates the script in it,
+ * on a worker thread. The engine is then handed over to the script.
+ */
+class RGBScript::EngineBuilder : public QRunnable
+{
+public:
+    EngineBuilder(RGBScript *script)
+        : m_script(script)
+        , m_contents(script->m_contents)
+        , m_fileName(script->m_fileName)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        QScriptEngine *engine = new QScriptEngine();
+        QScriptValue script = engine->evaluate(m_contents, m_fileName);
+
+        if (script.isError() == true ||
+            m_script->adoptEngine(engine, script, m_contents) == false)
+        {
+            script = QScriptValue();
+            delete engine;
+        }
+
+        m_done.release();
+    }
+
+    /** Released when run() is over */
+    QSemaphore m_done;
+
+private:
+    RGBScript *m_script;
+    QString m_contents;
+    QString m_fileName;
+};
+
 /****************************************************************************
  * Initialization
  ****************************************************************************/
 
 RGBScript::RGBScript(Doc * doc)
     : RGBAlgorithm(doc)
+    , m_engineMutex(QMutex::Recursive)
     , m_apiVersion(0)
+    , m_deterministic(false)
+    , m_engineWanted(false)
 {
 }
 
 RGBScript::RGBScript(const RGBScript& s)
     : RGBAlgorithm(s.doc())
+    , m_engineMutex(QMutex::Recursive)
     , m_fileName(s.m_fileName)
     , m_contents(s.m_contents)
     , m_apiVersion(0)
+    , m_deterministic(false)
+    , m_engineWanted(false)
 {
     evaluate();
 }
 
 RGBScript::~RGBScript()
 {
+    if (m_engineBuilder.isNull() == false)
+    {
+        // an engine being built must not be adopted anymore
+        m_engineMutex.lock();
+        m_engineWanted = false;
+        m_engineMutex.unlock();
+
+        waitForEngine();
+    }
 }
 
 bool RGBScript::operator==(const RGBScript& s) const
@@ -89,7 +146,7 @@ bool RGBScript::load(const QDir& dir, const QString& fileName)
     // Create the script engine when it's first needed
     initEngine();
 
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     m_contents.clear();
     m_script = QScriptValue();
@@ -128,18 +185,20 @@ QString RGBScript::fileName() const
 
 bool RGBScript::evaluate()
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     m_rgbMap = QScriptValue();
     m_rgbMapStepCount = QScriptValue();
     m_apiVersion = 0;
+    m_deterministic = false;
+    bumpRevision();
 
-    m_script = s_engine->evaluate(m_contents, m_fileName);
-    if (s_engine->hasUncaughtException() == true)
+    m_script = engine()->evaluate(m_contents, m_fileName);
+    if (engine()->hasUncaughtException() == true)
     {
         QString msg("%1: %2");
-        qWarning() << msg.arg(m_fileName).arg(s_engine->uncaughtException().toString());
-        foreach (QString s, s_engine->uncaughtExceptionBacktrace())
+        qWarning() << msg.arg(m_fileName).arg(engine()->uncaughtException().toString());
+        foreach (QString s, engine()->uncaughtExceptionBacktrace())
             qDebug() << s;
         return false;
     }
@@ -160,6 +219,7 @@ bool RGBScript::evaluate()
         }
 
         m_apiVersion = m_script.property("apiVersion").toInteger();
+        m_deterministic = m_script.property("deterministic").toBool();
         if (m_apiVersion > 0)
         {
             if (m_apiVersion == 2)
@@ -185,13 +245,78 @@ void RGBScript::initEngine()
     Q_ASSERT(s_engine != NULL);
 }
 
+QScriptEngine* RGBScript::engine() const
+{
+    if (m_engine.isNull())
+        return s_engine;
+
+    return m_engine.data();
+}
+
+RGBScript::EngineLocker::EngineLocker(const RGBScript *script)
+    : m_scriptLocker(&script->m_engineMutex)
+    , m_sharedMutex(NULL)
+{
+    // m_engine changes only with m_engineMutex locked
+    if (script->m_engine.isNull() && s_engineMutex != NULL)
+    {
+        m_sharedMutex = s_engineMutex;
+        m_sharedMutex->lock();
+    }
+}
+
+RGBScript::EngineLocker::~EngineLocker()
+{
+    if (m_sharedMutex != NULL)
+        m_sharedMutex->unlock();
+}
+
+bool RGBScript::adoptEngine(QScriptEngine *engine, const QScriptValue &script, const QString &contents)
+{
+    QMutexLocker scriptLocker(&m_engineMutex);
+
+    if (m_engineWanted == false || m_engine.isNull() == false || contents != m_contents)
+        return false;
+
+    QHash<QString, QString> values = propertiesAsStrings();
+
+    {
+        // values of the shared engine must be moved under its lock
+        QMutexLocker engineLocker(s_engineMutex);
+        m_sharedScript = m_script;
+        m_sharedRgbMap = m_rgbMap;
+        m_sharedRgbMapStepCount = m_rgbMapStepCount;
+        m_script = script;
+        m_rgbMap = script.property("rgbMap");
+        m_rgbMapStepCount = script.property("rgbMapStepCount");
+    }
+
+    // keep the engine out of the worker thread, which has no event loop
+    if (QCoreApplication::instance() != NULL)
+        engine->moveToThread(QCoreApplication::instance()->thread());
+    m_engine.reset(engine);
+
+    setProperties(values);
+
+    return true;
+}
+
+void RGBScript::waitForEngine()
+{
+    if (m_engineBuilder.isNull())
+        return;
+
+    m_engineBuilder->m_done.acquire();
+    m_engineBuilder.reset();
+}
+
 /****************************************************************************
  * Script API
  ****************************************************************************/
 
 int RGBScript::rgbMapStepCount(const QSize& size)
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     if (m_rgbMapStepCount.isValid() == false)
         return -1;
@@ -203,14 +328,68 @@ int RGBScript::rgbMapStepCount(const QSize& size)
     return ret;
 }
 
-RGBMap RGBScript::rgbMap(const QSize& size, uint rgb, int step)
+bool RGBScript::isDeterministic() const
+{
+    return m_deterministic;
+}
+
+void RGBScript::preRun()
 {
-    RGBMap map;
+    QMutexLocker scriptLocker(&m_engineMutex);
+
+    m_engineWanted = true;
+    if (m_engine.isNull() == false || m_contents.isEmpty())
+        return;
+
+    // a builder left by a previous run hands over its engine when done
+    if (m_engineBuilder.isNull() == false)
+    {
+        if (m_engineBuilder->m_done.tryAcquire() == false)
+            return;
+        m_engineBuilder.reset();
+    }
+
+    m_engineBuilder.reset(new EngineBuilder(this));
+    QThreadPool::globalInstance()->start(m_engineBuilder.data());
+}
+
+void RGBScript::postRun()
+{
+    QMutexLocker scriptLocker(&m_engineMutex);
+
+    m_engineWanted = false;
+    if (m_engine.isNull())
+        return;
+
+    QHash<QString, QString> values = propertiesAsStrings();
+
+    m_script = QScriptValue();
+    m_rgbMap = QScriptValue();
+    m_rgbMapStepCount = QScriptValue();
+
+    // the engine is deleted by the thread it belongs to,
+    // not by the MasterTimer
+    m_engine.take()->deleteLater();
+
+    {
+        QMutexLocker engineLocker(s_engineMutex);
+        qSwap(m_script, m_sharedScript);
+        qSwap(m_rgbMap, m_sharedRgbMap);
+        qSwap(m_rgbMapStepCount, m_sharedRgbMapStepCount);
+    }
+
+    setProperties(values);
+}
 
-    QMutexLocker engineLocker(s_engineMutex);
+void RGBScript::renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame)
+{
+    EngineLocker engineLocker(this);
 
     if (m_rgbMap.isValid() == false)
-        return map;
+    {
+        frame.resize(QSize());
+        return;
+    }
 
     QScriptValueList args;
     args << size.width() << size.height() << rgb << step;
@@ -218,30 +397,42 @@ RGBMap RGBScript::rgbMap(const QSize& size, uint rgb, int step)
     if (yarray.isArray() == true)
     {
         int ylen = yarray.property("length").toInteger();
-        map = RGBMap(ylen);
+        frame.resize(size);
+        frame.fill(0);
+
+        if (ylen > 0 && ylen == size.width() * size.height() &&
+            yarray.property(quint32(0)).isArray() == false)
+        {
+            // flat array of width * height pixels, row by row
+            quint32 i = 0;
+            for (int y = 0; y < size.height(); y++)
+            {
+                uint *line = frame.scanLine(y);
+                for (int x = 0; x < size.width(); x++)
+                    line[x] = yarray.property(i++).toUInt32();
+            }
+            return;
+        }
+
         for (int y = 0; y < ylen && y < size.height(); y++)
         {
-            QScriptValue xarray = yarray.property(QString::number(y));
+            QScriptValue xarray = yarray.property(quint32(y));
             int xlen = xarray.property("length").toInteger();
-            map[y].resize(xlen);
+            uint *line = frame.scanLine(y);
             for (int x = 0; x < xlen && x < size.width(); x++)
-            {
-                QScriptValue yx = xarray.property(QString::number(x));
-                map[y][x] = yx.toInteger();
-            }
+                line[x] = xarray.property(quint32(x)).toInteger();
         }
     }
     else
     {
         qWarning() << "Returned value is not an array within an array!";
+        frame.resize(QSize());
     }
-
-    return map;
 }
 
 QString RGBScript::name() const
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     QScriptValue name = m_script.property("name");
     QString ret = name.isValid() ? name.toString() : QString();
@@ -250,7 +441,7 @@ QString RGBScript::name() const
 
 QString RGBScript::author() const
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     QScriptValue author = m_script.property("author");
     QString ret = author.isValid() ? author.toString() : QString();
@@ -269,7 +460,7 @@ RGBAlgorithm::Type RGBScript::type() const
 
 int RGBScript::acceptColors() const
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     QScriptValue accColors = m_script.property("acceptColors");
     if (accColors.isValid())
@@ -315,7 +506,7 @@ QList<RGBScriptProperty> RGBScript::properties()
 
 QHash<QString, QString> RGBScript::propertiesAsStrings()
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     QHash<QString, QString> properties;
     foreach(RGBScriptProperty cap, m_properties)
@@ -334,7 +525,7 @@ QHash<QString, QString> RGBScript::propertiesAsStrings()
 
 bool RGBScript::setProperty(QString propertyName, QString value)
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     foreach(RGBScriptProperty cap, m_properties)
     {
@@ -348,6 +539,7 @@ bool RGBScript::setProperty(QString propertyName, QString value)
             }
             QScriptValueList args;
             args << value;
+            bumpRevision();
             writeMethod.call(QScriptValue(), args);
             return true;
         }
@@ -355,9 +547,19 @@ bool RGBScript::setProperty(QString propertyName, QString value)
     return false;
 }
 
+void RGBScript::setProperties(const QHash<QString, QString> &values)
+{
+    QHashIterator<QString, QString> it(values);
+    while (it.hasNext())
+    {
+        it.next();
+        setProperty(it.key(), it.value());
+    }
+}
+
 QString RGBScript::property(QString propertyName)
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     foreach(RGBScriptProperty cap, m_properties)
     {
@@ -382,7 +584,7 @@ QString RGBScript::property(QString propertyName)
 
 bool RGBScript::loadProperties()
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     QScriptValue svCaps = m_script.property("properties");
     if (svCaps.isArray() == false)
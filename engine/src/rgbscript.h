@@ -21,13 +21,15 @@
 #define RGBSCRIPT_H
 
 #include <QScriptValue>
+#include <QScopedPointer>
+#include <QMutex>
+
 #include "rgbalgorithm.h"
 #include "rgbscriptproperty.h"
 
 class QScriptEngine;
 class QSize;
 class QDir;
-class QMutex;
 
 /** @addtogroup engine_functions Functions
  * @{
@@ -67,6 +69,8 @@ public:
 private:
     static QScriptEngine* s_engine; //! The engine that runs all scripts
     static QMutex* s_engineMutex;   //! Protection
+    QScopedPointer<QScriptEngine> m_engine; //! The engine of this script while it runs
+    mutable QMutex m_engineMutex;   //! Protection of m_engine and of the script values
     QString m_fileName;             //! The file name that contains this script
     QString m_contents;             //! The file's contents
 
@@ -74,6 +78,27 @@ private:
     /** Init engine, engine mutex, and scripts map */
     static void initEngine();
 
+    /** Get the engine running this script: the shared engine, or the engine
+     *  of its own while the script runs. An EngineLocker must be held by
+     *  the caller */
+    QScriptEngine* engine() const;
+
+    /**
+     * Lock the script for the lifetime of the object: m_engineMutex
+     * and, while the script runs on the shared engine, s_engineMutex too.
+     * The two are always locked in this order.
+     */
+    class EngineLocker
+    {
+    public:
+        EngineLocker(const RGBScript *script);
+        ~EngineLocker();
+
+    private:
+        QMutexLocker m_scriptLocker;
+        QMutex *m_sharedMutex;
+    };
+
     /************************************************************************
      * RGBAlgorithm API
      ************************************************************************/
@@ -82,7 +107,23 @@ public:
     int rgbMapStepCount(const QSize& size);
 
     /** @reimp */
-    RGBMap rgbMap(const QSize& size, uint rgb, int step);
+    bool isDeterministic() const;
+
+    /**
+     * Start building an engine of its own for the script, so that it doesn't
+     * have to wait for the other running scripts. The engine is created and
+     * the script evaluated on a worker thread, while the script keeps
+     * rendering on the shared engine. The engine lives until postRun() or
+     * until the script is deleted.
+     */
+    void preRun();
+
+    /** Move the script back to the shared engine and release its own engine.
+     *  Property values are carried over */
+    void postRun();
+
+    /** @reimp */
+    void renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame);
 
     /** @reimp */
     QString name() const;
@@ -107,10 +148,37 @@ public:
 
 private:
     int m_apiVersion;               //! The API version that the script uses
+    bool m_deterministic;           //! The script renders the same map for the same inputs
     QScriptValue m_script;          //! The script itself
     QScriptValue m_rgbMap;          //! rgbMap() function
     QScriptValue m_rgbMapStepCount; //! rgbMapStepCount() function
 
+    /************************************************************************
+     * Engine of a running script
+     ************************************************************************/
+private:
+    class EngineBuilder;
+
+    /**
+     * Move the script to $engine, built by an EngineBuilder, where $script
+     * has been evaluated from $contents. Returns false, leaving the script
+     * untouched, if the script doesn't run anymore or has been reloaded.
+     */
+    bool adoptEngine(QScriptEngine *engine, const QScriptValue &script, const QString &contents);
+
+    /** Wait until the EngineBuilder of the script, if any, is done */
+    void waitForEngine();
+
+    /** Set all the properties in $values */
+    void setProperties(const QHash<QString, QString> &values);
+
+private:
+    QScopedPointer<EngineBuilder> m_engineBuilder; //! Builds m_engine on a worker thread
+    bool m_engineWanted;                //! The script runs. Guarded by m_engineMutex
+    QScriptValue m_sharedScript;           //! Values of the shared engine, kept
+    QScriptValue m_sharedRgbMap;           //! while the script runs on m_engine
+    QScriptValue m_sharedRgbMapStepCount;
+
     /************************************************************************
      * Properties
      ************************************************************************/
@@ -122,7 +190,7 @@ public:
     QHash<QString, QString> propertiesAsStrings();
 
     /** Set a property to the given value */
-    bool setProperty(QString propertyName, QString value);
+    virtual bool setProperty(QString propertyName, QString value);
 
     /** Read the value of the property with the given name */
     QString property(QString propertyName);
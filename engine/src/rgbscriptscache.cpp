@@ -21,11 +21,7 @@
 #include <QDir>
 
 #include "rgbscriptscache.h"
-#ifdef QT_QML_LIB
-  #include "rgbscriptv4.h"
-#else
-  #include "rgbscript.h"
-#endif
+#include "rgbnativescript.h"
 #include "qlcconfig.h"
 #include "qlcfile.h"
 
@@ -71,17 +67,31 @@ bool RGBScriptsCache::load(const QDir& dir)
     {
         if (!m_scriptsMap.contains(file))
         {
-            RGBScript* script = new RGBScript(m_doc);
-            if (script->load(dir, file))
+            // bundled scripts with a native implementation are rendered
+            // by compiled code, as long as they were not modified
+            RGBScript* script = NULL;
+            RGBNativeScript* native = RGBNativeScript::create(m_doc, file);
+            if (native != NULL)
             {
-                qDebug() << "    " << file << " loaded";
-                m_scriptsMap.insert(file, script);
+                if (native->load(dir, file) && native->isValid())
+                    script = native;
+                else
+                    delete native;
             }
-            else
+
+            if (script == NULL)
             {
-                qDebug() << "    " << file << " loading failed";
-                delete script;
+                script = new RGBScript(m_doc);
+                if (script->load(dir, file) == false)
+                {
+                    qDebug() << "    " << file << " loading failed";
+                    delete script;
+                    continue;
+                }
             }
+
+            qDebug() << "    " << file << " loaded";
+            m_scriptsMap.insert(file, script);
         }
         else
         {
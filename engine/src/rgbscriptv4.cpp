@@ -20,9 +20,14 @@
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
 #include <QJSEngine>
+#include <QCoreApplication>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <QRunnable>
 #include <QMutex>
 #include <QDebug>
 #include <QFile>
+#include <string.h>
 
 #include "rgbscriptv4.h"
 
@@ -33,27 +38,81 @@
 QJSEngine* RGBScript::s_engine = NULL;
 QMutex* RGBScript::s_engineMutex = NULL;
 
+/**
+ * Creates the engine of a running script and evaluates the script in it,
+ * on a worker thread. The engine is then handed over to the script.
+ */
+class RGBScript::EngineBuilder : public QRunnable
+{
+public:
+    EngineBuilder(RGBScript *script)
+        : m_script(script)
+        , m_contents(script->m_contents)
+        , m_fileName(script->m_fileName)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        QJSEngine *engine = new QJSEngine();
+        QJSValue script = engine->evaluate(m_contents, m_fileName);
+
+        if (script.isError() == true ||
+            m_script->adoptEngine(engine, script, m_contents) == false)
+        {
+            script = QJSValue();
+            delete engine;
+        }
+
+        m_done.release();
+    }
+
+    /** Released when run() is over */
+    QSemaphore m_done;
+
+private:
+    RGBScript *m_script;
+    QString m_contents;
+    QString m_fileName;
+};
+
 /****************************************************************************
  * Initialization
  ****************************************************************************/
 
 RGBScript::RGBScript(Doc * doc)
     : RGBAlgorithm(doc)
+    , m_engineMutex(QMutex::Recursive)
     , m_apiVersion(0)
+    , m_deterministic(false)
+    , m_engineWanted(false)
 {
 }
 
 RGBScript::RGBScript(const RGBScript& s)
     : RGBAlgorithm(s.doc())
+    , m_engineMutex(QMutex::Recursive)
     , m_fileName(s.m_fileName)
     , m_contents(s.m_contents)
     , m_apiVersion(0)
+    , m_deterministic(false)
+    , m_engineWanted(false)
 {
     evaluate();
 }
 
 RGBScript::~RGBScript()
 {
+    if (m_engineBuilder.isNull() == false)
+    {
+        // an engine being built must not be adopted anymore
+        m_engineMutex.lock();
+        m_engineWanted = false;
+        m_engineMutex.unlock();
+
+        waitForEngine();
+    }
 }
 
 bool RGBScript::operator==(const RGBScript& s) const
@@ -79,7 +138,7 @@ bool RGBScript::load(const QDir& dir, const QString& fileName)
     // Create the script engine when it's first needed
     initEngine();
 
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     m_contents.clear();
     m_script = QJSValue();
@@ -109,13 +168,15 @@ QString RGBScript::fileName() const
 
 bool RGBScript::evaluate()
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     m_rgbMap = QJSValue();
     m_rgbMapStepCount = QJSValue();
     m_apiVersion = 0;
+    m_deterministic = false;
+    bumpRevision();
 
-    m_script = s_engine->evaluate(m_contents, m_fileName);
+    m_script = engine()->evaluate(m_contents, m_fileName);
     if (m_script.isError())
     {
         QString msg("%1: Uncaught exception at line %2. Error: %3");
@@ -141,6 +202,7 @@ bool RGBScript::evaluate()
     }
 
     m_apiVersion = m_script.property("apiVersion").toInt();
+    m_deterministic = m_script.property("deterministic").toBool();
     if (m_apiVersion > 0)
     {
         if (m_apiVersion == 2)
@@ -165,13 +227,78 @@ void RGBScript::initEngine()
     Q_ASSERT(s_engine != NULL);
 }
 
+QJSEngine* RGBScript::engine() const
+{
+    if (m_engine.isNull())
+        return s_engine;
+
+    return m_engine.data();
+}
+
+RGBScript::EngineLocker::EngineLocker(const RGBScript *script)
+    : m_scriptLocker(&script->m_engineMutex)
+    , m_sharedMutex(NULL)
+{
+    // m_engine changes only with m_engineMutex locked
+    if (script->m_engine.isNull() && s_engineMutex != NULL)
+    {
+        m_sharedMutex = s_engineMutex;
+        m_sharedMutex->lock();
+    }
+}
+
+RGBScript::EngineLocker::~EngineLocker()
+{
+    if (m_sharedMutex != NULL)
+        m_sharedMutex->unlock();
+}
+
+bool RGBScript::adoptEngine(QJSEngine *engine, const QJSValue &script, const QString &contents)
+{
+    QMutexLocker scriptLocker(&m_engineMutex);
+
+    if (m_engineWanted == false || m_engine.isNull() == false || contents != m_contents)
+        return false;
+
+    QHash<QString, QString> values = propertiesAsStrings();
+
+    {
+        // values of the shared engine must be moved under its lock
+        QMutexLocker engineLocker(s_engineMutex);
+        m_sharedScript = m_script;
+        m_sharedRgbMap = m_rgbMap;
+        m_sharedRgbMapStepCount = m_rgbMapStepCount;
+        m_script = script;
+        m_rgbMap = script.property("rgbMap");
+        m_rgbMapStepCount = script.property("rgbMapStepCount");
+    }
+
+    // keep the engine out of the worker thread, which has no event loop
+    if (QCoreApplication::instance() != NULL)
+        engine->moveToThread(QCoreApplication::instance()->thread());
+    m_engine.reset(engine);
+
+    setProperties(values);
+
+    return true;
+}
+
+void RGBScript::waitForEngine()
+{
+    if (m_engineBuilder.isNull())
+        return;
+
+    m_engineBuilder->m_done.acquire();
+    m_engineBuilder.reset();
+}
+
 /****************************************************************************
  * Script API
  ****************************************************************************/
 
 int RGBScript::rgbMapStepCount(const QSize& size)
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     if (m_rgbMapStepCount.isCallable() == false)
         return -1;
@@ -183,45 +310,148 @@ int RGBScript::rgbMapStepCount(const QSize& size)
     return ret;
 }
 
-RGBMap RGBScript::rgbMap(const QSize& size, uint rgb, int step)
+bool RGBScript::isDeterministic() const
+{
+    return m_deterministic;
+}
+
+void RGBScript::preRun()
 {
-    RGBMap map;
+    QMutexLocker scriptLocker(&m_engineMutex);
 
-    QMutexLocker engineLocker(s_engineMutex);
+    m_engineWanted = true;
+    if (m_engine.isNull() == false || m_contents.isEmpty())
+        return;
+
+    // a builder left by a previous run hands over its engine when done
+    if (m_engineBuilder.isNull() == false)
+    {
+        if (m_engineBuilder->m_done.tryAcquire() == false)
+            return;
+        m_engineBuilder.reset();
+    }
+
+    m_engineBuilder.reset(new EngineBuilder(this));
+    QThreadPool::globalInstance()->start(m_engineBuilder.data());
+}
+
+void RGBScript::postRun()
+{
+    QMutexLocker scriptLocker(&m_engineMutex);
+
+    m_engineWanted = false;
+    if (m_engine.isNull())
+        return;
+
+    QHash<QString, QString> values = propertiesAsStrings();
+
+    m_script = QJSValue();
+    m_rgbMap = QJSValue();
+    m_rgbMapStepCount = QJSValue();
+
+    // the engine is deleted by the thread it belongs to,
+    // not by the MasterTimer
+    m_engine.take()->deleteLater();
+
+    {
+        QMutexLocker engineLocker(s_engineMutex);
+        qSwap(m_script, m_sharedScript);
+        qSwap(m_rgbMap, m_sharedRgbMap);
+        qSwap(m_rgbMapStepCount, m_sharedRgbMapStepCount);
+    }
+
+    setProperties(values);
+}
+
+void RGBScript::renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame)
+{
+    EngineLocker engineLocker(this);
 
     if (m_rgbMap.isUndefined() == true)
-        return map;
+    {
+        frame.resize(QSize());
+        return;
+    }
 
     QJSValueList args;
     args << size.width() << size.height() << rgb << step;
     QJSValue yarray = m_rgbMap.call(args);
-    if (yarray.isArray() == true)
+    if (yarray.isArray() == false && yarray.isObject() == true &&
+        yarray.property("BYTES_PER_ELEMENT").isNumber() == true)
+    {
+        // typed array of width * height pixels, row by row
+        int length = yarray.property("length").toInt();
+        frame.resize(size);
+        frame.fill(0);
+
+        if (yarray.property("constructor").property("name").toString() == "Uint32Array")
+        {
+            // the pixels are stored as they are in the frame:
+            // the whole buffer is copied at once
+            QByteArray buffer = yarray.property("buffer").toVariant().toByteArray();
+            int offset = yarray.property("byteOffset").toInt();
+            const uint *pixels = reinterpret_cast<const uint *>(buffer.constData() + offset);
+
+            length = qMin(length, (buffer.size() - offset) / int(sizeof(uint)));
+            for (int y = 0; y < size.height() && length > 0; y++)
+            {
+                int count = qMin(length, size.width());
+                memcpy(frame.scanLine(y), pixels, count * sizeof(uint));
+                pixels += count;
+                length -= count;
+            }
+        }
+        else
+        {
+            // other types, such as Float32Array, are converted pixel by pixel
+            quint32 i = 0;
+            for (int y = 0; y < size.height() && int(i) < length; y++)
+            {
+                uint *line = frame.scanLine(y);
+                for (int x = 0; x < size.width() && int(i) < length; x++)
+                    line[x] = yarray.property(i++).toUInt();
+            }
+        }
+    }
+    else if (yarray.isArray() == true)
     {
         int ylen = yarray.property("length").toInt();
-        map = RGBMap(ylen);
+        frame.resize(size);
+        frame.fill(0);
+
+        if (ylen > 0 && ylen == size.width() * size.height() &&
+            yarray.property(quint32(0)).isArray() == false)
+        {
+            // flat array of width * height pixels, row by row
+            quint32 i = 0;
+            for (int y = 0; y < size.height(); y++)
+            {
+                uint *line = frame.scanLine(y);
+                for (int x = 0; x < size.width(); x++)
+                    line[x] = yarray.property(i++).toUInt();
+            }
+            return;
+        }
+
         for (int y = 0; y < ylen && y < size.height(); y++)
         {
-            QJSValue xarray = yarray.property(QString::number(y));
+            QJSValue xarray = yarray.property(quint32(y));
             int xlen = xarray.property("length").toInt();
-            map[y].resize(xlen);
+            uint *line = frame.scanLine(y);
             for (int x = 0; x < xlen && x < size.width(); x++)
-            {
-                QJSValue yx = xarray.property(QString::number(x));
-                map[y][x] = yx.toInt();
-            }
+                line[x] = xarray.property(quint32(x)).toInt();
         }
     }
     else
     {
         qWarning() << "Returned value is not an array within an array!";
+        frame.resize(QSize());
     }
-
-    return map;
 }
 
 QString RGBScript::name() const
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     QJSValue name = m_script.property("name");
     QString ret = name.isUndefined() ? QString() : name.toString();
@@ -230,7 +460,7 @@ QString RGBScript::name() const
 
 QString RGBScript::author() const
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     QJSValue author = m_script.property("author");
     QString ret = author.isUndefined() ? QString() : author.toString();
@@ -249,7 +479,7 @@ RGBAlgorithm::Type RGBScript::type() const
 
 int RGBScript::acceptColors() const
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     QJSValue accColors = m_script.property("acceptColors");
     if (!accColors.isUndefined())
@@ -295,7 +525,7 @@ QList<RGBScriptProperty> RGBScript::properties()
 
 QHash<QString, QString> RGBScript::propertiesAsStrings()
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     QHash<QString, QString> properties;
     foreach(RGBScriptProperty cap, m_properties)
@@ -314,7 +544,7 @@ QHash<QString, QString> RGBScript::propertiesAsStrings()
 
 bool RGBScript::setProperty(QString propertyName, QString value)
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     foreach(RGBScriptProperty cap, m_properties)
     {
@@ -328,6 +558,7 @@ bool RGBScript::setProperty(QString propertyName, QString value)
             }
             QJSValueList args;
             args << value;
+            bumpRevision();
             writeMethod.call(args);
             return true;
         }
@@ -335,9 +566,19 @@ bool RGBScript::setProperty(QString propertyName, QString value)
     return false;
 }
 
+void RGBScript::setProperties(const QHash<QString, QString> &values)
+{
+    QHashIterator<QString, QString> it(values);
+    while (it.hasNext())
+    {
+        it.next();
+        setProperty(it.key(), it.value());
+    }
+}
+
 QString RGBScript::property(QString propertyName)
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     foreach(RGBScriptProperty cap, m_properties)
     {
@@ -362,7 +603,7 @@ QString RGBScript::property(QString propertyName)
 
 bool RGBScript::loadProperties()
 {
-    QMutexLocker engineLocker(s_engineMutex);
+    EngineLocker engineLocker(this);
 
     QJSValue svCaps = m_script.property("properties");
     if (svCaps.isArray() == false)
@@ -23,11 +23,13 @@
 #include <QHash>
 #include <QJSValue>
 
+#include <QScopedPointer>
+#include <QMutex>
+
 #include "rgbalgorithm.h"
 #include "rgbscriptproperty.h"
 
 class QJSEngine;
-class QMutex;
 class QDir;
 
 /** @addtogroup engine_functions Functions
@@ -69,9 +71,32 @@ private:
     /** Init engine, engine mutex, and scripts map */
     static void initEngine();
 
+    /** Get the engine running this script: the shared engine, or the engine
+     *  of its own while the script runs. An EngineLocker must be held by
+     *  the caller */
+    QJSEngine* engine() const;
+
+    /**
+     * Lock the script for the lifetime of the object: m_engineMutex
+     * and, while the script runs on the shared engine, s_engineMutex too.
+     * The two are always locked in this order.
+     */
+    class EngineLocker
+    {
+    public:
+        EngineLocker(const RGBScript *script);
+        ~EngineLocker();
+
+    private:
+        QMutexLocker m_scriptLocker;
+        QMutex *m_sharedMutex;
+    };
+
 private:
     static QJSEngine* s_engine;      //! The engine that runs all scripts
     static QMutex* s_engineMutex;   //! Protection
+    QScopedPointer<QJSEngine> m_engine; //! The engine of this script while it runs
+    mutable QMutex m_engineMutex;   //! Protection of m_engine and of the script values
     QString m_fileName;             //! The file name that contains this script
     QString m_contents;             //! The file's contents
 
@@ -83,7 +108,23 @@ public:
     int rgbMapStepCount(const QSize& size);
 
     /** @reimp */
-    RGBMap rgbMap(const QSize& size, uint rgb, int step);
+    bool isDeterministic() const;
+
+    /**
+     * Start building an engine of its own for the script, so that it doesn't
+     * have to wait for the other running scripts. The engine is created and
+     * the script evaluated on a worker thread, while the script keeps
+     * rendering on the shared engine. The engine lives until postRun() or
+     * until the script is deleted.
+     */
+    void preRun();
+
+    /** Move the script back to the shared engine and release its own engine.
+     *  Property values are carried over */
+    void postRun();
+
+    /** @reimp */
+    void renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame);
 
     /** @reimp */
     QString name() const;
@@ -108,10 +149,37 @@ public:
 
 private:
     int m_apiVersion;           //! The API version that the script uses
+    bool m_deterministic;       //! The script renders the same map for the same inputs
     QJSValue m_script;          //! The script itself
     QJSValue m_rgbMap;          //! rgbMap() function
     QJSValue m_rgbMapStepCount; //! rgbMapStepCount() function
 
+    /************************************************************************
+     * Engine of a running script
+     ************************************************************************/
+private:
+    class EngineBuilder;
+
+    /**
+     * Move the script to $engine, built by an EngineBuilder, where $script
+     * has been evaluated from $contents. Returns false, leaving the script
+     * untouched, if the script doesn't run anymore or has been reloaded.
+     */
+    bool adoptEngine(QJSEngine *engine, const QJSValue &script, const QString &contents);
+
+    /** Wait until the EngineBuilder of the script, if any, is done */
+    void waitForEngine();
+
+    /** Set all the properties in $values */
+    void setProperties(const QHash<QString, QString> &values);
+
+private:
+    QScopedPointer<EngineBuilder> m_engineBuilder; //! Builds m_engine on a worker thread
+    bool m_engineWanted;                //! The script runs. Guarded by m_engineMutex
+    QJSValue m_sharedScript;           //! Values of the shared engine, kept
+    QJSValue m_sharedRgbMap;           //! while the script runs on m_engine
+    QJSValue m_sharedRgbMapStepCount;
+
     /************************************************************************
      * Properties
      ************************************************************************/
@@ -123,7 +191,7 @@ public:
     QHash<QString, QString> propertiesAsStrings();
 
     /** Set a property to the given value */
-    bool setProperty(QString propertyName, QString value);
+    virtual bool setProperty(QString propertyName, QString value);
 
     /** Read the value of the property with the given name */
     QString property(QString propertyName);
@@ -0,0 +1,149 @@
+/*
+  Q Light Controller Plus
+  rgbstarfield.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <math.h>
+
+#include "rgbstarfield.h"
+
+/** Depth at which new stars appear */
+#define STAR_DEPTH 128
+
+RGBStarfield::RGBStarfield(Doc * doc)
+    : RGBNativeScript(doc, "3D Starfield", QStringList() << "StarsAmount" << "MultiColor")
+    , m_starsCount(50)
+    , m_multiColor(false)
+    , m_initialized(false)
+{
+}
+
+/* Like RGBScript, a copy starts from the script defaults */
+RGBStarfield::RGBStarfield(const RGBStarfield& s)
+    : RGBNativeScript(s)
+    , m_starsCount(50)
+    , m_multiColor(false)
+    , m_initialized(false)
+{
+}
+
+RGBStarfield::~RGBStarfield()
+{
+}
+
+RGBAlgorithm* RGBStarfield::clone() const
+{
+    RGBStarfield* starfield = new RGBStarfield(*this);
+    return static_cast<RGBAlgorithm*> (starfield);
+}
+
+int RGBStarfield::rgbMapStepCount(const QSize& size)
+{
+    return size.width() * size.height();
+}
+
+static double randomInRange(double minVal, double maxVal)
+{
+    minVal = RGBNativeScript::randomValue() * minVal;
+    maxVal = RGBNativeScript::randomValue() * maxVal;
+    return floor(RGBNativeScript::randomValue() * (maxVal - minVal + 1)) + minVal;
+}
+
+void RGBStarfield::resetStar(int star, uint rgb)
+{
+    Star &s = m_stars[star];
+    s.m_x = randomInRange(-10, 10);
+    s.m_y = randomInRange(-10, 10);
+    s.m_z = STAR_DEPTH;
+
+    if (m_multiColor)
+    {
+        uint r = uint(randomValue() * 255);
+        uint g = uint(randomValue() * 255);
+        uint b = uint(randomValue() * 255);
+        s.m_color = (r << 16) + (g << 8) + b;
+    }
+    else
+    {
+        s.m_color = rgb;
+    }
+}
+
+void RGBStarfield::renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame)
+{
+    Q_UNUSED(step)
+
+    frame.resize(size);
+    frame.fill(0);
+    if (frame.isEmpty())
+        return;
+
+    // the first stars are black until they are reset, as in the script
+    if (m_initialized == false)
+    {
+        for (int i = 0; i < s_maxStars; i++)
+            resetStar(i, 0);
+        m_initialized = true;
+    }
+
+    int width = size.width();
+    int height = size.height();
+    double halfWidth = width / 2.0;
+    double halfHeight = height / 2.0;
+    double speed = (height >= width) ? height / (height / 4.0) : width / (width / 4.0);
+    int count = qMin(m_starsCount - 1, int(s_maxStars));
+
+    for (int i = 0; i < count; i++)
+    {
+        Star &star = m_stars[i];
+
+        star.m_z -= speed;
+        if (star.m_z <= 0)
+            resetStar(i, rgb);
+
+        double k = 200 / star.m_z;
+        double px = star.m_x * k + halfWidth;
+        double py = star.m_y * k + halfHeight;
+
+        if (px > 0 && px < width && py > 0 && py < height)
+        {
+            // stars get brighter as they get closer
+            double dim = star.m_z * 2;
+            int r = (star.m_color >> 16) & 0x00FF;
+            int g = (star.m_color >> 8) & 0x00FF;
+            int b = star.m_color & 0x00FF;
+            uint rr = uint(qBound(0.0, r - dim, double(r)));
+            uint gg = uint(qBound(0.0, g - dim, double(g)));
+            uint bb = uint(qBound(0.0, b - dim, double(b)));
+
+            frame.setPixel(int(px), int(py), (rr << 16) + (gg << 8) + bb);
+        }
+        else
+        {
+            // the star left the matrix: replace it on the next step
+            star.m_z = 0;
+        }
+    }
+}
+
+void RGBStarfield::applyProperty(const QString& propertyName, const QString& value)
+{
+    if (propertyName == "StarsAmount")
+        m_starsCount = value.toInt();
+    else if (propertyName == "MultiColor")
+        m_multiColor = (value == "Yes");
+}
@@ -0,0 +1,80 @@
+/*
+  Q Light Controller Plus
+  rgbstarfield.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef RGBSTARFIELD_H
+#define RGBSTARFIELD_H
+
+#include "rgbnativescript.h"
+
+/** @addtogroup engine_functions Functions
+ * @{
+ */
+
+/**
+ * Native implementation of starfield.js: stars flying from the center
+ * of the matrix towards its edges.
+ */
+class RGBStarfield : public RGBNativeScript
+{
+public:
+    RGBStarfield(Doc * doc);
+    RGBStarfield(const RGBStarfield& s);
+    ~RGBStarfield();
+
+    /** @reimp */
+    RGBAlgorithm* clone() const;
+
+    /************************************************************************
+     * RGBAlgorithm API
+     ************************************************************************/
+public:
+    /** @reimp */
+    int rgbMapStepCount(const QSize& size);
+
+    /** @reimp */
+    void renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame);
+
+protected:
+    /** @reimp */
+    void applyProperty(const QString& propertyName, const QString& value);
+
+private:
+    /** Place $star at a random position close to the center */
+    void resetStar(int star, uint rgb);
+
+private:
+    static const int s_maxStars = 255;
+
+    int m_starsCount;
+    bool m_multiColor;
+    bool m_initialized;
+
+    struct Star
+    {
+        double m_x;
+        double m_y;
+        double m_z;
+        uint m_color;
+    };
+    Star m_stars[s_maxStars];
+};
+
+/** @} */
+
+#endif
@@ -0,0 +1,546 @@
+/*
+  Q Light Controller Plus
+  rgbstream.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QFileInfo>
+#include <QThread>
+#include <QImage>
+#include <QDebug>
+#include <QDir>
+
+#include "rgbstream.h"
+#include "doc.h"
+
+#define KXMLQLCRGBStreamSource "Source"
+
+/** Number of decoded frames kept ahead of the current step */
+#define RING_SIZE 8
+
+/****************************************************************************
+ * RGBStreamPrefetcher
+ ****************************************************************************/
+
+class RGBStreamPrefetcher : public QThread
+{
+public:
+    RGBStreamPrefetcher(RGBStream *stream)
+        : m_stream(stream)
+    {
+    }
+
+protected:
+    void run()
+    {
+        m_stream->prefetch();
+    }
+
+private:
+    RGBStream *m_stream;
+};
+
+/****************************************************************************
+ * Initialization
+ ****************************************************************************/
+
+RGBStream::RGBStream(Doc * doc)
+    : RGBAlgorithm(doc)
+    , m_source("")
+    , m_raw(NULL)
+    , m_rawSize(0)
+    , m_prefetcher(NULL)
+    , m_prefetching(false)
+    , m_ring(RING_SIZE)
+    , m_nextFrame(0)
+    , m_direction(1)
+    , m_lastStep(-1)
+    , m_droppedFrames(0)
+{
+}
+
+RGBStream::RGBStream(const RGBStream& s)
+    : RGBAlgorithm(s.doc())
+    , m_source(s.source())
+    , m_raw(NULL)
+    , m_rawSize(0)
+    , m_prefetcher(NULL)
+    , m_prefetching(false)
+    , m_ring(RING_SIZE)
+    , m_nextFrame(0)
+    , m_direction(1)
+    , m_lastStep(-1)
+    , m_droppedFrames(0)
+{
+    openSource();
+}
+
+RGBStream::~RGBStream()
+{
+    stopPrefetch();
+    closeSource();
+}
+
+RGBAlgorithm* RGBStream::clone() const
+{
+    RGBStream* stream = new RGBStream(*this);
+    return static_cast<RGBAlgorithm*> (stream);
+}
+
+/****************************************************************************
+ * Source
+ ****************************************************************************/
+
+void RGBStream::setSource(const QString& source)
+{
+    bool running = (m_prefetcher != NULL);
+
+    stopPrefetch();
+    m_source = source;
+    openSource();
+    bumpRevision();
+
+    if (running)
+        startPrefetch();
+}
+
+QString RGBStream::source() const
+{
+    return m_source;
+}
+
+int RGBStream::frameCount(const QSize& size) const
+{
+    if (m_files.isEmpty() == false)
+        return m_files.size();
+
+    qint64 frameBytes = qint64(size.width()) * size.height() * 3;
+    if (m_raw == NULL || frameBytes <= 0)
+        return 0;
+
+    return int(m_rawSize / frameBytes);
+}
+
+void RGBStream::openSource()
+{
+    closeSource();
+
+    if (m_source.isEmpty())
+        return;
+
+    QFileInfo info(m_source);
+    if (info.isDir())
+    {
+        QDir dir(m_source);
+        dir.setFilter(QDir::Files);
+        dir.setSorting(QDir::Name);
+        dir.setNameFilters(QStringList() << "*.png" << "*.bmp" << "*.jpg" << "*.jpeg" << "*.gif");
+        foreach (QString name, dir.entryList())
+            m_files.append(dir.absoluteFilePath(name));
+
+        if (m_files.isEmpty())
+            qWarning() << "[RGBStream] No images found in" << m_source;
+    }
+    else
+    {
+        m_rawFile.setFileName(m_source);
+        if (m_rawFile.open(QIODevice::ReadOnly) == false)
+        {
+            qWarning() << "[RGBStream] Unable to open" << m_source;
+            return;
+        }
+
+        // the kernel pages frames in on demand, off the timer thread
+        m_rawSize = m_rawFile.size();
+        m_raw = m_rawFile.map(0, m_rawSize);
+        if (m_raw == NULL)
+        {
+            qWarning() << "[RGBStream] Unable to map" << m_source;
+            m_rawSize = 0;
+            m_rawFile.close();
+        }
+    }
+}
+
+void RGBStream::closeSource()
+{
+    m_files.clear();
+
+    if (m_raw != NULL)
+        m_rawFile.unmap(const_cast<uchar *>(m_raw));
+    if (m_rawFile.isOpen())
+        m_rawFile.close();
+
+    m_raw = NULL;
+    m_rawSize = 0;
+}
+
+void RGBStream::loadFrame(int index, const QSize& size, RGBFrame& frame) const
+{
+    frame.resize(size);
+
+    if (index < 0 || index >= frameCount(size))
+    {
+        frame.fill(0);
+        return;
+    }
+
+    if (m_files.isEmpty() == false)
+    {
+        QImage image(m_files.at(index));
+        if (image.isNull())
+        {
+            qWarning() << "[RGBStream] Failed to load" << m_files.at(index);
+            frame.fill(0);
+            return;
+        }
+
+        if (image.size() != size)
+            image = image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        image = image.convertToFormat(QImage::Format_ARGB32);
+
+        for (int y = 0; y < size.height(); y++)
+        {
+            const QRgb *src = reinterpret_cast<const QRgb *>(image.constScanLine(y));
+            uint *line = frame.scanLine(y);
+            for (int x = 0; x < size.width(); x++)
+                line[x] = qAlpha(src[x]) == 0 ? 0 : src[x] & 0x00FFFFFF;
+        }
+    }
+    else
+    {
+        const uchar *src = m_raw + qint64(index) * size.width() * size.height() * 3;
+
+        for (int y = 0; y < size.height(); y++)
+        {
+            uint *line = frame.scanLine(y);
+            for (int x = 0; x < size.width(); x++, src += 3)
+                line[x] = (uint(src[0]) << 16) | (uint(src[1]) << 8) | uint(src[2]);
+        }
+    }
+}
+
+/****************************************************************************
+ * Prefetching
+ ****************************************************************************/
+
+int RGBStream::ringSize()
+{
+    return RING_SIZE;
+}
+
+int RGBStream::droppedFrames() const
+{
+    return m_droppedFrames.loadAcquire();
+}
+
+void RGBStream::startPrefetch()
+{
+    if (m_prefetcher != NULL)
+        return;
+
+    for (int i = 0; i < m_ring.size(); i++)
+        m_ring[i].m_state = Slot::Free;
+    m_size = QSize();
+    m_nextFrame = 0;
+    m_direction = 1;
+    m_lastStep = -1;
+    m_shown.resize(QSize());
+    m_droppedFrames.storeRelease(0);
+
+    m_prefetching = true;
+    m_prefetcher = new RGBStreamPrefetcher(this);
+    m_prefetcher->start();
+}
+
+void RGBStream::stopPrefetch()
+{
+    if (m_prefetcher == NULL)
+        return;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_prefetching = false;
+        m_wake.wakeAll();
+    }
+
+    m_prefetcher->wait();
+    delete m_prefetcher;
+    m_prefetcher = NULL;
+}
+
+void RGBStream::prefetch()
+{
+    QMutexLocker locker(&m_mutex);
+
+    while (m_prefetching)
+    {
+        int index, slot;
+        if (nextPrefetch(index, slot) == false)
+        {
+            m_wake.wait(&m_mutex);
+            continue;
+        }
+
+        // the ring is never resized while prefetching, so the slot
+        // can be filled without holding the lock
+        QSize size = m_size;
+        m_ring[slot].m_state = Slot::Loading;
+        m_ring[slot].m_index = index;
+        RGBFrame& frame = m_ring[slot].m_frame;
+
+        locker.unlock();
+        loadFrame(index, size, frame);
+        locker.relock();
+
+        // drop the frame if the matrix was resized in the meantime
+        if (m_ring[slot].m_index == index && size == m_size)
+            m_ring[slot].m_state = Slot::Ready;
+        else
+            m_ring[slot].m_state = Slot::Free;
+    }
+}
+
+bool RGBStream::nextPrefetch(int& index, int& slot)
+{
+    // nothing to do until the matrix renders its first step
+    int count = frameCount(m_size);
+    if (m_size.isEmpty() || count == 0)
+        return false;
+
+    int window = qMin(m_ring.size(), count);
+
+    // release the frames that have been played or skipped
+    for (int i = 0; i < m_ring.size(); i++)
+    {
+        Slot& s = m_ring[i];
+        if (s.m_state != Slot::Ready)
+            continue;
+
+        int offset = ((s.m_index - m_nextFrame) * m_direction) % count;
+        if (offset < 0)
+            offset += count;
+        if (offset >= window)
+            s.m_state = Slot::Free;
+    }
+
+    for (int k = 0; k < window; k++)
+    {
+        int frame = (m_nextFrame + k * m_direction) % count;
+        if (frame < 0)
+            frame += count;
+
+        bool found = false;
+        int freeSlot = -1;
+        for (int i = 0; i < m_ring.size(); i++)
+        {
+            const Slot& s = m_ring.at(i);
+            if (s.m_state == Slot::Free)
+            {
+                if (freeSlot == -1)
+                    freeSlot = i;
+            }
+            else if (s.m_index == frame)
+            {
+                found = true;
+                break;
+            }
+        }
+
+        if (found)
+            continue;
+
+        if (freeSlot == -1)
+            return false;
+
+        index = frame;
+        slot = freeSlot;
+        return true;
+    }
+
+    return false;
+}
+
+/****************************************************************************
+ * RGBAlgorithm
+ ****************************************************************************/
+
+int RGBStream::rgbMapStepCount(const QSize& size)
+{
+    return qMax(1, frameCount(size));
+}
+
+void RGBStream::renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame)
+{
+    // not running: just decode the frame
+    if (m_prefetcher == NULL)
+    {
+        renderPreview(size, rgb, step, frame);
+        return;
+    }
+
+    int count = frameCount(size);
+    if (count == 0)
+    {
+        frame.resize(QSize());
+        return;
+    }
+
+    int index = step % count;
+
+    QMutexLocker locker(&m_mutex);
+
+    if (size != m_size)
+    {
+        m_size = size;
+        for (int i = 0; i < m_ring.size(); i++)
+        {
+            if (m_ring[i].m_state == Slot::Ready)
+                m_ring[i].m_state = Slot::Free;
+            else if (m_ring[i].m_state == Slot::Loading)
+                m_ring[i].m_index = -1;
+        }
+        m_shown.resize(QSize());
+    }
+
+    // follow the run order of the matrix, backward or ping pong
+    if (m_lastStep >= 0 && qAbs(step - m_lastStep) == 1)
+        m_direction = step - m_lastStep;
+    m_lastStep = step;
+
+    bool ready = false;
+    for (int i = 0; i < m_ring.size(); i++)
+    {
+        const Slot& s = m_ring.at(i);
+        if (s.m_state == Slot::Ready && s.m_index == index)
+        {
+            m_shown = s.m_frame;
+            ready = true;
+            break;
+        }
+    }
+
+    if (ready == false)
+    {
+        // the very first frame has nothing to hold, so it is decoded here.
+        // Later frames that are late are dropped, to stay in sync
+        if (m_shown.isEmpty())
+            loadFrame(index, size, m_shown);
+        else
+            m_droppedFrames.fetchAndAddRelaxed(1);
+    }
+
+    frame = m_shown;
+
+    m_nextFrame = (index + m_direction + count) % count;
+    m_wake.wakeOne();
+}
+
+void RGBStream::renderPreview(const QSize& size, uint rgb, int step, RGBFrame& frame)
+{
+    Q_UNUSED(rgb);
+
+    int count = frameCount(size);
+    if (count == 0)
+    {
+        frame.resize(QSize());
+        return;
+    }
+
+    loadFrame(step % count, size, frame);
+}
+
+void RGBStream::preRun()
+{
+    startPrefetch();
+}
+
+void RGBStream::postRun()
+{
+    stopPrefetch();
+}
+
+QString RGBStream::name() const
+{
+    return QString("Stream");
+}
+
+QString RGBStream::author() const
+{
+    return QString("Massimo Callegari");
+}
+
+int RGBStream::apiVersion() const
+{
+    return 1;
+}
+
+RGBAlgorithm::Type RGBStream::type() const
+{
+    return RGBAlgorithm::Stream;
+}
+
+int RGBStream::acceptColors() const
+{
+    return 0;
+}
+
+bool RGBStream::loadXML(QXmlStreamReader &root)
+{
+    if (root.name() != KXMLQLCRGBAlgorithm)
+    {
+        qWarning() << Q_FUNC_INFO << "RGB Algorithm node not found";
+        return false;
+    }
+
+    if (root.attributes().value(KXMLQLCRGBAlgorithmType).toString() != KXMLQLCRGBStream)
+    {
+        qWarning() << Q_FUNC_INFO << "RGB Algorithm is not Stream";
+        return false;
+    }
+
+    while (root.readNextStartElement())
+    {
+        if (root.name() == KXMLQLCRGBStreamSource)
+        {
+            setSource(doc()->denormalizeComponentPath(root.readElementText()));
+        }
+        else
+        {
+            qWarning() << Q_FUNC_INFO << "Unknown RGBStream tag:" << root.name();
+            root.skipCurrentElement();
+        }
+    }
+
+    return true;
+}
+
+bool RGBStream::saveXML(QXmlStreamWriter *doc) const
+{
+    Q_ASSERT(doc != NULL);
+
+    doc->writeStartElement(KXMLQLCRGBAlgorithm);
+    doc->writeAttribute(KXMLQLCRGBAlgorithmType, KXMLQLCRGBStream);
+
+    doc->writeTextElement(KXMLQLCRGBStreamSource, this->doc()->normalizeComponentPath(m_source));
+
+    /* End the <Algorithm> tag */
+    doc->writeEndElement();
+
+    return true;
+}
@@ -0,0 +1,198 @@
+/*
+  Q Light Controller Plus
+  rgbstream.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef RGBSTREAM_H
+#define RGBSTREAM_H
+
+#include <QWaitCondition>
+#include <QAtomicInt>
+#include <QStringList>
+#include <QVector>
+#include <QMutex>
+#include <QFile>
+
+#include "rgbalgorithm.h"
+
+class RGBStreamPrefetcher;
+
+/** @addtogroup engine_functions Functions
+ * @{
+ */
+
+#define KXMLQLCRGBStream "Stream"
+
+/**
+ * RGBStream plays pre-rendered content, one frame per step. The source
+ * is either a directory holding an image sequence, played in file name
+ * order, or a raw file of RGB888 frames at the matrix resolution, which
+ * is memory mapped.
+ *
+ * While the matrix runs, a background thread decodes the frames ahead
+ * of the current step, scales them to the matrix size and stores them
+ * in a small ring buffer, so renderMap() never waits for the disk or
+ * for a decoder. A frame that is not ready when its step comes is
+ * dropped: the previous frame is held and the prefetcher skips ahead,
+ * so the content stays in sync with the steps of the matrix.
+ */
+class RGBStream : public RGBAlgorithm
+{
+public:
+    RGBStream(Doc * doc);
+    RGBStream(const RGBStream& s);
+    ~RGBStream();
+
+    /** @reimp */
+    RGBAlgorithm* clone() const;
+
+    /************************************************************************
+     * Source
+     ************************************************************************/
+public:
+    /** Set the image sequence directory or the raw RGB file to play */
+    void setSource(const QString& source);
+
+    /** Get the image sequence directory or the raw RGB file */
+    QString source() const;
+
+    /** Get the number of frames of the source, at the given matrix size */
+    int frameCount(const QSize& size) const;
+
+private:
+    /** Scan the image sequence or map the raw file */
+    void openSource();
+
+    /** Release the mapped raw file */
+    void closeSource();
+
+    /** Decode frame $index into $frame, scaled to $size */
+    void loadFrame(int index, const QSize& size, RGBFrame& frame) const;
+
+private:
+    QString m_source;
+
+    /** Files of an image sequence, sorted by name */
+    QStringList m_files;
+
+    /** Memory mapping of a raw RGB file */
+    QFile m_rawFile;
+    const uchar *m_raw;
+    qint64 m_rawSize;
+
+    /************************************************************************
+     * Prefetching
+     ************************************************************************/
+public:
+    /** Get the number of frames the ring buffer holds */
+    static int ringSize();
+
+    /** Get the number of frames dropped because they were not ready in
+     *  time, since the matrix started */
+    int droppedFrames() const;
+
+private:
+    /** Start/stop the prefetching thread */
+    void startPrefetch();
+    void stopPrefetch();
+
+    /** Body of the prefetching thread */
+    void prefetch();
+
+    /** Look for a frame to decode and a free slot to decode it into.
+     *  Slots holding frames outside of the prefetch window are released.
+     *  Called with m_mutex locked. */
+    bool nextPrefetch(int& index, int& slot);
+
+    friend class RGBStreamPrefetcher;
+
+private:
+    struct Slot
+    {
+        Slot() : m_state(Free), m_index(-1) {}
+
+        enum State { Free, Loading, Ready };
+        State m_state;
+        int m_index;
+        RGBFrame m_frame;
+    };
+
+    /** Protects the ring, the size and the prefetch window */
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    RGBStreamPrefetcher *m_prefetcher;
+    bool m_prefetching;
+
+    QVector<Slot> m_ring;
+    QSize m_size;
+
+    /** First frame of the prefetch window and the playback direction */
+    int m_nextFrame;
+    int m_direction;
+    int m_lastStep;
+
+    /** The last frame that was rendered, held when a frame is late */
+    RGBFrame m_shown;
+
+    /** Number of late frames. Counted by the timer thread, read by any */
+    QAtomicInt m_droppedFrames;
+
+    /************************************************************************
+     * RGBAlgorithm
+     ************************************************************************/
+public:
+    /** @reimp */
+    int rgbMapStepCount(const QSize& size);
+
+    /** @reimp */
+    void renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame);
+
+    /** @reimp. The frame is decoded on the spot, leaving the ring
+     *  and the counters of a running stream untouched */
+    void renderPreview(const QSize& size, uint rgb, int step, RGBFrame& frame);
+
+    /** @reimp */
+    void preRun();
+
+    /** @reimp */
+    void postRun();
+
+    /** @reimp */
+    QString name() const;
+
+    /** @reimp */
+    QString author() const;
+
+    /** @reimp */
+    int apiVersion() const;
+
+    /** @reimp */
+    RGBAlgorithm::Type type() const;
+
+    /** @reimp */
+    int acceptColors() const;
+
+    /** @reimp */
+    bool loadXML(QXmlStreamReader &root);
+
+    /** @reimp */
+    bool saveXML(QXmlStreamWriter *doc) const;
+};
+
+/** @} */
+
+#endif
@@ -39,6 +39,7 @@ RGBText::RGBText(Doc * doc)
     , m_animationStyle(Horizontal)
     , m_xOffset(0)
     , m_yOffset(0)
+    , m_cacheRevision(0)
 {
 }
 
@@ -49,6 +50,7 @@ RGBText::RGBText(const RGBText& t)
     , m_animationStyle(t.animationStyle())
     , m_xOffset(t.xOffset())
     , m_yOffset(t.yOffset())
+    , m_cacheRevision(0)
 {
 }
 
@@ -69,6 +71,7 @@ RGBAlgorithm* RGBText::clone() const
 void RGBText::setText(const QString& str)
 {
     m_text = str;
+    bumpRevision();
 }
 
 QString RGBText::text() const
@@ -79,6 +82,7 @@ QString RGBText::text() const
 void RGBText::setFont(const QFont& font)
 {
     m_font = font;
+    bumpRevision();
 }
 
 QFont RGBText::font() const
@@ -96,6 +100,7 @@ void RGBText::setAnimationStyle(RGBText::AnimationStyle ani)
         m_animationStyle = ani;
     else
         m_animationStyle = StaticLetters;
+    bumpRevision();
 }
 
 RGBText::AnimationStyle RGBText::animationStyle() const
@@ -139,6 +144,7 @@ QStringList RGBText::animationStyles()
 void RGBText::setXOffset(int offset)
 {
     m_xOffset = offset;
+    bumpRevision();
 }
 
 int RGBText::xOffset() const
@@ -149,6 +155,7 @@ int RGBText::xOffset() const
 void RGBText::setYOffset(int offset)
 {
     m_yOffset = offset;
+    bumpRevision();
 }
 
 int RGBText::yOffset() const
@@ -165,25 +172,101 @@ int RGBText::scrollingTextStepCount() const
         return fm.width(m_text);
 }
 
-RGBMap RGBText::renderScrollingText(const QSize& size, uint rgb, int step) const
+void RGBText::renderScrollingText(const QSize& size, uint rgb, int step, RGBFrame& frame)
 {
-    QImage image;
-    if (animationStyle() == Horizontal)
-        image = QImage(scrollingTextStepCount(), size.height(), QImage::Format_RGB32);
+    updateCache(size);
+
+    // Treat the frame as a "window" on top of the fully-drawn text and pick the
+    // correct pixels according to $step.
+    frame.resize(size);
+    frame.fill(0);
+    for (int y = 0; y < size.height(); y++)
+    {
+        uint *line = frame.scanLine(y);
+
+        if (animationStyle() == Horizontal)
+        {
+            if (y >= m_cache.height() || step < 0 || step >= m_cache.width())
+                continue;
+
+            const QRgb *src = reinterpret_cast<const QRgb *>(m_cache.constScanLine(y));
+            blitLine(line, src + step, qMin(size.width(), m_cache.width() - step), rgb);
+        }
+        else
+        {
+            if (step + y < 0 || step + y >= m_cache.height())
+                continue;
+
+            const QRgb *src = reinterpret_cast<const QRgb *>(m_cache.constScanLine(step + y));
+            blitLine(line, src, qMin(size.width(), m_cache.width()), rgb);
+        }
+    }
+}
+
+void RGBText::renderStaticLetters(const QSize& size, uint rgb, int step, RGBFrame& frame)
+{
+    updateCache(size);
+
+    frame.resize(size);
+    if (step < 0 || step >= m_text.length())
+    {
+        frame.fill(0xFF000000);
+        return;
+    }
+
+    // Each letter has its own cell in the strip
+    int offset = step * size.width();
+    for (int y = 0; y < size.height(); y++)
+    {
+        const QRgb *src = reinterpret_cast<const QRgb *>(m_cache.constScanLine(y));
+        blitLine(frame.scanLine(y), src + offset, size.width(), rgb);
+    }
+}
+
+/****************************************************************************
+ * Text cache
+ ****************************************************************************/
+
+void RGBText::updateCache(const QSize& size)
+{
+    if (size == m_cacheSize && revision() == m_cacheRevision)
+        return;
+
+    m_cacheSize = size;
+    m_cacheRevision = revision();
+
+    if (animationStyle() == StaticLetters)
+        m_cache = QImage(size.width() * m_text.length(), size.height(), QImage::Format_RGB32);
+    else if (animationStyle() == Horizontal)
+        m_cache = QImage(scrollingTextStepCount(), size.height(), QImage::Format_RGB32);
     else
-        image = QImage(size.width(), scrollingTextStepCount(), QImage::Format_RGB32);
-    image.fill(QRgb(0));
+        m_cache = QImage(size.width(), scrollingTextStepCount(), QImage::Format_RGB32);
 
-    QPainter p(&image);
+    if (m_cache.isNull())
+        return;
+
+    m_cache.fill(QRgb(0));
+
+    QPainter p(&m_cache);
     p.setRenderHint(QPainter::TextAntialiasing, false);
     p.setRenderHint(QPainter::Antialiasing, false);
     p.setFont(m_font);
-    p.setPen(QColor(rgb));
+    p.setPen(Qt::white);
 
-    if (animationStyle() == Vertical)
+    if (animationStyle() == StaticLetters)
+    {
+        // Draw one letter per cell, each one clipped to its own cell
+        for (int i = 0; i < m_text.length(); i++)
+        {
+            QRect cell(i * size.width(), 0, size.width(), size.height());
+            p.setClipRect(cell);
+            p.drawText(cell.translated(xOffset(), yOffset()), Qt::AlignCenter, m_text.mid(i, 1));
+        }
+    }
+    else if (animationStyle() == Vertical)
     {
         QFontMetrics fm(m_font);
-        QRect rect(0, 0, image.width(), image.height());
+        QRect rect(0, 0, m_cache.width(), m_cache.height());
 
         for (int i = 0; i < m_text.length(); i++)
         {
@@ -195,61 +278,29 @@ RGBMap RGBText::renderScrollingText(const QSize& size, uint rgb, int step) const
     }
     else
     {
-        // Draw the whole text each time
-        QRect rect(xOffset(), yOffset(), image.width(), image.height());
+        QRect rect(xOffset(), yOffset(), m_cache.width(), m_cache.height());
         p.drawText(rect, Qt::AlignLeft | Qt::AlignVCenter, m_text);
     }
     p.end();
-
-    // Treat the RGBMap as a "window" on top of the fully-drawn text and pick the
-    // correct pixels according to $step.
-    RGBMap map(size.height());
-    for (int y = 0; y < size.height(); y++)
-    {
-        map[y].resize(size.width());
-        for (int x = 0; x < size.width(); x++)
-        {
-            if (animationStyle() == Horizontal)
-            {
-                if (step + x < image.width())
-                    map[y][x] = image.pixel(step + x, y);
-            }
-            else
-            {
-                if (step + y < image.height())
-                    map[y][x] = image.pixel(x, step + y);
-            }
-        }
-    }
-
-    return map;
 }
 
-RGBMap RGBText::renderStaticLetters(const QSize& size, uint rgb, int step) const
+void RGBText::blitLine(uint *dst, const QRgb *src, int width, uint rgb)
 {
-    QImage image(size, QImage::Format_RGB32);
-    image.fill(QRgb(0));
-
-    QPainter p(&image);
-    p.setRenderHint(QPainter::TextAntialiasing, false);
-    p.setRenderHint(QPainter::Antialiasing, false);
-    p.setFont(m_font);
-
-    p.setPen(QColor(rgb));
-    // Draw one letter at a time
-    QRect rect(xOffset(), yOffset(), size.width(), size.height());
-    p.drawText(rect, Qt::AlignCenter, m_text.mid(step, 1));
-    p.end();
+    rgb &= 0x00FFFFFF;
 
-    RGBMap map(size.height());
-    for (int y = 0; y < size.height(); y++)
+    for (int x = 0; x < width; x++)
     {
-        map[y].resize(size.width());
-        for (int x = 0; x < size.width(); x++)
-            map[y][x] = image.pixel(x, y);
+        // The text is drawn in white, so any component is its coverage
+        uint coverage = src[x] & 0xFF;
+        if (coverage == 0xFF)
+            dst[x] = 0xFF000000 | rgb;
+        else if (coverage == 0)
+            dst[x] = 0xFF000000;
+        else
+            dst[x] = qRgb((qRed(rgb) * coverage) / 255,
+                          (qGreen(rgb) * coverage) / 255,
+                          (qBlue(rgb) * coverage) / 255);
     }
-
-    return map;
 }
 
 /****************************************************************************
@@ -265,12 +316,17 @@ int RGBText::rgbMapStepCount(const QSize& size)
         return scrollingTextStepCount();
 }
 
-RGBMap RGBText::rgbMap(const QSize& size, uint rgb, int step)
+bool RGBText::isDeterministic() const
+{
+    return true;
+}
+
+void RGBText::renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame)
 {
     if (animationStyle() == StaticLetters)
-        return renderStaticLetters(size, rgb, step);
+        renderStaticLetters(size, rgb, step, frame);
     else
-        return renderScrollingText(size, rgb, step);
+        renderScrollingText(size, rgb, step, frame);
 }
 
 QString RGBText::name() const
@@ -22,6 +22,7 @@
 #define RGBTEXT_H
 
 #include <QString>
+#include <QImage>
 #include <QFont>
 
 #include "rgbalgorithm.h"
@@ -83,14 +84,37 @@ public:
 
 private:
     int scrollingTextStepCount() const;
-    RGBMap renderScrollingText(const QSize& size, uint rgb, int step) const;
-    RGBMap renderStaticLetters(const QSize& size, uint rgb, int step) const;
+    void renderScrollingText(const QSize& size, uint rgb, int step, RGBFrame& frame);
+    void renderStaticLetters(const QSize& size, uint rgb, int step, RGBFrame& frame);
 
 private:
     AnimationStyle m_animationStyle;
     int m_xOffset;
     int m_yOffset;
 
+    /************************************************************************
+     * Text cache
+     ************************************************************************/
+private:
+    /**
+     * Make sure m_cache holds the text drawn in white for a matrix of
+     * $size with the current settings, drawing it again only when the
+     * size or the settings (revision) changed.
+     *
+     * Scrolling styles cache the whole text, while StaticLetters caches
+     * a strip with one matrix-sized cell per letter, so that each step
+     * is just a window copied out of m_cache.
+     */
+    void updateCache(const QSize& size);
+
+    /** Copy $width pixels of $src to $dst, painting the text with $rgb */
+    static void blitLine(uint *dst, const QRgb *src, int width, uint rgb);
+
+private:
+    QImage m_cache;
+    QSize m_cacheSize;
+    uint m_cacheRevision;
+
     /************************************************************************
      * RGBAlgorithm
      ************************************************************************/
@@ -99,7 +123,10 @@ public:
     int rgbMapStepCount(const QSize& size);
 
     /** @reimp */
-    RGBMap rgbMap(const QSize& size, uint rgb, int step);
+    bool isDeterministic() const;
+
+    /** @reimp */
+    void renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame);
 
     /** @reimp */
     QString name() const;
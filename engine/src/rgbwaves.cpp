@@ -0,0 +1,166 @@
+/*
+  Q Light Controller Plus
+  rgbwaves.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <string.h>
+
+#include "rgbwaves.h"
+
+/** Number of brightness levels of a tail */
+#define FADE_STEPS 100
+
+RGBWaves::RGBWaves(Doc * doc)
+    : RGBNativeScript(doc, "Waves", QStringList() << "taillength" << "tailfade"
+                                                  << "direction" << "orientation")
+    , m_tailLength(50)
+    , m_tailFade(true)
+    , m_direction(Right)
+    , m_vertical(false)
+{
+}
+
+/* Like RGBScript, a copy starts from the script defaults */
+RGBWaves::RGBWaves(const RGBWaves& s)
+    : RGBNativeScript(s)
+    , m_tailLength(50)
+    , m_tailFade(true)
+    , m_direction(Right)
+    , m_vertical(false)
+{
+}
+
+RGBWaves::~RGBWaves()
+{
+}
+
+RGBAlgorithm* RGBWaves::clone() const
+{
+    RGBWaves* waves = new RGBWaves(*this);
+    return static_cast<RGBAlgorithm*> (waves);
+}
+
+int RGBWaves::tailSteps(int span) const
+{
+    int steps = int(jsRound(span * m_tailLength / 100));
+    return steps == 0 ? 1 : steps;
+}
+
+int RGBWaves::rgbMapStepCount(const QSize& size)
+{
+    int span = m_vertical ? size.height() : size.width();
+    bool isEven = (span % 2 == 0);
+
+    if (m_direction == Right || m_direction == Left)
+        return span + tailSteps(span) - (isEven ? 0 : 1);
+    else
+        return (span + 1) / 2 + tailSteps(span) - 1;
+}
+
+void RGBWaves::renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame)
+{
+    int span = m_vertical ? size.height() : size.width();
+    int center = (span + 1) / 2 - 1;
+    bool isEven = (span % 2 == 0);
+    int tail = tailSteps(span);
+
+    // every line across the wave looks the same, so the colors of a
+    // single line are computed and then copied to the whole frame
+    m_line.resize(span);
+    for (int pos = 0; pos < span; pos++)
+    {
+        int stepPos = pos;
+        if (m_direction == Left)
+            stepPos = span - 1 - pos;
+        else if (m_direction == In)
+            stepPos = (pos <= center) ? pos : span - 1 - pos;
+        else if (m_direction == Out)
+            stepPos = (pos <= center) ? center - pos : pos - center - (isEven ? 1 : 0);
+
+        bool fill;
+        if (m_direction == Right || m_direction == Left || stepPos <= center)
+            fill = (stepPos <= step && stepPos > step - tail);
+        else
+            fill = ((span - 1 - stepPos) <= step && (span - 1 - stepPos) > step - tail);
+
+        uint color = fill ? rgb : 0;
+        if (fill && m_tailFade)
+        {
+            // tail steps past the fade levels are black, as in the script
+            int tailStep = int(jsRound(double(FADE_STEPS) * (step - stepPos) / tail));
+            color = 0;
+            if (tailStep >= 0 && tailStep < FADE_STEPS)
+            {
+                double level = (tailStep == 0) ? 1 : (1.0 / FADE_STEPS) * (FADE_STEPS - tailStep);
+                uint r = uint(jsRound(((rgb >> 16) & 0x00FF) * level));
+                uint g = uint(jsRound(((rgb >> 8) & 0x00FF) * level));
+                uint b = uint(jsRound((rgb & 0x00FF) * level));
+                color = (r << 16) + (g << 8) + b;
+            }
+        }
+        m_line[pos] = color;
+    }
+
+    frame.resize(size);
+    const uint *line = m_line.constData();
+    for (int y = 0; y < size.height(); y++)
+    {
+        uint *dst = frame.scanLine(y);
+        if (m_vertical)
+        {
+            for (int x = 0; x < size.width(); x++)
+                dst[x] = line[y];
+        }
+        else
+        {
+            memcpy(dst, line, size.width() * sizeof(uint));
+        }
+    }
+}
+
+void RGBWaves::applyProperty(const QString& propertyName, const QString& value)
+{
+    if (propertyName == "taillength")
+    {
+        m_tailLength = value.toDouble();
+    }
+    else if (propertyName == "tailfade")
+    {
+        if (value == "Yes")
+            m_tailFade = true;
+        else if (value == "No")
+            m_tailFade = false;
+    }
+    else if (propertyName == "direction")
+    {
+        if (value == "Right")
+            m_direction = Right;
+        else if (value == "Left")
+            m_direction = Left;
+        else if (value == "In")
+            m_direction = In;
+        else if (value == "Out")
+            m_direction = Out;
+    }
+    else if (propertyName == "orientation")
+    {
+        if (value == "Vertical")
+            m_vertical = true;
+        else if (value == "Horizontal")
+            m_vertical = false;
+    }
+}
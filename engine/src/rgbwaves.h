@@ -0,0 +1,77 @@
+/*
+  Q Light Controller Plus
+  rgbwaves.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef RGBWAVES_H
+#define RGBWAVES_H
+
+#include <QVector>
+
+#include "rgbnativescript.h"
+
+/** @addtogroup engine_functions Functions
+ * @{
+ */
+
+/**
+ * Native implementation of waves.js: a wave with a fading tail moving
+ * across the matrix, horizontally or vertically.
+ */
+class RGBWaves : public RGBNativeScript
+{
+public:
+    RGBWaves(Doc * doc);
+    RGBWaves(const RGBWaves& s);
+    ~RGBWaves();
+
+    /** @reimp */
+    RGBAlgorithm* clone() const;
+
+    /************************************************************************
+     * RGBAlgorithm API
+     ************************************************************************/
+public:
+    /** @reimp */
+    int rgbMapStepCount(const QSize& size);
+
+    /** @reimp */
+    void renderMap(const QSize& size, uint rgb, int step, RGBFrame& frame);
+
+protected:
+    /** @reimp */
+    void applyProperty(const QString& propertyName, const QString& value);
+
+private:
+    enum Direction { Right = 0, Left, In, Out };
+
+    /** Number of steps of the tail of a wave across $span pixels */
+    int tailSteps(int span) const;
+
+private:
+    double m_tailLength;
+    bool m_tailFade;
+    Direction m_direction;
+    bool m_vertical;
+
+    /** Colors of a line across the wave */
+    QVector<uint> m_line;
+};
+
+/** @} */
+
+#endif
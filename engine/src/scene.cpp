@@ -42,9 +42,14 @@
 
 Scene::Scene(Doc* doc) : Function(doc, Function::SceneType)
     , m_legacyFadeBus(Bus::invalid())
+    , m_valuesDirty(true)
     , m_fader(NULL)
+    , m_settled(false)
 {
     setName(tr("New Scene"));
+
+    connect(doc, SIGNAL(fixtureChanged(quint32)),
+            this, SLOT(slotFixtureChanged(quint32)));
 }
 
 Scene::~Scene()
@@ -92,6 +97,7 @@ bool Scene::copyFrom(const Function* function)
 
     m_values.clear();
     m_values = scene->m_values;
+    m_valuesDirty = true;
     m_fixtures.clear();
     m_fixtures = scene->m_fixtures;
     m_channelGroups.clear();
@@ -132,6 +138,9 @@ void Scene::setValue(const SceneValue& scv, bool blind, bool checkHTP)
             valChanged = true;
         }
 
+        if (valChanged)
+            m_valuesDirty = true;
+
         // if the scene is running, we must
         // update/add the changed channel
         if (blind == false && m_fader != NULL)
@@ -145,6 +154,7 @@ void Scene::setValue(const SceneValue& scv, bool blind, bool checkHTP)
                 m_fader->forceAdd(fc);
             else
                 m_fader->add(fc);
+            m_settled = false;
          }
     }
 
@@ -166,6 +176,7 @@ void Scene::unsetValue(quint32 fxi, quint32 ch)
     {
         QMutexLocker locker(&m_valueListMutex);
         m_values.remove(SceneValue(fxi, ch, 0));
+        m_valuesDirty = true;
     }
 
     emit changed(this->id());
@@ -253,6 +264,7 @@ QColor Scene::colorValue(quint32 fxi)
 void Scene::clear()
 {
     m_values.clear();
+    m_valuesDirty = true;
     m_fixtures.clear();
 }
 
@@ -319,7 +331,21 @@ void Scene::slotFixtureRemoved(quint32 fxi_id)
         hasChanged = true;
 
     if (hasChanged)
+    {
+        m_valuesDirty = true;
+        m_fixturesRevision.ref();
         emit changed(this->id());
+    }
+}
+
+void Scene::slotFixtureChanged(quint32 fxi_id)
+{
+    // The fixture might have a new address or new channels
+    if (m_fixtures.contains(fxi_id))
+    {
+        m_valuesDirty = true;
+        m_fixturesRevision.ref();
+    }
 }
 
 void Scene::addFixture(quint32 fixtureId)
@@ -526,6 +552,7 @@ void Scene::postLoad()
         if (fxi == NULL || fxi->channel(value.channel) == NULL)
             it.remove();
     }
+    m_valuesDirty = true;
 }
 
 /****************************************************************************
@@ -560,10 +587,12 @@ void Scene::writeDMX(MasterTimer* timer, QList<Universe *> ua)
     {
         // Keep HTP and LTP channels up. Flash is more or less a forceful intervention
         // so enforce all values that the user has chosen to flash.
-        foreach (const SceneValue& sv, m_values.keys())
+        QMutexLocker locker(&m_valueListMutex);
+        resolveValues();
+
+        for (int i = 0; i < m_resolvedValues.count(); i++)
         {
-            FadeChannel fc(doc(), sv.fxi, sv.channel);
-            fc.setTarget(sv.value);
+            FadeChannel fc(m_resolvedValues.at(i).m_fadeChannel);
             fc.setFlashing(true);
             // Force add this channel, since it will be removed
             // by MasterTimer once applied
@@ -602,56 +631,61 @@ void Scene::write(MasterTimer* timer, QList<Universe*> ua)
     {
         QMutexLocker locker(&m_valueListMutex);
 
+        resolveValues();
+
         m_fader = new GenericFader(doc());
         m_fader->adjustIntensity(getAttributeValue(Intensity));
         m_fader->setBlendMode(blendMode());
+        m_settled = false;
 
-        QMapIterator <SceneValue, uchar> it(m_values);
-        while (it.hasNext() == true)
+        uint fadeIn = overrideFadeInSpeed() == defaultSpeed() ? fadeInSpeed() : overrideFadeInSpeed();
+        if (tempoType() == Beats)
         {
-            SceneValue value(it.next().key());
-            bool canFade = true;
+            int fadeInTime = beatsToTime(fadeIn, timer->beatTimeDuration());
+            int beatOffset = timer->nextBeatTimeOffset();
 
-            FadeChannel fc(doc(), value.fxi, value.channel);
-            Fixture *fixture = doc()->fixture(value.fxi);
-            if (fixture != NULL)
-                canFade = fixture->channelCanFade(value.channel);
+            if (fadeInTime - beatOffset > 0)
+                fadeIn = fadeInTime - beatOffset;
+            else
+                fadeIn = fadeInTime;
+        }
 
-            fc.setTarget(value.value);
+        FadeChannelTable& channels(m_fader->channels());
+        QMutexLocker channelsLocker(timer->faderMutex());
+        const FadeChannelTable& timerChannels(timer->faderChannelsRef());
 
-            if (canFade == false)
-            {
-                fc.setFadeTime(0);
-            }
-            else
-            {
-                uint fadein = overrideFadeInSpeed() == defaultSpeed() ? fadeInSpeed() : overrideFadeInSpeed();
+        for (int i = 0; i < m_resolvedValues.count(); i++)
+        {
+            const ResolvedValue& rv(m_resolvedValues.at(i));
+            FadeChannel fc(rv.m_fadeChannel);
 
-                if (tempoType() == Beats)
-                {
-                    int fadeInTime = beatsToTime(fadein, timer->beatTimeDuration());
-                    int beatOffset = timer->nextBeatTimeOffset();
+            fc.setFadeTime(rv.m_canFade ? fadeIn : 0);
+            insertStartValue(fc, rv.m_group, timerChannels, ua);
 
-                    if (fadeInTime - beatOffset > 0)
-                        fc.setFadeTime(fadeInTime - beatOffset);
-                    else
-                        fc.setFadeTime(fadeInTime);
-                }
-                else
-                    fc.setFadeTime(fadein);
-            }
-            insertStartValue(fc, timer, ua);
-            m_fader->add(fc);
+            // Like GenericFader::add(), with the channel properties already known
+            int index = channels.indexOf(fc);
+            if (index == -1 || channels.current(index) <= fc.current())
+                channels.insert(fc, rv.m_group, rv.m_canFade);
         }
     }
 
-    //qDebug() << "[Scene] writing channels:" << m_fader->channels().count();
-    // Run the internal GenericFader
-    m_fader->write(ua, isPaused());
-
-    // Fader has nothing to do. Stop.
-    if (m_fader->channels().size() == 0)
-        stop(FunctionParent::master());
+    if (m_settled == true)
+    {
+        // All the fades are over: just write the final values
+        writeSettled(ua);
+    }
+    else
+    {
+        //qDebug() << "[Scene] writing channels:" << m_fader->channels().count();
+        // Run the internal GenericFader
+        m_fader->write(ua, isPaused());
+
+        // Fader has nothing to do. Stop.
+        if (m_fader->channels().size() == 0)
+            stop(FunctionParent::master());
+        else if (isPaused() == false)
+            m_settled = settle();
+    }
 
     if (isPaused() == false)
     {
@@ -665,19 +699,15 @@ void Scene::postRun(MasterTimer* timer, QList<Universe *> ua)
 {
     if (m_fader != NULL)
     {
-        QHashIterator <FadeChannel,FadeChannel> it(m_fader->channels());
-        while (it.hasNext() == true)
+        const FadeChannelTable& channels(m_fader->channels());
+        for (int i = 0; i < channels.count(); i++)
         {
-            it.next();
-            FadeChannel fc = it.value();
             // fade out only intensity channels
-            if (fc.group(doc()) != QLCChannel::Intensity)
+            if (channels.group(i) != QLCChannel::Intensity)
                 continue;
 
-            bool canFade = true;
-            Fixture *fixture = doc()->fixture(fc.fixture());
-            if (fixture != NULL)
-                canFade = fixture->channelCanFade(fc.channel());
+            FadeChannel fc = channels.at(i);
+            bool canFade = channels.canFade(i);
             fc.setStart(fc.current(getAttributeValue(Intensity)));
             fc.setCurrent(fc.current(getAttributeValue(Intensity)));
 
@@ -706,20 +736,23 @@ void Scene::postRun(MasterTimer* timer, QList<Universe *> ua)
         m_fader = NULL;
     }
 
+    m_settled = false;
+    m_settledRuns.clear();
+    m_settledValues.clear();
+
     Function::postRun(timer, ua);
 }
 
-void Scene::insertStartValue(FadeChannel& fc, const MasterTimer* timer,
+void Scene::insertStartValue(FadeChannel& fc, QLCChannel::Group group,
+                             const FadeChannelTable& timerChannels,
                              const QList<Universe*> ua)
 {
-    QMutexLocker channelsLocker(timer->faderMutex());
-    QHash <FadeChannel,FadeChannel> const& channels(timer->faderChannelsRef());
-    QHash <FadeChannel,FadeChannel>::const_iterator existing_it = channels.find(fc);
-    if (existing_it != channels.constEnd())
+    int existing = timerChannels.indexOf(fc);
+    if (existing != -1)
     {
         // MasterTimer's GenericFader contains the channel so grab its current
         // value as the new starting value to get a smoother fade
-        fc.setStart(existing_it.value().current());
+        fc.setStart(timerChannels.current(existing));
         fc.setCurrent(fc.start());
     }
     else
@@ -727,7 +760,7 @@ void Scene::insertStartValue(FadeChannel& fc, const MasterTimer* timer,
         // MasterTimer didn't have the channel. Grab the starting value from UniverseArray.
         quint32 address = fc.address();
         quint32 uni = fc.universe();
-        if (fc.group(doc()) != QLCChannel::Intensity)
+        if (group != QLCChannel::Intensity)
             fc.setStart(ua[uni]->preGMValue(address));
         else
             fc.setStart(0); // HTP channels must start at zero
@@ -735,6 +768,192 @@ void Scene::insertStartValue(FadeChannel& fc, const MasterTimer* timer,
     }
 }
 
+void Scene::resolveValues()
+{
+    if (m_valuesDirty == false)
+        return;
+
+    m_valuesDirty = false;
+    m_resolvedValues.clear();
+    m_resolvedValues.reserve(m_values.size());
+
+    QMapIterator <SceneValue, uchar> it(m_values);
+    while (it.hasNext() == true)
+        m_resolvedValues.append(resolveValue(it.next().key()));
+}
+
+Scene::ResolvedValue Scene::resolveValue(const SceneValue& value) const
+{
+    ResolvedValue rv;
+
+    rv.m_fadeChannel = FadeChannel(doc(), value.fxi, value.channel);
+    rv.m_fadeChannel.setTarget(value.value);
+    rv.m_group = rv.m_fadeChannel.group(doc());
+    rv.m_canFade = rv.m_fadeChannel.canFade(doc());
+
+    return rv;
+}
+
+/*****************************************************************************
+ * Staging
+ *****************************************************************************/
+
+void Scene::prepareValues()
+{
+    QMutexLocker locker(&m_valueListMutex);
+    resolveValues();
+}
+
+Scene::StagedValues Scene::stageValues(const QList <SceneValue>& values) const
+{
+    StagedValues staged;
+
+    // read the revision first: a fixture change happening
+    // while the values are resolved invalidates them
+    staged.m_fixturesRevision = m_fixturesRevision.load();
+
+    for (int i = 0; i < values.count(); i++)
+        staged.m_values.insert(values.at(i), values.at(i).value);
+
+    // resolve in the order of m_values, like resolveValues() does
+    staged.m_resolvedValues.reserve(staged.m_values.size());
+    QMapIterator <SceneValue, uchar> it(staged.m_values);
+    while (it.hasNext() == true)
+        staged.m_resolvedValues.append(resolveValue(it.next().key()));
+
+    return staged;
+}
+
+void Scene::setStagedValues(const StagedValues& staged)
+{
+    bool sameChannels = false;
+
+    {
+        QMutexLocker locker(&m_valueListMutex);
+
+        // the staged values replace the scene values when they set the
+        // same channels, which is the case of consecutive sequence steps
+        if (m_values.size() == staged.m_values.size())
+        {
+            sameChannels = true;
+            QMap <SceneValue, uchar>::const_iterator it = m_values.constBegin();
+            QMap <SceneValue, uchar>::const_iterator sit = staged.m_values.constBegin();
+            for (; it != m_values.constEnd(); ++it, ++sit)
+            {
+                if ((it.key() == sit.key()) == false)
+                {
+                    sameChannels = false;
+                    break;
+                }
+            }
+        }
+
+        if (sameChannels)
+        {
+            QList <SceneValue> changedValues;
+            QMap <SceneValue, uchar>::const_iterator it = m_values.constBegin();
+            QMap <SceneValue, uchar>::const_iterator sit = staged.m_values.constBegin();
+            for (; it != m_values.constEnd(); ++it, ++sit)
+            {
+                if (it.value() != sit.value())
+                    changedValues.append(sit.key());
+            }
+
+            m_values = staged.m_values;
+            m_resolvedValues = staged.m_resolvedValues;
+            m_valuesDirty = (staged.m_fixturesRevision != m_fixturesRevision.load());
+
+            locker.unlock();
+
+            emit changed(this->id());
+            foreach (SceneValue scv, changedValues)
+                emit valueChanged(scv);
+            return;
+        }
+    }
+
+    QMapIterator <SceneValue, uchar> it(staged.m_values);
+    while (it.hasNext() == true)
+        setValue(it.next().key(), true);
+}
+
+bool Scene::settle()
+{
+    const FadeChannelTable& channels(m_fader->channels());
+
+    for (int i = 0; i < channels.count(); i++)
+    {
+        if (channels.current(i) != channels.target(i))
+            return false;
+    }
+
+    // Sort the final values by address, to write them in runs
+    QMap <quint32, uchar> values;
+    for (int i = 0; i < channels.count(); i++)
+    {
+        quint32 universe = channels.universe(i);
+        if (universe == Universe::invalid())
+            continue;
+
+        uchar value = channels.current(i);
+        if (channels.group(i) == QLCChannel::Intensity && channels.canFade(i) == true)
+            value = channels.current(i, m_fader->intensity());
+
+        values.insert((universe * UNIVERSE_SIZE) + channels.addressInUniverse(i), value);
+    }
+
+    m_settledRuns.clear();
+    m_settledValues.resize(values.size());
+
+    int offset = 0;
+    QMapIterator <quint32, uchar> it(values);
+    while (it.hasNext() == true)
+    {
+        it.next();
+        quint32 universe = it.key() / UNIVERSE_SIZE;
+        int address = it.key() % UNIVERSE_SIZE;
+
+        if (m_settledRuns.isEmpty() ||
+            m_settledRuns.last().m_universe != universe ||
+            m_settledRuns.last().m_address + m_settledRuns.last().m_count != address)
+        {
+            SettledRun run;
+            run.m_universe = universe;
+            run.m_address = address;
+            run.m_offset = offset;
+            run.m_count = 0;
+            m_settledRuns.append(run);
+        }
+
+        m_settledRuns.last().m_count++;
+        m_settledValues[offset++] = char(it.value());
+    }
+
+    return true;
+}
+
+void Scene::writeSettled(QList<Universe*> ua)
+{
+    const uchar *values = reinterpret_cast<const uchar *>(m_settledValues.constData());
+    Universe::BlendMode mode = blendMode();
+
+    for (int i = 0; i < m_settledRuns.count(); i++)
+    {
+        const SettledRun& run(m_settledRuns.at(i));
+        Universe *universe = ua[run.m_universe];
+
+        if (mode == Universe::NormalBlend)
+        {
+            universe->writeRange(run.m_address, values + run.m_offset, run.m_count);
+        }
+        else
+        {
+            for (int c = 0; c < run.m_count; c++)
+                universe->writeBlended(run.m_address + c, values[run.m_offset + c], mode);
+        }
+    }
+}
+
 /****************************************************************************
  * Intensity
  ****************************************************************************/
@@ -744,7 +963,11 @@ int Scene::adjustAttribute(qreal fraction, int attributeId)
     int attrIndex = Function::adjustAttribute(fraction, attributeId);
 
     if (m_fader != NULL && attrIndex == Intensity)
+    {
         m_fader->adjustIntensity(getAttributeValue(Function::Intensity));
+        // write through the fader again, to settle with the new intensity
+        m_settled = false;
+    }
 
     return attrIndex;
 }
@@ -761,7 +984,10 @@ void Scene::setBlendMode(Universe::BlendMode mode)
     qDebug() << "Scene" << name() << "blend mode set to" << Universe::blendModeToString(mode);
 
     if (m_fader != NULL)
+    {
         m_fader->setBlendMode(mode);
+        m_settled = false;
+    }
 
     Function::setBlendMode(mode);
 }
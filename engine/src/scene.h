@@ -21,6 +21,9 @@
 #ifndef SCENE_H
 #define SCENE_H
 
+#include <QByteArray>
+#include <QAtomicInt>
+#include <QVector>
 #include <QMutex>
 #include <QList>
 
@@ -148,6 +151,66 @@ protected:
     QMap <SceneValue, uchar> m_values;
     QMutex m_valueListMutex;
 
+private:
+    /** Resolve m_values into m_resolvedValues, if they have changed.
+     *  Must be called with m_valueListMutex locked */
+    void resolveValues();
+
+private:
+    /** A scene value resolved to the fixture channel it is written to */
+    struct ResolvedValue
+    {
+        /** Fade channel with address and target set */
+        FadeChannel m_fadeChannel;
+        QLCChannel::Group m_group;
+        bool m_canFade;
+    };
+
+    /** Resolve a single $value to the fixture channel it is written to */
+    ResolvedValue resolveValue(const SceneValue& value) const;
+
+    /** The scene values, resolved once and reused at every start */
+    QVector<ResolvedValue> m_resolvedValues;
+
+    /** Set when values or fixtures change, to resolve the values again */
+    bool m_valuesDirty;
+
+    /** Incremented at each change of the scene fixtures, to tell
+     *  if values staged ahead of time are still valid */
+    QAtomicInt m_fixturesRevision;
+
+    /*********************************************************************
+     * Staging
+     *********************************************************************/
+public:
+    /** A set of values resolved ahead of time by stageValues() */
+    struct StagedValues
+    {
+        QMap <SceneValue, uchar> m_values;
+        QVector<ResolvedValue> m_resolvedValues;
+        int m_fixturesRevision;
+    };
+
+    /**
+     * Resolve the current values ahead of the next start of the scene,
+     * so that the start has no fixture lookup to do. This is called by
+     * the runners of Chasers and Shows, on the MasterTimer thread.
+     */
+    void prepareValues();
+
+    /**
+     * Resolve $values without touching the scene, so that they can be
+     * set later at once with setStagedValues().
+     */
+    StagedValues stageValues(const QList <SceneValue>& values) const;
+
+    /**
+     * Set the values resolved by stageValues(), like setValue() with
+     * $blind set to true would do for each of them. When the staged values
+     * replace all the scene values, their resolved form is kept as it is.
+     */
+    void setStagedValues(const StagedValues& staged);
+
     /*********************************************************************
      * Channel Groups
      *********************************************************************/
@@ -187,6 +250,10 @@ protected:
 public slots:
     void slotFixtureRemoved(quint32 fxi_id);
 
+private slots:
+    /** Resolve the values again when one of the scene fixtures changes */
+    void slotFixtureChanged(quint32 fxi_id);
+
 public:
     void addFixture(quint32 fixtureId);
     bool removeFixture(quint32 fixtureId);
@@ -238,12 +305,42 @@ public:
     void postRun(MasterTimer* timer, QList<Universe*> ua);
 
 private:
-    /** Insert starting values to $fc, either from $timer->fader() or $ua */
-    void insertStartValue(FadeChannel& fc, const MasterTimer* timer, const QList<Universe *> ua);
+    /** Insert starting values to $fc, either from $timerChannels or $ua */
+    void insertStartValue(FadeChannel& fc, QLCChannel::Group group,
+                          const FadeChannelTable& timerChannels, const QList<Universe *> ua);
+
+    /**
+     * Check if all the fades of m_fader have reached their targets and,
+     * if so, prepare m_settledRuns and m_settledValues with the final values.
+     *
+     * @return true if the scene is settled
+     */
+    bool settle();
+
+    /** Write the final values of a settled scene to $ua */
+    void writeSettled(QList<Universe*> ua);
 
 private:
     GenericFader* m_fader;
 
+    /** A run of consecutive channels of a settled scene */
+    struct SettledRun
+    {
+        quint32 m_universe;
+        int m_address;
+        /** Index of the first value of the run in m_settledValues */
+        int m_offset;
+        int m_count;
+    };
+
+    /** Once all the fades are complete, the scene values don't change
+     *  anymore and they are written directly to the universes, run by
+     *  run, without going through m_fader. Any change to the running
+     *  scene (values, intensity, blend mode) clears this flag */
+    bool m_settled;
+    QVector<SettledRun> m_settledRuns;
+    QByteArray m_settledValues;
+
     /*********************************************************************
      * Attributes
      *********************************************************************/
@@ -657,8 +657,9 @@ QString Script::handleSetFixture(const QList<QStringList>& tokens, QList<Univers
                 // the bowels of GenericFader so get the starting value from there.
                 // Otherwise get it from universes (HTP channels are always 0 then).
                 quint32 uni = fc.universe();
-                if (gf->channels().contains(fc) == true)
-                    fc.setStart(gf->channels()[fc].current());
+                int existing = gf->channels().indexOf(fc);
+                if (existing != -1)
+                    fc.setStart(gf->channels().current(existing));
                 else
                     fc.setStart(universes[uni]->preGMValue(address));
                 fc.setCurrent(fc.start());
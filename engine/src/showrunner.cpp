@@ -19,6 +19,7 @@
 
 #include <QMutex>
 #include <QDebug>
+#include <algorithm>
 
 #include "showrunner.h"
 #include "chaserstep.h"
@@ -34,11 +35,12 @@
 
 #define TIMER_INTERVAL 50
 
-static bool compareShowFunctions(const ShowFunction *sf1, const ShowFunction *sf2)
+/** Number of ticks the Functions are prepared ahead of their start */
+#define LOOKAHEAD_TICKS 4
+
+static bool compareRunTimes(const QPair<quint32, int>& r1, const QPair<quint32, int>& r2)
 {
-    if (sf1->startTime() < sf2->startTime())
-        return true;
-    return false;
+    return r1.first < r2.first;
 }
 
 ShowRunner::ShowRunner(const Doc* doc, quint32 showID, quint32 startTime)
@@ -46,7 +48,10 @@ ShowRunner::ShowRunner(const Doc* doc, quint32 showID, quint32 startTime)
     , m_doc(doc)
     , m_elapsedTime(startTime)
     , m_totalRunTime(0)
+    , m_treeSize(1)
     , m_currentFunctionIndex(0)
+    , m_currentStopIndex(0)
+    , m_preparedIndex(0)
 {
     Q_ASSERT(m_doc != NULL);
     Q_ASSERT(showID != Show::invalidId());
@@ -55,6 +60,8 @@ ShowRunner::ShowRunner(const Doc* doc, quint32 showID, quint32 startTime)
     if (m_show == NULL)
         return;
 
+    QVector <FunctionRun> runs;
+
     foreach(Track *track, m_show->tracks())
     {
         // some sanity checks
@@ -65,33 +72,70 @@ ShowRunner::ShowRunner(const Doc* doc, quint32 showID, quint32 startTime)
         if (track->isMute())
             continue;
 
-        // get all the functions of the track and append them to the runner queue
+        // get all the functions of the track and resolve them once for all,
+        // together with the track they belong to
         foreach(ShowFunction *sfunc, track->showFunctions())
         {
-            if (sfunc->startTime() + sfunc->duration() <= startTime)
-                continue;
             Function *f = m_doc->function(sfunc->functionID());
             if (f == NULL)
                 continue;
 
-            m_functions.append(sfunc);
+            FunctionRun run;
+            run.m_showFunction = sfunc;
+            run.m_function = f;
+            run.m_trackId = track->id();
+            run.m_startTime = sfunc->startTime();
+            run.m_stopTime = sfunc->startTime() + sfunc->duration();
+            runs.append(run);
 
-            if (sfunc->startTime() + sfunc->duration() > m_totalRunTime)
-                m_totalRunTime = sfunc->startTime() + sfunc->duration();
+            if (run.m_stopTime > m_totalRunTime)
+                m_totalRunTime = run.m_stopTime;
         }
 
         // Initialize the intensity map
         m_intensityMap[track->id()] = 1.0;
     }
 
-    qSort(m_functions.begin(), m_functions.end(), compareShowFunctions);
+    // Order the Functions by start time, and build the stop events
+    QVector < QPair<quint32, int> > order;
+    for (int i = 0; i < runs.count(); i++)
+        order.append(QPair<quint32, int>(runs.at(i).m_startTime, i));
+    std::stable_sort(order.begin(), order.end(), compareRunTimes);
+
+    for (int i = 0; i < order.count(); i++)
+    {
+        m_runs.append(runs.at(order.at(i).second));
+        m_startTimes.append(order.at(i).first);
+    }
+
+    order.clear();
+    for (int i = 0; i < m_runs.count(); i++)
+        order.append(QPair<quint32, int>(m_runs.at(i).m_stopTime, i));
+    std::stable_sort(order.begin(), order.end(), compareRunTimes);
 
-#if 1
+    for (int i = 0; i < order.count(); i++)
+    {
+        m_stopOrder.append(order.at(i).second);
+        m_stopTimes.append(order.at(i).first);
+    }
+
+    // The leaves of the tree are the stop times of m_runs,
+    // each node holds the latest stop time of its two children
+    while (m_treeSize < m_runs.count())
+        m_treeSize *= 2;
+    m_maxStopTree.fill(0, 2 * m_treeSize);
+    for (int i = 0; i < m_runs.count(); i++)
+        m_maxStopTree[m_treeSize + i] = m_runs.at(i).m_stopTime;
+    for (int i = m_treeSize - 1; i > 0; i--)
+        m_maxStopTree[i] = qMax(m_maxStopTree.at(2 * i), m_maxStopTree.at(2 * i + 1));
+
+#if 0
     qDebug() << "Ordered list of ShowFunctions:";
-    foreach (ShowFunction *sfunc, m_functions)
-        qDebug() << "ID:" << sfunc->functionID() << "st:" << sfunc->startTime() << "dur:" << sfunc->duration();
+    foreach (FunctionRun run, m_runs)
+        qDebug() << "ID:" << run.m_function->id() << "st:" << run.m_startTime << "stop:" << run.m_stopTime;
 #endif
     m_runningQueue.clear();
+    seek(startTime);
 
     qDebug() << "ShowRunner created";
 }
@@ -109,22 +153,21 @@ void ShowRunner::setPause(bool enable)
 {
     for (int i = 0; i < m_runningQueue.count(); i++)
     {
-        Function *f = m_runningQueue.at(i).first;
+        Function *f = m_runs.at(m_runningQueue.at(i)).m_function;
         f->setPause(enable);
     }
 }
 
 void ShowRunner::stop()
 {
-    m_elapsedTime = 0;
-    m_currentFunctionIndex = 0;
     for (int i = 0; i < m_runningQueue.count(); i++)
     {
-        Function *f = m_runningQueue.at(i).first;
+        Function *f = m_runs.at(m_runningQueue.at(i)).m_function;
         f->stop(functionParent());
     }
 
     m_runningQueue.clear();
+    seek(0);
     qDebug() << "ShowRunner stopped";
 }
 
@@ -137,65 +180,31 @@ void ShowRunner::write()
 {
     //qDebug() << Q_FUNC_INFO << "elapsed:" << m_elapsedTime << ", total:" << m_totalRunTime;
 
-    // Phase 1. Check all the Functions that need to be started
-    // m_functions is ordered by startup time, so when we found an entry
-    // with start time greater than m_elapsed, this phase is over
-    bool startupDone = false;
-
-    while(startupDone == false)
+    // Phase 1. Start the Functions that were already running at the seek
+    // time, then the ones whose start time has come. m_runs is ordered by
+    // start time, so when an entry starts later than m_elapsed, this phase is over
+    while (m_seekQueue.isEmpty() == false)
     {
-        if (m_currentFunctionIndex == m_functions.count())
-            break;
-
-        ShowFunction *sf = m_functions.at(m_currentFunctionIndex);
-        quint32 funcStartTime = sf->startTime();
-        quint32 functionTimeOffset = 0;
-        Function *f = m_doc->function(sf->functionID());
-
-        // this should happen only when a Show is not started from 0
-        if (m_elapsedTime > funcStartTime)
-        {
-            functionTimeOffset = m_elapsedTime - funcStartTime;
-            funcStartTime = m_elapsedTime;
-        }
-        if (m_elapsedTime >= funcStartTime)
-        {
-            foreach (Track *track, m_show->tracks())
-            {
-                if (track->showFunctions().contains(sf))
-                {
-                    int intOverrideId = f->requestAttributeOverride(Function::Intensity, m_intensityMap[track->id()]);
-                    //f->adjustAttribute(m_intensityMap[track->id()], Function::Intensity);
-                    sf->setIntensityOverrideId(intOverrideId);
-                    break;
-                }
-            }
-
-            f->start(m_doc->masterTimer(), functionParent(), functionTimeOffset);
-            m_runningQueue.append(QPair<Function *, quint32>(f, sf->startTime() + sf->duration()));
-            m_currentFunctionIndex++;
-        }
-        else
-            startupDone = true;
+        int index = m_seekQueue.takeFirst();
+        startRun(index, m_elapsedTime - m_runs.at(index).m_startTime);
     }
 
-    // Phase 2. Check if we need to stop some running Functions
-    // It is done in reverse order for two reasons:
-    // 1- m_runningQueue is not ordered by stop time
-    // 2- to avoid messing up with indices when an entry is removed
-    for(int i = m_runningQueue.count() - 1; i >= 0; i--)
+    while (m_currentFunctionIndex < m_runs.count() &&
+           m_startTimes.at(m_currentFunctionIndex) <= m_elapsedTime)
     {
-        Function *func = m_runningQueue.at(i).first;
-        quint32 stopTime = m_runningQueue.at(i).second;
+        startRun(m_currentFunctionIndex, m_elapsedTime - m_startTimes.at(m_currentFunctionIndex));
+        m_currentFunctionIndex++;
+    }
 
-        // if we passed the function stop time
-        if (m_elapsedTime >= stopTime)
-        {
-            // stop the function
-            func->stop(functionParent());
-            // remove it from the running queue
-            m_runningQueue.removeAt(i);
-        }
+    // Phase 2. Stop the Functions whose stop time has come.
+    // m_stopOrder is ordered by stop time, so this works the same way
+    while (m_currentStopIndex < m_stopOrder.count() &&
+           m_stopTimes.at(m_currentStopIndex) <= m_elapsedTime)
+    {
+        int index = m_stopOrder.at(m_currentStopIndex);
+        if (m_runningQueue.removeOne(index))
+            m_runs.at(index).m_function->stop(functionParent());
+        m_currentStopIndex++;
     }
 
     // Phase 3. Check if this is the end of the Show
@@ -209,6 +218,78 @@ void ShowRunner::write()
 
     m_elapsedTime += MasterTimer::tick();
     emit timeChanged(m_elapsedTime);
+
+    prepareFunctions();
+}
+
+void ShowRunner::prepareFunctions()
+{
+    quint32 horizon = m_elapsedTime + LOOKAHEAD_TICKS * MasterTimer::tick();
+
+    if (m_preparedIndex < m_currentFunctionIndex)
+        m_preparedIndex = m_currentFunctionIndex;
+
+    // m_runs is ordered by start time, so the ones to prepare
+    // are the ones after the last prepared, up to the horizon
+    while (m_preparedIndex < m_runs.count() &&
+           m_startTimes.at(m_preparedIndex) <= horizon)
+    {
+        Scene *scene = qobject_cast<Scene*>(m_runs.at(m_preparedIndex).m_function);
+        if (scene != NULL)
+            scene->prepareValues();
+        m_preparedIndex++;
+    }
+}
+
+/************************************************************************
+ * Timeline
+ ************************************************************************/
+
+void ShowRunner::seek(quint32 time)
+{
+    m_elapsedTime = time;
+
+    // Functions starting after $time are still to come...
+    m_currentFunctionIndex = std::upper_bound(m_startTimes.begin(), m_startTimes.end(), time)
+                             - m_startTimes.begin();
+    // ...and so are the stops after $time
+    m_currentStopIndex = std::upper_bound(m_stopTimes.begin(), m_stopTimes.end(), time)
+                         - m_stopTimes.begin();
+    m_preparedIndex = m_currentFunctionIndex;
+
+    // the ones started before $time that are not over yet are active
+    m_seekQueue.clear();
+    collectActive(1, 0, m_treeSize, m_currentFunctionIndex, time, m_seekQueue);
+}
+
+void ShowRunner::startRun(int index, quint32 offset)
+{
+    const FunctionRun& run(m_runs.at(index));
+
+    int intOverrideId = run.m_function->requestAttributeOverride(Function::Intensity,
+                                                                 m_intensityMap[run.m_trackId]);
+    run.m_showFunction->setIntensityOverrideId(intOverrideId);
+
+    run.m_function->start(m_doc->masterTimer(), functionParent(), offset);
+    m_runningQueue.append(index);
+}
+
+void ShowRunner::collectActive(int node, int first, int last, int count,
+                               quint32 time, QList <int>& active) const
+{
+    // skip the subtrees that are past $count or that are all over by $time
+    if (first >= count || m_maxStopTree.at(node) <= time)
+        return;
+
+    if (last - first == 1)
+    {
+        active.append(first);
+        return;
+    }
+
+    int middle = (first + last) / 2;
+    collectActive(2 * node, first, middle, count, time, active);
+    collectActive(2 * node + 1, middle, last, count, time, active);
 }
 
 /************************************************************************
@@ -223,18 +304,10 @@ void ShowRunner::adjustIntensity(qreal fraction, Track *track)
     qDebug() << Q_FUNC_INFO << "Track ID: " << track->id() << ", val:" << fraction;
     m_intensityMap[track->id()] = fraction;
 
-    foreach (ShowFunction *sf, track->showFunctions())
+    for (int i = 0; i < m_runningQueue.count(); i++)
     {
-        Function *f = m_doc->function(sf->functionID());
-        if (f == NULL)
-            continue;
-
-        for (int i = 0; i < m_runningQueue.count(); i++)
-        {
-            Function *rf = m_runningQueue.at(i).first;
-            if (f == rf)
-                f->adjustAttribute(fraction, sf->intensityOverrideId());
-        }
+        const FunctionRun& run(m_runs.at(m_runningQueue.at(i)));
+        if (run.m_trackId == track->id())
+            run.m_function->adjustAttribute(fraction, run.m_showFunction->intensityOverrideId());
     }
 }
-
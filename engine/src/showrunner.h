@@ -21,6 +21,7 @@
 #define SHOWRUNNER_H
 
 #include <QObject>
+#include <QVector>
 #include <QMutex>
 #include <QMap>
 
@@ -55,27 +56,26 @@ public:
 
     void write();
 
+private:
+    /**
+     * Resolve the Functions that start within the next few ticks ahead of
+     * their start. Called by write() at the end of each tick, on the
+     * MasterTimer thread, where the Functions run.
+     */
+    void prepareFunctions();
+
 private:
     const Doc* m_doc;
 
     /** The reference of the show to play */
     Show* m_show;
 
-    /** The list of Functions of the show to play */
-    QList <ShowFunction *> m_functions;
-
     /** Elapsed time since runner start. Used also to move the cursor in MultiTrackView */
     quint32 m_elapsedTime;
 
     /** Total time the runner has to run */
     quint32 m_totalRunTime;
 
-    /** List of the currently running Functions and their stop time */
-    QList < QPair<Function *, quint32> > m_runningQueue;
-
-    /** Index of the item in m_functions to be considered for playback */
-    int m_currentFunctionIndex;
-
 private:
     FunctionParent functionParent() const;
 
@@ -83,6 +83,68 @@ signals:
     void timeChanged(quint32 time);
     void showFinished();
 
+    /************************************************************************
+     * Timeline
+     ************************************************************************/
+private:
+    /**
+     * Move the timeline to $time, without starting any Function. The ones
+     * that are active at $time are started with an offset at the next write().
+     * This is a binary search, plus a walk over the active Functions only.
+     */
+    void seek(quint32 time);
+
+    /** Start the Function of m_runs at $index, $offset milliseconds in */
+    void startRun(int index, quint32 offset);
+
+    /**
+     * Append to $active the indices of m_runs lower than $count that are
+     * still running at $time, looking into the subtree of $node that
+     * covers the indices from $first to $last (excluded)
+     */
+    void collectActive(int node, int first, int last, int count,
+                       quint32 time, QList <int>& active) const;
+
+private:
+    /** A ShowFunction of the show, resolved once when the runner is created */
+    struct FunctionRun
+    {
+        ShowFunction *m_showFunction;
+        Function *m_function;
+        quint32 m_trackId;
+        quint32 m_startTime;
+        quint32 m_stopTime;
+    };
+
+    /** The Functions of the show to play, ordered by start time */
+    QVector <FunctionRun> m_runs;
+
+    /** The start times of m_runs, for binary searches */
+    QVector <quint32> m_startTimes;
+
+    /** The indices of m_runs ordered by stop time, and their stop times */
+    QVector <int> m_stopOrder;
+    QVector <quint32> m_stopTimes;
+
+    /** Binary tree over m_runs, holding the latest stop time of each subtree */
+    QVector <quint32> m_maxStopTree;
+    int m_treeSize;
+
+    /** Index of the next item in m_runs to be started */
+    int m_currentFunctionIndex;
+
+    /** Index of the next item in m_stopOrder to be stopped */
+    int m_currentStopIndex;
+
+    /** Index of the next item in m_runs to be prepared by prepareFunctions() */
+    int m_preparedIndex;
+
+    /** Indices in m_runs of the Functions active at the seek time */
+    QList <int> m_seekQueue;
+
+    /** Indices in m_runs of the currently running Functions */
+    QList <int> m_runningQueue;
+
     /************************************************************************
      * Intensity
      ************************************************************************/
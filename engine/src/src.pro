@@ -78,7 +78,9 @@ HEADERS += bus.h \
            dmxsource.h \
            efx.h \
            efxfixture.h \
+           engineprofiler.h \
            fadechannel.h \
+           fadechanneltable.h \
            fixture.h \
            fixturegroup.h \
            function.h \
@@ -93,16 +95,26 @@ HEADERS += bus.h \
            mastertimer.h \
            monitorproperties.h \
            outputpatch.h \
+           pixelfader.h \
            qlcclipboard.h \
            qlcpoint.h \
            rgbalgorithm.h \
            rgbaudio.h \
+           rgbframe.h \
+           rgbframecache.h \
            rgbmatrix.h \
            rgbimage.h \
+           rgbballs.h \
+           rgbnativescript.h \
+           rgbnoise.h \
            rgbplain.h \
+           rgbplasma.h \
            rgbscriptproperty.h \
            rgbscriptscache.h \
+           rgbstarfield.h \
+           rgbstream.h \
            rgbtext.h \
+           rgbwaves.h \
            scene.h \
            scenevalue.h \
            script.h \
@@ -156,7 +168,9 @@ SOURCES += bus.cpp \
            dmxdumpfactoryproperties.cpp \
            efx.cpp \
            efxfixture.cpp \
+           engineprofiler.cpp \
            fadechannel.cpp \
+           fadechanneltable.cpp \
            fixture.cpp \
            fixturegroup.cpp \
            function.cpp \
@@ -171,15 +185,25 @@ SOURCES += bus.cpp \
            mastertimer.cpp \
            monitorproperties.cpp \
            outputpatch.cpp \
+           pixelfader.cpp \
            qlcclipboard.cpp \
            qlcpoint.cpp \
            rgbalgorithm.cpp \
            rgbaudio.cpp \
+           rgbframe.cpp \
+           rgbframecache.cpp \
            rgbmatrix.cpp \
            rgbimage.cpp \
+           rgbballs.cpp \
+           rgbnativescript.cpp \
+           rgbnoise.cpp \
            rgbplain.cpp \
+           rgbplasma.cpp \
            rgbscriptscache.cpp \
+           rgbstarfield.cpp \
+           rgbstream.cpp \
            rgbtext.cpp \
+           rgbwaves.cpp \
            scene.cpp \
            scenevalue.cpp \
            script.cpp \
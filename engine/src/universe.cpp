@@ -22,6 +22,12 @@
 #include <QDebug>
 #include <math.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "channelmodifier.h"
 #include "inputoutputmap.h"
 #include "qlcioplugin.h"
@@ -56,8 +62,13 @@ Universe::Universe(quint32 id, GrandMaster *gm, QObject *parent)
     , m_intensityChannelsChanged(false)
     , m_preGMValues(new QByteArray(UNIVERSE_SIZE, char(0)))
     , m_postGMValues(new QByteArray(UNIVERSE_SIZE, char(0)))
-    , m_lastPostGMValues(new QByteArray(UNIVERSE_SIZE, char(0)))
+    , m_lastPostGMValues(new QByteArray())
+    , m_generation(0)
     , m_passthroughValues()
+    , m_hasRelativeValues(false)
+    , m_batchMode(false)
+    , m_dirtyMin(UNIVERSE_SIZE)
+    , m_dirtyMax(-1)
 {
     m_relativeValues.fill(0, UNIVERSE_SIZE);
     m_modifiers.fill(NULL, UNIVERSE_SIZE);
@@ -116,13 +127,29 @@ ushort Universe::totalChannels()
 
 bool Universe::hasChanged()
 {
-    bool changed =
+    bool changed = m_lastPostGMValues->size() != m_usedChannels ||
         memcmp(m_lastPostGMValues->constData(), m_postGMValues->constData(), m_usedChannels) != 0;
     if (changed)
+    {
+        // the snapshot is detached (copied) here only if a listener
+        // is still holding the previous one. Otherwise it's reused.
+        m_lastPostGMValues->resize(m_usedChannels);
         memcpy(m_lastPostGMValues->data(), m_postGMValues->constData(), m_usedChannels);
+        m_generation++;
+    }
     return changed;
 }
 
+const QByteArray &Universe::postGMSnapshot() const
+{
+    return *m_lastPostGMValues;
+}
+
+quint32 Universe::generation() const
+{
+    return m_generation;
+}
+
 void Universe::setPassthrough(bool enable)
 {
     if (enable == m_passthrough)
@@ -202,6 +229,8 @@ void Universe::reset()
     }
     zeroRelativeValues();
     m_modifiers.fill(NULL, UNIVERSE_SIZE);
+    m_modifiedChannels.clear();
+    m_modifiedZeroValues->fill(0);
     m_passthrough = false; // not releasing m_passthroughValues, see comment in setPassthrough
 }
 
@@ -228,6 +257,13 @@ void Universe::reset(int address, int range)
 
     memset(m_preGMValues->data() + address, 0, range * sizeof(*m_preGMValues->data()));
     memset(m_relativeValues.data() + address, 0, range * sizeof(*m_relativeValues.data()));
+
+    if (m_batchMode)
+    {
+        markDirty(address, range);
+        return;
+    }
+
     memcpy(m_postGMValues->data() + address, m_modifiedZeroValues->data() + address, range * sizeof(*m_postGMValues->data()));
 
     applyPassthroughValues(address, range);
@@ -262,6 +298,10 @@ uchar Universe::postGMValue(int address) const
     if (address >= m_postGMValues->size())
         return 0;
 
+    // in batch mode, dirty channels are not processed yet
+    if (m_batchMode && address >= m_dirtyMin && address <= m_dirtyMax)
+        return calculatePostGMValue(address);
+
     return uchar(m_postGMValues->at(address));
 }
 
@@ -272,7 +312,11 @@ const QByteArray* Universe::postGMValues() const
 
 void Universe::zeroRelativeValues()
 {
+    if (m_hasRelativeValues == false)
+        return;
+
     memset(m_relativeValues.data(), 0, UNIVERSE_SIZE * sizeof(*m_relativeValues.data()));
+    m_hasRelativeValues = false;
 }
 
 Universe::BlendMode Universe::stringToBlendMode(QString mode)
@@ -322,7 +366,7 @@ uchar Universe::preGMValue(int address) const
     return static_cast<uchar>(m_preGMValues->at(address));
 }
 
-uchar Universe::applyRelative(int channel, uchar value)
+uchar Universe::applyRelative(int channel, uchar value) const
 {
     if (m_relativeValues[channel] != 0)
     {
@@ -333,7 +377,7 @@ uchar Universe::applyRelative(int channel, uchar value)
     return value;
 }
 
-uchar Universe::applyGM(int channel, uchar value)
+uchar Universe::applyGM(int channel, uchar value) const
 {
     if ((m_grandMaster->channelMode() == GrandMaster::Intensity && m_channelsMask->at(channel) & Intensity) ||
         (m_grandMaster->channelMode() == GrandMaster::AllChannels))
@@ -347,7 +391,7 @@ uchar Universe::applyGM(int channel, uchar value)
     return value;
 }
 
-uchar Universe::applyModifiers(int channel, uchar value)
+uchar Universe::applyModifiers(int channel, uchar value) const
 {
     if (m_modifiers.at(channel) != NULL)
         return m_modifiers.at(channel)->getValue(value);
@@ -355,7 +399,7 @@ uchar Universe::applyModifiers(int channel, uchar value)
     return value;
 }
 
-uchar Universe::applyPassthrough(int channel, uchar value)
+uchar Universe::applyPassthrough(int channel, uchar value) const
 {
     if (m_passthrough)
     {
@@ -369,7 +413,7 @@ uchar Universe::applyPassthrough(int channel, uchar value)
     return value;
 }
 
-void Universe::updatePostGMValue(int channel)
+uchar Universe::calculatePostGMValue(int channel) const
 {
     uchar value = preGMValue(channel);
 
@@ -387,7 +431,20 @@ void Universe::updatePostGMValue(int channel)
 
     value = applyPassthrough(channel, value);
 
-    (*m_postGMValues)[channel] = static_cast<char>(value);
+    return value;
+}
+
+void Universe::updatePostGMValue(int channel)
+{
+    (*m_postGMValues)[channel] = static_cast<char>(calculatePostGMValue(channel));
+}
+
+void Universe::requestPostGMUpdate(int channel)
+{
+    if (m_batchMode)
+        markDirty(channel, 1);
+    else
+        updatePostGMValue(channel);
 }
 
 /************************************************************************
@@ -525,7 +582,7 @@ OutputPatch *Universe::feedbackPatch() const
     return m_fbPatch;
 }
 
-void Universe::dumpOutput(const QByteArray &data)
+void Universe::dumpOutput(const QByteArray &data, bool dataChanged)
 {
     if (m_outputPatchList.count() == 0)
         return;
@@ -536,9 +593,9 @@ void Universe::dumpOutput(const QByteArray &data)
             op->setPluginParameter(PLUGIN_UNIVERSECHANNELS, m_totalChannels);
 
         if (op->blackout())
-            op->dump(m_id, *m_modifiedZeroValues);
+            op->dump(m_id, *m_modifiedZeroValues, dataChanged);
         else
-            op->dump(m_id, data);
+            op->dump(m_id, data, dataChanged);
     }
     m_totalChannelsChanged = false;
 }
@@ -685,6 +742,11 @@ void Universe::setChannelModifier(ushort channel, ChannelModifier *modifier)
 
     m_modifiers[channel] = modifier;
 
+    if (modifier == NULL)
+        Utils::vectorRemove(m_modifiedChannels, channel);
+    else
+        Utils::vectorSortedAddUnique(m_modifiedChannels, channel);
+
     (*m_modifiedZeroValues)[channel] =
         (modifier == NULL ? uchar(0) : modifier->getValue(0));
 
@@ -740,6 +802,218 @@ void Universe::updateIntensityChannelsRanges()
     qDebug() << Q_FUNC_INFO << ":" << m_intensityChannelsRanges.size() << "ranges";
 }
 
+/****************************************************************************
+ * Batch processing
+ ****************************************************************************/
+
+/*
+ * The following kernels process a whole range of channels at once.
+ * When available, SSE2 (16 channels) or AVX2 (32 channels) instructions
+ * are used, then the remaining channels are processed one by one.
+ * All the paths produce the very same result as the per-channel
+ * Universe::calculatePostGMValue().
+ */
+
+/** Same as floor(value * (gm / 255.0) + 0.5), using integer math only */
+static inline uchar gmReduceValue(uchar value, uint gm)
+{
+    uint t = uint(value) * gm + 128;
+    return uchar((t + (t >> 8)) >> 8);
+}
+
+#if defined(__AVX2__)
+static inline __m256i intensityMask256(const uchar *caps)
+{
+    const __m256i intensity = _mm256_set1_epi8(char(Universe::Intensity));
+    __m256i mask = _mm256_loadu_si256((const __m256i *)caps);
+    return _mm256_cmpeq_epi8(_mm256_and_si256(mask, intensity), intensity);
+}
+
+static inline __m256i gmReduce256(__m256i values, __m256i gm)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi16(128);
+    __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(values, zero), gm), round);
+    __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(values, zero), gm), round);
+    lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+    hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+    return _mm256_packus_epi16(lo, hi);
+}
+#elif defined(__SSE2__)
+static inline __m128i intensityMask128(const uchar *caps)
+{
+    const __m128i intensity = _mm_set1_epi8(char(Universe::Intensity));
+    __m128i mask = _mm_loadu_si128((const __m128i *)caps);
+    return _mm_cmpeq_epi8(_mm_and_si128(mask, intensity), intensity);
+}
+
+static inline __m128i gmReduce128(__m128i values, __m128i gm)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(128);
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(values, zero), gm), round);
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(values, zero), gm), round);
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+    return _mm_packus_epi16(lo, hi);
+}
+
+static inline __m128i select128(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+/**
+ * Apply the Grand Master to $count $values. If $caps is not NULL,
+ * only the channels with the Intensity capability are affected.
+ */
+static void applyGMRange(uchar *values, const uchar *caps, int count,
+                         GrandMaster::ValueMode mode, uchar gm)
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    const __m256i gm8 = _mm256_set1_epi8(char(gm));
+    const __m256i gm16 = _mm256_set1_epi16(gm);
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(values + i));
+        __m256i r = (mode == GrandMaster::Limit) ? _mm256_min_epu8(v, gm8) : gmReduce256(v, gm16);
+        if (caps != NULL)
+            r = _mm256_blendv_epi8(v, r, intensityMask256(caps + i));
+        _mm256_storeu_si256((__m256i *)(values + i), r);
+    }
+#elif defined(__SSE2__)
+    const __m128i gm8 = _mm_set1_epi8(char(gm));
+    const __m128i gm16 = _mm_set1_epi16(gm);
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+        __m128i r = (mode == GrandMaster::Limit) ? _mm_min_epu8(v, gm8) : gmReduce128(v, gm16);
+        if (caps != NULL)
+            r = select128(intensityMask128(caps + i), r, v);
+        _mm_storeu_si128((__m128i *)(values + i), r);
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        if (caps != NULL && (caps[i] & Universe::Intensity) == 0)
+            continue;
+
+        if (mode == GrandMaster::Limit)
+            values[i] = MIN(values[i], gm);
+        else
+            values[i] = gmReduceValue(values[i], gm);
+    }
+}
+
+/** HTP merge $count $other values into $values */
+static void mergeHTPRange(uchar *values, const uchar *other, int count)
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    for (; i + 32 <= count; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(values + i));
+        __m256i o = _mm256_loadu_si256((const __m256i *)(other + i));
+        _mm256_storeu_si256((__m256i *)(values + i), _mm256_max_epu8(v, o));
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+        __m128i o = _mm_loadu_si128((const __m128i *)(other + i));
+        _mm_storeu_si128((__m128i *)(values + i), _mm_max_epu8(v, o));
+    }
+#endif
+
+    for (; i < count; i++)
+        values[i] = MAX(values[i], other[i]);
+}
+
+void Universe::startBatch()
+{
+    m_batchMode = true;
+}
+
+void Universe::commitBatch()
+{
+    m_batchMode = false;
+
+    if (m_dirtyMax < m_dirtyMin)
+        return;
+
+    const int start = m_dirtyMin;
+    const int count = m_dirtyMax - m_dirtyMin + 1;
+    uchar *values = reinterpret_cast<uchar *>(m_postGMValues->data()) + start;
+
+    m_dirtyMin = UNIVERSE_SIZE;
+    m_dirtyMax = -1;
+
+    memcpy(values, m_preGMValues->constData() + start, count);
+
+    // Relative values
+    if (m_hasRelativeValues)
+    {
+        const short *relative = m_relativeValues.constData() + start;
+        for (int i = 0; i < count; i++)
+        {
+            if (relative[i] != 0)
+            {
+                int val = relative[i] + values[i];
+                values[i] = CLAMP(val, 0, (int)UCHAR_MAX);
+            }
+        }
+    }
+
+    // Grand Master. Read its parameters just once for the whole range
+    const uchar gm = m_grandMaster->value();
+    if (gm != UCHAR_MAX)
+    {
+        const uchar *caps = NULL;
+        if (m_grandMaster->channelMode() == GrandMaster::Intensity)
+            caps = reinterpret_cast<const uchar *>(m_channelsMask->constData()) + start;
+
+        applyGMRange(values, caps, count, m_grandMaster->valueMode(), gm);
+    }
+
+    // Channel modifiers. A value of zero gives the modified zero value
+    // as in calculatePostGMValue(), since Grand Master never changes zero
+    for (int i = 0; i < m_modifiedChannels.count(); i++)
+    {
+        int channel = m_modifiedChannels.at(i);
+        if (channel < start)
+            continue;
+        if (channel >= start + count)
+            break;
+
+        values[channel - start] = m_modifiers.at(channel)->getValue(values[channel - start]);
+    }
+
+    // Passthrough HTP merge
+    if (m_passthrough)
+    {
+        const uchar *passthrough = reinterpret_cast<const uchar *>(m_passthroughValues->constData()) + start;
+        mergeHTPRange(values, passthrough, count);
+    }
+}
+
+bool Universe::isBatchMode() const
+{
+    return m_batchMode;
+}
+
+void Universe::markDirty(int address, int range)
+{
+    if (address < m_dirtyMin)
+        m_dirtyMin = address;
+    if (address + range - 1 > m_dirtyMax)
+        m_dirtyMax = address + range - 1;
+}
+
 /****************************************************************************
  * Writing
  ****************************************************************************/
@@ -761,7 +1035,7 @@ bool Universe::write(int channel, uchar value, bool forceLTP)
 
     (*m_preGMValues)[channel] = char(value);
 
-    updatePostGMValue(channel);
+    requestPostGMUpdate(channel);
 
     return true;
 }
@@ -777,8 +1051,9 @@ bool Universe::writeRelative(int channel, uchar value)
         return true;
 
     m_relativeValues[channel] += value - RELATIVE_ZERO;
+    m_hasRelativeValues = true;
 
-    updatePostGMValue(channel);
+    requestPostGMUpdate(channel);
 
     return true;
 }
@@ -829,11 +1104,44 @@ bool Universe::writeBlended(int channel, uchar value, Universe::BlendMode blend)
         break;
     }
 
-    updatePostGMValue(channel);
+    requestPostGMUpdate(channel);
 
     return true;
 }
 
+void Universe::writeRange(int channel, const uchar *values, int count)
+{
+    Q_ASSERT(channel >= 0 && channel + count <= UNIVERSE_SIZE);
+
+    if (count <= 0)
+        return;
+
+    if (channel + count > m_usedChannels)
+        m_usedChannels = channel + count;
+
+    uchar *pre = reinterpret_cast<uchar *>(m_preGMValues->data()) + channel;
+    const uchar *mask = reinterpret_cast<const uchar *>(m_channelsMask->constData()) + channel;
+
+    // LTP channels take the new value, HTP channels keep the highest one.
+    // No branches on the channel type, so that the loop can be vectorized
+    for (int i = 0; i < count; i++)
+    {
+        uchar htp = uchar(0) - uchar((mask[i] & HTP) != 0);
+        uchar keep = htp & uchar(0 - uchar(pre[i] > values[i]));
+        pre[i] = (pre[i] & keep) | (values[i] & ~keep);
+    }
+
+    if (m_batchMode)
+    {
+        markDirty(channel, count);
+    }
+    else
+    {
+        for (int i = 0; i < count; i++)
+            updatePostGMValue(channel + i);
+    }
+}
+
 /*********************************************************************
  * Load & Save
  *********************************************************************/
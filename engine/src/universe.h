@@ -121,10 +121,25 @@ public:
     ushort totalChannels();
 
     /**
-     * Returns if the universe has changed since the last MasterTimer tick
+     * Returns if the universe has changed since the last MasterTimer tick.
+     * When it has, the post GM snapshot is refreshed and the generation
+     * counter is incremented.
      */
     bool hasChanged();
 
+    /**
+     * Returns the post GM values as of the last hasChanged() call,
+     * usedChannels() long. The array is implicitly shared, so listeners
+     * can keep a copy of it without a deep copy being made every tick.
+     */
+    const QByteArray& postGMSnapshot() const;
+
+    /**
+     * Returns a counter incremented every time hasChanged() detects
+     * a change in the post GM values
+     */
+    quint32 generation() const;
+
     /**
      * Enable or disable the passthrough mode for this universe
      */
@@ -145,7 +160,7 @@ public:
      */
     bool monitor() const;
 
-    uchar applyPassthrough(int channel, uchar value);
+    uchar applyPassthrough(int channel, uchar value) const;
 
 protected slots:
     /**
@@ -162,12 +177,21 @@ protected:
      *
      * @return Value filtered through grand master (if applicable)
      */
-    uchar applyGM(int channel, uchar value);
+    uchar applyGM(int channel, uchar value) const;
+
+    uchar applyRelative(int channel, uchar value) const;
+    uchar applyModifiers(int channel, uchar value) const;
 
-    uchar applyRelative(int channel, uchar value);
-    uchar applyModifiers(int channel, uchar value);
+    /** Calculate the post-GM value of $channel out of its pre-GM value */
+    uchar calculatePostGMValue(int channel) const;
+
+    /** Update the post-GM value of $channel right away */
     void updatePostGMValue(int channel);
 
+    /** Update the post-GM value of $channel, or defer it to
+     *  commitBatch() when the universe is in batch mode */
+    void requestPostGMUpdate(int channel);
+
 signals:
     void nameChanged();
     void passthroughChanged();
@@ -224,9 +248,11 @@ public:
     OutputPatch* feedbackPatch() const;
 
     /**
-     * This is the actual function that writes data to an output patch
+     * This is the actual function that writes data to an output patch.
+     * When $dataChanged is false, patches may skip the write until
+     * their refresh interval expires.
      */
-    void dumpOutput(const QByteArray& data);
+    void dumpOutput(const QByteArray& data, bool dataChanged = true);
 
     /**
      * @brief dumpBlackout
@@ -308,6 +334,9 @@ protected:
     /** Vector of pointer to ChannelModifier classes. If not NULL, they will modify
      *  a DMX value right before HTP/LTP check and before being assigned to preGM */
     QVector<ChannelModifier*> m_modifiers;
+    /** Sorted list of the channels with a modifier, to skip
+     *  the others when processing a batch */
+    QVector<int> m_modifiedChannels;
     /** Modified channels with the non-modified value at 0.
      *  This is used for ranged initialization operations. */
     QScopedPointer<QByteArray> m_modifiedZeroValues;
@@ -414,17 +443,55 @@ protected:
     QScopedPointer<QByteArray> m_preGMValues;
     /** Array of values AFTER the Grand Master changes (applyGM) */
     QScopedPointer<QByteArray> m_postGMValues;
-    /** Array of the last preGM values written before the zeroIntensityChannels call  */
+    /** Snapshot of the postGM values, taken by hasChanged() */
     QScopedPointer<QByteArray> m_lastPostGMValues;
+    /** Number of changes detected by hasChanged() */
+    quint32 m_generation;
 
     /** Array of values from input line, when passtrhough is enabled */
     QScopedPointer<QByteArray> m_passthroughValues;
 
     QVector<short> m_relativeValues;
+    /** Flag set when at least one relative value might be non zero */
+    bool m_hasRelativeValues;
 
     /* impl speedup */
     void updateIntensityChannelsRanges();
 
+    /************************************************************************
+     * Batch processing
+     ************************************************************************/
+public:
+    /**
+     * Enter batch mode. Until commitBatch() is called, write operations
+     * only update the pre-GM values and extend the universe dirty range.
+     * This is used by MasterTimer to compute the post-GM values of a
+     * whole tick in a single pass instead of once per written channel.
+     */
+    void startBatch();
+
+    /**
+     * Compute the post-GM values of the dirty range (relative values,
+     * Grand Master, channel modifiers and passthrough merge) and leave
+     * batch mode.
+     */
+    void commitBatch();
+
+    /** Return true if the universe is in batch mode */
+    bool isBatchMode() const;
+
+protected:
+    /** Add the channels from $address to $address + $range to the dirty range */
+    void markDirty(int address, int range);
+
+protected:
+    /** Flag set between startBatch() and commitBatch() */
+    bool m_batchMode;
+    /** The lowest channel whose post-GM value needs to be calculated */
+    int m_dirtyMin;
+    /** The highest channel whose post-GM value needs to be calculated */
+    int m_dirtyMax;
+
     /************************************************************************
      * Blend mode
      ************************************************************************/
@@ -481,6 +548,17 @@ public:
      */
     bool writeBlended(int channel, uchar value, BlendMode blend = NormalBlend);
 
+    /**
+     * Write $count consecutive DMX values starting at $channel, like
+     * write() would do for each of them: HTP channels keep the highest
+     * value, the others take the new one.
+     *
+     * @param channel The first channel to write to
+     * @param values The values to write
+     * @param count The number of channels to write
+     */
+    void writeRange(int channel, const uchar *values, int count);
+
     /*********************************************************************
      * Load & Save
      *********************************************************************/
@@ -0,0 +1,26 @@
+include(../../../variables.pri)
+include(../../../coverage.pri)
+TEMPLATE = app
+LANGUAGE = C++
+TARGET   = audiocapture_test
+
+QT      += testlib
+CONFIG  -= app_bundle
+
+DEPENDPATH   += ../../src
+INCLUDEPATH  += ../../../plugins/interfaces
+INCLUDEPATH  += ../../src ../../audio/src
+QMAKE_LIBDIR += ../../src
+LIBS         += -lqlcplusengine
+
+!android:!ios {
+  CONFIG += link_pkgconfig
+  system(pkg-config --exists fftw3) {
+    DEFINES += HAS_FFTW3
+    PKGCONFIG += fftw3
+    macx:LIBS += -lfftw3
+  }
+}
+
+SOURCES += audiocapture_test.cpp
+HEADERS += audiocapture_test.h
@@ -0,0 +1,285 @@
+/*
+  Q Light Controller Plus - Unit test
+  audiocapture_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QtTest>
+#include <qmath.h>
+
+#ifdef HAS_FFTW3
+#include "fftw3.h"
+#endif
+
+#include "audiocapture_test.h"
+
+#define private public
+#define protected public
+#include "audiocapture.h"
+#undef protected
+#undef private
+
+/** An audio capture with no device, fed by the test */
+class AudioCaptureStub : public AudioCapture
+{
+public:
+    AudioCaptureStub() : AudioCapture() { }
+    ~AudioCaptureStub() { }
+
+    bool initialize() { return true; }
+    void uninitialize() { }
+    qint64 latency() { return 0; }
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    void setVolume(qreal volume) { Q_UNUSED(volume) }
+#endif
+    void suspend() { }
+    void resume() { }
+    bool readAudio(int maxSize) { Q_UNUSED(maxSize) return true; }
+};
+
+/** Fill the capture buffer with a sine wave peaking on spectrum $bin */
+static void fillSine(AudioCapture& capture, int bin, int amplitude)
+{
+    for (unsigned int i = 0; i < capture.m_captureSize; i++)
+        capture.m_audioBuffer[i] = int16_t(amplitude * qSin((2 * M_PI * bin * i) / capture.m_captureSize));
+}
+
+/** Register $number bands without starting the capture thread */
+static void addBands(AudioCapture& capture, int number)
+{
+    BandsData bands;
+    bands.m_registerCounter = 1;
+    bands.m_fftMagnitudeBuffer = QVector<double>(number);
+    capture.m_fftMagnitudeMap[number] = bands;
+}
+
+void AudioCapture_Test::setupSpectrum()
+{
+    AudioCaptureStub capture;
+    capture.m_sampleRate = 44100;
+    int size = capture.m_captureSize;
+
+    QVERIFY(capture.m_fftPlan == NULL);
+    QCOMPARE(capture.m_spectrumSize, uint(0));
+
+    capture.setupSpectrum();
+    QCOMPARE(capture.m_spectrumSize, uint(size));
+    QCOMPARE(capture.m_spectrumRate, uint(44100));
+    QCOMPARE(capture.m_fftMagnitude.size(), (size * SPECTRUM_MAX_FREQUENCY) / 44100);
+
+    // a Hanning window, computed once
+    QCOMPARE(capture.m_windowTable.size(), size);
+    QCOMPARE(capture.m_windowTable.first(), 0.0);
+    for (int i = 0; i < size; i += 100)
+    {
+        double value = 0.5 * (1.0 - qCos((2 * M_PI * i) / (size - 1)));
+        QVERIFY(qAbs(capture.m_windowTable.at(i) - value) < 1e-6);
+    }
+
+#ifdef HAS_FFTW3
+    void *plan = capture.m_fftPlan;
+    QVERIFY(plan != NULL);
+#endif
+
+    // a new sample rate resizes the spectrum only
+    capture.m_sampleRate = 22050;
+    capture.setupSpectrum();
+    QCOMPARE(capture.m_fftMagnitude.size(), (size * SPECTRUM_MAX_FREQUENCY) / 22050);
+#ifdef HAS_FFTW3
+    QCOMPARE(capture.m_fftPlan, plan);
+#endif
+}
+
+void AudioCapture_Test::linearBands()
+{
+    AudioCaptureStub capture;
+    capture.m_sampleRate = 44100;
+    capture.setupSpectrum();
+    QVERIFY(capture.logarithmicBands() == false);
+
+    int bins = capture.m_fftMagnitude.size();
+    QVector<int> edges = capture.bandsEdges(16);
+    QCOMPARE(edges.size(), 17);
+    for (int b = 0; b <= 16; b++)
+        QCOMPARE(edges.at(b), b * (bins / 16));
+
+    // more bands than bins: the bands are empty
+    edges = capture.bandsEdges(bins + 1);
+    QCOMPARE(edges.last(), 0);
+
+    BandsData bands;
+    bands.m_fftMagnitudeBuffer = QVector<double>(bins + 1);
+    capture.m_fftMagnitude.fill(1.0);
+    QCOMPARE(capture.fillBandsData(bands), 0.0);
+    QCOMPARE(bands.m_bandsEdges, edges);
+}
+
+void AudioCapture_Test::logarithmicBands()
+{
+    AudioCaptureStub capture;
+    capture.m_sampleRate = 44100;
+    capture.setupSpectrum();
+
+    capture.setLogarithmicBands(true);
+    QVERIFY(capture.logarithmicBands() == true);
+
+    // the bands start past the noise bins, and they span at least one bin
+    int bins = capture.m_fftMagnitude.size();
+    QVector<int> edges = capture.bandsEdges(16);
+    QCOMPARE(edges.size(), 17);
+    QCOMPARE(edges.first(), 5);
+    QCOMPARE(edges.last(), bins);
+    for (int b = 0; b < 16; b++)
+        QVERIFY(edges.at(b + 1) > edges.at(b));
+    QVERIFY(edges.at(16) - edges.at(15) > edges.at(1) - edges.at(0));
+
+    // changing the scale computes the edges again
+    addBands(capture, 16);
+    capture.m_fftMagnitudeMap[16].m_bandsEdges = edges;
+    capture.setLogarithmicBands(false);
+    QVERIFY(capture.m_fftMagnitudeMap[16].m_bandsEdges.isEmpty());
+
+    // as does a new sample rate
+    capture.m_fftMagnitudeMap[16].m_bandsEdges = edges;
+    capture.m_sampleRate = 48000;
+    capture.setupSpectrum();
+    QVERIFY(capture.m_fftMagnitudeMap[16].m_bandsEdges.isEmpty());
+}
+
+void AudioCapture_Test::spectrum()
+{
+#ifndef HAS_FFTW3
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+    QSKIP("FFTW is not available", SkipAll);
+#else
+    QSKIP("FFTW is not available");
+#endif
+#else
+    AudioCaptureStub capture;
+    capture.m_sampleRate = 44100;
+    addBands(capture, 8);
+    addBands(capture, 16);
+
+    fillSine(capture, 50, 10000);
+    capture.processData();
+    QCOMPARE(capture.m_spectrumSize, capture.m_captureSize);
+
+    // the average of a rectified sine is 2/pi of its amplitude
+    QVERIFY(capture.m_signalPower > 6300 && capture.m_signalPower < 6430);
+
+    // the spectrum peaks on the sine bin
+    int peak = 0;
+    for (int i = 0; i < capture.m_fftMagnitude.size(); i++)
+    {
+        if (capture.m_fftMagnitude.at(i) > capture.m_fftMagnitude.at(peak))
+            peak = i;
+    }
+    QCOMPARE(peak, 50);
+
+    // and so does the band holding it, for any number of bands
+    foreach (int number, capture.m_fftMagnitudeMap.keys())
+    {
+        const BandsData &bands = capture.m_fftMagnitudeMap[number];
+        QCOMPARE(bands.m_bandsEdges.size(), number + 1);
+
+        int band = 50 / bands.m_bandsEdges.at(1);
+        for (int b = 0; b < number; b++)
+        {
+            double sum = 0;
+            for (int i = bands.m_bandsEdges.at(b); i < bands.m_bandsEdges.at(b + 1); i++)
+                sum += capture.m_fftMagnitude.at(i);
+            QCOMPARE(bands.m_fftMagnitudeBuffer.at(b), sum / bands.m_bandsEdges.at(1));
+
+            if (b != band)
+                QVERIFY(bands.m_fftMagnitudeBuffer.at(b) < bands.m_fftMagnitudeBuffer.at(band));
+        }
+    }
+
+    // the plan is kept for the next buffers
+    void *plan = capture.m_fftPlan;
+    capture.processData();
+    QCOMPARE(capture.m_fftPlan, plan);
+#endif
+}
+
+#ifdef HAS_FFTW3
+/** The spectrum analysis as it was: a plan and a window for each buffer,
+ *  and the bins magnitude for each number of bands */
+static void processDataPerBuffer(AudioCapture& capture)
+{
+    unsigned int size = capture.m_captureSize;
+    fftw_complex *output = (fftw_complex*)capture.m_fftOutputBuffer;
+    fftw_plan plan = fftw_plan_dft_r2c_1d(size, capture.m_fftInputBuffer, output, 0);
+
+    for (unsigned int i = 0; i < size; i++)
+        capture.m_fftInputBuffer[i] = capture.m_audioBuffer[i] * (0.5 * (1.00 - qCos((2 * M_PI * i) / (size - 1))));
+
+    fftw_execute(plan);
+    fftw_destroy_plan(plan);
+
+    foreach (int number, capture.m_fftMagnitudeMap.keys())
+    {
+        unsigned int i = 0;
+        int subBandWidth = ((size * SPECTRUM_MAX_FREQUENCY) / capture.m_sampleRate) / number;
+        for (int b = 0; b < number; b++)
+        {
+            quint64 magnitudeSum = 0;
+            for (int s = 0; s < subBandWidth; s++, i++)
+                magnitudeSum += qSqrt((output[i][0] * output[i][0]) + (output[i][1] * output[i][1]));
+            capture.m_fftMagnitudeMap[number].m_fftMagnitudeBuffer[b] = magnitudeSum / subBandWidth;
+        }
+    }
+}
+#endif
+
+void AudioCapture_Test::processDataEfficiency_data()
+{
+    QTest::addColumn<bool>("cached");
+
+    QTest::newRow("Per buffer plan") << false;
+    QTest::newRow("Cached plan") << true;
+}
+
+void AudioCapture_Test::processDataEfficiency()
+{
+#ifndef HAS_FFTW3
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+    QSKIP("FFTW is not available", SkipAll);
+#else
+    QSKIP("FFTW is not available");
+#endif
+#else
+    QFETCH(bool, cached);
+
+    // a few audio triggers and matrices with different numbers of bands
+    AudioCaptureStub capture;
+    capture.m_sampleRate = 44100;
+    addBands(capture, 8);
+    addBands(capture, 16);
+    addBands(capture, 32);
+    fillSine(capture, 50, 10000);
+
+    QBENCHMARK
+    {
+        if (cached)
+            capture.processData();
+        else
+            processDataPerBuffer(capture);
+    }
+#endif
+}
+
+QTEST_MAIN(AudioCapture_Test)
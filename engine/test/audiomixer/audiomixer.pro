@@ -0,0 +1,21 @@
+include(../../../variables.pri)
+include(../../../coverage.pri)
+TEMPLATE = app
+LANGUAGE = C++
+TARGET   = audiomixer_test
+
+QT      += testlib
+CONFIG  -= app_bundle
+
+DEPENDPATH   += ../../src
+INCLUDEPATH  += ../../../plugins/interfaces
+INCLUDEPATH  += ../../src ../../audio/src
+QMAKE_LIBDIR += ../../src
+LIBS         += -lqlcplusengine
+
+# The null renderer is not part of the engine
+SOURCES += ../../audio/src/audiorenderer_null.cpp
+HEADERS += ../../audio/src/audiorenderer_null.h
+
+SOURCES += audiomixer_test.cpp
+HEADERS += audiomixer_test.h
@@ -0,0 +1,420 @@
+/*
+  Q Light Controller Plus - Unit test
+  audiomixer_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QtTest>
+
+#include "audiomixer_test.h"
+#include "audiorenderer_null.h"
+
+#define private public
+#define protected public
+#include "audiomixer.h"
+#undef protected
+#undef private
+
+/** Number of frames mixed at each read */
+#define BLOCK_FRAMES 1024
+
+/** A decoder of $frames frames, all the samples set to $value */
+class AudioDecoderStub : public AudioDecoder
+{
+public:
+    AudioDecoderStub(qint64 frames, qint16 value, int channels = 2, quint32 rate = 44100)
+        : m_frames(frames)
+        , m_value(value)
+        , m_position(0)
+    {
+        configure(rate, channels, PCM_S16LE);
+    }
+
+    AudioDecoder *createCopy() { return NULL; }
+    int priority() const { return 0; }
+    QStringList supportedFormats() { return QStringList(); }
+    bool initialize(const QString &path) { Q_UNUSED(path) return true; }
+    qint64 totalTime() { return m_frames * 1000 / audioParameters().sampleRate(); }
+    void seek(qint64 time) { m_position = time * audioParameters().sampleRate() / 1000; }
+    int bitrate() { return 0; }
+
+    qint64 read(char *data, qint64 maxSize)
+    {
+        int channels = audioParameters().channels();
+        qint64 frames = qMin(maxSize / (channels * 2), m_frames - m_position);
+        qint16 *samples = (qint16 *)data;
+        for (qint64 i = 0; i < frames * channels; i++)
+            samples[i] = m_value;
+        m_position += frames;
+        return frames * channels * 2;
+    }
+
+    qint64 m_frames;
+    qint16 m_value;
+    qint64 m_position;
+};
+
+/** A renderer that doesn't read the mix, so that the tests do */
+class AudioRendererIdle : public AudioRendererNull
+{
+public:
+    void run() { }
+};
+
+class AudioMixerStub : public AudioMixer
+{
+public:
+    AudioMixerStub(bool render) : m_render(render) { }
+
+protected:
+    AudioRenderer *createRenderer()
+    {
+        if (m_render)
+            return new AudioRendererNull();
+        return new AudioRendererIdle();
+    }
+
+private:
+    bool m_render;
+};
+
+/** Mix one block of $mixer, like its renderer does */
+static QVector<qint16> mixBlock(AudioMixer& mixer, qint64 *bytes = NULL)
+{
+    QVector<qint16> block(BLOCK_FRAMES * 2);
+    qint64 read = mixer.read((char *)block.data(), BLOCK_FRAMES * 4);
+    if (bytes != NULL)
+        *bytes = read;
+    block.resize(read / 2);
+    return block;
+}
+
+void AudioMixer_Test::canMix()
+{
+    AudioMixerStub mixer(false);
+    QVERIFY(mixer.canMix(AudioParameters(44100, 2, PCM_S16LE)) == true);
+    QVERIFY(mixer.canMix(AudioParameters(48000, 1, PCM_S16LE)) == true);
+    QVERIFY(mixer.canMix(AudioParameters(44100, 2, PCM_S8)) == false);
+    QVERIFY(mixer.canMix(AudioParameters(44100, 2, PCM_S24LE)) == false);
+    QVERIFY(mixer.canMix(AudioParameters(44100, 6, PCM_S16LE)) == false);
+    QVERIFY(mixer.addSource(NULL, 0, 1.0, 0, false) == false);
+    QVERIFY(mixer.m_renderer == NULL);
+
+    AudioDecoderStub dec(44100, 1000, 2, 48000);
+    QVERIFY(mixer.addSource(&dec, 0, 1.0, 0, false) == true);
+    QVERIFY(mixer.m_renderer != NULL);
+    QCOMPARE(mixer.sourcesCount(), 1);
+    QCOMPARE(mixer.audioParameters().sampleRate(), quint32(48000));
+    QCOMPARE(mixer.audioParameters().channels(), 2);
+
+    // the output rate is set by the first source
+    QVERIFY(mixer.canMix(AudioParameters(48000, 1, PCM_S16LE)) == true);
+    QVERIFY(mixer.canMix(AudioParameters(44100, 2, PCM_S16LE)) == false);
+    AudioDecoderStub other(44100, 1000, 2, 44100);
+    QVERIFY(mixer.addSource(&other, 0, 1.0, 0, false) == false);
+    QCOMPARE(mixer.sourcesCount(), 1);
+
+    // a source added again is mixed once
+    QVERIFY(mixer.addSource(&dec, 0, 1.0, 0, false) == true);
+    QCOMPARE(mixer.sourcesCount(), 1);
+
+    mixer.removeSource(&dec);
+    QCOMPARE(mixer.sourcesCount(), 0);
+    mixer.removeSource(&dec);
+    QCOMPARE(mixer.sourcesCount(), 0);
+}
+
+void AudioMixer_Test::mix()
+{
+    AudioMixerStub mixer(false);
+    AudioDecoderStub a(44100, 1000);
+    AudioDecoderStub b(44100, 2000);
+    AudioDecoderStub c(44100, 300, 1);
+
+    mixer.addSource(&a, 0, 1.0, 0, false);
+    mixer.addSource(&b, 0, 0.5, 0, false);
+    mixer.addSource(&c, 0, 1.0, 0, false);
+
+    // mono sources play on both channels
+    QVector<qint16> block = mixBlock(mixer);
+    QCOMPARE(block.size(), BLOCK_FRAMES * 2);
+    for (int i = 0; i < block.size(); i++)
+        QCOMPARE(block.at(i), qint16(2300));
+
+    QCOMPARE(a.m_position, qint64(BLOCK_FRAMES));
+    QCOMPARE(b.m_position, qint64(BLOCK_FRAMES));
+    QCOMPARE(c.m_position, qint64(BLOCK_FRAMES));
+    QCOMPARE(mixer.m_position, qint64(BLOCK_FRAMES));
+}
+
+void AudioMixer_Test::clipping()
+{
+    AudioMixerStub mixer(false);
+    AudioDecoderStub a(44100, 30000);
+    AudioDecoderStub b(44100, 30000);
+    mixer.addSource(&a, 0, 1.0, 0, false);
+    mixer.addSource(&b, 0, 1.0, 0, false);
+
+    QVector<qint16> block = mixBlock(mixer);
+    for (int i = 0; i < block.size(); i++)
+        QCOMPARE(block.at(i), qint16(32767));
+
+    a.m_value = -30000;
+    b.m_value = -30000;
+    block = mixBlock(mixer);
+    for (int i = 0; i < block.size(); i++)
+        QCOMPARE(block.at(i), qint16(-32768));
+}
+
+void AudioMixer_Test::startTime()
+{
+    AudioMixerStub mixer(false);
+    AudioDecoderStub a(44100, 1000);
+    AudioDecoderStub b(44100, 1000);
+    AudioDecoderStub c(44100, 1000);
+
+    mixer.addSource(&a, 100, 1.0, 0, false);
+    QCOMPARE(mixer.m_sources.at(0).m_startFrame, qint64(0));
+    mixBlock(mixer);
+    QCOMPARE(a.m_position, qint64(BLOCK_FRAMES));
+
+    // a later tick starts at the next block
+    mixer.addSource(&b, 120, 1.0, 0, false);
+    QCOMPARE(mixer.m_sources.at(1).m_startFrame, qint64(BLOCK_FRAMES));
+    mixBlock(mixer);
+    QCOMPARE(b.m_position, qint64(BLOCK_FRAMES));
+
+    // the same tick, after a block was mixed: the source drops the
+    // frames it missed and stays aligned with the other one
+    mixer.addSource(&c, 120, 1.0, 0, false);
+    QCOMPARE(mixer.m_sources.at(2).m_startFrame, qint64(BLOCK_FRAMES));
+    QVector<qint16> block = mixBlock(mixer);
+    QCOMPARE(c.m_position, b.m_position);
+    QCOMPARE(block.at(0), qint16(3000));
+    QCOMPARE(mixer.m_sources.at(2).m_startFrame, qint64(BLOCK_FRAMES * 2));
+}
+
+void AudioMixer_Test::fadeIn()
+{
+    AudioMixerStub mixer(false);
+    AudioDecoderStub a(44100, 10000);
+
+    // 10ms are 441 frames
+    mixer.addSource(&a, 0, 1.0, 10, false);
+    QCOMPARE(mixer.m_sources.at(0).m_rampFrames, qint64(441));
+
+    QVector<qint16> block = mixBlock(mixer);
+    QCOMPARE(block.at(0), qint16(0));
+    for (int f = 1; f < 441; f++)
+    {
+        QVERIFY(block.at(f * 2) >= block.at((f - 1) * 2));
+        QCOMPARE(block.at(f * 2 + 1), block.at(f * 2));
+    }
+    QVERIFY(qAbs(block.at(220 * 2) - 4989) <= 2);
+    QVERIFY(block.at(440 * 2) < 10000);
+
+    for (int f = 441; f < BLOCK_FRAMES; f++)
+        QCOMPARE(block.at(f * 2), qint16(10000));
+    QCOMPARE(mixer.m_sources.at(0).m_rampFrames, qint64(0));
+    QCOMPARE(mixer.m_sources.at(0).m_gain, 1.0f);
+}
+
+void AudioMixer_Test::fadeOut()
+{
+    AudioMixerStub mixer(false);
+    AudioDecoderStub a(44100, 10000);
+    mixer.addSource(&a, 0, 1.0, 0, false);
+    mixBlock(mixer);
+
+    // the first fade out only is done
+    mixer.setSourceFadeOut(&a, 10);
+    mixer.setSourceFadeOut(&a, 1000);
+    QCOMPARE(mixer.m_sources.at(0).m_rampFrames, qint64(441));
+
+    QVector<qint16> block = mixBlock(mixer);
+    QCOMPARE(block.at(0), qint16(10000));
+    for (int f = 1; f < 441; f++)
+        QVERIFY(block.at(f * 2) <= block.at((f - 1) * 2));
+    for (int f = 441; f < BLOCK_FRAMES; f++)
+        QCOMPARE(block.at(f * 2), qint16(0));
+
+    // intensity changes don't bring it back
+    mixer.setSourceIntensity(&a, 0.5);
+    block = mixBlock(mixer);
+    QCOMPARE(block.at(0), qint16(0));
+
+    // the source plays silently until its end
+    QCOMPARE(mixer.sourcesCount(), 1);
+    QCOMPARE(a.m_position, qint64(BLOCK_FRAMES * 3));
+}
+
+void AudioMixer_Test::intensity()
+{
+    AudioMixerStub mixer(false);
+    AudioDecoderStub a(44100, 10000);
+    mixer.addSource(&a, 0, 2.0, 0, false);
+    QCOMPARE(mixer.m_sources.at(0).m_gain, 1.0f);
+    mixBlock(mixer);
+
+    // a change is a ramp of 20ms, 882 frames
+    mixer.setSourceIntensity(&a, 0.5);
+    QVector<qint16> block = mixBlock(mixer);
+    QCOMPARE(block.at(0), qint16(10000));
+    for (int f = 1; f < 882; f++)
+        QVERIFY(block.at(f * 2) <= block.at((f - 1) * 2));
+    for (int f = 882; f < BLOCK_FRAMES; f++)
+        QCOMPARE(block.at(f * 2), qint16(5000));
+
+    // during a fade in, the fade goes on towards the new intensity
+    AudioDecoderStub b(44100, 10000);
+    mixer.addSource(&b, 0, 1.0, 100, false);
+    mixer.setSourceIntensity(&b, 0.25);
+    QCOMPARE(mixer.m_sources.at(1).m_gainTarget, 0.25f);
+    QCOMPARE(mixer.m_sources.at(1).m_rampFrames, qint64(4410));
+}
+
+void AudioMixer_Test::pause()
+{
+    AudioMixerStub mixer(false);
+    AudioDecoderStub a(44100, 1000);
+    mixer.addSource(&a, 0, 1.0, 0, false);
+
+    mixer.setSourcePaused(&a, true);
+    QVector<qint16> block = mixBlock(mixer);
+    QCOMPARE(block.size(), BLOCK_FRAMES * 2);
+    for (int i = 0; i < block.size(); i++)
+        QCOMPARE(block.at(i), qint16(0));
+    QCOMPARE(a.m_position, qint64(0));
+
+    mixer.setSourcePaused(&a, false);
+    block = mixBlock(mixer);
+    QCOMPARE(block.at(0), qint16(1000));
+    QCOMPARE(a.m_position, qint64(BLOCK_FRAMES));
+}
+
+void AudioMixer_Test::endOfSource()
+{
+    AudioMixerStub mixer(false);
+    QSignalSpy spy(&mixer, SIGNAL(sourceFinished(AudioDecoder*)));
+    AudioDecoderStub a(1500, 1000);
+    mixer.addSource(&a, 0, 1.0, 0, false);
+
+    mixBlock(mixer);
+    QCOMPARE(spy.count(), 0);
+
+    // the block is completed with silence
+    QVector<qint16> block = mixBlock(mixer);
+    QCOMPARE(block.size(), BLOCK_FRAMES * 2);
+    QCOMPARE(block.at(475 * 2), qint16(1000));
+    QCOMPARE(block.at(476 * 2), qint16(0));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<AudioDecoder*>(), (AudioDecoder*) &a);
+    QCOMPARE(mixer.sourcesCount(), 0);
+
+    // no sources left: the end of the mix
+    qint64 bytes = -1;
+    mixBlock(mixer, &bytes);
+    QCOMPARE(bytes, qint64(0));
+    QVERIFY(mixer.m_running == false);
+}
+
+void AudioMixer_Test::looped()
+{
+    AudioMixerStub mixer(false);
+    QSignalSpy spy(&mixer, SIGNAL(sourceFinished(AudioDecoder*)));
+    AudioDecoderStub a(500, 1000);
+    mixer.addSource(&a, 0, 1.0, 0, false);
+    mixer.m_sources[0].m_looped = true;
+
+    QVector<qint16> block = mixBlock(mixer);
+    for (int i = 0; i < block.size(); i++)
+        QCOMPARE(block.at(i), qint16(1000));
+    QCOMPARE(a.m_position, qint64(BLOCK_FRAMES - 1000));
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(mixer.sourcesCount(), 1);
+
+    // an empty source doesn't loop forever
+    AudioDecoderStub empty(0, 1000);
+    mixer.addSource(&empty, 0, 1.0, 0, true);
+    mixBlock(mixer);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(mixer.sourcesCount(), 1);
+}
+
+void AudioMixer_Test::render()
+{
+    AudioMixerStub mixer(true);
+    AudioDecoderStub a(4410, 1000);
+    AudioDecoderStub b(8820, 1000, 1);
+
+    // the null renderer reads the mix as fast as it can
+    mixer.addSource(&a, 0, 1.0, 0, false);
+    mixer.addSource(&b, 0, 1.0, 0, false);
+    AudioRenderer *renderer = mixer.m_renderer;
+    QVERIFY(renderer != NULL);
+
+    for (int wait = 0; wait < 100 && renderer->isRunning(); wait++)
+        QTest::qWait(10);
+
+    QVERIFY(renderer->isRunning() == false);
+    QCOMPARE(mixer.sourcesCount(), 0);
+    QCOMPARE(a.m_position, qint64(4410));
+    QCOMPARE(b.m_position, qint64(8820));
+    QVERIFY(mixer.m_running == false);
+
+    // a new source starts a new renderer
+    a.seek(0);
+    mixer.addSource(&a, 100, 1.0, 0, false);
+    QVERIFY(mixer.m_renderer != NULL);
+
+    for (int wait = 0; wait < 100 && mixer.m_renderer->isRunning(); wait++)
+        QTest::qWait(10);
+    QCOMPARE(mixer.sourcesCount(), 0);
+}
+
+void AudioMixer_Test::mixEfficiency_data()
+{
+    QTest::addColumn<int>("sources");
+
+    QTest::newRow("1 source") << 1;
+    QTest::newRow("4 sources") << 4;
+    QTest::newRow("16 sources") << 16;
+}
+
+void AudioMixer_Test::mixEfficiency()
+{
+    QFETCH(int, sources);
+
+    // cue stacks with stems: looped sources, some fading
+    AudioMixerStub mixer(false);
+    QList <AudioDecoderStub *> decoders;
+    for (int i = 0; i < sources; i++)
+    {
+        decoders << new AudioDecoderStub(44100, 1000, i % 2 ? 1 : 2);
+        mixer.addSource(decoders.last(), 0, 0.8, i % 4 ? 0 : 1000000, true);
+    }
+
+    QByteArray buffer(8192, 0);
+    QBENCHMARK
+    {
+        mixer.read(buffer.data(), buffer.size());
+    }
+
+    mixer.m_sources.clear();
+    qDeleteAll(decoders);
+}
+
+QTEST_MAIN(AudioMixer_Test)
@@ -1303,6 +1303,106 @@ void ChaserRunner_Test::writeNoAutoStep()
     }
 }
 
+void ChaserRunner_Test::prepareNextStep()
+{
+    m_chaser->setDirection(Function::Forward);
+    m_chaser->setRunOrder(Function::PingPong);
+
+    uint dur = MasterTimer::tick() * 5;
+    m_chaser->setDuration(dur);
+
+    ChaserRunner cr(m_doc, m_chaser);
+    MasterTimer timer(m_doc);
+
+    // Nothing runs yet, there is nothing to prepare
+    cr.prepareNextStep();
+    QCOMPARE(cr.m_stagedStep.m_index, -1);
+
+    // The tick that starts a step doesn't resolve the next one...
+    QVERIFY(cr.write(&timer, QList<Universe*>()) == true);
+    timer.timerTick();
+    QCOMPARE(cr.m_lastRunStepIdx, 0);
+    QCOMPARE(cr.m_stagedStep.m_index, -1);
+
+    // ...the following one does, leaving the runner state alone
+    QVERIFY(cr.write(&timer, QList<Universe*>()) == true);
+    timer.timerTick();
+    QCOMPARE(cr.m_stagedStep.m_index, 1);
+    QCOMPARE(cr.m_stagedStep.m_function, (Function*) m_scene2);
+    QCOMPARE(cr.m_lastRunStepIdx, 0);
+
+    // The staged step is the one that starts
+    while (cr.m_lastRunStepIdx == 0)
+    {
+        QVERIFY(cr.write(&timer, QList<Universe*>()) == true);
+        timer.timerTick();
+    }
+    QCOMPARE(cr.m_lastRunStepIdx, 1);
+    QCOMPARE(cr.m_stagedStep.m_index, -1);
+    QCOMPARE(timer.m_functionList.size(), 1);
+    QCOMPARE(timer.m_functionList[0], m_scene2);
+
+    while (cr.m_lastRunStepIdx == 1)
+    {
+        QVERIFY(cr.write(&timer, QList<Universe*>()) == true);
+        timer.timerTick();
+    }
+    QCOMPARE(cr.m_lastRunStepIdx, 2);
+
+    // Ping pong: the direction changes only when the step starts
+    QVERIFY(cr.write(&timer, QList<Universe*>()) == true);
+    timer.timerTick();
+    QCOMPARE(cr.m_stagedStep.m_index, 1);
+    QCOMPARE(cr.m_direction, Function::Forward);
+
+    // Another step than the staged one is resolved when it starts
+    cr.setCurrentStep(0);
+    QVERIFY(cr.write(&timer, QList<Universe*>()) == true);
+    timer.timerTick();
+    QCOMPARE(cr.m_lastRunStepIdx, 0);
+    QCOMPARE(cr.m_stagedStep.m_index, -1);
+    QCOMPARE(timer.m_functionList.size(), 1);
+    QCOMPARE(timer.m_functionList[0], m_scene1);
+
+    // A change in the chaser drops the staged step
+    QVERIFY(cr.write(&timer, QList<Universe*>()) == true);
+    timer.timerTick();
+    QCOMPARE(cr.m_stagedStep.m_index, 1);
+    m_chaser->setDuration(dur * 2);
+    QCOMPARE(cr.m_stagedStep.m_index, -1);
+}
+
+void ChaserRunner_Test::prepareRandomStep()
+{
+    m_chaser->setDirection(Function::Forward);
+    m_chaser->setRunOrder(Function::Random);
+    m_chaser->setDuration(MasterTimer::tick() * 3);
+
+    ChaserRunner cr(m_doc, m_chaser);
+    MasterTimer timer(m_doc);
+
+    QVERIFY(cr.write(&timer, QList<Universe*>()) == true);
+    timer.timerTick();
+
+    // Several rounds, so that the order is shuffled again a few times:
+    // the predicted step is always the one that starts
+    for (int i = 0; i < 12; i++)
+    {
+        int current = cr.m_lastRunStepIdx;
+        QVERIFY(cr.write(&timer, QList<Universe*>()) == true);
+        timer.timerTick();
+        int staged = cr.m_stagedStep.m_index;
+        QVERIFY(staged != -1);
+
+        while (cr.m_lastRunStepIdx == current)
+        {
+            QVERIFY(cr.write(&timer, QList<Universe*>()) == true);
+            timer.timerTick();
+        }
+        QCOMPARE(cr.m_lastRunStepIdx, staged);
+    }
+}
+
 void ChaserRunner_Test::adjustIntensity()
 {
     m_chaser->setDirection(Function::Forward);
@@ -66,6 +66,9 @@ private slots:
     void writeBackwardPingPongFive();
     void writeNoAutoStep();
 
+    void prepareNextStep();
+    void prepareRandomStep();
+
     void adjustIntensity();
 
 private:
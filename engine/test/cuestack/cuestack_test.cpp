@@ -837,15 +837,25 @@ void CueStack_Test::switchCue()
     QCOMPARE(cs.m_fader->channels()[fc].channel(), QLCChannel::invalid());
 
     fc.setChannel(m_doc, 0);
-    cs.m_fader->m_channels[fc].setCurrent(127);
+    fc = cs.m_fader->channels()[fc];
+    fc.setCurrent(127);
+    cs.m_fader->forceAdd(fc);
     fc.setChannel(m_doc, 1);
-    cs.m_fader->m_channels[fc].setCurrent(127);
+    fc = cs.m_fader->channels()[fc];
+    fc.setCurrent(127);
+    cs.m_fader->forceAdd(fc);
     fc.setChannel(m_doc, 10);
-    cs.m_fader->m_channels[fc].setCurrent(127);
+    fc = cs.m_fader->channels()[fc];
+    fc.setCurrent(127);
+    cs.m_fader->forceAdd(fc);
     fc.setChannel(m_doc, 11);
-    cs.m_fader->m_channels[fc].setCurrent(127);
+    fc = cs.m_fader->channels()[fc];
+    fc.setCurrent(127);
+    cs.m_fader->forceAdd(fc);
     fc.setChannel(m_doc, 500);
-    cs.m_fader->m_channels[fc].setCurrent(127);
+    fc = cs.m_fader->channels()[fc];
+    fc.setCurrent(127);
+    cs.m_fader->forceAdd(fc);
 
     // Switch to cue two
     cs.switchCue(0, 1, ua);
@@ -901,6 +911,86 @@ void CueStack_Test::switchCue()
     cs.postRun(&mt);
 }
 
+void CueStack_Test::resolveValues()
+{
+    QLCFixtureDef* def = m_doc->fixtureDefCache()->fixtureDef("Futurelight", "DJScan250");
+    QVERIFY(def != NULL);
+
+    QLCFixtureMode* mode = def->modes().first();
+    QVERIFY(mode != NULL);
+
+    Fixture* fxi = new Fixture(m_doc);
+    fxi->setFixtureDefinition(def, mode);
+    fxi->setAddress(10);
+    fxi->setUniverse(0);
+    m_doc->addFixture(fxi);
+
+    CueStack cs(m_doc);
+
+    Cue cue;
+    cue.setValue(3, 100);
+    cue.setValue(10, 200); // Pan
+    cue.setValue(15, 255); // Shutter
+    cue.setValue(520, 50);
+    cue.setFadeInSpeed(20);
+    QVERIFY(cue.isResolved() == false);
+
+    // Values are resolved when the cue is stored
+    cs.appendCue(cue);
+    QVERIFY(cs.m_cues[0].isResolved() == true);
+
+    QVector <FadeChannel> values = cs.m_cues[0].resolvedValues();
+    QCOMPARE(values.size(), 4);
+    for (int i = 0; i < values.size(); i++)
+    {
+        const FadeChannel& fc(values.at(i));
+        QCOMPARE(fc.target(), cue.value(fc.channel()));
+        QCOMPARE(fc.universe(), fc.channel() / 512);
+        QCOMPARE(fc.addressInUniverse(), fc.channel() % 512);
+        if (fc.channel() == 10)
+            QCOMPARE(fc.m_group, QLCChannel::Pan);
+        else
+            QCOMPARE(fc.m_group, QLCChannel::Intensity);
+    }
+
+    // Moving the fixture resolves the values again, when the cue is used
+    fxi->setAddress(0);
+    QVERIFY(cs.m_cues[0].isResolved() == false);
+    values = cs.resolvedCue(0).resolvedValues();
+    QVERIFY(cs.m_cues[0].isResolved() == true);
+    QCOMPARE(values.size(), 4);
+    for (int i = 0; i < values.size(); i++)
+    {
+        const FadeChannel& fc(values.at(i));
+        if (fc.channel() == 3)
+            QCOMPARE(fc.m_group, QLCChannel::Gobo);
+        else
+            QCOMPARE(fc.m_group, QLCChannel::Intensity);
+    }
+
+    // Values changed in place are resolved at the next switch
+    cs.m_cues[0].setValue(5, 42);
+    QVERIFY(cs.m_cues[0].isResolved() == false);
+
+    QList<Universe*> ua;
+    ua.append(new Universe(0, new GrandMaster()));
+    ua.append(new Universe(1, new GrandMaster()));
+    cs.preRun();
+    cs.switchCue(-1, 0, ua);
+    QVERIFY(cs.m_cues[0].isResolved() == true);
+    QCOMPARE(cs.m_fader->channels().size(), 5);
+
+    FadeChannel fc;
+    fc.setChannel(m_doc, 5);
+    QCOMPARE(cs.m_fader->channels()[fc].target(), uchar(42));
+    QCOMPARE(cs.m_fader->channels()[fc].fadeTime(), uint(20));
+    fc.setChannel(m_doc, 520);
+    QCOMPARE(cs.m_fader->channels()[fc].target(), uchar(50));
+
+    MasterTimer mt(m_doc);
+    cs.postRun(&mt);
+}
+
 void CueStack_Test::postRun()
 {
     QLCFixtureDef* def = m_doc->fixtureDefCache()->fixtureDef("Futurelight", "DJScan250");
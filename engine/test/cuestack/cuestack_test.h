@@ -53,6 +53,7 @@ private slots:
     void nextPrevious();
     void insertStartValue();
     void switchCue();
+    void resolveValues();
     void postRun();
     void write();
 
@@ -2305,6 +2305,96 @@ void EFX_Test::rotateAndScale()
     QCOMPARE(floor(y + 0.5), double(143));
 }
 
+void EFX_Test::pathTable()
+{
+    EFX e(m_doc);
+    e.setRotation(30);
+    e.setWidth(100);
+    e.setXOffset(120);
+
+    QVERIFY(e.m_pathDirty.loadAcquire() == 1);
+    QVERIFY(e.m_pathX.isEmpty() == true);
+
+    /* Without a table, points are calculated exactly */
+    float iterator = 1.234;
+    float x, y, tx, ty;
+    e.calculatePoint(iterator, &x, &y);
+    e.calculatePathPoints(1, &iterator, &tx, &ty);
+    QCOMPARE(tx, x);
+    QCOMPARE(ty, y);
+
+    QStringList algos(EFX::algorithmList());
+    for (int a = 0; a < algos.size(); a++)
+    {
+        e.setAlgorithm(EFX::stringToAlgorithm(algos.at(a)));
+        QVERIFY(e.m_pathDirty.loadAcquire() == 1);
+        e.updatePathTable();
+        QVERIFY(e.m_pathDirty.loadAcquire() == 0);
+        QCOMPARE(e.m_pathX.size(), EFX_PATH_RESOLUTION + 1);
+        QCOMPARE(e.m_pathY.size(), EFX_PATH_RESOLUTION + 1);
+
+        /* Points of all the fixtures at once */
+        QVector<float> iterators, px(1000), py(1000);
+        for (int i = 0; i < 1000; i++)
+            iterators.append((M_PI * 2.0 * i) / 1000.0);
+        e.calculatePathPoints(iterators.size(), iterators.constData(), px.data(), py.data());
+
+        for (int i = 0; i < iterators.size(); i++)
+        {
+            e.calculatePoint(iterators.at(i), &x, &y);
+
+            /* Interpolated points are within a tenth of a DMX value.
+               The choppy square jumps, so only its values are checked */
+            if (e.algorithm() == EFX::SquareChoppy)
+            {
+                e.calculatePoint(iterators.at(i) + 0.01, &tx, &ty);
+                QVERIFY((qAbs(px.at(i) - x) < 0.1 && qAbs(py.at(i) - y) < 0.1) ||
+                        (qAbs(px.at(i) - tx) < 0.1 && qAbs(py.at(i) - ty) < 0.1));
+            }
+            else
+            {
+                QVERIFY(qAbs(px.at(i) - x) < 0.1);
+                QVERIFY(qAbs(py.at(i) - y) < 0.1);
+            }
+        }
+    }
+
+    /* Width, height, rotation and offsets don't change the table */
+    e.setWidth(20);
+    e.setRotation(200);
+    e.setYOffset(30);
+    QVERIFY(e.m_pathDirty.loadAcquire() == 0);
+    e.calculatePoint(iterator, &x, &y);
+    e.calculatePathPoints(1, &iterator, &tx, &ty);
+    QVERIFY(qAbs(tx - x) < 0.1);
+    QVERIFY(qAbs(ty - y) < 0.1);
+
+    /* Frequency and phase do */
+    e.setXFrequency(5);
+    QVERIFY(e.m_pathDirty.loadAcquire() == 1);
+    e.updatePathTable();
+    e.setYPhase(40);
+    QVERIFY(e.m_pathDirty.loadAcquire() == 1);
+
+    /* A running EFX rebuilds the table when it's stale */
+    EFXFixture* ef = new EFXFixture(&e);
+    ef->setHead(GroupHead(0, 0));
+    e.addFixture(ef);
+
+    QList<Universe*> ua;
+    ua.append(new Universe(0, new GrandMaster()));
+    MasterTimerStub mts(m_doc, ua);
+
+    e.preRun(&mts);
+    QVERIFY(e.m_pathDirty.loadAcquire() == 0);
+    e.setAlgorithm(EFX::Eight);
+    QVERIFY(e.m_pathDirty.loadAcquire() == 1);
+    e.write(&mts, ua);
+    QVERIFY(e.m_pathDirty.loadAcquire() == 0);
+    QCOMPARE(e.m_stepFixtures.size(), 1);
+    e.postRun(&mts, ua);
+}
+
 void EFX_Test::copyFrom()
 {
     EFX e1(m_doc);
@@ -0,0 +1,153 @@
+/*
+  Q Light Controller Plus - Unit test
+  engineprofiler_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtTest>
+
+#define private public
+#include "engineprofiler_test.h"
+#include "engineprofiler.h"
+#undef private
+
+void EngineProfiler_Test::initial()
+{
+    EngineProfiler prof(NULL);
+    QVERIFY(prof.isEnabled() == false);
+    prof.setEnabled(true);
+    QVERIFY(prof.isEnabled() == true);
+
+    for (int s = 0; s < EngineProfiler::StageCount; s++)
+    {
+        EngineProfiler::Stage stage = EngineProfiler::Stage(s);
+        QCOMPARE(prof.count(stage), quint64(0));
+        QCOMPARE(prof.totalNs(stage), quint64(0));
+        QCOMPARE(prof.maxNs(stage), quint64(0));
+        QCOMPARE(prof.meanNs(stage), quint64(0));
+        QCOMPARE(prof.percentileNs(stage, 50), quint64(0));
+    }
+    QVERIFY(prof.functionCosts().isEmpty());
+}
+
+void EngineProfiler_Test::buckets()
+{
+    QCOMPARE(EngineProfiler::bucketIndex(0), 0);
+    QCOMPARE(EngineProfiler::bucketIndex(3), 3);
+
+    // each value must fall between its bucket bounds
+    quint64 values[] = { 4, 5, 7, 8, 100, 1000, 20000000, Q_UINT64_C(1) << 40, Q_UINT64_C(0xFFFFFFFFFFFFFFFF) };
+    for (uint i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+    {
+        int index = EngineProfiler::bucketIndex(values[i]);
+        QVERIFY(index < EngineProfiler::s_bucketsCount);
+        QVERIFY(values[i] <= EngineProfiler::bucketUpperBound(index));
+        QVERIFY(values[i] > EngineProfiler::bucketUpperBound(index - 1));
+        // buckets are at most 25% wide
+        QVERIFY(EngineProfiler::bucketUpperBound(index) - values[i] <= values[i] / 4);
+    }
+}
+
+void EngineProfiler_Test::stageSamples()
+{
+    EngineProfiler prof(NULL);
+
+    for (quint64 i = 1; i <= 100; i++)
+        prof.addStageSample(EngineProfiler::FaderStage, i * 1000);
+
+    QCOMPARE(prof.count(EngineProfiler::FaderStage), quint64(100));
+    QCOMPARE(prof.totalNs(EngineProfiler::FaderStage), quint64(5050000));
+    QCOMPARE(prof.meanNs(EngineProfiler::FaderStage), quint64(50500));
+    QCOMPARE(prof.maxNs(EngineProfiler::FaderStage), quint64(100000));
+
+    quint64 p50 = prof.percentileNs(EngineProfiler::FaderStage, 50);
+    QVERIFY(p50 >= 50000 && p50 <= 50000 * 5 / 4);
+    quint64 p99 = prof.percentileNs(EngineProfiler::FaderStage, 99);
+    QVERIFY(p99 >= 99000 && p99 <= 100000);
+    QCOMPARE(prof.percentileNs(EngineProfiler::FaderStage, 100), quint64(100000));
+
+    // other stages are not affected
+    QCOMPARE(prof.count(EngineProfiler::DumpStage), quint64(0));
+
+    prof.reset();
+    QCOMPARE(prof.count(EngineProfiler::FaderStage), quint64(0));
+    QCOMPARE(prof.percentileNs(EngineProfiler::FaderStage, 50), quint64(0));
+}
+
+void EngineProfiler_Test::functionCosts()
+{
+    EngineProfiler prof(NULL);
+
+    prof.addFunctionSample(1, 1000);
+    prof.addFunctionSample(2, 5000);
+
+    // nothing is published before the end of the tick
+    QVERIFY(prof.functionCosts().isEmpty());
+    prof.commitTick();
+
+    prof.addFunctionSample(1, 3000);
+    prof.commitTick();
+    QVERIFY(prof.m_pendingSamples.isEmpty());
+
+    QList<EngineProfiler::FunctionCost> costs = prof.functionCosts();
+    QCOMPARE(costs.count(), 2);
+    QCOMPARE(costs.at(0).m_id, quint32(2));
+    QCOMPARE(costs.at(0).m_calls, quint64(1));
+    QCOMPARE(costs.at(0).m_totalNs, quint64(5000));
+    QCOMPARE(costs.at(1).m_id, quint32(1));
+    QCOMPARE(costs.at(1).m_calls, quint64(2));
+    QCOMPARE(costs.at(1).m_totalNs, quint64(4000));
+    QCOMPARE(costs.at(1).m_maxNs, quint64(3000));
+
+    prof.reset();
+    QVERIFY(prof.functionCosts().isEmpty());
+}
+
+void EngineProfiler_Test::json()
+{
+    EngineProfiler prof(NULL);
+    prof.setEnabled(true);
+    prof.addStageSample(EngineProfiler::TickStage, 2000);
+    prof.addFunctionSample(7, 1500);
+    prof.commitTick();
+
+    QJsonDocument doc = QJsonDocument::fromJson(prof.toJson());
+    QVERIFY(doc.isObject());
+
+    QJsonObject root = doc.object();
+    QCOMPARE(root.value("enabled").toBool(), true);
+
+    QJsonArray stages = root.value("stages").toArray();
+    QCOMPARE(stages.count(), int(EngineProfiler::StageCount));
+    QCOMPARE(stages.at(0).toObject().value("name").toString(), QString("Tick"));
+    QCOMPARE(stages.at(0).toObject().value("count").toInt(), 1);
+    QCOMPARE(stages.at(0).toObject().value("maxNs").toInt(), 2000);
+
+    QJsonArray functions = root.value("functions").toArray();
+    QCOMPARE(functions.count(), 1);
+    QCOMPARE(functions.at(0).toObject().value("id").toInt(), 7);
+    QCOMPARE(functions.at(0).toObject().value("totalNs").toInt(), 1500);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QVERIFY(prof.saveToFile(file.fileName()) == true);
+    QCOMPARE(file.readAll(), prof.toJson());
+}
+
+QTEST_APPLESS_MAIN(EngineProfiler_Test)
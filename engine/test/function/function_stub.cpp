@@ -24,6 +24,8 @@
 Function_Stub::Function_Stub(Doc* doc) : Function(doc, Function::Type(0xDEADBEEF))
 {
     m_writeCalls = 0;
+    m_prepareWrite = false;
+    m_prepareWriteCalls = 0;
     m_preRunCalls = 0;
     m_postRunCalls = 0;
     m_slotFixtureRemovedId = Fixture::invalidId();
@@ -83,6 +85,17 @@ void Function_Stub::write(MasterTimer* timer, QList<Universe *> universes)
     m_writeCalls++;
 }
 
+bool Function_Stub::supportsPrepareWrite() const
+{
+    return m_prepareWrite;
+}
+
+void Function_Stub::prepareWrite(MasterTimer* timer)
+{
+    Q_UNUSED(timer);
+    m_prepareWriteCalls++;
+}
+
 void Function_Stub::postRun(MasterTimer* timer, QList<Universe *> universes)
 {
     Q_UNUSED(timer);
@@ -39,6 +39,8 @@ public:
 
     void preRun(MasterTimer* timer);
     void write(MasterTimer* timer, QList<Universe*> universes);
+    bool supportsPrepareWrite() const;
+    void prepareWrite(MasterTimer* timer);
     void postRun(MasterTimer* timer, QList<Universe*> universes);
 
 public slots:
@@ -47,6 +49,8 @@ public slots:
 public:
     int m_preRunCalls;
     int m_writeCalls;
+    bool m_prepareWrite;
+    int m_prepareWriteCalls;
     int m_postRunCalls;
 
     quint32 m_slotFixtureRemovedId;
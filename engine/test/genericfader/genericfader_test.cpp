@@ -122,6 +122,36 @@ void GenericFader_Test::addRemove()
     QCOMPARE(fader.m_channels[fc].target(), uchar(63));
 }
 
+void GenericFader_Test::sparseIndex()
+{
+    GenericFader fader(m_doc);
+
+    // a channel in the fourth universe allocates that universe only
+    FadeChannel fc(m_doc, Fixture::invalidId(), 3 * UNIVERSE_SIZE + 7);
+    fc.setTarget(100);
+    fader.add(fc);
+    QCOMPARE(fader.m_channels.m_index.size(), 4);
+    QVERIFY(fader.m_channels.m_index.at(0).isEmpty());
+    QVERIFY(fader.m_channels.m_index.at(2).isEmpty());
+    QCOMPARE(fader.m_channels.m_index.at(3).size(), int(UNIVERSE_SIZE));
+    QCOMPARE(fader.m_channels.indexOf(fc), 0);
+
+    // addresses of universes without a block are not found
+    QCOMPARE(fader.m_channels.indexOf(7), -1);
+    QCOMPARE(fader.m_channels.indexOf(9 * UNIVERSE_SIZE), -1);
+
+    FadeChannel first(m_doc, Fixture::invalidId(), 5);
+    fader.add(first);
+    QCOMPARE(fader.m_channels.m_index.size(), 4);
+    QCOMPARE(fader.m_channels.m_index.at(0).size(), int(UNIVERSE_SIZE));
+    QCOMPARE(fader.m_channels.indexOf(first), 1);
+
+    // removing the first slot moves the last one in its place
+    fader.remove(fc);
+    QCOMPARE(fader.m_channels.indexOf(fc), -1);
+    QCOMPARE(fader.m_channels.indexOf(first), 0);
+}
+
 void GenericFader_Test::writeZeroFade()
 {
     QList<Universe*> ua;
@@ -169,6 +199,46 @@ void GenericFader_Test::writeLoop()
     }
 }
 
+void GenericFader_Test::writeRemoveZero()
+{
+    QList<Universe*> ua;
+    ua.append(new Universe(0, new GrandMaster()));
+    GenericFader fader(m_doc);
+
+    // HTP channel fading to zero
+    FadeChannel fc;
+    fc.setFixture(m_doc, 0);
+    fc.setChannel(m_doc, 5);
+    fc.setStart(255);
+    fc.setCurrent(255);
+    fc.setTarget(0);
+    fc.setFadeTime(0);
+    fader.add(fc);
+
+    // LTP channel
+    fc.setChannel(m_doc, 0);
+    fc.setTarget(127);
+    fader.add(fc);
+    QCOMPARE(fader.m_channels.count(), 2);
+
+    // Channels are identified by their DMX address
+    FadeChannel abs;
+    abs.setChannel(m_doc, 10);
+    QVERIFY(fader.m_channels.contains(abs) == true);
+    QCOMPARE(fader.m_channels[abs].fixture(), quint32(0));
+    QCOMPARE(fader.m_channels[abs].channel(), quint32(0));
+
+    // HTP channels that reached zero are removed
+    fader.write(ua);
+    QCOMPARE(fader.m_channels.count(), 1);
+    QVERIFY(fader.m_channels.contains(fc) == true);
+    QCOMPARE(ua[0]->preGMValues()[10], (char) 127);
+    QCOMPARE(ua[0]->preGMValues()[15], (char) 0);
+
+    fader.remove(abs);
+    QCOMPARE(fader.m_channels.count(), 0);
+}
+
 void GenericFader_Test::adjustIntensity()
 {
     QList<Universe*> ua;
@@ -33,8 +33,10 @@ private slots:
     void cleanup();
 
     void addRemove();
+    void sparseIndex();
     void writeZeroFade();
     void writeLoop();
+    void writeRemoveZero();
     void adjustIntensity();
 
 private:
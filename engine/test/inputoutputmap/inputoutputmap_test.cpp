@@ -653,8 +653,12 @@ void InputOutputMap_Test::claimReleaseDumpReset()
         unis[3]->write(i, 'd');
     iom.releaseUniverses();
 
+    int endFrameCalls = stub->m_endFrameCalls;
     iom.dumpUniverses();
 
+    // one frame end for all the universes patched to the same plugin
+    QCOMPARE(stub->m_endFrameCalls, endFrameCalls + 1);
+
     for (int i = 0; i < 512; i++)
         QCOMPARE(stub->m_universe.data()[i], 'a');
 
@@ -33,6 +33,7 @@ void IOPluginStub::init()
     m_configureCalled = 0;
     m_canConfigure = false;
     m_universe = QByteArray(int(4 * 512), char(0));
+    m_endFrameCalls = 0;
 }
 
 QString IOPluginStub::name()
@@ -93,6 +94,11 @@ void IOPluginStub::writeUniverse(quint32 universe, quint32 output, const QByteAr
     m_universe = m_universe.replace(output * 512, data.size(), data);
 }
 
+void IOPluginStub::endFrame()
+{
+    m_endFrameCalls++;
+}
+
 /*****************************************************************************
  * Inputs
  *****************************************************************************/
@@ -72,6 +72,9 @@ public:
     /** @reimp */
     void writeUniverse(quint32 universe, quint32 output, const QByteArray& data);
 
+    /** @reimp */
+    void endFrame();
+
 public:
     /** List of outputs that have been opened */
     QList <quint32> m_openOutputs;
@@ -79,6 +82,9 @@ public:
     /** Fake universe buffer */
     QByteArray m_universe;
 
+    /** Number of endFrame() calls */
+    int m_endFrameCalls;
+
     /*********************************************************************
      * Inputs
      *********************************************************************/
@@ -62,8 +62,7 @@ void MasterTimer_Test::initial()
 
     QVERIFY(mt->runningFunctions() == 0);
     QVERIFY(mt->m_functionList.size() == 0);
-    QVERIFY(mt->m_functionListMutex.tryLock() == true);
-    mt->m_functionListMutex.unlock();
+    QVERIFY(mt->m_startQueue.loadAcquire() == NULL);
 
     QVERIFY(mt->m_dmxSourceList.size() == 0);
     QVERIFY(mt->m_dmxSourceListMutex.tryLock() == true);
@@ -122,6 +121,45 @@ void MasterTimer_Test::startStopFunction()
     QVERIFY(mt->runningFunctions() == 0);
 }
 
+void MasterTimer_Test::startQueue()
+{
+    // use a private instance, ticked manually
+    MasterTimer mt(m_doc);
+    Function_Stub fs1(m_doc);
+    Function_Stub fs2(m_doc);
+    Function_Stub fs3(m_doc);
+
+    QVERIFY(mt.takeStartQueue().isEmpty());
+
+    mt.startFunction(&fs1);
+    mt.startFunction(&fs2);
+    mt.startFunction(&fs1);
+    mt.startFunction(&fs3);
+    mt.startFunction(&fs2);
+    QVERIFY(mt.m_startQueue.loadAcquire() != NULL);
+
+    /* Requests come out in order, without duplicates */
+    QList<Function*> queue = mt.takeStartQueue();
+    QCOMPARE(queue.count(), 3);
+    QVERIFY(queue.at(0) == &fs1);
+    QVERIFY(queue.at(1) == &fs2);
+    QVERIFY(queue.at(2) == &fs3);
+    QVERIFY(mt.m_startQueue.loadAcquire() == NULL);
+    QVERIFY(mt.takeStartQueue().isEmpty());
+
+    /* A tick starts the queued functions once */
+    mt.startFunction(&fs2);
+    mt.startFunction(&fs2);
+    mt.timerTick();
+    QCOMPARE(mt.runningFunctions(), 1);
+    QCOMPARE(fs2.m_preRunCalls, 1);
+    QCOMPARE(fs2.m_writeCalls, 1);
+
+    fs2.stop(FunctionParent::master());
+    mt.timerTick();
+    QCOMPARE(mt.runningFunctions(), 0);
+}
+
 void MasterTimer_Test::registerUnregisterDMXSource()
 {
     MasterTimer* mt = m_doc->masterTimer();
@@ -206,6 +244,82 @@ void MasterTimer_Test::interval()
     QVERIFY(mt->m_dmxSourceList.size() == 0);
 }
 
+void MasterTimer_Test::tickAccounting()
+{
+    // the shared timer must not tick while the tick length is changed
+    m_doc->masterTimer()->stop();
+
+    MasterTimer mt(m_doc);
+    quint64 tickNs = MasterTimer::s_tickNs;
+    uint tick = MasterTimer::tick();
+
+    /* 50Hz: whole milliseconds */
+    QCOMPARE(MasterTimer::tickNs(), quint64(20000000));
+    for (int i = 0; i < 10; i++)
+    {
+        mt.advanceTick();
+        QCOMPARE(MasterTimer::tick(), uint(20));
+    }
+
+    MasterTimer::s_tickNs = Q_UINT64_C(1000000000) / 44;
+    mt.m_tickRemainderNs = 0;
+    uint total = 0;
+
+#if defined(WIN32) || defined(Q_OS_WIN)
+    /* 44Hz: the system timer runs at 22ms, and so do all the ticks */
+    for (int i = 0; i < 10; i++)
+    {
+        mt.advanceTick();
+        QCOMPARE(MasterTimer::tick(), uint(22));
+        total += MasterTimer::tick();
+    }
+    QCOMPARE(total, uint(220));
+#else
+    /* 44Hz: 22.7ms ticks alternate between 22 and 23ms */
+    for (int i = 0; i < 44 * 60; i++)
+    {
+        mt.advanceTick();
+        QVERIFY(MasterTimer::tick() == 22 || MasterTimer::tick() == 23);
+        total += MasterTimer::tick();
+    }
+    /* One minute of ticks, with less than a millisecond of error */
+    QVERIFY(total >= 59999 && total <= 60000);
+#endif
+
+    MasterTimer::s_tickNs = tickNs;
+    MasterTimer::s_tick.storeRelease(int(tick));
+}
+
+void MasterTimer_Test::timingStats()
+{
+    MasterTimer mt(m_doc);
+
+    MasterTimer::TimingStats stats = mt.timingStats();
+    QCOMPARE(stats.ticks, quint64(0));
+    QCOMPARE(stats.lateTicks, quint64(0));
+    QCOMPARE(stats.meanJitterNs, quint64(0));
+    QCOMPARE(stats.maxJitterNs, quint64(0));
+
+    /* The first tick is not measured */
+    mt.timerTick();
+    QCOMPARE(mt.timingStats().ticks, quint64(0));
+
+    /* A tick coming after two tick lengths is late */
+    QTest::qWait(2 * MasterTimer::tick());
+    mt.timerTick();
+    stats = mt.timingStats();
+    QCOMPARE(stats.ticks, quint64(1));
+    QCOMPARE(stats.lateTicks, quint64(1));
+    QVERIFY(stats.maxJitterNs >= MasterTimer::tickNs());
+    QCOMPARE(stats.meanJitterNs, stats.maxJitterNs);
+
+    mt.resetTimingStats();
+    stats = mt.timingStats();
+    QCOMPARE(stats.ticks, quint64(0));
+    QCOMPARE(stats.lateTicks, quint64(0));
+    QCOMPARE(stats.maxJitterNs, quint64(0));
+}
+
 void MasterTimer_Test::functionInitiatedStop()
 {
     MasterTimer* mt = m_doc->masterTimer();
@@ -268,6 +382,63 @@ void MasterTimer_Test::runMultipleFunctions()
     QVERIFY(mt->runningFunctions() == 0);
 }
 
+void MasterTimer_Test::prepareFunctions()
+{
+    // use a private instance, ticked manually
+    MasterTimer mt(m_doc);
+    QCOMPARE(mt.workerThreads(), 0);
+    mt.setWorkerThreads(-1);
+    QCOMPARE(mt.workerThreads(), 0);
+    QVERIFY(mt.m_workerPool == NULL);
+
+    mt.setWorkerThreads(2);
+    QCOMPARE(mt.workerThreads(), 2);
+    QVERIFY(mt.m_workerPool != NULL);
+
+    QList<Function_Stub*> stubs;
+    for (int i = 0; i < 5; i++)
+    {
+        Function_Stub* fs = new Function_Stub(m_doc);
+        fs->m_prepareWrite = (i != 2);
+        fs->start(&mt, FunctionParent::master());
+        stubs << fs;
+    }
+
+    // functions started in this tick are not prepared
+    mt.timerTick();
+    QCOMPARE(mt.runningFunctions(), 5);
+    foreach (Function_Stub* fs, stubs)
+    {
+        QCOMPARE(fs->m_prepareWriteCalls, 0);
+        QCOMPARE(fs->m_writeCalls, 1);
+    }
+
+    mt.timerTick();
+    mt.timerTick();
+    for (int i = 0; i < stubs.count(); i++)
+    {
+        QCOMPARE(stubs.at(i)->m_prepareWriteCalls, i == 2 ? 0 : 2);
+        QCOMPARE(stubs.at(i)->m_writeCalls, 3);
+    }
+
+    // serial mode: no preparation at all
+    mt.setWorkerThreads(0);
+    QVERIFY(mt.m_workerPool == NULL);
+    mt.timerTick();
+    for (int i = 0; i < stubs.count(); i++)
+    {
+        QCOMPARE(stubs.at(i)->m_prepareWriteCalls, i == 2 ? 0 : 2);
+        QCOMPARE(stubs.at(i)->m_writeCalls, 4);
+    }
+
+    foreach (Function_Stub* fs, stubs)
+        fs->stop(FunctionParent::master());
+    mt.timerTick();
+    QCOMPARE(mt.runningFunctions(), 0);
+
+    qDeleteAll(stubs);
+}
+
 void MasterTimer_Test::stopAllFunctions()
 {
     MasterTimer* mt = m_doc->masterTimer();
@@ -345,16 +516,14 @@ void MasterTimer_Test::restart()
     QTest::qWait(60);
     QVERIFY(mt->runningFunctions() == 0);
     QVERIFY(mt->m_functionList.size() == 0);
-    QVERIFY(mt->m_functionListMutex.tryLock() == true);
-    mt->m_functionListMutex.unlock();
+    QVERIFY(mt->m_startQueue.loadAcquire() == NULL);
     // QVERIFY(mt->m_running == false);
     QVERIFY(mt->m_stopAllFunctions == false);
 
     mt->start();
     QVERIFY(mt->runningFunctions() == 0);
     QVERIFY(mt->m_functionList.size() == 0);
-    QVERIFY(mt->m_functionListMutex.tryLock() == true);
-    mt->m_functionListMutex.unlock();
+    QVERIFY(mt->m_startQueue.loadAcquire() == NULL);
     // QVERIFY(mt->m_running == true);
     QVERIFY(mt->m_stopAllFunctions == false);
 
@@ -36,10 +36,14 @@ private slots:
     void initial();
     void startStop();
     void startStopFunction();
+    void startQueue();
     void registerUnregisterDMXSource();
     void interval();
+    void tickAccounting();
+    void timingStats();
     void functionInitiatedStop();
     void runMultipleFunctions();
+    void prepareFunctions();
     void stopAllFunctions();
     void stop();
     void restart();
@@ -144,4 +144,50 @@ void OutputPatch_Test::dump()
     delete op;
 }
 
+void OutputPatch_Test::dumpUnchanged()
+{
+    QByteArray uni(512, char(0));
+    uni[0] = 100;
+
+    OutputPatch* op = new OutputPatch(0, this);
+    QCOMPARE(op->refreshInterval(), 0);
+    op->setRefreshInterval(-5);
+    QCOMPARE(op->refreshInterval(), 0);
+
+    IOPluginStub* stub = static_cast<IOPluginStub*>
+                                (m_doc->ioPluginCache()->plugins().at(0));
+    QVERIFY(stub != NULL);
+    op->set(stub, 0);
+
+    /* Without a refresh interval, unchanged data is written anyway */
+    op->dump(0, uni, false);
+    QVERIFY(stub->m_universe[0] == (char) 100);
+    uni[0] = 50;
+    op->dump(0, uni, false);
+    QVERIFY(stub->m_universe[0] == (char) 50);
+
+    /* With a refresh interval, unchanged data is skipped */
+    op->setRefreshInterval(60000);
+    QCOMPARE(op->refreshInterval(), 60000);
+    uni[0] = 25;
+    op->dump(0, uni, false);
+    QVERIFY(stub->m_universe[0] == (char) 50);
+
+    /* Changed data is always written */
+    op->dump(0, uni, true);
+    QVERIFY(stub->m_universe[0] == (char) 25);
+
+    /* A state change forces the next write */
+    uni[0] = 12;
+    op->setBlackout(true);
+    op->dump(0, uni, false);
+    QVERIFY(stub->m_universe[0] == (char) 12);
+
+    uni[0] = 6;
+    op->dump(0, uni, false);
+    QVERIFY(stub->m_universe[0] == (char) 12);
+
+    delete op;
+}
+
 QTEST_APPLESS_MAIN(OutputPatch_Test)
@@ -0,0 +1,385 @@
+/*
+  Q Light Controller Plus - Unit test
+  pixelfader_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QtTest>
+
+#include "pixelfader_test.h"
+#include "genericfader.h"
+#include "grandmaster.h"
+#include "fadechannel.h"
+#include "mastertimer.h"
+#include "universe.h"
+#include "fixture.h"
+#include "doc.h"
+
+#define private public
+#include "pixelfader.h"
+#undef private
+
+/** Number of universes and channels of the efficiency test: 1024 RGB pixels */
+#define BENCH_UNIVERSES 6
+#define BENCH_CHANNELS  3072
+
+void PixelFader_Test::initTestCase()
+{
+    m_doc = new Doc(this);
+}
+
+void PixelFader_Test::cleanupTestCase()
+{
+    delete m_doc;
+}
+
+void PixelFader_Test::addClear()
+{
+    PixelFader fader;
+    QCOMPARE(fader.count(), 0);
+
+    QCOMPARE(fader.add(515, false, false), 0);
+    QCOMPARE(fader.count(), 1);
+    QCOMPARE(fader.universe(0), quint32(1));
+    QCOMPARE(fader.addressInUniverse(0), quint32(3));
+    QCOMPARE(fader.current(0), uchar(0));
+    QCOMPARE(fader.target(0), uchar(0));
+
+    for (int i = 1; i < 6; i++)
+        QCOMPARE(fader.add(i, true, true), i);
+    QCOMPARE(fader.count(), 6);
+    QCOMPARE(fader.universe(5), quint32(0));
+    QCOMPARE(fader.addressInUniverse(5), quint32(5));
+
+    // slots are padded to whole vectors
+    QCOMPARE(fader.m_current.size(), 8);
+    QCOMPARE(fader.m_elapsed.size(), 8);
+
+    fader.setTarget(2, 100, 0);
+    fader.advance(20);
+    QCOMPARE(fader.current(2), uchar(100));
+
+    // memory is kept, slots start over from 0
+    fader.clear();
+    QCOMPARE(fader.count(), 0);
+    QCOMPARE(fader.m_current.size(), 8);
+    QCOMPARE(fader.add(10, false, false), 0);
+    QCOMPARE(fader.add(11, false, false), 1);
+    QCOMPARE(fader.add(12, false, false), 2);
+    QCOMPARE(fader.current(2), uchar(0));
+    QCOMPARE(fader.target(2), uchar(0));
+}
+
+void PixelFader_Test::remap()
+{
+    PixelFader fader;
+    fader.add(10, true, true);
+    fader.add(11, true, true);
+    fader.setTarget(0, 200, 1000);
+    fader.setTarget(1, 100, 0);
+    fader.advance(500);
+    QCOMPARE(fader.current(0), uchar(100));
+    QCOMPARE(fader.current(1), uchar(100));
+
+    // address 10 moves to another slot and resumes its fade,
+    // address 11 is gone and address 12 is new
+    fader.remap();
+    QCOMPARE(fader.count(), 0);
+    QCOMPARE(fader.add(12, true, true), 0);
+    QCOMPARE(fader.add(10, true, true), 1);
+    QCOMPARE(fader.count(), 2);
+
+    QCOMPARE(fader.current(0), uchar(0));
+    QCOMPARE(fader.target(0), uchar(0));
+
+    QCOMPARE(fader.current(1), uchar(100));
+    QCOMPARE(fader.start(1), uchar(0));
+    QCOMPARE(fader.target(1), uchar(200));
+    QCOMPARE(fader.elapsed(1), uint(500));
+    fader.advance(250);
+    QCOMPARE(fader.current(1), uchar(150));
+
+    // clear() forgets the fades
+    fader.clear();
+    QCOMPARE(fader.add(10, true, true), 0);
+    QCOMPARE(fader.current(0), uchar(0));
+}
+
+void PixelFader_Test::setTarget()
+{
+    PixelFader fader;
+    fader.add(0, false, false);
+
+    fader.setTarget(0, 200, 1000);
+    QCOMPARE(fader.start(0), uchar(0));
+    QCOMPARE(fader.target(0), uchar(200));
+    QCOMPARE(fader.fadeTime(0), uint(1000));
+    QCOMPARE(fader.elapsed(0), uint(0));
+
+    fader.advance(300);
+    QCOMPARE(fader.current(0), uchar(60));
+    QCOMPARE(fader.elapsed(0), uint(300));
+
+    // the same target: the fade goes on
+    fader.setTarget(0, 200, 1000);
+    QCOMPARE(fader.start(0), uchar(0));
+    QCOMPARE(fader.elapsed(0), uint(300));
+
+    // a new target: the fade restarts from the current value
+    fader.setTarget(0, 100, 500);
+    QCOMPARE(fader.start(0), uchar(60));
+    QCOMPARE(fader.target(0), uchar(100));
+    QCOMPARE(fader.fadeTime(0), uint(500));
+    QCOMPARE(fader.elapsed(0), uint(0));
+
+    fader.advance(250);
+    QCOMPARE(fader.current(0), uchar(80));
+
+    // elapsed time stops at the fade time
+    fader.advance(1000);
+    QCOMPARE(fader.current(0), uchar(100));
+    QCOMPARE(fader.elapsed(0), uint(500));
+
+    // no fade time: the target is reached at the next tick
+    fader.setTarget(0, 10, 0);
+    QCOMPARE(fader.current(0), uchar(100));
+    QCOMPARE(fader.fadeTime(0), uint(1));
+    fader.advance(20);
+    QCOMPARE(fader.current(0), uchar(10));
+}
+
+void PixelFader_Test::advance()
+{
+    // odd number of slots, to cover both the vector and the scalar code
+    const int starts[] = { 0, 255, 10, 200, 0, 128, 77 };
+    const int targets[] = { 255, 0, 250, 100, 1, 128, 3 };
+    const uint fades[] = { 1000, 500, 40, 333, 7, 100, 1234 };
+    const int count = 7;
+
+    PixelFader fader;
+    QList <FadeChannel> channels;
+
+    for (int i = 0; i < count; i++)
+    {
+        fader.add(i, false, false);
+        fader.setTarget(i, starts[i], 0);
+
+        FadeChannel fc(m_doc, Fixture::invalidId(), i);
+        fc.setStart(starts[i]);
+        fc.setCurrent(starts[i]);
+        fc.setTarget(targets[i]);
+        fc.setFadeTime(fades[i]);
+        channels << fc;
+    }
+    fader.advance(20);
+
+    for (int i = 0; i < count; i++)
+        fader.setTarget(i, targets[i], fades[i]);
+
+    // the values are the same as FadeChannel's, tick after tick
+    for (int tick = 0; tick < 70; tick++)
+    {
+        fader.advance(20);
+        for (int i = 0; i < count; i++)
+            QCOMPARE(fader.current(i), channels[i].nextStep(20));
+    }
+
+    // fractions that float and double round differently
+    // (49 * 1 / 49 vs 49 * (1 / 49)) give the same value too
+    fader.clear();
+    channels.clear();
+    for (int i = 0; i < 5; i++)
+    {
+        fader.add(i, false, false);
+        fader.setTarget(i, 49, 49);
+
+        FadeChannel fc(m_doc, Fixture::invalidId(), i);
+        fc.setTarget(49);
+        fc.setFadeTime(49);
+        channels << fc;
+    }
+
+    for (int tick = 0; tick < 50; tick++)
+    {
+        fader.advance(1);
+        for (int i = 0; i < 5; i++)
+            QCOMPARE(fader.current(i), channels[i].nextStep(1));
+    }
+}
+
+void PixelFader_Test::write()
+{
+    QList<Universe*> ua;
+    ua.append(new Universe(0, new GrandMaster()));
+    ua.append(new Universe(1, new GrandMaster()));
+    ua[1]->setChannelCapability(10, QLCChannel::Intensity);
+
+    PixelFader fader;
+    fader.add(5, false, false);
+    fader.add(UNIVERSE_SIZE + 10, true, true);
+
+    fader.setTarget(0, 255, 0);
+    fader.setTarget(1, 255, 1000);
+
+    QCOMPARE(ua[0]->preGMValues()[5], (char) 0);
+    QCOMPARE(ua[1]->preGMValues()[10], (char) 0);
+
+    // paused: nothing moves
+    fader.write(ua, true);
+    QCOMPARE(ua[0]->preGMValues()[5], (char) 0);
+    QCOMPARE(ua[1]->preGMValues()[10], (char) 0);
+
+    for (uint ms = MasterTimer::tick(); ms < 1000; ms += MasterTimer::tick())
+    {
+        ua[1]->zeroIntensityChannels();
+        fader.write(ua);
+        QCOMPARE(uchar(ua[0]->preGMValues()[5]), uchar(255));
+        QCOMPARE(uchar(ua[1]->preGMValues()[10]), uchar(floor(255.0 * ms / 1000.0)));
+    }
+
+    // Intensity channels at zero are not written at all
+    fader.setTarget(1, 0, 0);
+    ua[1]->zeroIntensityChannels();
+    fader.write(ua);
+    QCOMPARE(ua[1]->preGMValues()[10], (char) 0);
+    ua[1]->write(10, 42);
+    fader.write(ua);
+    QCOMPARE(ua[1]->preGMValues()[10], (char) 42);
+
+    // other channels are
+    fader.setTarget(0, 0, 0);
+    fader.write(ua);
+    QCOMPARE(ua[0]->preGMValues()[5], (char) 0);
+
+    // slots of missing universes are skipped
+    fader.add(2 * UNIVERSE_SIZE + 1, false, false);
+    fader.setTarget(0, 255, 0);
+    fader.setTarget(2, 255, 0);
+    fader.write(ua);
+    QCOMPARE(uchar(ua[0]->preGMValues()[5]), uchar(255));
+}
+
+void PixelFader_Test::writeBlended()
+{
+    QList<Universe*> ua;
+    ua.append(new Universe(0, new GrandMaster()));
+
+    PixelFader fader;
+    fader.add(5, false, false);
+    fader.add(6, true, true);
+    fader.setTarget(0, 100, 0);
+    fader.setTarget(1, 0, 0);
+
+    ua[0]->write(5, 100);
+    ua[0]->write(6, 100);
+    fader.setBlendMode(Universe::AdditiveBlend);
+    fader.write(ua);
+    QCOMPARE(uchar(ua[0]->preGMValues()[5]), uchar(200));
+    QCOMPARE(uchar(ua[0]->preGMValues()[6]), uchar(100));
+
+    // with a mask, zero Intensity channels are written
+    fader.setBlendMode(Universe::MaskBlend);
+    fader.write(ua);
+    QCOMPARE(uchar(ua[0]->preGMValues()[6]), uchar(0));
+}
+
+void PixelFader_Test::adjustIntensity()
+{
+    QList<Universe*> ua;
+    ua.append(new Universe(0, new GrandMaster()));
+
+    PixelFader fader;
+    QCOMPARE(fader.intensity(), qreal(1.0));
+
+    fader.add(1, false, true);
+    fader.add(2, true, true);
+    fader.add(3, true, false);
+    for (int i = 0; i < 3; i++)
+        fader.setTarget(i, 201, 0);
+
+    fader.adjustIntensity(0.5);
+    QCOMPARE(fader.intensity(), qreal(0.5));
+    fader.write(ua);
+
+    // only Intensity channels that can fade are adjusted
+    QCOMPARE(uchar(ua[0]->preGMValues()[1]), uchar(201));
+    QCOMPARE(uchar(ua[0]->preGMValues()[2]), uchar(101));
+    QCOMPARE(uchar(ua[0]->preGMValues()[3]), uchar(201));
+    QCOMPARE(fader.current(1), uchar(201));
+    QCOMPARE(fader.current(1, 0.5), uchar(101));
+}
+
+void PixelFader_Test::stepEfficiency_data()
+{
+    QTest::addColumn<bool>("pixelFader");
+
+    QTest::newRow("GenericFader") << false;
+    QTest::newRow("PixelFader") << true;
+}
+
+void PixelFader_Test::stepEfficiency()
+{
+    QFETCH(bool, pixelFader);
+
+    QList<Universe*> ua;
+    for (int i = 0; i < BENCH_UNIVERSES; i++)
+        ua.append(new Universe(i, new GrandMaster()));
+
+    // like a matrix: the channels are resolved once, then each
+    // iteration is a step change followed by a tick
+    QList <FadeChannel> channels;
+    PixelFader pixels;
+    GenericFader generic(m_doc);
+    for (int i = 0; i < BENCH_CHANNELS; i++)
+    {
+        channels << FadeChannel(m_doc, Fixture::invalidId(), i);
+        pixels.add(i, false, false);
+    }
+
+    int step = 0;
+    QBENCHMARK
+    {
+        for (int i = 0; i < BENCH_CHANNELS; i++)
+        {
+            uchar target = ((i / 3 + step) % 4 == 0) ? 255 : 0;
+
+            if (pixelFader)
+            {
+                pixels.setTarget(i, target, 200);
+            }
+            else
+            {
+                FadeChannelTable& table(generic.channels());
+                int index = table.indexOf(channels.at(i));
+                if (index == -1)
+                    index = table.insert(channels.at(i), QLCChannel::Colour, false);
+                table.setTarget(index, target, 200);
+            }
+        }
+
+        if (pixelFader)
+            pixels.write(ua);
+        else
+            generic.write(ua);
+
+        step++;
+    }
+
+    while (ua.isEmpty() == false)
+        delete ua.takeFirst();
+}
+
+QTEST_MAIN(PixelFader_Test)
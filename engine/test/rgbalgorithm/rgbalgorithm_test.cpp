@@ -25,6 +25,7 @@
 #define private public
 #include "rgbalgorithm_test.h"
 #include "rgbscriptscache.h"
+#include "rgbframecache.h"
 #include "rgbalgorithm.h"
 #ifdef QT_QML_LIB
   #include "rgbscriptv4.h"
@@ -58,6 +59,7 @@ void RGBAlgorithm_Test::algorithms()
     QStringList list = RGBAlgorithm::algorithms(m_doc);
     QVERIFY(list.contains("Text"));
     QVERIFY(list.contains("Image"));
+    QVERIFY(list.contains("Stream"));
     QVERIFY(list.contains("Stripes"));
     QVERIFY(list.contains("Opposite"));
     QVERIFY(list.contains("Random Single"));
@@ -183,4 +185,119 @@ void RGBAlgorithm_Test::loader()
     QVERIFY(algo == NULL);
 }
 
+void RGBAlgorithm_Test::frame()
+{
+    RGBFrame frame;
+    QVERIFY(frame.isEmpty() == true);
+    QCOMPARE(frame.toMap(), RGBMap());
+
+    frame.resize(QSize(5, 3));
+    QCOMPARE(frame.size(), QSize(5, 3));
+    QCOMPARE(frame.stride(), 8);
+    QVERIFY(frame.isEmpty() == false);
+
+    frame.fill(0x112233);
+    frame.setPixel(4, 2, 0xFF0000);
+    QCOMPARE(frame.pixel(0, 0), uint(0x112233));
+    QCOMPARE(frame.constScanLine(2)[4], uint(0xFF0000));
+
+    RGBMap map = frame.toMap();
+    QCOMPARE(map.size(), 3);
+    QCOMPARE(map[0].size(), 5);
+    QCOMPARE(map[1][3], uint(0x112233));
+    QCOMPARE(map[2][4], uint(0xFF0000));
+
+    // shrinking keeps the buffer
+    const uint *bits = frame.constScanLine(0);
+    frame.resize(QSize(4, 2));
+    QCOMPARE(frame.stride(), 4);
+    QVERIFY(frame.constScanLine(0) == bits);
+
+    // rows shorter than the longest are padded with black
+    map[1].resize(2);
+    frame.fromMap(map);
+    QCOMPARE(frame.size(), QSize(5, 3));
+    QCOMPARE(frame.pixel(1, 1), uint(0x112233));
+    QCOMPARE(frame.pixel(2, 1), uint(0));
+    QCOMPARE(frame.pixel(4, 2), uint(0xFF0000));
+
+    // the RGBMap shim matches the rendered frame
+    RGBAlgorithm* algo = RGBAlgorithm::algorithm(m_doc, "Stripes");
+    QVERIFY(algo != NULL);
+    for (int step = 0; step < 3; step++)
+    {
+        algo->renderMap(QSize(6, 4), 0x00FF00, step, frame);
+        QCOMPARE(frame.size(), QSize(6, 4));
+        QCOMPARE(algo->rgbMap(QSize(6, 4), 0x00FF00, step), frame.toMap());
+    }
+    delete algo;
+}
+
+void RGBAlgorithm_Test::frameCache()
+{
+    RGBFrame frame;
+    frame.resize(QSize(4, 4));
+    frame.fill(0x00FF00);
+
+    // a disabled cache keeps nothing
+    RGBFrameCache cache;
+    QCOMPARE(cache.budget(), 0);
+    cache.insert(QSize(4, 4), 0x00FF00, 0, 0, frame);
+    QCOMPARE(cache.count(), 0);
+
+    // room for two 4x4 frames
+    cache.setBudget(2 * 4 * 4 * sizeof(uint));
+    QVERIFY(cache.frame(QSize(4, 4), 0x00FF00, 0, 0) == NULL);
+    cache.insert(QSize(4, 4), 0x00FF00, 0, 0, frame);
+    QCOMPARE(cache.count(), 1);
+    QCOMPARE(cache.memoryUsage(), int(4 * 4 * sizeof(uint)));
+
+    const RGBFrame *cached = cache.frame(QSize(4, 4), 0x00FF00, 0, 0);
+    QVERIFY(cached != NULL);
+    QCOMPARE(cached->pixel(3, 3), uint(0x00FF00));
+
+    // size, color and step are all part of the key
+    QVERIFY(cache.frame(QSize(4, 3), 0x00FF00, 0, 0) == NULL);
+    QVERIFY(cache.frame(QSize(4, 4), 0xFF0000, 0, 0) == NULL);
+    QVERIFY(cache.frame(QSize(4, 4), 0x00FF00, 1, 0) == NULL);
+
+    // the least recently used frame is evicted first
+    cache.insert(QSize(4, 4), 0x00FF00, 1, 0, frame);
+    QVERIFY(cache.frame(QSize(4, 4), 0x00FF00, 0, 0) != NULL);
+    cache.insert(QSize(4, 4), 0x00FF00, 2, 0, frame);
+    QCOMPARE(cache.count(), 2);
+    QVERIFY(cache.frame(QSize(4, 4), 0x00FF00, 0, 0) != NULL);
+    QVERIFY(cache.frame(QSize(4, 4), 0x00FF00, 1, 0) == NULL);
+    QVERIFY(cache.frame(QSize(4, 4), 0x00FF00, 2, 0) != NULL);
+
+    // frames larger than the budget are not cached
+    RGBFrame big;
+    big.resize(QSize(8, 8));
+    cache.insert(QSize(8, 8), 0x00FF00, 0, 0, big);
+    QVERIFY(cache.frame(QSize(8, 8), 0x00FF00, 0, 0) == NULL);
+    QCOMPARE(cache.count(), 2);
+
+    // a new revision drops everything
+    QVERIFY(cache.frame(QSize(4, 4), 0x00FF00, 0, 1) == NULL);
+    QCOMPARE(cache.count(), 0);
+
+    // algorithm revisions follow their settings
+    RGBAlgorithm* algo = RGBAlgorithm::algorithm(m_doc, "Stripes");
+    QVERIFY(algo != NULL);
+    QVERIFY(algo->isDeterministic() == true);
+    uint revision = algo->revision();
+    algo->setColors(QColor(Qt::red), QColor(Qt::blue));
+    QVERIFY(algo->revision() != revision);
+    revision = algo->revision();
+    RGBScript* script = static_cast<RGBScript*>(algo);
+    QVERIFY(script->setProperty("orientation", "Vertical") == true);
+    QVERIFY(algo->revision() != revision);
+    delete algo;
+
+    algo = RGBAlgorithm::algorithm(m_doc, "Random Single");
+    QVERIFY(algo != NULL);
+    QVERIFY(algo->isDeterministic() == false);
+    delete algo;
+}
+
 QTEST_MAIN(RGBAlgorithm_Test)
@@ -35,6 +35,8 @@ private slots:
     void algorithms();
     void algorithm();
     void loader();
+    void frame();
+    void frameCache();
 private:
    Doc * m_doc;
 };
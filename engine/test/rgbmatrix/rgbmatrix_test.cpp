@@ -28,6 +28,7 @@
 #include "qlcfixturemode.h"
 #include "qlcfixturedef.h"
 #include "fixturegroup.h"
+#include "pixelfader.h"
 #include "mastertimer.h"
 #include "rgbmatrix.h"
 #include "fixture.h"
@@ -174,6 +175,88 @@ void RGBMatrix_Test::previewMaps()
     }
 }
 
+void RGBMatrix_Test::mapChannels()
+{
+    RGBMatrix mtx(m_doc);
+    mtx.setFixtureGroup(0);
+    mtx.setFadeInSpeed(1000);
+    mtx.setFadeOutSpeed(500);
+    QVERIFY(mtx.m_mapDirty == true);
+
+    mtx.m_group = m_doc->fixtureGroup(0);
+    mtx.compileMap();
+    QVERIFY(mtx.m_mapDirty == false);
+    QCOMPARE(mtx.m_mapSize, QSize(5, 5));
+
+    // LED PAR56 heads have RGB channels and no dimmer
+    QCOMPARE(mtx.m_mapPixels.size(), 26);
+    QCOMPARE(mtx.m_mapChannels.size(), 75);
+    for (int i = 0; i < 25; i++)
+        QCOMPARE(mtx.m_mapPixels.at(i), i * 3);
+    QCOMPARE(mtx.m_mapPixels.last(), 75);
+
+    Fixture* fxi = m_doc->fixture(m_doc->fixtureGroup(0)->head(QLCPoint(0, 0)).fxi);
+    QVERIFY(fxi != NULL);
+    QCOMPARE(mtx.m_mapChannels.at(0).m_address, fxi->address() + 1);
+    QCOMPARE(mtx.m_mapChannels.at(0).m_component, RGBMatrix::MapRed);
+    QCOMPARE(mtx.m_mapChannels.at(1).m_address, fxi->address() + 2);
+    QCOMPARE(mtx.m_mapChannels.at(1).m_component, RGBMatrix::MapGreen);
+    QCOMPARE(mtx.m_mapChannels.at(2).m_address, fxi->address() + 3);
+    QCOMPARE(mtx.m_mapChannels.at(2).m_component, RGBMatrix::MapBlue);
+
+    RGBFrame frame(QSize(5, 5));
+    frame.fill(0);
+    frame.setPixel(0, 0, qRgb(255, 128, 0));
+
+    // compiling the map sets up a fader slot for each channel
+    mtx.m_fader = new PixelFader();
+    mtx.compileMap();
+    QCOMPARE(mtx.m_mapSlots, 75);
+    QCOMPARE(mtx.m_fader->count(), 75);
+    mtx.updateMapChannels(frame, mtx.m_group);
+
+    int red = mtx.m_mapChannels.at(0).m_slot;
+    int green = mtx.m_mapChannels.at(1).m_slot;
+    int blue = mtx.m_mapChannels.at(2).m_slot;
+    PixelFader *fader = mtx.m_fader;
+    QCOMPARE(fader->universe(red), fxi->universe());
+    QCOMPARE(fader->addressInUniverse(red), fxi->address() + 1);
+    QCOMPARE(fader->target(red), uchar(255));
+    QCOMPARE(fader->fadeTime(red), uint(1000));
+    QCOMPARE(fader->target(green), uchar(128));
+    QCOMPARE(fader->target(blue), uchar(0));
+    QCOMPARE(fader->fadeTime(blue), uint(500));
+
+    // a fade towards the same target goes on
+    fader->advance(500);
+    QCOMPARE(fader->current(red), uchar(127));
+    QCOMPARE(fader->current(green), uchar(64));
+    mtx.updateMapChannels(frame, mtx.m_group);
+    QCOMPARE(fader->start(red), uchar(0));
+    QCOMPARE(fader->elapsed(red), uint(500));
+
+    // a new target restarts the fade from the current value
+    frame.setPixel(0, 0, qRgb(0, 0, 0));
+    mtx.updateMapChannels(frame, mtx.m_group);
+    QCOMPARE(fader->start(red), uchar(127));
+    QCOMPARE(fader->target(red), uchar(0));
+    QCOMPARE(fader->elapsed(red), uint(0));
+
+    fader->advance(250);
+    QCOMPARE(fader->current(red), uchar(64));
+    fader->advance(250);
+    QCOMPARE(fader->current(red), uchar(0));
+
+    // changing the dimmer control compiles the map again
+    mtx.setDimmerControl(false);
+    QVERIFY(mtx.m_mapDirty == true);
+    mtx.updateMapChannels(frame, mtx.m_group);
+    QVERIFY(mtx.m_mapDirty == false);
+
+    delete mtx.m_fader;
+    mtx.m_fader = NULL;
+}
+
 void RGBMatrix_Test::loadSave()
 {
     RGBMatrix* mtx = new RGBMatrix(m_doc);
@@ -21,6 +21,7 @@
 
 #define private public
 #include "rgbscript_test.h"
+#include "rgbnativescript.h"
 #include "rgbscriptscache.h"
 #ifdef QT_QML_LIB
   #include "rgbscriptv4.h"
@@ -194,4 +195,259 @@ void RGBScript_Test::rgbMap()
     }
 }
 
+void RGBScript_Test::flatMap()
+{
+    // rgbMap() returning a flat array of width * height pixels
+    QString code("( function() { var algo = new Object; algo.apiVersion = 1;"
+                 "algo.rgbMapStepCount = function(width, height) { return 1; };"
+                 "algo.rgbMap = function(width, height, rgb, step) {"
+                 "  var map = new Array(width * height);"
+                 "  for (var i = 0; i < width * height; i++) map[i] = i + rgb;"
+                 "  return map; };"
+                 "return algo; } )()");
+    RGBScript s(m_doc);
+    s.m_contents = code;
+    QCOMPARE(s.evaluate(), true);
+
+    RGBFrame frame;
+    s.renderMap(QSize(7, 3), 0x100, 0, frame);
+    QCOMPARE(frame.size(), QSize(7, 3));
+    for (int y = 0; y < 3; y++)
+        for (int x = 0; x < 7; x++)
+            QCOMPARE(frame.pixel(x, y), uint(0x100 + y * 7 + x));
+
+#ifdef QT_QML_LIB
+    // rgbMap() returning a Uint32Array
+    code = QString("( function() { var algo = new Object; algo.apiVersion = 1;"
+                   "algo.rgbMapStepCount = function(width, height) { return 1; };"
+                   "algo.rgbMap = function(width, height, rgb, step) {"
+                   "  var map = new Uint32Array(width * height);"
+                   "  for (var i = 0; i < width * height; i++) map[i] = 0xFF000000 + i;"
+                   "  return map; };"
+                   "return algo; } )()");
+    s.m_contents = code;
+    QCOMPARE(s.evaluate(), true);
+
+    s.renderMap(QSize(7, 3), 0, 0, frame);
+    QCOMPARE(frame.size(), QSize(7, 3));
+    for (int y = 0; y < 3; y++)
+        for (int x = 0; x < 7; x++)
+            QCOMPARE(frame.pixel(x, y), uint(0xFF000000 + y * 7 + x));
+
+    // other typed arrays are converted, not copied
+    code = QString("( function() { var algo = new Object; algo.apiVersion = 1;"
+                   "algo.rgbMapStepCount = function(width, height) { return 1; };"
+                   "algo.rgbMap = function(width, height, rgb, step) {"
+                   "  var map = new Float32Array(width * height);"
+                   "  for (var i = 0; i < width * height; i++) map[i] = 0x100 + i;"
+                   "  return map; };"
+                   "return algo; } )()");
+    s.m_contents = code;
+    QCOMPARE(s.evaluate(), true);
+
+    s.renderMap(QSize(7, 3), 0, 0, frame);
+    QCOMPARE(frame.size(), QSize(7, 3));
+    for (int y = 0; y < 3; y++)
+        for (int x = 0; x < 7; x++)
+            QCOMPARE(frame.pixel(x, y), uint(0x100 + y * 7 + x));
+#endif
+}
+
+void RGBScript_Test::ownEngine()
+{
+    RGBScript s = m_doc->rgbScriptsCache()->script("Stripes");
+    QVERIFY(s.engine() == s.s_engine);
+    {
+        // the script runs on the shared engine, which is locked too
+        RGBScript::EngineLocker locker(&s);
+        QVERIFY(locker.m_sharedMutex == s.s_engineMutex);
+    }
+
+    s.setProperty("orientation", "Vertical");
+    RGBMap shared = s.rgbMap(QSize(5, 5), QColor(Qt::red).rgb(), 2);
+
+    // a running script gets an engine of its own, built on a worker
+    // thread, and keeps its properties
+    s.preRun();
+    s.waitForEngine();
+    QVERIFY(s.engine() != s.s_engine);
+    {
+        RGBScript::EngineLocker locker(&s);
+        QVERIFY(locker.m_sharedMutex == NULL);
+    }
+    QCOMPARE(s.apiVersion(), 2);
+    QCOMPARE(s.name(), QString("Stripes"));
+    QCOMPARE(s.property("orientation"), QString("Vertical"));
+    QCOMPARE(s.rgbMap(QSize(5, 5), QColor(Qt::red).rgb(), 2), shared);
+
+    // a stopped script goes back to the shared engine
+    s.setProperty("orientation", "Horizontal");
+    s.postRun();
+    QVERIFY(s.engine() == s.s_engine);
+    QVERIFY(s.m_engineBuilder.isNull() == true);
+    QCOMPARE(s.property("orientation"), QString("Horizontal"));
+    QCOMPARE(s.name(), QString("Stripes"));
+
+    // an engine built for a script that stopped meanwhile is dropped
+    s.preRun();
+    s.postRun();
+    s.waitForEngine();
+    QVERIFY(s.engine() == s.s_engine);
+
+    // the cached script is untouched
+    RGBScript cached = m_doc->rgbScriptsCache()->script("Stripes");
+    QVERIFY(cached.engine() == cached.s_engine);
+}
+
+void RGBScript_Test::nativeScripts()
+{
+    QVERIFY(m_doc->rgbScriptsCache()->load(QDir(INTERNAL_SCRIPTDIR)));
+
+    QStringList names;
+    names << "Plasma" << "Plasma (Colors)" << "Waves" << "3D Starfield" << "Balls" << "Noise";
+    foreach (QString name, names)
+    {
+        const RGBScript& cached = m_doc->rgbScriptsCache()->script(name);
+        QVERIFY(dynamic_cast<const RGBNativeScript*>(&cached) != NULL);
+
+        // clones are native too, and keep the script identity
+        RGBAlgorithm* algo = RGBAlgorithm::algorithm(m_doc, name);
+        RGBNativeScript* native = dynamic_cast<RGBNativeScript*>(algo);
+        QVERIFY(native != NULL);
+        QCOMPARE(native->type(), RGBAlgorithm::Script);
+        QCOMPARE(native->name(), name);
+        QCOMPARE(native->properties().count(), cached.m_properties.count());
+
+        // no script engine is needed to run
+        native->preRun();
+        QVERIFY(native->m_engine.isNull() == true);
+
+        RGBFrame frame;
+        for (int step = 0; step < 10; step++)
+        {
+            native->renderMap(QSize(12, 7), 0xFF00FF, step, frame);
+            QCOMPARE(frame.size(), QSize(12, 7));
+        }
+        delete algo;
+    }
+
+    // property values are the ones of the script
+    RGBScript* waves = static_cast<RGBScript*>(RGBAlgorithm::algorithm(m_doc, "Waves"));
+    QVERIFY(waves->setProperty("direction", "Out") == true);
+    QCOMPARE(waves->property("direction"), QString("Out"));
+    QVERIFY(waves->setProperty("foo", "bar") == false);
+    QCOMPARE(waves->propertiesAsStrings().value("direction"), QString("Out"));
+    delete waves;
+
+    // a script that doesn't match its native implementation stays a script
+    RGBNativeScript* native = RGBNativeScript::create(m_doc, "waves.js");
+    QVERIFY(native != NULL);
+    native->m_contents = QString("( function() { var algo = new Object; algo.apiVersion = 1;"
+                                 "algo.name = \"Waves\";"
+                                 "algo.rgbMapStepCount = function(width, height) { return 1; };"
+                                 "algo.rgbMap = function(width, height, rgb, step) { return [[rgb]]; };"
+                                 "return algo; } )()");
+    QCOMPARE(native->evaluate(), true);
+    QVERIFY(native->isValid() == false);
+    delete native;
+
+    QVERIFY(RGBNativeScript::create(m_doc, "stripes.js") == NULL);
+}
+
+void RGBScript_Test::nativeMatchesScript_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<QStringList>("properties");
+
+    QTest::newRow("Plasma") << "plasma.js" << QSize(17, 9) << QStringList();
+    QTest::newRow("Plasma Fire") << "plasma.js" << QSize(8, 30)
+        << (QStringList() << "presetIndex" << "Fire" << "presetSize" << "12" << "ramp" << "27" << "stepsize" << "44");
+    QTest::newRow("Plasma Colors") << "plasmacolors.js" << QSize(20, 20)
+        << (QStringList() << "color2Index" << "Teal" << "ramp" << "10" << "color5Index" << "Foo");
+    QTest::newRow("Waves") << "waves.js" << QSize(9, 6) << QStringList();
+    QTest::newRow("Waves In") << "waves.js" << QSize(10, 7)
+        << (QStringList() << "direction" << "In" << "taillength" << "30");
+    QTest::newRow("Waves Out") << "waves.js" << QSize(9, 6)
+        << (QStringList() << "direction" << "Out" << "orientation" << "Vertical");
+    QTest::newRow("Waves Left") << "waves.js" << QSize(10, 7)
+        << (QStringList() << "direction" << "Left" << "tailfade" << "No");
+}
+
+void RGBScript_Test::nativeMatchesScript()
+{
+    QFETCH(QString, fileName);
+    QFETCH(QSize, size);
+    QFETCH(QStringList, properties);
+
+    RGBScript script(m_doc);
+    QVERIFY(script.load(QDir(INTERNAL_SCRIPTDIR), fileName));
+    RGBNativeScript* native = RGBNativeScript::create(m_doc, fileName);
+    QVERIFY(native != NULL);
+    QVERIFY(native->load(QDir(INTERNAL_SCRIPTDIR), fileName));
+    QVERIFY(native->isValid());
+
+    for (int i = 0; i + 1 < properties.count(); i += 2)
+    {
+        QVERIFY(script.setProperty(properties.at(i), properties.at(i + 1)));
+        QVERIFY(native->setProperty(properties.at(i), properties.at(i + 1)));
+    }
+
+    int steps = script.rgbMapStepCount(size);
+    QCOMPARE(native->rgbMapStepCount(size), steps);
+
+    // both render the same frames, step after step
+    RGBFrame expected, frame;
+    for (int step = 0; step < qMin(steps, 40); step++)
+    {
+        script.renderMap(size, 0xFFFF8040, step, expected);
+        native->renderMap(size, 0xFFFF8040, step, frame);
+        QCOMPARE(frame.toMap(), expected.toMap());
+    }
+
+    delete native;
+}
+
+void RGBScript_Test::renderEfficiency_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<bool>("native");
+
+    QStringList files;
+    files << "plasma.js" << "plasmacolors.js" << "waves.js"
+          << "starfield.js" << "balls.js" << "noise.js";
+    foreach (QString file, files)
+    {
+        QTest::newRow(QString("%1 script").arg(file).toLatin1()) << file << false;
+        QTest::newRow(QString("%1 native").arg(file).toLatin1()) << file << true;
+    }
+}
+
+void RGBScript_Test::renderEfficiency()
+{
+    QFETCH(QString, fileName);
+    QFETCH(bool, native);
+
+    RGBScript* script = native ? RGBNativeScript::create(m_doc, fileName) : new RGBScript(m_doc);
+    QVERIFY(script != NULL);
+    QVERIFY(script->load(QDir(INTERNAL_SCRIPTDIR), fileName));
+    script->preRun();
+    script->waitForEngine();
+
+    // a 32x32 pixels matrix
+    RGBFrame frame;
+    QSize size(32, 32);
+    int steps = script->rgbMapStepCount(size);
+    int step = 0;
+
+    QBENCHMARK
+    {
+        script->renderMap(size, 0xFFFF8040, step, frame);
+        step = (step + 1) % steps;
+    }
+
+    QCOMPARE(frame.size(), size);
+    delete script;
+}
+
 QTEST_MAIN(RGBScript_Test)
@@ -41,6 +41,13 @@ private slots:
     void evaluateInvalidApiVersion();
     void rgbMapStepCount();
     void rgbMap();
+    void flatMap();
+    void ownEngine();
+    void nativeScripts();
+    void nativeMatchesScript_data();
+    void nativeMatchesScript();
+    void renderEfficiency_data();
+    void renderEfficiency();
 
 private:
     Doc * m_doc;
@@ -0,0 +1,345 @@
+/*
+  Q Light Controller Plus - Unit tests
+  rgbstream_test.cpp
+
+  Copyright (C) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QtTest>
+#include <QImage>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+#define private public
+#include "rgbstream_test.h"
+#include "rgbstream.h"
+#undef private
+
+#include "doc.h"
+
+/** Check that all the pixels of $frame are $rgb */
+static bool isSolid(const RGBFrame& frame, uint rgb)
+{
+    for (int y = 0; y < frame.height(); y++)
+    {
+        for (int x = 0; x < frame.width(); x++)
+        {
+            if (frame.pixel(x, y) != rgb)
+                return false;
+        }
+    }
+    return true;
+}
+
+/** Wait up to a second for the prefetcher to decode frame $index */
+static bool waitPrefetched(RGBStream& stream, int index)
+{
+    for (int wait = 0; wait < 100; wait++)
+    {
+        {
+            QMutexLocker locker(&stream.m_mutex);
+            for (int i = 0; i < stream.m_ring.size(); i++)
+            {
+                if (stream.m_ring.at(i).m_state == RGBStream::Slot::Ready &&
+                    stream.m_ring.at(i).m_index == index)
+                    return true;
+            }
+        }
+        QTest::qWait(10);
+    }
+    return false;
+}
+
+void RGBStream_Test::initTestCase()
+{
+    m_doc = new Doc(this);
+    QVERIFY(m_dir.isValid());
+
+    // images larger than the matrix, to be scaled down
+    QDir dir(m_dir.path());
+    QVERIFY(dir.mkdir("sequence"));
+    m_sequence = dir.absoluteFilePath("sequence");
+
+    QList <QColor> colors;
+    colors << Qt::red << Qt::green << Qt::blue;
+    for (int i = 0; i < colors.size(); i++)
+    {
+        QImage image(8, 4, QImage::Format_RGB32);
+        image.fill(colors.at(i));
+        QVERIFY(image.save(QString("%1/frame%2.png").arg(m_sequence).arg(i)));
+    }
+
+    // files that are not images are not part of the sequence
+    QFile text(QString("%1/readme.txt").arg(m_sequence));
+    QVERIFY(text.open(QIODevice::WriteOnly));
+    text.write("Foo");
+    text.close();
+
+    m_raw = dir.absoluteFilePath("stream.rgb");
+    QFile raw(m_raw);
+    QVERIFY(raw.open(QIODevice::WriteOnly));
+    QByteArray data;
+    for (int i = 0; i < 2 * 3 * 2; i++)
+        data.append(char(i)).append(char(0x10 * i)).append(char(0xFF - i));
+    raw.write(data);
+    raw.close();
+}
+
+void RGBStream_Test::cleanupTestCase()
+{
+    delete m_doc;
+}
+
+void RGBStream_Test::initial()
+{
+    RGBStream stream(m_doc);
+    QCOMPARE(stream.source(), QString());
+    QCOMPARE(stream.name(), QString("Stream"));
+    QCOMPARE(stream.author(), QString("Massimo Callegari"));
+    QCOMPARE(stream.apiVersion(), 1);
+    QCOMPARE(stream.type(), RGBAlgorithm::Stream);
+    QCOMPARE(stream.acceptColors(), 0);
+    QVERIFY(stream.isDeterministic() == false);
+
+    QCOMPARE(stream.frameCount(QSize(5, 5)), 0);
+    QCOMPARE(stream.rgbMapStepCount(QSize(5, 5)), 1);
+
+    RGBFrame frame;
+    stream.renderMap(QSize(5, 5), 0, 0, frame);
+    QVERIFY(frame.isEmpty() == true);
+
+    // a source that doesn't exist plays nothing
+    stream.setSource("/foo/bar/baz.rgb");
+    QCOMPARE(stream.source(), QString("/foo/bar/baz.rgb"));
+    QCOMPARE(stream.frameCount(QSize(5, 5)), 0);
+}
+
+void RGBStream_Test::imageSequence()
+{
+    RGBStream stream(m_doc);
+    uint revision = stream.revision();
+    stream.setSource(m_sequence);
+    QVERIFY(stream.revision() != revision);
+
+    QCOMPARE(stream.frameCount(QSize(4, 2)), 3);
+    QCOMPARE(stream.rgbMapStepCount(QSize(4, 2)), 3);
+    QCOMPARE(stream.m_files.size(), 3);
+    QVERIFY(stream.m_files.at(0).endsWith("frame0.png"));
+    QVERIFY(stream.m_files.at(2).endsWith("frame2.png"));
+
+    RGBFrame frame;
+    stream.renderMap(QSize(4, 2), 0, 0, frame);
+    QCOMPARE(frame.size(), QSize(4, 2));
+    QVERIFY(isSolid(frame, 0xFF0000));
+
+    stream.renderMap(QSize(4, 2), 0, 1, frame);
+    QVERIFY(isSolid(frame, 0x00FF00));
+
+    stream.renderMap(QSize(4, 2), 0, 2, frame);
+    QVERIFY(isSolid(frame, 0x0000FF));
+
+    // a copy plays the same sequence
+    RGBAlgorithm *algo = stream.clone();
+    RGBStream *copy = static_cast<RGBStream*> (algo);
+    QCOMPARE(copy->source(), m_sequence);
+    QCOMPARE(copy->frameCount(QSize(4, 2)), 3);
+    delete algo;
+}
+
+void RGBStream_Test::rawFile()
+{
+    RGBStream stream(m_doc);
+    stream.setSource(m_raw);
+    QVERIFY(stream.m_raw != NULL);
+
+    // frames are at the matrix resolution, only whole frames are played
+    QCOMPARE(stream.frameCount(QSize(3, 2)), 2);
+    QCOMPARE(stream.frameCount(QSize(2, 2)), 3);
+    QCOMPARE(stream.frameCount(QSize(5, 5)), 0);
+
+    RGBFrame frame;
+    for (int step = 0; step < 2; step++)
+    {
+        stream.renderMap(QSize(3, 2), 0, step, frame);
+        QCOMPARE(frame.size(), QSize(3, 2));
+        for (int y = 0; y < 2; y++)
+        {
+            for (int x = 0; x < 3; x++)
+            {
+                uint i = step * 6 + y * 3 + x;
+                QCOMPARE(frame.pixel(x, y), (i << 16) | ((0x10 * i & 0xFF) << 8) | (0xFF - i));
+            }
+        }
+    }
+
+    stream.setSource(QString());
+    QVERIFY(stream.m_raw == NULL);
+    QCOMPARE(stream.frameCount(QSize(3, 2)), 0);
+}
+
+void RGBStream_Test::prefetch()
+{
+    RGBStream stream(m_doc);
+    stream.setSource(m_sequence);
+    QVERIFY(stream.m_prefetcher == NULL);
+
+    stream.preRun();
+    QVERIFY(stream.m_prefetcher != NULL);
+
+    // the first frame is decoded right away, the following ones
+    // are decoded by the prefetcher
+    RGBFrame frame;
+    stream.renderMap(QSize(4, 2), 0, 0, frame);
+    QVERIFY(isSolid(frame, 0xFF0000));
+    QCOMPARE(stream.m_nextFrame, 1);
+
+    for (int step = 1; step < 5; step++)
+    {
+        int index = step % 3;
+        QVERIFY(waitPrefetched(stream, index) == true);
+
+        stream.renderMap(QSize(4, 2), 0, step, frame);
+        QVERIFY(isSolid(frame, index == 0 ? 0xFF0000 : index == 1 ? 0x00FF00 : 0x0000FF));
+    }
+    QCOMPARE(stream.droppedFrames(), 0);
+
+    // playing backward prefetches the previous frames
+    stream.renderMap(QSize(4, 2), 0, 3, frame);
+    QCOMPARE(stream.m_direction, -1);
+    QCOMPARE(stream.m_nextFrame, 2);
+
+    // a preview gets the requested frame and leaves playback alone
+    RGBMap preview = stream.rgbMap(QSize(4, 2), 0, 4);
+    QCOMPARE(preview[0][0], uint(0x00FF00));
+    QCOMPARE(stream.m_lastStep, 3);
+    QCOMPARE(stream.m_direction, -1);
+    QCOMPARE(stream.m_nextFrame, 2);
+    QCOMPARE(stream.droppedFrames(), 0);
+
+    // changing the source keeps the prefetcher running
+    stream.setSource(m_raw);
+    QVERIFY(stream.m_prefetcher != NULL);
+    stream.renderMap(QSize(3, 2), 0, 0, frame);
+    QCOMPARE(frame.pixel(0, 0), uint(0x0000FF));
+
+    // with the prefetcher halted and the ring empty, the next frame is
+    // late: it is dropped and counted, and the previous one is held
+    {
+        QMutexLocker locker(&stream.m_mutex);
+        stream.m_prefetching = false;
+        stream.m_wake.wakeAll();
+    }
+    stream.m_prefetcher->wait();
+    for (int i = 0; i < stream.m_ring.size(); i++)
+        stream.m_ring[i].m_state = RGBStream::Slot::Free;
+
+    int dropped = stream.droppedFrames();
+    stream.renderMap(QSize(3, 2), 0, 1, frame);
+    QCOMPARE(frame.pixel(0, 0), uint(0x0000FF));
+    QCOMPARE(stream.droppedFrames(), dropped + 1);
+
+    stream.postRun();
+    QVERIFY(stream.m_prefetcher == NULL);
+
+    // a new run starts counting again
+    stream.preRun();
+    QCOMPARE(stream.droppedFrames(), 0);
+    stream.postRun();
+}
+
+void RGBStream_Test::save()
+{
+    RGBStream stream(m_doc);
+    stream.setSource(m_raw);
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly | QIODevice::Text);
+    QXmlStreamWriter xmlWriter(&buffer);
+
+    QVERIFY(stream.saveXML(&xmlWriter) == true);
+
+    xmlWriter.setDevice(NULL);
+    buffer.close();
+
+    buffer.open(QIODevice::ReadOnly | QIODevice::Text);
+    QXmlStreamReader xmlReader(&buffer);
+    xmlReader.readNextStartElement();
+
+    QCOMPARE(xmlReader.name().toString(), QString("Algorithm"));
+    QCOMPARE(xmlReader.attributes().value("Type").toString(), QString("Stream"));
+
+    int source = 0;
+    while (xmlReader.readNextStartElement())
+    {
+        if (xmlReader.name() == "Source")
+        {
+            QCOMPARE(xmlReader.readElementText(), m_raw);
+            source++;
+        }
+        else
+        {
+            QFAIL(QString("Unexpected tag: %1").arg(xmlReader.name().toString()).toUtf8().constData());
+        }
+    }
+
+    QCOMPARE(source, 1);
+}
+
+void RGBStream_Test::load()
+{
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly | QIODevice::Text);
+    QXmlStreamWriter xmlWriter(&buffer);
+
+    xmlWriter.writeStartElement("Algorithm");
+    xmlWriter.writeAttribute("Type", "Stream");
+    xmlWriter.writeTextElement("Source", m_sequence);
+    xmlWriter.writeTextElement("Foo", "Bar");
+    xmlWriter.writeEndElement();
+
+    xmlWriter.setDevice(NULL);
+    buffer.close();
+
+    buffer.open(QIODevice::ReadOnly | QIODevice::Text);
+    QXmlStreamReader xmlReader(&buffer);
+    xmlReader.readNextStartElement();
+
+    RGBAlgorithm *algo = RGBAlgorithm::loader(m_doc, xmlReader);
+    QVERIFY(algo != NULL);
+    QCOMPARE(algo->type(), RGBAlgorithm::Stream);
+    RGBStream *stream = static_cast<RGBStream*> (algo);
+    QCOMPARE(stream->source(), m_sequence);
+    QCOMPARE(stream->frameCount(QSize(4, 2)), 3);
+    delete algo;
+
+    // wrong type
+    buffer.setData(QByteArray());
+    buffer.open(QIODevice::WriteOnly | QIODevice::Text);
+    xmlWriter.setDevice(&buffer);
+    xmlWriter.writeStartElement("Algorithm");
+    xmlWriter.writeAttribute("Type", "Image");
+    xmlWriter.writeEndElement();
+    xmlWriter.setDevice(NULL);
+    buffer.close();
+
+    buffer.open(QIODevice::ReadOnly | QIODevice::Text);
+    xmlReader.setDevice(&buffer);
+    xmlReader.readNextStartElement();
+
+    RGBStream other(m_doc);
+    QVERIFY(other.loadXML(xmlReader) == false);
+}
+
+QTEST_MAIN(RGBStream_Test)
@@ -0,0 +1,53 @@
+/*
+  Q Light Controller Plus - Unit tests
+  rgbstream_test.h
+
+  Copyright (C) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef RGBSTREAM_TEST_H
+#define RGBSTREAM_TEST_H
+
+#include <QTemporaryDir>
+#include <QObject>
+
+class Doc;
+class RGBStream_Test : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void initial();
+    void imageSequence();
+    void rawFile();
+    void prefetch();
+    void save();
+    void load();
+
+private:
+    Doc * m_doc;
+    QTemporaryDir m_dir;
+
+    /** Directory of 3 solid red, green and blue images */
+    QString m_sequence;
+
+    /** Raw file of 2 frames of 3x2 pixels */
+    QString m_raw;
+};
+
+#endif
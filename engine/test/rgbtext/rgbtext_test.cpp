@@ -424,4 +424,68 @@ void RGBText_Test::verticalScroll()
     }
 }
 
+void RGBText_Test::cache()
+{
+    RGBText text(m_doc);
+    text.setText("QLC");
+    text.setAnimationStyle(RGBText::StaticLetters);
+
+    // the letters are drawn once, in a strip of matrix sized cells
+    RGBFrame frame;
+    text.renderMap(QSize(10, 8), 0xFF0000, 0, frame);
+    QCOMPARE(text.m_cache.size(), QSize(30, 8));
+    QCOMPARE(text.m_cacheRevision, text.revision());
+    qint64 key = text.m_cache.cacheKey();
+
+    // other steps and colors reuse it
+    RGBFrame green;
+    text.renderMap(QSize(10, 8), 0x00FF00, 0, green);
+    text.renderMap(QSize(10, 8), 0x00FF00, 2, frame);
+    QCOMPARE(text.m_cache.cacheKey(), key);
+
+    // the same pixels are lit, with the requested color
+    RGBFrame red;
+    text.renderMap(QSize(10, 8), 0xFF0000, 0, red);
+    bool lit = false;
+    for (int y = 0; y < 8; y++)
+    {
+        for (int x = 0; x < 10; x++)
+        {
+            QCOMPARE(qRed(green.pixel(x, y)), 0);
+            QCOMPARE(qGreen(red.pixel(x, y)), 0);
+            QCOMPARE(qGreen(green.pixel(x, y)), qRed(red.pixel(x, y)));
+            if (qRed(red.pixel(x, y)) != 0)
+                lit = true;
+        }
+    }
+    QVERIFY(lit == true);
+
+    // a different size or different settings draw the text again
+    text.renderMap(QSize(12, 8), 0xFF0000, 0, frame);
+    QCOMPARE(text.m_cache.size(), QSize(36, 8));
+    key = text.m_cache.cacheKey();
+
+    text.setText("QLC+");
+    text.renderMap(QSize(12, 8), 0xFF0000, 0, frame);
+    QCOMPARE(text.m_cache.size(), QSize(48, 8));
+    QVERIFY(text.m_cache.cacheKey() != key);
+    key = text.m_cache.cacheKey();
+
+    text.setAnimationStyle(RGBText::Horizontal);
+    QFontMetrics fm(text.font());
+    text.renderMap(QSize(12, 8), 0xFF0000, 0, frame);
+    QCOMPARE(text.m_cache.size(), QSize(fm.width("QLC+"), 8));
+    QVERIFY(text.m_cache.cacheKey() != key);
+
+    text.setAnimationStyle(RGBText::Vertical);
+    text.renderMap(QSize(12, 8), 0xFF0000, 0, frame);
+    QCOMPARE(text.m_cache.size(), QSize(12, fm.ascent() * 4));
+
+    // a copy starts with no cache
+    RGBText copy(text);
+    QVERIFY(copy.m_cache.isNull() == true);
+    copy.renderMap(QSize(12, 8), 0xFF0000, 0, frame);
+    QCOMPARE(copy.m_cache.size(), QSize(12, fm.ascent() * 4));
+}
+
 QTEST_MAIN(RGBText_Test)
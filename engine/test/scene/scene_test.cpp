@@ -943,4 +943,173 @@ void Scene_Test::writeLTPReady()
     QVERIFY(s1->isRunning() == true);
 }
 
+void Scene_Test::writeSettled()
+{
+    Doc* doc = new Doc(this);
+    MasterTimer timer(doc);
+    QList<Universe*> ua;
+
+    QLCFixtureDef* def = m_doc->fixtureDefCache()->fixtureDef("Futurelight", "DJScan250");
+    QVERIFY(def != NULL);
+
+    QLCFixtureMode* mode = def->mode("Mode 1");
+    QVERIFY(mode != NULL);
+
+    Fixture* fxi = new Fixture(doc);
+    fxi->setFixtureDefinition(def, mode);
+    fxi->setAddress(0);
+    fxi->setUniverse(0);
+    doc->addFixture(fxi);
+
+    Scene* s1 = new Scene(doc);
+    s1->setFadeInSpeed(MasterTimer::tick() * 2);
+    s1->setFadeOutSpeed(MasterTimer::tick() * 2);
+    s1->setValue(fxi->id(), 5, 250); // HTP
+    s1->setValue(fxi->id(), 0, 100); // LTP
+    s1->setValue(fxi->id(), 1, 50); // LTP
+    doc->addFunction(s1);
+    QVERIFY(s1->m_valuesDirty == true);
+
+    s1->start(&timer, FunctionParent::master());
+    timer.timerTick();
+
+    // values are resolved once
+    QVERIFY(s1->m_valuesDirty == false);
+    QCOMPARE(s1->m_resolvedValues.size(), 3);
+    QVERIFY(s1->m_settled == false);
+
+    // fades complete: the scene settles
+    timer.timerTick();
+    QVERIFY(s1->m_settled == true);
+    QCOMPARE(s1->m_settledRuns.size(), 2);
+    QCOMPARE(s1->m_settledRuns.at(0).m_address, 0);
+    QCOMPARE(s1->m_settledRuns.at(0).m_count, 2);
+    QCOMPARE(s1->m_settledRuns.at(0).m_offset, 0);
+    QCOMPARE(s1->m_settledRuns.at(1).m_address, 5);
+    QCOMPARE(s1->m_settledRuns.at(1).m_count, 1);
+    QCOMPARE(s1->m_settledRuns.at(1).m_offset, 2);
+
+    // and keeps writing the same values
+    ua = doc->inputOutputMap()->claimUniverses();
+    ua[0]->write(5, 255); // Overridden in the next round
+    ua[0]->write(0, 42);  // Not overridden in the next round
+    doc->inputOutputMap()->releaseUniverses(false);
+
+    timer.timerTick();
+    QVERIFY(s1->m_settled == true);
+    ua = doc->inputOutputMap()->claimUniverses();
+    QVERIFY(ua[0]->preGMValues()[5] == (char) 250);
+    QVERIFY(ua[0]->preGMValues()[0] == (char) 100);
+    QVERIFY(ua[0]->preGMValues()[1] == (char) 50);
+    doc->inputOutputMap()->releaseUniverses(false);
+
+    // a new intensity goes through the fader, then settles again
+    s1->adjustAttribute(0.5, Function::Intensity);
+    QVERIFY(s1->m_settled == false);
+    timer.timerTick();
+    QVERIFY(s1->m_settled == true);
+    ua = doc->inputOutputMap()->claimUniverses();
+    QVERIFY(ua[0]->preGMValues()[5] == (char) 125);
+    QVERIFY(ua[0]->preGMValues()[0] == (char) 100);
+    doc->inputOutputMap()->releaseUniverses(false);
+
+    timer.timerTick();
+    ua = doc->inputOutputMap()->claimUniverses();
+    QVERIFY(ua[0]->preGMValues()[5] == (char) 125);
+    doc->inputOutputMap()->releaseUniverses(false);
+
+    // so does a value change
+    s1->setValue(SceneValue(fxi->id(), 0, 10), false, false);
+    QVERIFY(s1->m_settled == false);
+    QVERIFY(s1->m_valuesDirty == true);
+    timer.timerTick();
+    QVERIFY(s1->m_settled == true);
+    timer.timerTick();
+    ua = doc->inputOutputMap()->claimUniverses();
+    QVERIFY(ua[0]->preGMValues()[0] == (char) 10);
+    doc->inputOutputMap()->releaseUniverses(false);
+
+    s1->stop(FunctionParent::master());
+    timer.timerTick();
+    QVERIFY(s1->isRunning() == false);
+    QVERIFY(s1->m_settled == false);
+    QVERIFY(s1->m_settledRuns.isEmpty() == true);
+
+    // moving the fixture resolves the values again
+    s1->start(&timer, FunctionParent::master());
+    timer.timerTick();
+    QVERIFY(s1->m_valuesDirty == false);
+    fxi->setAddress(10);
+    QVERIFY(s1->m_valuesDirty == true);
+    s1->stop(FunctionParent::master());
+    timer.timerTick();
+}
+
+void Scene_Test::stagedValues()
+{
+    QLCFixtureDef* def = m_doc->fixtureDefCache()->fixtureDef("Futurelight", "DJScan250");
+    QVERIFY(def != NULL);
+
+    QLCFixtureMode* mode = def->mode("Mode 1");
+    QVERIFY(mode != NULL);
+
+    Fixture* fxi = new Fixture(m_doc);
+    fxi->setFixtureDefinition(def, mode);
+    fxi->setAddress(0);
+    fxi->setUniverse(0);
+    m_doc->addFixture(fxi);
+
+    Scene* s = new Scene(m_doc);
+    s->setValue(fxi->id(), 0, 10);
+    s->setValue(fxi->id(), 5, 20);
+    m_doc->addFunction(s);
+
+    // staging leaves the scene untouched
+    QList <SceneValue> values;
+    values << SceneValue(fxi->id(), 5, 200) << SceneValue(fxi->id(), 0, 100);
+    Scene::StagedValues staged = s->stageValues(values);
+    QCOMPARE(s->value(fxi->id(), 0), uchar(10));
+    QCOMPARE(s->value(fxi->id(), 5), uchar(20));
+
+    QCOMPARE(staged.m_resolvedValues.size(), 2);
+    QCOMPARE(staged.m_resolvedValues.at(0).m_fadeChannel.channel(), quint32(0));
+    QCOMPARE(staged.m_resolvedValues.at(0).m_fadeChannel.target(), uchar(100));
+    QCOMPARE(staged.m_resolvedValues.at(0).m_group, QLCChannel::Pan);
+    QCOMPARE(staged.m_resolvedValues.at(1).m_fadeChannel.channel(), quint32(5));
+    QCOMPARE(staged.m_resolvedValues.at(1).m_fadeChannel.target(), uchar(200));
+    QCOMPARE(staged.m_resolvedValues.at(1).m_group, QLCChannel::Intensity);
+
+    // the same channels: the resolved values are taken as they are
+    QSignalSpy spy(s, SIGNAL(valueChanged(SceneValue)));
+    s->setStagedValues(staged);
+    QCOMPARE(s->value(fxi->id(), 0), uchar(100));
+    QCOMPARE(s->value(fxi->id(), 5), uchar(200));
+    QVERIFY(s->m_valuesDirty == false);
+    QCOMPARE(s->m_resolvedValues.size(), 2);
+    QCOMPARE(s->m_resolvedValues.at(1).m_fadeChannel.target(), uchar(200));
+    QCOMPARE(spy.count(), 2);
+
+    // a fixture change after staging: the values are resolved again
+    values.clear();
+    values << SceneValue(fxi->id(), 0, 1) << SceneValue(fxi->id(), 5, 2);
+    staged = s->stageValues(values);
+    fxi->setAddress(10);
+    s->setStagedValues(staged);
+    QCOMPARE(s->value(fxi->id(), 0), uchar(1));
+    QVERIFY(s->m_valuesDirty == true);
+
+    s->prepareValues();
+    QVERIFY(s->m_valuesDirty == false);
+    QCOMPARE(s->m_resolvedValues.at(0).m_fadeChannel.address(), quint32(10));
+
+    // other channels are set one by one
+    values.clear();
+    values << SceneValue(fxi->id(), 3, 30);
+    s->setStagedValues(s->stageValues(values));
+    QCOMPARE(s->values().size(), 3);
+    QCOMPARE(s->value(fxi->id(), 3), uchar(30));
+    QCOMPARE(s->value(fxi->id(), 5), uchar(2));
+    QVERIFY(s->m_valuesDirty == true);
+}
+
 QTEST_APPLESS_MAIN(Scene_Test)
@@ -53,6 +53,8 @@ private slots:
     void writeHTPTwoTicks();
     void writeHTPTwoTicksIntensity();
     void writeLTPReady();
+    void writeSettled();
+    void stagedValues();
 
 private:
     Doc* m_doc;
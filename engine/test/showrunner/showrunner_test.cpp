@@ -0,0 +1,265 @@
+/*
+  Q Light Controller Plus - Unit test
+  showrunner_test.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QtTest>
+
+#include "showrunner_test.h"
+#include "showfunction.h"
+#include "mastertimer.h"
+#include "track.h"
+#include "scene.h"
+#include "show.h"
+#include "doc.h"
+
+#define private public
+#include "showrunner.h"
+#undef private
+
+/** Number of ShowFunctions of the efficiency test */
+#define BENCH_FUNCTIONS 4000
+
+/** Run $runner until its elapsed time is past $time */
+static void runUntil(ShowRunner& runner, quint32 time)
+{
+    while (runner.m_elapsedTime <= time)
+        runner.write();
+}
+
+void ShowRunner_Test::initTestCase()
+{
+    m_doc = new Doc(this);
+}
+
+void ShowRunner_Test::cleanupTestCase()
+{
+    delete m_doc;
+}
+
+void ShowRunner_Test::init()
+{
+    m_doc->clearContents();
+    m_scenes.clear();
+
+    for (int i = 0; i < 5; i++)
+    {
+        Scene *scene = new Scene(m_doc);
+        m_doc->addFunction(scene);
+        m_scenes << scene;
+    }
+
+    m_show = new Show(m_doc);
+    m_doc->addFunction(m_show);
+
+    // Track 0: A [0, 1000), B [2000, 3000) and a missing Function
+    Track *track = new Track();
+    m_show->addTrack(track);
+    ShowFunction *sf = track->createShowFunction(m_scenes[0]->id());
+    sf->setStartTime(0);
+    sf->setDuration(1000);
+    sf = track->createShowFunction(m_scenes[1]->id());
+    sf->setStartTime(2000);
+    sf->setDuration(1000);
+    sf = track->createShowFunction(1234);
+    sf->setStartTime(100);
+    sf->setDuration(100000);
+
+    // Track 1: C [500, 5000), D [1500, 1600)
+    track = new Track();
+    m_show->addTrack(track);
+    sf = track->createShowFunction(m_scenes[2]->id());
+    sf->setStartTime(500);
+    sf->setDuration(4500);
+    sf = track->createShowFunction(m_scenes[3]->id());
+    sf->setStartTime(1500);
+    sf->setDuration(100);
+
+    // Track 2 is muted
+    track = new Track();
+    track->setMute(true);
+    m_show->addTrack(track);
+    sf = track->createShowFunction(m_scenes[4]->id());
+    sf->setStartTime(0);
+    sf->setDuration(10000);
+}
+
+void ShowRunner_Test::timeline()
+{
+    ShowRunner runner(m_doc, m_show->id());
+
+    // missing Functions and muted tracks are left out
+    QCOMPARE(runner.m_runs.count(), 4);
+    QCOMPARE(runner.m_totalRunTime, quint32(5000));
+
+    // ordered by start time: A, C, D, B
+    QCOMPARE(runner.m_runs.at(0).m_function, (Function*) m_scenes[0]);
+    QCOMPARE(runner.m_runs.at(1).m_function, (Function*) m_scenes[2]);
+    QCOMPARE(runner.m_runs.at(2).m_function, (Function*) m_scenes[3]);
+    QCOMPARE(runner.m_runs.at(3).m_function, (Function*) m_scenes[1]);
+    QCOMPARE(runner.m_runs.at(0).m_trackId, m_show->tracks().at(0)->id());
+    QCOMPARE(runner.m_runs.at(1).m_trackId, m_show->tracks().at(1)->id());
+
+    // stops ordered by stop time: A, D, B, C
+    QCOMPARE(runner.m_stopOrder, QVector<int>() << 0 << 2 << 3 << 1);
+    QCOMPARE(runner.m_stopTimes, QVector<quint32>() << 1000 << 1600 << 3000 << 5000);
+
+    // the root of the tree holds the latest stop time
+    QCOMPARE(runner.m_treeSize, 4);
+    QCOMPARE(runner.m_maxStopTree.at(1), quint32(5000));
+
+    // from 0, A is started right away
+    QCOMPARE(runner.m_seekQueue, QList<int>() << 0);
+    QCOMPARE(runner.m_currentFunctionIndex, 1);
+    QCOMPARE(runner.m_currentStopIndex, 0);
+}
+
+void ShowRunner_Test::write()
+{
+    ShowRunner runner(m_doc, m_show->id());
+
+    runner.write();
+    QCOMPARE(runner.m_runningQueue, QList<int>() << 0);
+    QCOMPARE(m_scenes[0]->stopped(), false);
+    QCOMPARE(m_scenes[0]->elapsed(), quint32(0));
+
+    runUntil(runner, 500);
+    QCOMPARE(runner.m_runningQueue, QList<int>() << 0 << 1);
+
+    runUntil(runner, 1000);
+    QCOMPARE(runner.m_runningQueue, QList<int>() << 1);
+    QCOMPARE(m_scenes[0]->stopped(), true);
+
+    runUntil(runner, 1500);
+    QCOMPARE(runner.m_runningQueue, QList<int>() << 1 << 2);
+
+    runUntil(runner, 2000);
+    QCOMPARE(runner.m_runningQueue, QList<int>() << 1 << 3);
+    QCOMPARE(m_scenes[3]->stopped(), true);
+
+    QSignalSpy spy(&runner, SIGNAL(showFinished()));
+    runUntil(runner, 4990);
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(runner.m_runningQueue, QList<int>() << 1);
+
+    runner.write();
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(runner.m_runningQueue.isEmpty(), true);
+    QCOMPARE(m_scenes[2]->stopped(), true);
+}
+
+void ShowRunner_Test::seek()
+{
+    // C and D are active at 1550, A is over and B is yet to come
+    ShowRunner runner(m_doc, m_show->id(), 1550);
+    QCOMPARE(runner.m_elapsedTime, quint32(1550));
+    QCOMPARE(runner.m_seekQueue, QList<int>() << 1 << 2);
+    QCOMPARE(runner.m_currentFunctionIndex, 3);
+    QCOMPARE(runner.m_currentStopIndex, 1);
+
+    // they start with an offset
+    runner.write();
+    QCOMPARE(runner.m_runningQueue, QList<int>() << 1 << 2);
+    QCOMPARE(runner.m_seekQueue.isEmpty(), true);
+    QCOMPARE(m_scenes[2]->elapsed(), quint32(1050));
+    QCOMPARE(m_scenes[3]->elapsed(), quint32(50));
+
+    runUntil(runner, 2000);
+    QCOMPARE(runner.m_runningQueue, QList<int>() << 1 << 3);
+
+    // a stop time is not part of the Function
+    runner.seek(1000);
+    QCOMPARE(runner.m_seekQueue, QList<int>() << 1);
+    runner.seek(0);
+    QCOMPARE(runner.m_seekQueue, QList<int>() << 0);
+    runner.seek(999);
+    QCOMPARE(runner.m_seekQueue, QList<int>() << 0 << 1);
+
+    // past the end of the show, nothing is active
+    runner.seek(6000);
+    QCOMPARE(runner.m_seekQueue.isEmpty(), true);
+    QCOMPARE(runner.m_currentFunctionIndex, 4);
+    QCOMPARE(runner.m_currentStopIndex, 4);
+
+    runner.stop();
+}
+
+void ShowRunner_Test::stop()
+{
+    ShowRunner runner(m_doc, m_show->id());
+    runUntil(runner, 600);
+    QCOMPARE(runner.m_runningQueue.count(), 2);
+
+    runner.stop();
+    QCOMPARE(runner.m_runningQueue.isEmpty(), true);
+    QCOMPARE(m_scenes[0]->stopped(), true);
+    QCOMPARE(m_scenes[2]->stopped(), true);
+
+    // back to the beginning
+    QCOMPARE(runner.m_elapsedTime, quint32(0));
+    QCOMPARE(runner.m_seekQueue, QList<int>() << 0);
+    QCOMPARE(runner.m_currentFunctionIndex, 1);
+    QCOMPARE(runner.m_currentStopIndex, 0);
+}
+
+void ShowRunner_Test::adjustIntensity()
+{
+    ShowRunner runner(m_doc, m_show->id());
+    runner.adjustIntensity(0.5, m_show->tracks().at(0));
+    runner.write();
+    QCOMPARE(m_scenes[0]->getAttributeValue(Function::Intensity), qreal(0.5));
+
+    // only the running Functions of the track are adjusted
+    runner.adjustIntensity(0.2, m_show->tracks().at(0));
+    QCOMPARE(m_scenes[0]->getAttributeValue(Function::Intensity), qreal(0.2));
+    QCOMPARE(m_scenes[2]->getAttributeValue(Function::Intensity), qreal(1.0));
+
+    runner.adjustIntensity(0.4, m_show->tracks().at(1));
+    runUntil(runner, 500);
+    QCOMPARE(m_scenes[2]->getAttributeValue(Function::Intensity), qreal(0.4));
+    QCOMPARE(m_scenes[0]->getAttributeValue(Function::Intensity), qreal(0.2));
+
+    runner.stop();
+}
+
+void ShowRunner_Test::seekEfficiency()
+{
+    // a long timecoded track: each Function overlaps the next one
+    Track *track = new Track();
+    m_show->addTrack(track);
+    for (int i = 0; i < BENCH_FUNCTIONS; i++)
+    {
+        ShowFunction *sf = track->createShowFunction(m_scenes[i % 5]->id());
+        sf->setStartTime(i * 100);
+        sf->setDuration(250);
+    }
+
+    ShowRunner runner(m_doc, m_show->id());
+    QCOMPARE(runner.m_runs.count(), BENCH_FUNCTIONS + 4);
+
+    runner.seek(200050);
+    QCOMPARE(runner.m_seekQueue.count(), 3);
+
+    quint32 time = 0;
+    QBENCHMARK
+    {
+        runner.seek(time);
+        time = (time + 99991) % (BENCH_FUNCTIONS * 100);
+    }
+}
+
+QTEST_MAIN(ShowRunner_Test)
@@ -1,4 +1,6 @@
 TEMPLATE = subdirs
+SUBDIRS += audiocapture
+SUBDIRS += audiomixer
 SUBDIRS += bus
 SUBDIRS += chaser
 SUBDIRS += chaserrunner
@@ -9,6 +11,7 @@ SUBDIRS += cuestack
 SUBDIRS += doc
 SUBDIRS += efx
 SUBDIRS += efxfixture
+SUBDIRS += engineprofiler
 SUBDIRS += fadechannel
 SUBDIRS += fixture
 SUBDIRS += fixturegroup
@@ -19,6 +22,7 @@ SUBDIRS += inputoutputmap
 SUBDIRS += inputpatch
 SUBDIRS += mastertimer
 SUBDIRS += outputpatch
+SUBDIRS += pixelfader
 SUBDIRS += qlccapability
 SUBDIRS += qlcchannel
 SUBDIRS += qlcfile
@@ -35,11 +39,13 @@ SUBDIRS += qlcpoint
 SUBDIRS += rgbalgorithm
 SUBDIRS += rgbmatrix
 SUBDIRS += rgbscript
+SUBDIRS += rgbstream
 SUBDIRS += rgbtext
 SUBDIRS += scene
 SUBDIRS += scenevalue
 SUBDIRS += script
 SUBDIRS += sequence
+SUBDIRS += showrunner
 SUBDIRS += universe
 
 # Stubs
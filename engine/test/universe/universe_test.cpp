@@ -392,6 +392,41 @@ void Universe_Test::writeRelative()
     QCOMPARE(quint8(m_uni->postGMValues()->at(9)), quint8(0));
 }
 
+void Universe_Test::writeRange()
+{
+    m_uni->setChannelCapability(1, QLCChannel::Intensity);
+    m_uni->setChannelCapability(3, QLCChannel::Intensity);
+
+    m_uni->write(0, 200);
+    m_uni->write(1, 200);
+    m_uni->write(2, 10);
+    m_uni->write(3, 10);
+
+    // LTP channels are overwritten, HTP channels keep the highest value
+    const uchar values[] = { 100, 100, 100, 100, 50 };
+    m_uni->writeRange(0, values, 5);
+    QCOMPARE(quint8(m_uni->preGMValues().at(0)), quint8(100));
+    QCOMPARE(quint8(m_uni->preGMValues().at(1)), quint8(200));
+    QCOMPARE(quint8(m_uni->preGMValues().at(2)), quint8(100));
+    QCOMPARE(quint8(m_uni->preGMValues().at(3)), quint8(100));
+    QCOMPARE(quint8(m_uni->preGMValues().at(4)), quint8(50));
+    QCOMPARE(m_uni->usedChannels(), ushort(5));
+
+    // post-GM values are updated
+    QCOMPARE(quint8(m_uni->postGMValues()->at(0)), quint8(100));
+    QCOMPARE(quint8(m_uni->postGMValues()->at(1)), quint8(200));
+    QCOMPARE(quint8(m_uni->postGMValues()->at(4)), quint8(50));
+
+    // also in batch mode, once committed
+    m_uni->startBatch();
+    m_uni->writeRange(UNIVERSE_SIZE - 2, values, 2);
+    QCOMPARE(quint8(m_uni->preGMValues().at(UNIVERSE_SIZE - 1)), quint8(100));
+    QCOMPARE(quint8(m_uni->postGMValues()->at(UNIVERSE_SIZE - 1)), quint8(0));
+    m_uni->commitBatch();
+    QCOMPARE(quint8(m_uni->postGMValues()->at(UNIVERSE_SIZE - 1)), quint8(100));
+    QCOMPARE(m_uni->usedChannels(), ushort(UNIVERSE_SIZE));
+}
+
 void Universe_Test::reset()
 {
     int i;
@@ -418,6 +453,71 @@ void Universe_Test::reset()
         QCOMPARE((int)m_uni->postGMValues()->at(i), 0);
 }
 
+void Universe_Test::batch()
+{
+    Universe reference(1, m_gm);
+
+    // more than 32 channels to exercise both the vectorized and the plain paths
+    for (int i = 0; i < 45; i++)
+    {
+        QLCChannel::Group group = (i % 3) ? QLCChannel::Intensity : QLCChannel::Pan;
+        m_uni->setChannelCapability(i, group);
+        reference.setChannelCapability(i, group);
+    }
+
+    for (int mode = 0; mode < 4; mode++)
+    {
+        m_gm->setValueMode(mode & 1 ? GrandMaster::Limit : GrandMaster::Reduce);
+        m_gm->setChannelMode(mode & 2 ? GrandMaster::AllChannels : GrandMaster::Intensity);
+        m_gm->setValue(63 + mode * 40);
+
+        m_uni->startBatch();
+        QVERIFY(m_uni->isBatchMode() == true);
+        m_uni->zeroIntensityChannels();
+        reference.zeroIntensityChannels();
+
+        for (int i = 0; i < 45; i++)
+        {
+            m_uni->write(i, uchar(i * 5 + mode));
+            reference.write(i, uchar(i * 5 + mode));
+        }
+        m_uni->writeRelative(2, 140);
+        reference.writeRelative(2, 140);
+
+        // dirty channels are calculated on request
+        QCOMPARE(m_uni->postGMValue(7), reference.postGMValue(7));
+
+        m_uni->commitBatch();
+        QVERIFY(m_uni->isBatchMode() == false);
+
+        for (int i = 0; i < 45; i++)
+            QCOMPARE(m_uni->postGMValue(i), reference.postGMValue(i));
+    }
+}
+
+void Universe_Test::snapshot()
+{
+    QCOMPARE(m_uni->generation(), quint32(0));
+    QVERIFY(m_uni->postGMSnapshot().isEmpty());
+
+    m_uni->write(3, 100);
+    QCOMPARE(m_uni->hasChanged(), true);
+    QCOMPARE(m_uni->generation(), quint32(1));
+    QCOMPARE(m_uni->postGMSnapshot().size(), 4);
+    QCOMPARE(quint8(m_uni->postGMSnapshot().at(3)), quint8(100));
+
+    // a listener holding the snapshot keeps its values
+    QByteArray listener = m_uni->postGMSnapshot();
+    m_uni->write(3, 50);
+    QCOMPARE(m_uni->hasChanged(), true);
+    QCOMPARE(m_uni->generation(), quint32(2));
+    QCOMPARE(quint8(listener.at(3)), quint8(100));
+    QCOMPARE(quint8(m_uni->postGMSnapshot().at(3)), quint8(50));
+
+    QCOMPARE(m_uni->hasChanged(), false);
+    QCOMPARE(m_uni->generation(), quint32(2));
+}
+
 void Universe_Test::loadEmpty()
 {
     QBuffer buffer;
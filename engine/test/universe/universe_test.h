@@ -44,7 +44,10 @@ private slots:
     void applyGM();
     void write();
     void writeRelative();
+    void writeRange();
     void reset();
+    void batch();
+    void snapshot();
 
     void loadEmpty();
     void loadPassthroughTrue();
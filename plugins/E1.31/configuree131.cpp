@@ -39,6 +39,7 @@
 #define KMapColumnE131Uni       5
 #define KMapColumnTransmitMode  6
 #define KMapColumnPriority      7
+#define KMapColumnSyncUni       8
 
 #define PROP_UNIVERSE (Qt::UserRole + 0)
 #define PROP_LINE (Qt::UserRole + 1)
@@ -47,6 +48,8 @@
 #define E131_PRIORITY_MIN 0
 #define E131_PRIORITY_MAX 200
 
+#define E131_SYNC_UNIVERSE_MAX 63999
+
 /*****************************************************************************
  * Initialization
  *****************************************************************************/
@@ -184,6 +187,12 @@ void ConfigureE131::fillMappingTree()
                 prioritySpin->setValue(info->outputPriority);
                 prioritySpin->setToolTip(tr("%1 - min, %2 - default, %3 - max").arg(E131_PRIORITY_MIN).arg(E131_PRIORITY_DEFAULT).arg(E131_PRIORITY_MAX));
                 m_uniMapTree->setItemWidget(item, KMapColumnPriority, prioritySpin);
+
+                QSpinBox *syncSpin = new QSpinBox(this);
+                syncSpin->setRange(0, E131_SYNC_UNIVERSE_MAX);
+                syncSpin->setValue(info->outputSyncUniverse);
+                syncSpin->setToolTip(tr("Universe of the synchronization packets sent after each frame. 0 - disabled"));
+                m_uniMapTree->setItemWidget(item, KMapColumnSyncUni, syncSpin);
             }
         }
     }
@@ -388,6 +397,10 @@ void ConfigureE131::accept()
                 QSpinBox* prioSpin = qobject_cast<QSpinBox*>(m_uniMapTree->itemWidget(item, KMapColumnPriority));
                 m_plugin->setParameter(universe, line, QLCIOPlugin::Output,
                         E131_PRIORITY, prioSpin->value());
+
+                QSpinBox* syncSpin = qobject_cast<QSpinBox*>(m_uniMapTree->itemWidget(item, KMapColumnSyncUni));
+                m_plugin->setParameter(universe, line, QLCIOPlugin::Output,
+                        E131_SYNCUNIVERSE, syncSpin->value());
             }
         }
     }
@@ -33,15 +33,11 @@ E131Controller::E131Controller(QNetworkInterface const& interface, QNetworkAddre
     , m_packetSent(0)
     , m_packetReceived(0)
     , m_line(line)
-    , m_UdpSocket(new QUdpSocket(this))
     , m_packetizer(new E131Packetizer())
+    , m_sender(new UdpSender(m_ipAddr, m_interface))
+    , m_syncTargetsCount(0)
 {
     qDebug() << Q_FUNC_INFO;
-    m_UdpSocket->bind(m_ipAddr, 0);
-    // Output multicast on the correct interface
-    m_UdpSocket->setMulticastInterface(m_interface);
-    // Don't send multicast to self
-    m_UdpSocket->setSocketOption(QAbstractSocket::MulticastLoopbackOption, false);
 }
 
 E131Controller::~E131Controller()
@@ -80,6 +76,7 @@ void E131Controller::addUniverse(quint32 universe, E131Controller::Type type)
         info.outputUniverse = universe + 1;
         info.outputTransmissionMode = Full;
         info.outputPriority = E131_PRIORITY_DEFAULT;
+        info.outputSyncUniverse = 0;
         info.type = type;
         m_universeMap[universe] = info;
     }
@@ -276,6 +273,18 @@ void E131Controller::setOutputTransmissionMode(quint32 universe, E131Controller:
     m_universeMap[universe].outputTransmissionMode = int(mode);
 }
 
+void E131Controller::setOutputSyncUniverse(quint32 universe, quint32 syncUni)
+{
+    if (m_universeMap.contains(universe) == false)
+        return;
+
+    QMutexLocker locker(&m_dataMutex);
+    UniverseInfo& info = m_universeMap[universe];
+    info.outputSyncUniverse = syncUni;
+    // 239.255.<universe high byte>.<universe low byte>
+    info.outputSyncMcastAddress = QHostAddress(quint32(0xEFFF0000 | (syncUni & 0xFFFF)));
+}
+
 QString E131Controller::transmissionModeToString(E131Controller::TransmissionMode mode)
 {
     switch (mode)
@@ -329,7 +338,7 @@ quint32 E131Controller::line()
 
 quint64 E131Controller::getPacketSentNumber()
 {
-    return m_packetSent;
+    return m_packetSent + m_sender->packetsSent();
 }
 
 quint64 E131Controller::getPacketReceivedNumber()
@@ -340,16 +349,19 @@ quint64 E131Controller::getPacketReceivedNumber()
 void E131Controller::sendDmx(const quint32 universe, const QByteArray &data)
 {
     QMutexLocker locker(&m_dataMutex);
-    QByteArray dmxPacket;
-    QHostAddress outAddress = QHostAddress(QString("239.255.0.%1").arg(universe + 1));
+    QByteArray *dmxPacket = &m_dmxPacket;
+    QHostAddress outAddress;
     quint16 outPort = E131_DEFAULT_PORT;
     quint32 outUniverse = universe;
     quint32 outPriority = E131_PRIORITY_DEFAULT;
+    quint16 syncUniverse = 0;
     TransmissionMode transmitMode = Full;
 
-    if (m_universeMap.contains(universe))
+    QMap<quint32, UniverseInfo>::iterator it = m_universeMap.find(universe);
+    if (it != m_universeMap.end())
     {
-        UniverseInfo const& info = m_universeMap[universe];
+        UniverseInfo &info = it.value();
+        dmxPacket = &info.outputPacket;
         if (info.outputMulticast)
         {
             outAddress = info.outputMcastAddress;
@@ -362,29 +374,54 @@ void E131Controller::sendDmx(const quint32 universe, const QByteArray &data)
         outUniverse = info.outputUniverse;
         outPriority = info.outputPriority;
         transmitMode = TransmissionMode(info.outputTransmissionMode);
+        syncUniverse = info.outputSyncUniverse;
+
+        if (syncUniverse != 0)
+            addSyncTarget(syncUniverse, info.outputMulticast ? info.outputSyncMcastAddress : outAddress, outPort);
     }
     else
+    {
         qWarning() << Q_FUNC_INFO << "universe" << universe << "unknown";
+        outAddress = QHostAddress(QString("239.255.0.%1").arg(universe + 1));
+    }
+
+    m_packetizer->setupE131Dmx(*dmxPacket, outUniverse, outPriority, data,
+                               transmitMode == Full, syncUniverse);
 
-    if (transmitMode == Full)
+    m_sender->queueDatagram(*dmxPacket, outAddress, outPort);
+}
+
+void E131Controller::addSyncTarget(quint16 syncUniverse, const QHostAddress &address, quint16 port)
+{
+    for (int i = 0; i < m_syncTargetsCount; i++)
     {
-        QByteArray wholeuniverse(512, 0);
-        wholeuniverse.replace(0, data.length(), data);
-        m_packetizer->setupE131Dmx(dmxPacket, outUniverse, outPriority, wholeuniverse);
+        const SyncTarget &target = m_syncTargets.at(i);
+        if (target.universe == syncUniverse && target.port == port && target.address == address)
+            return;
     }
-    else
-        m_packetizer->setupE131Dmx(dmxPacket, outUniverse, outPriority, data);
 
-    qint64 sent = m_UdpSocket->writeDatagram(dmxPacket.data(), dmxPacket.size(),
-                                             outAddress, outPort);
-    if (sent < 0)
+    if (m_syncTargetsCount == m_syncTargets.size())
+        m_syncTargets.resize(m_syncTargetsCount + 1);
+
+    SyncTarget &target = m_syncTargets[m_syncTargetsCount++];
+    target.universe = syncUniverse;
+    target.address = address;
+    target.port = port;
+}
+
+void E131Controller::endFrame()
+{
+    QMutexLocker locker(&m_dataMutex);
+
+    for (int i = 0; i < m_syncTargetsCount; i++)
     {
-        qDebug() << "sendDmx failed";
-        qDebug() << "Errno: " << m_UdpSocket->error();
-        qDebug() << "Errmsg: " << m_UdpSocket->errorString();
+        const SyncTarget &target = m_syncTargets.at(i);
+        m_packetizer->setupE131Sync(m_syncPacket, target.universe);
+        m_sender->queueDatagram(m_syncPacket, target.address, target.port);
     }
-    else
-        m_packetSent++;
+    m_syncTargetsCount = 0;
+
+    m_sender->flush();
 }
 
 void E131Controller::processPendingPackets()
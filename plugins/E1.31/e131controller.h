@@ -29,10 +29,12 @@
 #else
 #include <QtNetwork>
 #endif
+#include <QVector>
 #include <QMutex>
 #include <QTimer>
 
 #include "e131packetizer.h"
+#include "udpsender.h"
 
 #define E131_DEFAULT_PORT     5568
 
@@ -51,6 +53,12 @@ typedef struct
     quint16 outputUniverse;
     int outputTransmissionMode;
     int outputPriority;
+    /** E1.31 synchronization universe. 0 when disabled */
+    quint16 outputSyncUniverse;
+    /** Multicast address of outputSyncUniverse */
+    QHostAddress outputSyncMcastAddress;
+    /** The E1.31 DMX packet, reused on every send */
+    QByteArray outputPacket;
 
     int type;
 } UniverseInfo;
@@ -76,6 +84,10 @@ public:
     /** Send DMX data to a specific port/universe */
     void sendDmx(const quint32 universe, const QByteArray& data);
 
+    /** Send the packets of the current frame, followed by the
+     *  synchronization packets required by the universes sent */
+    void endFrame();
+
     /** Return the controller IP address */
     QString getNetworkIP();
 
@@ -121,6 +133,12 @@ public:
      *  universe */
     void setOutputTransmissionMode(quint32 universe, TransmissionMode mode);
 
+    /** Set the E1.31 synchronization universe for the given QLC+ universe.
+     *  When not 0, the DMX packets of the universe are output by the
+     *  receivers only when the synchronization packet sent by endFrame()
+     *  is received */
+    void setOutputSyncUniverse(quint32 universe, quint32 syncUni);
+
     /** Converts a TransmissionMode value into a human readable string */
     static QString transmissionModeToString(TransmissionMode mode);
 
@@ -161,12 +179,32 @@ private:
     /** QLC+ line to be used when emitting a signal */
     quint32 m_line;
 
-    /** The UDP socket used to send E131 packets */
-    QSharedPointer<QUdpSocket> m_UdpSocket;
-
     /** Helper class used to create or parse E131 packets */
     QScopedPointer<E131Packetizer> m_packetizer;
 
+    /** E1.31 DMX packet buffer for universes not in m_universeMap */
+    QByteArray m_dmxPacket;
+
+    /** Thread sending the DMX packets from the controller interface,
+     *  multicast included */
+    QScopedPointer<UdpSender> m_sender;
+
+    /** Add a synchronization packet to the ones sent by endFrame() */
+    void addSyncTarget(quint16 syncUniverse, const QHostAddress& address, quint16 port);
+
+    typedef struct
+    {
+        quint16 universe;
+        QHostAddress address;
+        quint16 port;
+    } SyncTarget;
+
+    /** Synchronization packets to send at the end of the current frame.
+     *  Entries past m_syncTargetsCount are kept for reuse */
+    QVector<SyncTarget> m_syncTargets;
+    int m_syncTargetsCount;
+    QByteArray m_syncPacket;
+
     /** Keeps the current dmx values to send only the ones that changed */
     /** It holds values for all the handled universes */
     QMap<quint32, QByteArray*> m_dmxValuesMap;
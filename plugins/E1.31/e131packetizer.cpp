@@ -149,41 +149,112 @@ E131Packetizer::~E131Packetizer()
  * Sender functions
  *********************************************************************/
 
-void E131Packetizer::setupE131Dmx(QByteArray& data, const int &universe, const int &priority, const QByteArray &values)
+void E131Packetizer::setupE131Dmx(QByteArray& data, const int &universe, const int &priority,
+                                  const QByteArray &values, bool fullUniverse,
+                                  int syncUniverse)
 {
-    data.clear();
-    data.append(m_commonHeader);
+    int headerSize = m_commonHeader.length();
+    int valuesLength = values.length();
+    int slotCount = valuesLength;
 
-    data.append(values);
+    if (fullUniverse)
+    {
+        slotCount = 512;
+        valuesLength = qMin(valuesLength, slotCount);
+    }
 
-    int rootLayerSize = data.count() - 16;
-    int e131LayerSize = data.count() - 38;
-    int dmpLayerSize = data.count() - 115;
-    int valCountPlusOne = values.count() + 1;
+    // the packet is written in place. When $data is reused across calls
+    // (like the per-universe buffers of E131Controller do), resize()
+    // doesn't reallocate and no memory is allocated here
+    bool newPacket = data.length() < headerSize;
+    data.resize(headerSize + slotCount);
+    char *packet = data.data();
 
-    data[16] = 0x70 | (char)(rootLayerSize >> 8);
-    data[17] = (char)(rootLayerSize & 0x00FF);
+    // the header never changes, except for the fields patched below
+    if (newPacket || memcmp(packet, m_commonHeader.constData(), 16) != 0)
+        memcpy(packet, m_commonHeader.constData(), headerSize);
 
-    data[38] = 0x70 | (char)(e131LayerSize >> 8);
-    data[39] = (char)(e131LayerSize & 0x00FF);
+    memcpy(packet + headerSize, values.constData(), valuesLength);
+    if (slotCount > valuesLength)
+        memset(packet + headerSize + valuesLength, 0, slotCount - valuesLength);
 
-    data[108] = (char) priority;
+    int rootLayerSize = data.length() - 16;
+    int e131LayerSize = data.length() - 38;
+    int dmpLayerSize = data.length() - 115;
+    int valCountPlusOne = slotCount + 1;
 
-    data[111] = m_sequence[universe];
+    uchar &sequence = m_sequence[universe];
 
-    data[113] = (char)(universe >> 8);
-    data[114] = (char)(universe & 0x00FF);
+    packet[16] = 0x70 | (char)(rootLayerSize >> 8);
+    packet[17] = (char)(rootLayerSize & 0x00FF);
 
-    data[115] = 0x70 | (char)(dmpLayerSize >> 8);
-    data[116] = (char)(dmpLayerSize & 0x00FF);
+    packet[38] = 0x70 | (char)(e131LayerSize >> 8);
+    packet[39] = (char)(e131LayerSize & 0x00FF);
 
-    data[123] = (char)(valCountPlusOne >> 8);
-    data[124] = (char)(valCountPlusOne & 0x00FF);
+    packet[108] = (char) priority;
 
-    if (m_sequence[universe] == 0xff)
-        m_sequence[universe] = 1;
+    packet[109] = (char)(syncUniverse >> 8);
+    packet[110] = (char)(syncUniverse & 0x00FF);
+
+    packet[111] = (char)sequence;
+
+    packet[113] = (char)(universe >> 8);
+    packet[114] = (char)(universe & 0x00FF);
+
+    packet[115] = 0x70 | (char)(dmpLayerSize >> 8);
+    packet[116] = (char)(dmpLayerSize & 0x00FF);
+
+    packet[123] = (char)(valCountPlusOne >> 8);
+    packet[124] = (char)(valCountPlusOne & 0x00FF);
+
+    if (sequence == 0xff)
+        sequence = 1;
+    else
+        sequence++;
+}
+
+void E131Packetizer::setupE131Sync(QByteArray &data, const int &syncUniverse)
+{
+    data.resize(E131_SYNC_SIZE);
+    char *packet = data.data();
+
+    // Root layer: same as the DMX packets, except the vector
+    memcpy(packet, m_commonHeader.constData(), 38);
+    int rootLayerSize = E131_SYNC_SIZE - 16;
+    packet[16] = 0x70 | (char)(rootLayerSize >> 8);
+    packet[17] = (char)(rootLayerSize & 0x00FF);
+
+    // Identifies RLP Data as 1.31 Protocol extended PDU
+    packet[18] = 0x00;
+    packet[19] = 0x00;
+    packet[20] = 0x00;
+    packet[21] = 0x08;
+
+    // Synchronization framing layer
+    int framingLayerSize = E131_SYNC_SIZE - 38;
+    packet[38] = 0x70 | (char)(framingLayerSize >> 8);
+    packet[39] = (char)(framingLayerSize & 0x00FF);
+
+    // Identifies the framing layer as a synchronization packet
+    packet[40] = 0x00;
+    packet[41] = 0x00;
+    packet[42] = 0x00;
+    packet[43] = 0x01;
+
+    uchar &sequence = m_syncSequence[syncUniverse];
+    packet[44] = (char)sequence;
+
+    packet[45] = (char)(syncUniverse >> 8);
+    packet[46] = (char)(syncUniverse & 0x00FF);
+
+    // reserved
+    packet[47] = 0x00;
+    packet[48] = 0x00;
+
+    if (sequence == 0xff)
+        sequence = 1;
     else
-        m_sequence[universe]++;
+        sequence++;
 }
 
 bool E131Packetizer::checkPacket(QByteArray &data)
@@ -26,6 +26,7 @@
 #define E131PACKETIZER_H
 
 #define E131_PRIORITY_DEFAULT 100
+#define E131_SYNC_SIZE        49
 
 class E131Packetizer
 {
@@ -41,8 +42,17 @@ public:
      * Sender functions
      *********************************************************************/
 
-    /** Prepare an E1.31 DMX packet */
-    void setupE131Dmx(QByteArray& data, const int& universe, const int& priority, const QByteArray &values);
+    /** Prepare an E1.31 DMX packet. $data is resized and patched in place,
+     *  so reusing the same buffer for each universe avoids any allocation.
+     *  When $fullUniverse is true, $values is zero padded to 512 slots.
+     *  A non zero $syncUniverse tells the receivers to hold the data until
+     *  a synchronization packet for that universe is received */
+    void setupE131Dmx(QByteArray& data, const int& universe, const int& priority,
+                      const QByteArray &values, bool fullUniverse = false,
+                      int syncUniverse = 0);
+
+    /** Prepare an E1.31 synchronization packet for $syncUniverse */
+    void setupE131Sync(QByteArray& data, const int& syncUniverse);
 
     /*********************************************************************
      * Receiver functions
@@ -56,6 +66,7 @@ public:
 private:
     QByteArray m_commonHeader;
     QHash<int, uchar> m_sequence;
+    QHash<int, uchar> m_syncSequence;
 };
 
 #endif
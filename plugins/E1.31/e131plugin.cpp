@@ -201,6 +201,16 @@ void E131Plugin::writeUniverse(quint32 universe, quint32 output, const QByteArra
         controller->sendDmx(universe, data);
 }
 
+void E131Plugin::endFrame()
+{
+    for (int i = 0; i < m_IOmapping.count(); i++)
+    {
+        E131Controller *controller = m_IOmapping.at(i).controller;
+        if (controller != NULL)
+            controller->endFrame();
+    }
+}
+
 /*************************************************************************
   * Inputs
   *************************************************************************/  
@@ -345,6 +355,8 @@ void E131Plugin::setParameter(quint32 universe, quint32 line, Capability type,
             controller->setOutputTransmissionMode(universe, E131Controller::stringToTransmissionMode(value.toString()));
         else if (name == E131_PRIORITY)
             controller->setOutputPriority(universe, value.toUInt());
+        else if (name == E131_SYNCUNIVERSE)
+            controller->setOutputSyncUniverse(universe, value.toUInt());
         else
             qWarning() << Q_FUNC_INFO << name << "is not a valid E1.31 output parameter";
     }
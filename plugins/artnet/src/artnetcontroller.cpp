@@ -40,6 +40,9 @@ ArtNetController::ArtNetController(QNetworkInterface const& interface, QNetworkA
     , m_line(line)
     , m_udpSocket(udpSocket)
     , m_packetizer(new ArtNetPacketizer())
+    , m_sender(new UdpSender(m_ipAddr, QNetworkInterface(), ARTNET_PORT,
+                             QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint))
+    , m_syncPending(false)
     , m_pollTimer(NULL)
 {
     if (m_ipAddr == QHostAddress::LocalHost)
@@ -80,7 +83,7 @@ quint32 ArtNetController::line()
 
 quint64 ArtNetController::getPacketSentNumber()
 {
-    return m_packetSent;
+    return m_packetSent + m_sender->packetsSent();
 }
 
 quint64 ArtNetController::getPacketReceivedNumber()
@@ -117,6 +120,7 @@ void ArtNetController::addUniverse(quint32 universe, ArtNetController::Type type
         info.outputAddress = m_broadcastAddr;
         info.outputUniverse = universe;
         info.outputTransmissionMode = Full;
+        info.outputSync = false;
         info.type = type;
         m_universeMap[universe] = info;
     }
@@ -221,6 +225,17 @@ bool ArtNetController::setTransmissionMode(quint32 universe, ArtNetController::T
     return mode == ArtNetController::Full;
 }
 
+bool ArtNetController::setOutputSync(quint32 universe, bool enable)
+{
+    if (!m_universeMap.contains(universe))
+        return false;
+
+    QMutexLocker locker(&m_dataMutex);
+    m_universeMap[universe].outputSync = enable;
+
+    return enable == false;
+}
+
 QString ArtNetController::transmissionModeToString(ArtNetController::TransmissionMode mode)
 {
     switch (mode)
@@ -259,37 +274,40 @@ UniverseInfo *ArtNetController::getUniverseInfo(quint32 universe)
 void ArtNetController::sendDmx(const quint32 universe, const QByteArray &data)
 {
     QMutexLocker locker(&m_dataMutex);
-    QByteArray dmxPacket;
+    QByteArray *dmxPacket = &m_dmxPacket;
     QHostAddress outAddress = m_broadcastAddr;
     quint32 outUniverse = universe;
     TransmissionMode transmitMode = Full;
 
-    if (m_universeMap.contains(universe))
+    QMap<quint32, UniverseInfo>::iterator it = m_universeMap.find(universe);
+    if (it != m_universeMap.end())
     {
-        UniverseInfo info = m_universeMap[universe];
+        UniverseInfo &info = it.value();
+        dmxPacket = &info.outputPacket;
         outAddress = info.outputAddress;
         outUniverse = info.outputUniverse;
         transmitMode = TransmissionMode(info.outputTransmissionMode);
+        if (info.outputSync)
+            m_syncPending = true;
     }
 
-    if (transmitMode == Full)
-    {
-        QByteArray wholeuniverse(512, 0);
-        wholeuniverse.replace(0, data.length(), data);
-        m_packetizer->setupArtNetDmx(dmxPacket, outUniverse, wholeuniverse);
-    }
-    else
-        m_packetizer->setupArtNetDmx(dmxPacket, outUniverse, data);
+    m_packetizer->setupArtNetDmx(*dmxPacket, outUniverse, data, transmitMode == Full);
 
-    qint64 sent = m_udpSocket->writeDatagram(dmxPacket, outAddress, ARTNET_PORT);
-    if (sent < 0)
+    m_sender->queueDatagram(*dmxPacket, outAddress, ARTNET_PORT);
+}
+
+void ArtNetController::endFrame()
+{
+    QMutexLocker locker(&m_dataMutex);
+
+    if (m_syncPending)
     {
-        qWarning() << "sendDmx failed";
-        qWarning() << "Errno: " << m_udpSocket->error();
-        qWarning() << "Errmgs: " << m_udpSocket->errorString();
+        m_packetizer->setupArtNetSync(m_syncPacket);
+        m_sender->queueDatagram(m_syncPacket, m_broadcastAddr, ARTNET_PORT);
+        m_syncPending = false;
     }
-    else
-        m_packetSent++;
+
+    m_sender->flush();
 }
 
 bool ArtNetController::handleArtNetPollReply(QByteArray const& datagram, QHostAddress const& senderAddress)
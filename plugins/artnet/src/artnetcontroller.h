@@ -33,6 +33,7 @@
 #include <QTimer>
 
 #include "artnetpacketizer.h"
+#include "udpsender.h"
 
 #define ARTNET_PORT      6454
 
@@ -43,6 +44,10 @@ typedef struct
     QHostAddress outputAddress;
     ushort outputUniverse;
     int outputTransmissionMode;
+    /** Send an ArtSync packet at the end of each frame */
+    bool outputSync;
+    /** The ArtDmx packet, reused on every send */
+    QByteArray outputPacket;
 
     int type;
 } UniverseInfo;
@@ -69,6 +74,10 @@ public:
     /** Send DMX data to a specific port/universe */
     void sendDmx(const quint32 universe, const QByteArray& data);
 
+    /** Send the packets of the current frame, followed by an ArtSync
+     *  packet if any of the universes sent requires it */
+    void endFrame();
+
     /** Return the controller IP address */
     QString getNetworkIP();
 
@@ -100,6 +109,11 @@ public:
      *  Return true if this restores default transmission mode */
     bool setTransmissionMode(quint32 universe, TransmissionMode mode);
 
+    /** Enable or disable the ArtSync packet after each frame
+     *  for the given QLC+ universe.
+     *  Return true if this restores the default (disabled) */
+    bool setOutputSync(quint32 universe, bool enable);
+
     /** Converts a TransmissionMode value into a human readable string */
     static QString transmissionModeToString(TransmissionMode mode);
 
@@ -156,6 +170,16 @@ private:
     /** Helper class used to create or parse ArtNet packets */
     QScopedPointer<ArtNetPacketizer> m_packetizer;
 
+    /** ArtDmx packet buffer for universes not in m_universeMap */
+    QByteArray m_dmxPacket;
+
+    /** Thread sending the DMX packets from a socket of its own */
+    QScopedPointer<UdpSender> m_sender;
+
+    /** True when the current frame must be followed by an ArtSync */
+    bool m_syncPending;
+    QByteArray m_syncPacket;
+
     /** Map of the ArtNet nodes discovered with ArtPoll */
     QHash<QHostAddress, ArtNetNodeInfo> m_nodesList;
 
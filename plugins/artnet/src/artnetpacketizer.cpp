@@ -120,27 +120,60 @@ void ArtNetPacketizer::setupArtNetPollReply(QByteArray &data, QHostAddress ipAdd
         data.append((char)0x00); // bindIp[4], BindIndex, Status2 and filler
 }
 
-void ArtNetPacketizer::setupArtNetDmx(QByteArray& data, const int &universe, const QByteArray &values)
+void ArtNetPacketizer::setupArtNetDmx(QByteArray& data, const int &universe,
+                                      const QByteArray &values, bool fullUniverse)
 {
-    data.clear();
-    data.append(m_commonHeader);
-    const char opCodeMSB = (ARTNET_DMX >> 8);
-    data[9] = opCodeMSB;
-    data.append(m_sequence[universe]); // Sequence
-    data.append('\0'); // Physical
-    data.append((char)(universe & 0x00FF));
-    data.append((char)(universe >> 8));
-    int padLength = values.isEmpty() ? 2 : (values.length() % 2); // length must be even in the range 2-512
-    int len = values.length() + padLength;
-    data.append((char)(len >> 8));
-    data.append((char)(len & 0x00FF));
-    data.append(values);
-    data.append(QByteArray(padLength, 0));
-
-    if (m_sequence[universe] == 0xff)
-        m_sequence[universe] = 1;
+    int valuesLength = values.length();
+    int len;
+
+    if (fullUniverse)
+    {
+        len = 512;
+        valuesLength = qMin(valuesLength, len);
+    }
+    else
+    {
+        // length must be even in the range 2-512
+        int padLength = values.isEmpty() ? 2 : (valuesLength % 2);
+        len = valuesLength + padLength;
+    }
+
+    // the packet is written in place. When $data is reused across calls
+    // (like the per-universe buffers of ArtNetController do), resize()
+    // doesn't reallocate and no memory is allocated here
+    data.resize(ARTNET_DMX_HEADER_SIZE + len);
+    char *packet = data.data();
+
+    uchar &sequence = m_sequence[universe];
+
+    memcpy(packet, m_commonHeader.constData(), m_commonHeader.length());
+    packet[9] = (char)(ARTNET_DMX >> 8);
+    packet[12] = (char)sequence;
+    packet[13] = '\0'; // Physical
+    packet[14] = (char)(universe & 0x00FF);
+    packet[15] = (char)(universe >> 8);
+    packet[16] = (char)(len >> 8);
+    packet[17] = (char)(len & 0x00FF);
+
+    memcpy(packet + ARTNET_DMX_HEADER_SIZE, values.constData(), valuesLength);
+    if (len > valuesLength)
+        memset(packet + ARTNET_DMX_HEADER_SIZE + valuesLength, 0, len - valuesLength);
+
+    if (sequence == 0xff)
+        sequence = 1;
     else
-        m_sequence[universe]++;
+        sequence++;
+}
+
+void ArtNetPacketizer::setupArtNetSync(QByteArray &data)
+{
+    data.resize(ARTNET_SYNC_SIZE);
+    char *packet = data.data();
+
+    memcpy(packet, m_commonHeader.constData(), m_commonHeader.length());
+    packet[9] = (char)(ARTNET_SYNC >> 8);
+    packet[12] = '\0'; // Aux1
+    packet[13] = '\0'; // Aux2
 }
 
 /*********************************************************************
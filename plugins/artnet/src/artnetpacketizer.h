@@ -31,6 +31,7 @@
 #define ARTNET_COMMAND        0x2400
 #define ARTNET_DMX            0x5000
 #define ARTNET_NZS            0x5100
+#define ARTNET_SYNC           0x5200
 #define ARTNET_ADDRESS        0x6000
 #define ARTNET_INPUT          0x7000
 #define ARTNET_TODREQUEST     0x8000
@@ -62,6 +63,9 @@
 
 #define ARTNET_CODE_STR "Art-Net"
 
+#define ARTNET_DMX_HEADER_SIZE 18
+#define ARTNET_SYNC_SIZE       14
+
 typedef struct
 {
     QString shortName;
@@ -88,8 +92,15 @@ public:
     /** Prepare an ArtNetPollReply packet */
     void setupArtNetPollReply(QByteArray &data, QHostAddress ipAddr, QString MACaddr);
 
-    /** Prepare an ArtNetDmx packet */
-    void setupArtNetDmx(QByteArray& data, const int& universe, const QByteArray &values);
+    /** Prepare an ArtNetDmx packet. $data is resized and overwritten in place,
+     *  so reusing the same buffer for each universe avoids any allocation.
+     *  When $fullUniverse is true, $values is zero padded to 512 channels */
+    void setupArtNetDmx(QByteArray& data, const int& universe, const QByteArray &values,
+                        bool fullUniverse = false);
+
+    /** Prepare an ArtSync packet, telling the nodes to output
+     *  the ArtDmx data received so far */
+    void setupArtNetSync(QByteArray& data);
 
     /*********************************************************************
      * Receiver functions
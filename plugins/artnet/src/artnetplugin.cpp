@@ -213,6 +213,16 @@ void ArtNetPlugin::writeUniverse(quint32 universe, quint32 output, const QByteAr
         controller->sendDmx(universe, data);
 }
 
+void ArtNetPlugin::endFrame()
+{
+    for (int i = 0; i < m_IOmapping.count(); i++)
+    {
+        ArtNetController *controller = m_IOmapping.at(i).controller;
+        if (controller != NULL)
+            controller->endFrame();
+    }
+}
+
 /*************************************************************************
   * Inputs
   *************************************************************************/  
@@ -351,6 +361,8 @@ void ArtNetPlugin::setParameter(quint32 universe, quint32 line, Capability type,
             unset = controller->setOutputUniverse(universe, value.toUInt());
         else if (name == ARTNET_TRANSMITMODE)
             unset = controller->setTransmissionMode(universe, ArtNetController::stringToTransmissionMode(value.toString()));
+        else if (name == ARTNET_OUTPUTSYNC)
+            unset = controller->setOutputSync(universe, value.toBool());
         else
         {
             qWarning() << Q_FUNC_INFO << name << "is not a valid ArtNet output parameter";
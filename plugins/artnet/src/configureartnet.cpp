@@ -21,6 +21,7 @@
 #include <QMessageBox>
 #include <QSpacerItem>
 #include <QComboBox>
+#include <QCheckBox>
 #include <QLineEdit>
 #include <QSpinBox>
 #include <QLabel>
@@ -38,6 +39,7 @@
 #define KMapColumnIPAddress     2
 #define KMapColumnArtNetUni     3
 #define KMapColumnTransmitMode  4
+#define KMapColumnSync          5
 
 #define PROP_UNIVERSE (Qt::UserRole + 0)
 #define PROP_LINE (Qt::UserRole + 1)
@@ -177,6 +179,11 @@ void ConfigureArtNet::fillMappingTree()
                 if (info->outputTransmissionMode == ArtNetController::Partial)
                     combo->setCurrentIndex(1);
                 m_uniMapTree->setItemWidget(item, KMapColumnTransmitMode, combo);
+
+                QCheckBox *syncCheck = new QCheckBox(this);
+                syncCheck->setChecked(info->outputSync);
+                syncCheck->setToolTip(tr("Send an ArtSync packet after each frame"));
+                m_uniMapTree->setItemWidget(item, KMapColumnSync, syncCheck);
             }
         }
     }
@@ -247,6 +254,10 @@ void ConfigureArtNet::accept()
                 m_plugin->setParameter(universe, line, cap, ARTNET_TRANSMITMODE,
                         ArtNetController::transmissionModeToString(transmissionMode));
             }
+
+            QCheckBox *syncCheck = qobject_cast<QCheckBox*>(m_uniMapTree->itemWidget(item, KMapColumnSync));
+            if (syncCheck != NULL)
+                m_plugin->setParameter(universe, line, cap, ARTNET_OUTPUTSYNC, syncCheck->isChecked());
         }
     }
 
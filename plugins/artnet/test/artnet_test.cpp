@@ -17,11 +17,14 @@
   limitations under the License.
 */
 
+#include <QElapsedTimer>
+#include <QUdpSocket>
 #include <QTest>
 
 #define private public
 #include "artnet_test.h"
 #include "artnetpacketizer.h"
+#include "udpsender.h"
 #undef private
 
 /****************************************************************************
@@ -62,4 +65,120 @@ void ArtNet_Test::setupArtNetDmx()
     QCOMPARE(data.data(), "Art-Net");
 }
 
+void ArtNet_Test::setupArtNetDmxInPlace()
+{
+    ArtNetPacketizer ap;
+
+    QByteArray data;
+    const QByteArray fifty(50, 10);
+    const QByteArray fiftyone(51, 10);
+
+    // full universe, zero padded
+    ap.setupArtNetDmx(data, 0x0102, fifty, true);
+
+    QCOMPARE(data.size(), 18 + 512);
+    QCOMPARE(data.data(), "Art-Net");
+    QCOMPARE(uchar(data.at(9)), uchar(ARTNET_DMX >> 8));
+    QCOMPARE(uchar(data.at(12)), uchar(1));
+    QCOMPARE(uchar(data.at(14)), uchar(0x02));
+    QCOMPARE(uchar(data.at(15)), uchar(0x01));
+    QCOMPARE(uchar(data.at(16)), uchar(0x02));
+    QCOMPARE(uchar(data.at(17)), uchar(0x00));
+    QCOMPARE(data.mid(18, 50), fifty);
+    QCOMPARE(data.mid(18 + 50), QByteArray(512 - 50, 0));
+
+    // the same buffer is reused and only the data changes
+    const char *buffer = data.constData();
+    ap.setupArtNetDmx(data, 0x0102, fiftyone, true);
+
+    QVERIFY(data.constData() == buffer);
+    QCOMPARE(data.size(), 18 + 512);
+    QCOMPARE(uchar(data.at(12)), uchar(2));
+    QCOMPARE(data.mid(18, 51), fiftyone);
+    QCOMPARE(data.mid(18 + 51), QByteArray(512 - 51, 0));
+
+    // sequence is per universe
+    ap.setupArtNetDmx(data, 3, fiftyone);
+    QCOMPARE(data.size(), 18 + 52);
+    QCOMPARE(uchar(data.at(12)), uchar(1));
+    QCOMPARE(uchar(data.at(17)), uchar(52));
+    QCOMPARE(data.at(18 + 51), char(0));
+}
+
+void ArtNet_Test::setupArtNetSync()
+{
+    ArtNetPacketizer ap;
+    QByteArray data;
+
+    ap.setupArtNetSync(data);
+
+    QCOMPARE(data.size(), 14);
+    QCOMPARE(data.data(), "Art-Net");
+    QCOMPARE(uchar(data.at(8)), uchar(ARTNET_SYNC & 0xFF));
+    QCOMPARE(uchar(data.at(9)), uchar(ARTNET_SYNC >> 8));
+    QCOMPARE(uchar(data.at(11)), uchar(14));
+    QCOMPARE(data.at(12), char(0));
+    QCOMPARE(data.at(13), char(0));
+
+    int code = 0;
+    QVERIFY(ap.checkPacketAndCode(data, code));
+    QCOMPARE(code, ARTNET_SYNC);
+}
+
+void ArtNet_Test::batchedSend()
+{
+    QUdpSocket receiver;
+    QVERIFY(receiver.bind(QHostAddress::LocalHost, 0));
+    quint16 port = receiver.localPort();
+
+    UdpSender sender(QHostAddress::LocalHost);
+    ArtNetPacketizer ap;
+    QByteArray packet;
+
+    for (int i = 0; i < 32; i++)
+    {
+        ap.setupArtNetDmx(packet, i, QByteArray(512, char(i)));
+        sender.queueDatagram(packet, QHostAddress::LocalHost, port);
+    }
+
+    // nothing is sent until the frame is flushed
+    QTest::qWait(50);
+    QCOMPARE(receiver.hasPendingDatagrams(), false);
+    QCOMPARE(sender.packetsSent(), quint64(0));
+
+    sender.flush();
+
+    int received = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    while (received < 32 && timer.elapsed() < 5000)
+    {
+        if (receiver.hasPendingDatagrams() == false)
+        {
+            receiver.waitForReadyRead(100);
+            continue;
+        }
+
+        QByteArray datagram;
+        datagram.resize(receiver.pendingDatagramSize());
+        receiver.readDatagram(datagram.data(), datagram.size());
+
+        // datagrams are sent in the same order they are queued
+        QCOMPARE(datagram.size(), 18 + 512);
+        QCOMPARE(datagram.data(), "Art-Net");
+        QCOMPARE(int(datagram.at(14)), received);
+        QCOMPARE(datagram.at(18 + 511), char(received));
+        received++;
+    }
+
+    QCOMPARE(received, 32);
+    QTRY_COMPARE(sender.packetsSent(), quint64(32));
+    QCOMPARE(sender.packetsFailed(), quint64(0));
+    QVERIFY(sender.batchesSent() >= 1);
+
+    sender.stop();
+    QVERIFY(sender.isRunning() == false);
+}
+
 QTEST_MAIN(ArtNet_Test)
@@ -28,6 +28,9 @@ class ArtNet_Test : public QObject
 
 private slots:
     void setupArtNetDmx();
+    void setupArtNetDmxInPlace();
+    void setupArtNetSync();
+    void batchedSend();
 };
 
 #endif
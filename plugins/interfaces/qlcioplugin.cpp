@@ -56,6 +56,10 @@ void QLCIOPlugin::writeUniverse(quint32 universe, quint32 output, const QByteArr
     Q_UNUSED(data)
 }
 
+void QLCIOPlugin::endFrame()
+{
+}
+
 /*************************************************************************
  * Inputs
  *************************************************************************/
@@ -203,6 +203,16 @@ public:
      */
     virtual void writeUniverse(quint32 universe, quint32 output, const QByteArray& data);
 
+    /**
+     * Notify the plugin that all the universes of the current frame
+     * (a MasterTimer tick) have been written with writeUniverse().
+     * Network plugins can use it to send all the frame packets at once
+     * and to emit synchronization packets.
+     *
+     * The default implementation does nothing.
+     */
+    virtual void endFrame();
+
     /*************************************************************************
      * Inputs
      *************************************************************************/
@@ -382,7 +392,9 @@ protected:
     QMap<quint32, PluginUniverseDescriptor> m_universesMap;
 };
 
-#define QLCIOPlugin_iid "org.qlcplus.QLCIOPlugin"
+/* Bump the version whenever the QLCIOPlugin virtual methods change, so that
+   plugins built against an older interface are refused by the loader */
+#define QLCIOPlugin_iid "org.qlcplus.QLCIOPlugin/2"
 
 Q_DECLARE_INTERFACE(QLCIOPlugin, QLCIOPlugin_iid)
 
@@ -0,0 +1,276 @@
+/*
+  Q Light Controller Plus
+  udpsender.cpp
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#include <QMutexLocker>
+#include <QDebug>
+
+#if defined(Q_OS_LINUX)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <errno.h>
+#endif
+
+#include "udpsender.h"
+
+/** Maximum number of datagrams waiting to be sent. When the network
+ *  can't keep up, newer datagrams are refused */
+#define MAX_QUEUED_DATAGRAMS 4096
+
+/** Maximum number of datagrams passed to a single sendmmsg() call */
+#define MAX_BATCH_SIZE 64
+
+UdpSender::UdpSender(QHostAddress const& address, QNetworkInterface const& interface,
+                     quint16 port, QAbstractSocket::BindMode mode, QObject *parent)
+    : QThread(parent)
+    , m_address(address)
+    , m_interface(interface)
+    , m_port(port)
+    , m_bindMode(mode)
+    , m_socket(NULL)
+    , m_pendingCount(0)
+    , m_flushedCount(0)
+    , m_running(false)
+    , m_packetsSent(0)
+    , m_packetsFailed(0)
+    , m_batchesSent(0)
+{
+}
+
+UdpSender::~UdpSender()
+{
+    stop();
+}
+
+bool UdpSender::queueDatagram(const QByteArray &data, const QHostAddress &address, quint16 port)
+{
+    return queueDatagram(data.constData(), data.size(), address, port);
+}
+
+bool UdpSender::queueDatagram(const char *data, int size, const QHostAddress &address, quint16 port)
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_running == false)
+    {
+        m_running = true;
+        start(QThread::HighPriority);
+    }
+
+    if (m_pendingCount >= MAX_QUEUED_DATAGRAMS)
+    {
+        m_packetsFailed.fetchAndAddRelaxed(1);
+        return false;
+    }
+
+    if (m_pendingCount == m_pending.size())
+        m_pending.resize(m_pendingCount + 16);
+
+    Datagram &datagram = m_pending[m_pendingCount++];
+    datagram.m_data.resize(size);
+    memcpy(datagram.m_data.data(), data, size);
+    datagram.m_address = address;
+    datagram.m_port = port;
+
+    return true;
+}
+
+void UdpSender::flush()
+{
+    QMutexLocker locker(&m_mutex);
+
+    if (m_pendingCount == m_flushedCount)
+        return;
+
+    m_flushedCount = m_pendingCount;
+    m_queueNotEmpty.wakeOne();
+}
+
+void UdpSender::stop()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_running == false)
+            return;
+
+        m_running = false;
+        m_pendingCount = 0;
+        m_flushedCount = 0;
+        m_queueNotEmpty.wakeOne();
+    }
+
+    wait();
+}
+
+quint64 UdpSender::packetsSent() const
+{
+    return m_packetsSent.loadAcquire();
+}
+
+quint64 UdpSender::packetsFailed() const
+{
+    return m_packetsFailed.loadAcquire();
+}
+
+quint64 UdpSender::batchesSent() const
+{
+    return m_batchesSent.loadAcquire();
+}
+
+void UdpSender::run()
+{
+    // the socket belongs to this thread: nobody else reads or writes it
+    QUdpSocket socket;
+    if (socket.bind(m_address, m_port, m_bindMode) == false)
+        qWarning() << "[UdpSender] could not bind to" << m_address.toString()
+                   << "port" << m_port << ":" << socket.errorString();
+
+    if (m_interface.isValid())
+    {
+        socket.setMulticastInterface(m_interface);
+        socket.setSocketOption(QAbstractSocket::MulticastLoopbackOption, false);
+    }
+
+    m_socket = &socket;
+    m_mutex.lock();
+
+    while (m_running == true)
+    {
+        if (m_flushedCount == 0)
+        {
+            m_queueNotEmpty.wait(&m_mutex);
+            continue;
+        }
+
+        // take the flushed datagrams and give the callers
+        // the buffers sent in the previous round
+        int count = m_flushedCount;
+        int leftover = m_pendingCount - count;
+        m_pending.swap(m_sending);
+
+        // datagrams queued after flush() belong to the next frame
+        if (m_pending.size() < leftover)
+            m_pending.resize(leftover);
+        for (int i = 0; i < leftover; i++)
+        {
+            Datagram &from = m_sending[count + i];
+            Datagram &to = m_pending[i];
+            to.m_data.swap(from.m_data);
+            to.m_address = from.m_address;
+            to.m_port = from.m_port;
+        }
+
+        m_pendingCount = leftover;
+        m_flushedCount = 0;
+
+        m_mutex.unlock();
+        sendDatagrams(m_sending.constData(), count);
+        m_mutex.lock();
+    }
+
+    m_mutex.unlock();
+    m_socket = NULL;
+}
+
+void UdpSender::sendDatagrams(const Datagram *datagrams, int count)
+{
+    m_batchesSent.fetchAndAddRelaxed(1);
+
+#if defined(Q_OS_LINUX)
+    int fd = int(m_socket->socketDescriptor());
+    if (fd != -1)
+    {
+        struct mmsghdr messages[MAX_BATCH_SIZE];
+        struct iovec iovecs[MAX_BATCH_SIZE];
+        struct sockaddr_in addresses[MAX_BATCH_SIZE];
+        int index = 0;
+
+        while (index < count)
+        {
+            int batchSize = 0;
+
+            while (batchSize < MAX_BATCH_SIZE && index + batchSize < count)
+            {
+                const Datagram &datagram = datagrams[index + batchSize];
+                if (datagram.m_address.protocol() != QAbstractSocket::IPv4Protocol)
+                    break;
+
+                struct sockaddr_in &addr = addresses[batchSize];
+                memset(&addr, 0, sizeof(addr));
+                addr.sin_family = AF_INET;
+                addr.sin_port = htons(datagram.m_port);
+                addr.sin_addr.s_addr = htonl(datagram.m_address.toIPv4Address());
+
+                iovecs[batchSize].iov_base = (void *)datagram.m_data.constData();
+                iovecs[batchSize].iov_len = datagram.m_data.size();
+
+                struct mmsghdr &message = messages[batchSize];
+                memset(&message, 0, sizeof(message));
+                message.msg_hdr.msg_name = &addr;
+                message.msg_hdr.msg_namelen = sizeof(addr);
+                message.msg_hdr.msg_iov = &iovecs[batchSize];
+                message.msg_hdr.msg_iovlen = 1;
+
+                batchSize++;
+            }
+
+            if (batchSize == 0)
+            {
+                writeDatagram(datagrams[index]);
+                index++;
+                continue;
+            }
+
+            int sent = sendmmsg(fd, messages, batchSize, 0);
+            if (sent < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                // the first datagram of the batch failed. Skip it
+                // and try again with the following ones
+                qWarning() << "[UdpSender] sendmmsg failed:" << strerror(errno);
+                m_packetsFailed.fetchAndAddRelaxed(1);
+                index++;
+                continue;
+            }
+
+            m_packetsSent.fetchAndAddRelaxed(sent);
+            index += sent;
+        }
+
+        return;
+    }
+#endif
+
+    for (int i = 0; i < count; i++)
+        writeDatagram(datagrams[i]);
+}
+
+void UdpSender::writeDatagram(const Datagram &datagram)
+{
+    qint64 sent = m_socket->writeDatagram(datagram.m_data, datagram.m_address, datagram.m_port);
+    if (sent < 0)
+    {
+        qWarning() << "[UdpSender] writeDatagram failed:" << m_socket->errorString();
+        m_packetsFailed.fetchAndAddRelaxed(1);
+    }
+    else
+        m_packetsSent.fetchAndAddRelaxed(1);
+}
@@ -0,0 +1,135 @@
+/*
+  Q Light Controller Plus
+  udpsender.h
+
+  Copyright (c) Massimo Callegari
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0.txt
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+*/
+
+#ifndef UDPSENDER_H
+#define UDPSENDER_H
+
+#include <QNetworkInterface>
+#include <QAtomicInteger>
+#include <QWaitCondition>
+#include <QHostAddress>
+#include <QByteArray>
+#include <QUdpSocket>
+#include <QVector>
+#include <QThread>
+#include <QMutex>
+
+/**
+ * UdpSender transmits datagrams on a UDP socket from a dedicated thread,
+ * so that the caller (usually the MasterTimer thread dumping universes)
+ * never waits on a socket.
+ *
+ * The socket is created and used by the sender thread only, bound to
+ * the given local address and port. With port 0 the datagrams leave from
+ * an ephemeral port. Protocols that require a fixed source port, such as
+ * Art-Net, pass it together with a bind mode that lets the sender share
+ * the port with the plugin input socket. Plugins keep their own sockets
+ * for input and for the packets they send from the main thread.
+ *
+ * Datagrams are copied into a queue and held there until flush() is
+ * called, usually once per frame from QLCIOPlugin::endFrame(), so that
+ * the packets of a frame leave back to back. The sender thread then sends
+ * the flushed datagrams in a batch. On Linux, a batch is handed to the
+ * kernel with a single sendmmsg() call. On the other platforms, or for
+ * non IPv4 destinations, datagrams are sent one by one with
+ * QUdpSocket::writeDatagram().
+ *
+ * Queue buffers are reused, so once the queue has grown to the number of
+ * datagrams sent in a tick, queueing a datagram allocates no memory.
+ */
+class UdpSender : public QThread
+{
+    Q_OBJECT
+
+public:
+    /** Create a sender bound to $address:$port with $mode. If $interface
+     *  is valid, multicast datagrams leave from it and are not looped back */
+    UdpSender(QHostAddress const& address,
+              QNetworkInterface const& interface = QNetworkInterface(),
+              quint16 port = 0,
+              QAbstractSocket::BindMode mode = QAbstractSocket::DefaultForPlatform,
+              QObject *parent = 0);
+    ~UdpSender();
+
+    /** Queue a copy of $data for $address:$port. The sender thread
+     *  is started on the first call. Returns false if the queue is
+     *  full and the datagram was dropped */
+    bool queueDatagram(const QByteArray& data, const QHostAddress& address, quint16 port);
+    bool queueDatagram(const char *data, int size, const QHostAddress& address, quint16 port);
+
+    /** Send all the datagrams queued so far */
+    void flush();
+
+    /** Stop the sender thread. Datagrams still in the queue are discarded */
+    void stop();
+
+    /** Number of datagrams successfully sent */
+    quint64 packetsSent() const;
+
+    /** Number of datagrams that could not be sent or queued */
+    quint64 packetsFailed() const;
+
+    /** Number of batches handed to the network */
+    quint64 batchesSent() const;
+
+private:
+    void run();
+
+    struct Datagram
+    {
+        QByteArray m_data;
+        QHostAddress m_address;
+        quint16 m_port;
+    };
+
+    /** Send $count datagrams starting from $datagrams */
+    void sendDatagrams(const Datagram *datagrams, int count);
+
+    /** Send a single datagram with QUdpSocket */
+    void writeDatagram(const Datagram& datagram);
+
+private:
+    QHostAddress m_address;
+    QNetworkInterface m_interface;
+    quint16 m_port;
+    QAbstractSocket::BindMode m_bindMode;
+
+    /** The socket of the sender thread. Valid only while run() executes */
+    QUdpSocket *m_socket;
+
+    /** Datagrams queued by the callers. Guarded by m_mutex */
+    QVector<Datagram> m_pending;
+    int m_pendingCount;
+
+    /** Number of queued datagrams ready to be sent. Guarded by m_mutex */
+    int m_flushedCount;
+
+    /** Datagrams being sent. Owned by the sender thread */
+    QVector<Datagram> m_sending;
+
+    bool m_running;
+    QMutex m_mutex;
+    QWaitCondition m_queueNotEmpty;
+
+    QAtomicInteger<quint64> m_packetsSent;
+    QAtomicInteger<quint64> m_packetsFailed;
+    QAtomicInteger<quint64> m_batchesSent;
+};
+
+#endif
@@ -31,7 +31,8 @@ TRANSLATIONS += OSC_pt_BR.ts
 TRANSLATIONS += OSC_ca_ES.ts
 TRANSLATIONS += OSC_ja_JP.ts
 
-HEADERS += ../interfaces/qlcioplugin.h
+HEADERS += ../interfaces/qlcioplugin.h \
+           ../interfaces/udpsender.h
 HEADERS += oscpacketizer.h \
            osccontroller.h \
            oscplugin.h \
@@ -39,7 +40,8 @@ HEADERS += oscpacketizer.h \
 
 FORMS += configureosc.ui
 
-SOURCES += ../interfaces/qlcioplugin.cpp
+SOURCES += ../interfaces/qlcioplugin.cpp \
+           ../interfaces/udpsender.cpp
 SOURCES += oscpacketizer.cpp \
            osccontroller.cpp \
            oscplugin.cpp \
@@ -31,6 +31,7 @@ OSCController::OSCController(QString ipaddr, Type type, quint32 line, QObject *p
     , m_line(line)
     , m_outputSocket(new QUdpSocket(this))
     , m_packetizer(new OSCPacketizer())
+    , m_sender(new UdpSender(m_ipAddr))
 {
     qDebug() << "[OSCController] type: " << type;
     // Ensure packets will be sent from the correct interface
@@ -214,7 +215,7 @@ quint32 OSCController::line() const
 
 quint64 OSCController::getPacketSentNumber() const
 {
-    return m_packetSent;
+    return m_packetSent + m_sender->packetsSent();
 }
 
 quint64 OSCController::getPacketReceivedNumber() const
@@ -259,21 +260,20 @@ void OSCController::sendDmx(const quint32 universe, const QByteArray &dmxData)
 
         if (dmxData[i] != dmxValues->at(i))
         {
-            dmxValues->replace(i, 1, (const char *)(dmxData.data() + i), 1);
             m_packetizer->setupOSCDmx(dmxPacket, universe, i, dmxData[i]);
-            qint64 sent = m_outputSocket->writeDatagram(dmxPacket.data(), dmxPacket.size(),
-                                                     outAddress, outPort);
-            if (sent < 0)
-            {
-                qDebug() << "[OSC] sendDmx failed. Errno: " << m_outputSocket->error();
-                qDebug() << "Errmgs: " << m_outputSocket->errorString();
-            }
-            else
-                m_packetSent++;
+            // a refused packet is sent again at the next frame,
+            // since the cached value still differs
+            if (m_sender->queueDatagram(dmxPacket, outAddress, outPort))
+                dmxValues->replace(i, 1, (const char *)(dmxData.data() + i), 1);
         }
     }
 }
 
+void OSCController::endFrame()
+{
+    m_sender->flush();
+}
+
 void OSCController::sendFeedback(const quint32 universe, quint32 channel, uchar value, const QString &key)
 {
     QMutexLocker locker(&m_dataMutex);
@@ -35,6 +35,7 @@
 #include <QMap>
 
 #include "oscpacketizer.h"
+#include "udpsender.h"
 
 typedef struct
 {
@@ -123,6 +124,9 @@ public:
     /** Send DMX data to a specific universe */
     void sendDmx(const quint32 universe, const QByteArray& dmxData);
 
+    /** Send the packets of the current frame */
+    void endFrame();
+
     /** Send a feedback using the specified path and value */
     void sendFeedback(const quint32 universe, quint32 channel, uchar value, const QString &key);
 
@@ -160,6 +164,9 @@ private:
     /** Helper class used to create or parse OSC packets */
     QScopedPointer<OSCPacketizer> m_packetizer;
 
+    /** Thread sending the DMX packets from a socket of its own */
+    QScopedPointer<UdpSender> m_sender;
+
     /** Keeps the current dmx values to send only the ones that changed */
     /** It holds values for all the handled universes */
     QMap<quint32, QByteArray *> m_dmxValuesMap;
@@ -197,6 +197,16 @@ void OSCPlugin::writeUniverse(quint32 universe, quint32 output, const QByteArray
         controller->sendDmx(universe, data);
 }
 
+void OSCPlugin::endFrame()
+{
+    for (int i = 0; i < m_IOmapping.count(); i++)
+    {
+        OSCController *controller = m_IOmapping.at(i).controller;
+        if (controller != NULL)
+            controller->endFrame();
+    }
+}
+
 /*************************************************************************
   * Inputs
   *************************************************************************/  
@@ -92,6 +92,9 @@ public:
     /** @reimp */
     void writeUniverse(quint32 universe, quint32 output, const QByteArray& data);
 
+    /** @reimp */
+    void endFrame();
+
     /*************************************************************************
      * Inputs
      *************************************************************************/
@@ -23,6 +23,7 @@
 #include "rgbmatrixeditor.h"
 
 #include "rgbmatrix.h"
+#include "rgbstream.h"
 #include "rgbimage.h"
 #include "rgbtext.h"
 #include "doc.h"
@@ -107,7 +108,13 @@ void RGBMatrixEditor::setFixtureGroup(int fixtureGroup)
 
 QStringList RGBMatrixEditor::algorithms() const
 {
-    return RGBAlgorithm::algorithms(m_doc);
+    QStringList list = RGBAlgorithm::algorithms(m_doc);
+
+    // this editor has no way to set the source of a Stream yet
+    RGBStream stream(m_doc);
+    list.removeAll(stream.name());
+
+    return list;
 }
 
 int RGBMatrixEditor::algorithmIndex() const
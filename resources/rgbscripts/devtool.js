@@ -154,6 +154,8 @@ function writeCurrentStep()
             map.deleteRow(i);
         }
         var rgb = testAlgo.rgbMap(width, height, currentRgb, step);
+        // maps can also be returned as flat arrays of width * height colors
+        var flat = (rgb.length === width * height && !Array.isArray(rgb[0]));
 
         for (var y = 0; y < height; y++)
         {
@@ -162,7 +164,8 @@ function writeCurrentStep()
             for (var x = 0; x < width; x++)
             {
                 var cell = row.insertCell(x);
-                var rgbStr = rgb[y][x].toString(16);
+                var color = flat ? rgb[y * width + x] : rgb[y][x];
+                var rgbStr = color.toString(16);
                 while (rgbStr.length !== 6) {
                     rgbStr = "0" + rgbStr;
                 }
@@ -27,6 +27,9 @@ var testAlgo;
     algo.apiVersion = 2;
     algo.name = "Script name";
     algo.author = "Your Name";
+    // Set to true when rgbMap() only depends on its arguments and on the
+    // properties, so that QLC+ can cache the rendered frames
+    algo.deterministic = false;
     algo.properties = new Array();
 
     /**
@@ -35,7 +38,9 @@ var testAlgo;
       *
       * @param step The step number that is requested (0 to (algo.rgbMapStepCount - 1))
       * @param rgb Tells the color requested by user in the UI.
-      * @return A two-dimensional array[height][width].
+      * @return A two-dimensional array[height][width], or a flat array
+      *         (or Uint32Array) of width * height colors, row by row.
+      *         The flat form is much faster to read for large matrices.
       */
     algo.rgbMap = function(width, height, rgb, step)
     {
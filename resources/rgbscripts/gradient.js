@@ -27,6 +27,7 @@ var testAlgo;
     algo.apiVersion = 2;
     algo.name = "Gradient";
     algo.author = "Massimo Callegari";
+    algo.deterministic = true;
     algo.acceptColors = 0;
     algo.properties = new Array();
     algo.presetIndex = 0;
@@ -26,6 +26,7 @@ function()
     algo.apiVersion = 2;
     algo.name = "Waves";
     algo.author = "Nathan Durnan";
+    algo.deterministic = true;
 
     algo.properties = new Array();
     algo.taillength = 50;
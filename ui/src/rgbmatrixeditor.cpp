@@ -24,6 +24,7 @@
 #include <QGraphicsView>
 #include <QColorDialog>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QFontDialog>
 #include <QGradient>
 #include <QSettings>
@@ -39,6 +40,7 @@
 #include "rgbmatrixeditor.h"
 #include "qlcmacros.h"
 #include "rgbimage.h"
+#include "rgbstream.h"
 #include "sequence.h"
 #include "rgbitem.h"
 #include "rgbtext.h"
@@ -323,6 +325,7 @@ void RGBMatrixEditor::updateExtraOptions()
     {
         m_textGroup->hide();
         m_imageGroup->show();
+        m_imageAnimationCombo->show();
         m_offsetGroup->show();
 
         RGBImage* image = static_cast<RGBImage*> (m_matrix->algorithm());
@@ -337,6 +340,17 @@ void RGBMatrixEditor::updateExtraOptions()
         m_yOffsetSpin->setValue(image->yOffset());
 
     }
+    else if (m_matrix->algorithm()->type() == RGBAlgorithm::Stream)
+    {
+        m_textGroup->hide();
+        m_imageGroup->show();
+        m_imageAnimationCombo->hide();
+        m_offsetGroup->hide();
+
+        RGBStream* stream = static_cast<RGBStream*> (m_matrix->algorithm());
+        Q_ASSERT(stream != NULL);
+        m_imageEdit->setText(stream->source());
+    }
     else if (m_matrix->algorithm()->type() == RGBAlgorithm::Text)
     {
         m_textGroup->show();
@@ -754,6 +768,16 @@ void RGBMatrixEditor::slotImageEdited()
         }
         slotRestartTest();
     }
+    else if (m_matrix->algorithm() != NULL && m_matrix->algorithm()->type() == RGBAlgorithm::Stream)
+    {
+        RGBStream* algo = static_cast<RGBStream*> (m_matrix->algorithm());
+        Q_ASSERT(algo != NULL);
+        {
+            QMutexLocker algorithmLocker(&m_matrix->algorithmMutex());
+            algo->setSource(m_imageEdit->text());
+        }
+        slotRestartTest();
+    }
 }
 
 void RGBMatrixEditor::slotImageButtonClicked()
@@ -778,6 +802,30 @@ void RGBMatrixEditor::slotImageButtonClicked()
             slotRestartTest();
         }
     }
+    else if (m_matrix->algorithm() != NULL && m_matrix->algorithm()->type() == RGBAlgorithm::Stream)
+    {
+        RGBStream* algo = static_cast<RGBStream*> (m_matrix->algorithm());
+        Q_ASSERT(algo != NULL);
+
+        QString path = algo->source();
+        path = QFileDialog::getOpenFileName(this,
+                                            tr("Select a raw RGB file or an image of a sequence"),
+                                            path,
+                                            QString("%1 (*.rgb *.png *.bmp *.jpg *.jpeg *.gif)").arg(tr("Streams")));
+        if (path.isEmpty() == false)
+        {
+            // any image of a sequence selects the whole directory
+            if (path.endsWith(".rgb", Qt::CaseInsensitive) == false)
+                path = QFileInfo(path).absolutePath();
+
+            {
+                QMutexLocker algorithmLocker(&m_matrix->algorithmMutex());
+                algo->setSource(path);
+            }
+            m_imageEdit->setText(path);
+            slotRestartTest();
+        }
+    }
 }
 
 void RGBMatrixEditor::slotImageAnimationActivated(const QString& text)
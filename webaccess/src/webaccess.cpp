@@ -33,7 +33,9 @@
 #include "vcsoloframe.h"
 #include "outputpatch.h"
 #include "inputpatch.h"
+#include "engineprofiler.h"
 #include "simpledesk.h"
+#include "mastertimer.h"
 #include "qlcconfig.h"
 #include "webaccess.h"
 #include "vccuelist.h"
@@ -548,6 +550,23 @@ void WebAccess::slotHandleWebSocketRequest(QHttpConnection *conn, QString data)
             else
                 wsAPIMessage.append(Function::typeToString(Function::Undefined));
         }
+        else if (apiCmd == "getEngineProfile")
+        {
+            EngineProfiler *profiler = m_doc->masterTimer()->profiler();
+            wsAPIMessage.append(QString::fromUtf8(profiler->toJson()));
+        }
+        else if (apiCmd == "setEngineProfiling")
+        {
+            if (cmdList.count() < 3)
+                return;
+
+            EngineProfiler *profiler = m_doc->masterTimer()->profiler();
+            bool enable = cmdList[2].toInt() != 0;
+            if (enable && profiler->isEnabled() == false)
+                profiler->reset();
+            profiler->setEnabled(enable);
+            wsAPIMessage.append(enable ? "true" : "false");
+        }
         else if (apiCmd == "getWidgetsNumber")
         {
             VCFrame *mainFrame = m_vc->contents();